@@ -29,6 +29,7 @@
 #include "test_containers.h"
 #include "dvector.h"
 #include "set.h"
+#include "map.h"
 #include "print_string.h"
 #include "math_funcs.h"
 #include "servers/visual/default_mouse_cursor.xpm"
@@ -36,11 +37,667 @@
 #include "variant.h"
 #include "list.h"
 #include "image.h"
+#include "hash_map.h"
+#include "oa_hash_map.h"
+#include "os/os.h"
+#include "os/thread.h"
+#include "os/frame_allocator.h"
 
 namespace TestContainers {
 
+static bool _test_oa_hash_map() {
+
+	/* random inserts and erases, checked against HashMap */
+
+	HashMap<int,int> ref;
+	OAHashMap<int,int> oa;
+	uint32_t seed=1234;
+
+	for(int i=0;i<200000;i++) {
+
+		seed=seed*1103515245+12345;
+		int key=(seed>>8)%5000;
+		if ((seed>>4)&1) {
+			ref[key]=i;
+			oa[key]=i;
+		} else {
+			if (ref.erase(key)!=oa.erase(key))
+				return false;
+		}
+	}
+
+	if (ref.size()!=oa.size())
+		return false;
+
+	int count=0;
+	const int *k=NULL;
+	while((k=oa.next(k))) {
+		const int *r=ref.getptr(*k);
+		if (!r || *r!=oa[*k])
+			return false;
+		count++;
+	}
+
+	if (count!=(int)ref.size())
+		return false;
+
+	/* next() also accepts a copy of the key, as Dictionary iteration does */
+	if (oa.size()) {
+		int first=*oa.next(NULL);
+		const int *second=oa.next(&first);
+		if (second && *second==first)
+			return false;
+	}
+
+	OAHashMap<int,int> copy=oa;
+	k=NULL;
+	while((k=ref.next(k))) {
+		if (!copy.has(*k) || copy[*k]!=ref[*k])
+			return false;
+	}
+
+	/* variant keys, 1 and 1.0 hash differently so they stay apart */
+	OAHashMap<Variant,Variant,VariantHasher> vmap;
+	vmap[1]="int";
+	vmap["1"]="string";
+	vmap[Vector2(1,1)]="vector";
+	if (vmap.size()!=3 || vmap[1]!=Variant("int") || vmap["1"]!=Variant("string") || vmap[Vector2(1,1)]!=Variant("vector"))
+		return false;
+
+	return true;
+}
+
+template<class M,class K>
+static void _bench_map(const char* p_map,const char* p_type,const Vector<K>& p_keys) {
+
+	M map;
+	int n=p_keys.size();
+	OS *os=OS::get_singleton();
+
+	uint64_t t=os->get_ticks_usec();
+	for(int i=0;i<n;i++)
+		map.set(p_keys[i],i);
+	uint64_t insert=os->get_ticks_usec()-t;
+
+	int found=0;
+	t=os->get_ticks_usec();
+	for(int i=0;i<n;i++) {
+		if (map.getptr(p_keys[(uint32_t(i)*7919u)%n]))
+			found++;
+	}
+	uint64_t lookup=os->get_ticks_usec()-t;
+
+	int iterated=0;
+	t=os->get_ticks_usec();
+	const K *k=NULL;
+	while((k=map.next(k)))
+		iterated++;
+	uint64_t iterate=os->get_ticks_usec()-t;
+
+	t=os->get_ticks_usec();
+	for(int i=0;i<n;i++)
+		map.erase(p_keys[i]);
+	uint64_t erase=os->get_ticks_usec()-t;
+
+	print_line(String(p_map)+"<"+p_type+"> "+itos(n)+": insert "+rtos(insert/1000.0)+"ms, lookup "+rtos(lookup/1000.0)+"ms, iterate "+rtos(iterate/1000.0)+"ms, erase "+rtos(erase/1000.0)+"ms"+((found==n && iterated==n && map.empty())?"":" (FAILED)"));
+}
+
+template<class K,class H>
+static void _bench_maps(const char* p_type,const Vector<K>& p_keys) {
+
+	_bench_map< HashMap<K,int,H> >("HashMap",p_type,p_keys);
+	_bench_map< OAHashMap<K,int,H> >("OAHashMap",p_type,p_keys);
+}
+
+static void _bench_hash_maps() {
+
+	for(int n=1000;n<=1000000;n*=10) {
+
+		Vector<int> ints;
+		Vector<StringName> names;
+		Vector<Variant> variants;
+		ints.resize(n);
+		names.resize(n);
+		variants.resize(n);
+
+		for(int i=0;i<n;i++) {
+			ints[i]=i*2654435761u; //scattered ids
+			names[i]=StringName("key_"+itos(i));
+			variants[i]=(i&1)?Variant(i):Variant("key_"+itos(i));
+		}
+
+		_bench_maps<int,HashMapHahserDefault>("int",ints);
+		_bench_maps<StringName,StringNameHasher>("StringName",names);
+		_bench_maps<Variant,VariantHasher>("Variant",variants);
+	}
+}
+
+static bool _test_dictionary() {
+
+	Dictionary d;
+	for(int i=0;i<1000;i++)
+		d[i]=i*2;
+
+	/* erase most of them, values of the others don't move */
+	Variant *kept=d.getptr(990);
+	for(int i=0;i<1000;i++) {
+		if (i%10)
+			d.erase(i);
+	}
+	if (d.getptr(990)!=kept || *kept!=Variant(1980))
+		return false;
+
+	/* the holes are compacted once more room is needed */
+	for(int i=1000;i<1100;i++)
+		d[String::num(i)]=i;
+
+	if (d.size()!=200)
+		return false;
+
+	/* insertion order is kept, through next() and keys() */
+	Array keys=d.keys();
+	const Variant *k=NULL;
+	int idx=0;
+	while((k=d.next(k))) {
+		Variant expected = idx<100 ? Variant(idx*10) : Variant(String::num(900+idx));
+		if (*k!=expected || keys[idx]!=expected)
+			return false;
+		idx++;
+	}
+	if (idx!=200)
+		return false;
+
+	/* next() also accepts a copy of the key, as the script iterators do */
+	Variant copy=keys[5];
+	if (!d.next(&copy) || *d.next(&copy)!=keys[6])
+		return false;
+
+	Dictionary c=d.copy();
+	d[0]="changed";
+	if (c[0]!=Variant(0) || c.size()!=d.size() || !c.has("1050") || c.has(1))
+		return false;
+
+	d.clear();
+	return d.empty() && c.size()==200;
+}
+
+static void _bench_dictionary() {
+
+	/* against the HashMap it used to be built on */
+
+	OS *os=OS::get_singleton();
+
+	for(int n=1000;n<=100000;n*=10) {
+
+		Vector<Variant> keys;
+		keys.resize(n);
+		for(int i=0;i<n;i++)
+			keys[i]=(i&1)?Variant(i):Variant("key_"+itos(i));
+
+		uint64_t times[2][3];
+		int checks[2]={0,0};
+
+		{
+			HashMap<Variant,Variant,VariantHasher> map;
+			uint64_t t=os->get_ticks_usec();
+			for(int i=0;i<n;i++)
+				map[keys[i]]=i;
+			times[0][0]=os->get_ticks_usec()-t;
+			t=os->get_ticks_usec();
+			for(int i=0;i<n;i++)
+				checks[0]+=int(map[keys[(uint32_t(i)*7919u)%n]]);
+			times[0][1]=os->get_ticks_usec()-t;
+			t=os->get_ticks_usec();
+			const Variant *k=NULL;
+			while((k=map.next(k)))
+				checks[0]+=int(map[*k]);
+			times[0][2]=os->get_ticks_usec()-t;
+		}
+
+		{
+			Dictionary map;
+			uint64_t t=os->get_ticks_usec();
+			for(int i=0;i<n;i++)
+				map[keys[i]]=i;
+			times[1][0]=os->get_ticks_usec()-t;
+			t=os->get_ticks_usec();
+			for(int i=0;i<n;i++)
+				checks[1]+=int(map[keys[(uint32_t(i)*7919u)%n]]);
+			times[1][1]=os->get_ticks_usec()-t;
+			t=os->get_ticks_usec();
+			const Variant *k=NULL;
+			while((k=map.next(k)))
+				checks[1]+=int(map[*k]);
+			times[1][2]=os->get_ticks_usec()-t;
+		}
+
+		for(int i=0;i<2;i++)
+			print_line(String(i?"Dictionary ":"HashMap<Variant,Variant> ")+itos(n)+": build "+rtos(times[i][0]/1000.0)+"ms, lookup "+rtos(times[i][1]/1000.0)+"ms, iterate "+rtos(times[i][2]/1000.0)+"ms"+(checks[i]==checks[0]?"":" (FAILED)"));
+	}
+}
+
+static bool _test_dvector() {
+
+	DVector<int> a;
+	for(int i=0;i<1000;i++)
+		a.push_back(i);
+
+	/* copies share the data until one of them writes */
+	DVector<int> b=a;
+	b.set(0,-1);
+	if (a[0]!=0 || b[0]!=-1 || a.size()!=1000 || b.size()!=1000)
+		return false;
+
+	/* a Read keeps the data it was created with */
+	DVector<int>::Read r=a.read();
+	a.set(1,-1);
+	if (r[1]!=1 || a[1]!=-1)
+		return false;
+	r=DVector<int>::Read();
+
+	/* a Write locks against resizing, and does not trigger copies of its own */
+	DVector<int>::Write w=a.write();
+	w[2]=-2;
+	a.set(3,-3);
+	if (a.resize(10)!=ERR_LOCKED || !a.is_locked() || w[3]!=-3 || a[2]!=-2)
+		return false;
+	/* other users of the data don't make it resizable, the Write would be left on the old copy */
+	r=a.read();
+	DVector<int> c=a;
+	if (a.resize(20)!=ERR_LOCKED || a.resize(0)!=ERR_LOCKED || a.size()!=1000)
+		return false;
+	w[4]=-4;
+	if (a[4]!=-4)
+		return false;
+	r=DVector<int>::Read();
+	c=DVector<int>();
+	w=DVector<int>::Write();
+	if (a.is_locked() || a.resize(10)!=OK || a.size()!=10)
+		return false;
+
+	/* a Read of a temporary outlives it */
+	DVector<String> s;
+	s.push_back("kept");
+	r=DVector<int>::Read();
+	DVector<String>::Read sr=DVector<String>(s).read();
+	s.resize(0);
+	if (sr[0]!="kept")
+		return false;
+
+	a.insert(0,42);
+	a.remove(1);
+	a.invert();
+	return a.size()==10 && a[9]==42 && a[0]==9;
+}
+
+struct DVectorThread {
+
+	DVector<int> *shared;
+	int iterations;
+	int sum;
+};
+
+static void _dvector_thread(void *p_ud) {
+
+	/* copies and reads of a shared array, plus writes to private copies */
+	DVectorThread *t = (DVectorThread*)p_ud;
+	for(int i=0;i<t->iterations;i++) {
+		DVector<int> copy=*t->shared;
+		{
+			DVector<int>::Read r=copy.read();
+			t->sum+=r[i&255];
+		}
+		if ((i&63)==0) {
+			DVector<int>::Write w=copy.write();
+			w[0]=i;
+		}
+	}
+}
+
+static void _bench_dvector() {
+
+	OS *os=OS::get_singleton();
+	const int n=1000000;
+	int check=0;
+
+	uint64_t t=os->get_ticks_usec();
+	DVector<int> a;
+	for(int i=0;i<n;i++)
+		a.push_back(i);
+	uint64_t push_back=os->get_ticks_usec()-t;
+
+	t=os->get_ticks_usec();
+	for(int i=0;i<n;i++)
+		a.set(i,i*2);
+	uint64_t set=os->get_ticks_usec()-t;
+
+	t=os->get_ticks_usec();
+	for(int i=0;i<n;i++)
+		check+=a[i];
+	uint64_t get=os->get_ticks_usec()-t;
+
+	t=os->get_ticks_usec();
+	for(int i=0;i<n/100;i++) {
+		DVector<int>::Write w=a.write();
+		w[i]++;
+	}
+	for(int i=0;i<n/100;i++) {
+		DVector<int>::Read r=a.read();
+		check+=r[i];
+	}
+	uint64_t handles=os->get_ticks_usec()-t;
+
+	t=os->get_ticks_usec();
+	for(int i=0;i<1000;i++) {
+		DVector<int> b=a;
+		b.resize(1000+i);
+		check+=b[i];
+	}
+	uint64_t resize=os->get_ticks_usec()-t;
+
+	print_line("DVector<int> "+itos(n)+": push_back "+rtos(push_back/1000.0)+"ms, set "+rtos(set/1000.0)+"ms, get "+rtos(get/1000.0)+"ms, "+itos(n/50)+" handles "+rtos(handles/1000.0)+"ms, 1000 copy+resize "+rtos(resize/1000.0)+"ms (check "+itos(check)+")");
+
+	DVector<int> shared;
+	shared.resize(256);
+	for(int i=0;i<256;i++)
+		shared.set(i,1);
+
+	for(int threads=1;threads<=4;threads*=2) {
+
+		DVectorThread data[4];
+		Thread *thread[4];
+		const int iterations=400000/threads;
+
+		t=os->get_ticks_usec();
+		for(int i=0;i<threads;i++) {
+			data[i].shared=&shared;
+			data[i].iterations=iterations;
+			data[i].sum=0;
+			thread[i]=Thread::create(_dvector_thread,&data[i]);
+		}
+		int sum=0;
+		for(int i=0;i<threads;i++) {
+			Thread::wait_to_finish(thread[i]);
+			memdelete(thread[i]);
+			sum+=data[i].sum;
+		}
+		uint64_t elapsed=os->get_ticks_usec()-t;
+
+		print_line("DVector<int> shared by "+itos(threads)+" thread(s): "+itos(iterations*threads)+" copy+read in "+rtos(elapsed/1000.0)+"ms"+(sum==iterations*threads?"":" (FAILED)"));
+	}
+}
+
+static void _frame_alloc_thread(void *p_ud) {
+
+	// allocated here, freed by the main thread
+	List<int,FrameAllocator> *list=(List<int,FrameAllocator>*)p_ud;
+	for(int i=0;i<100;i++)
+		list->push_back(i);
+}
+
+static bool _test_frame_allocator() {
+
+	bool ok=true;
+
+	for(int frame=0;frame<3;frame++) {
+
+		Set<int,Comparator<int>,FrameAllocator> set;
+		List<int,FrameAllocator> list;
+		for(int i=0;i<1000;i++) {
+			set.insert((i*7919)%1000);
+			list.push_back(i);
+		}
+		for(int i=0;i<1000;i+=2)
+			set.erase(i);
+
+		int expected=1;
+		for(Set<int,Comparator<int>,FrameAllocator>::Element *E=set.front();E;E=E->next()) {
+			ok = ok && E->get()==expected;
+			expected+=2;
+		}
+		ok = ok && set.size()==500 && list.size()==1000 && list.back()->get()==999;
+	}
+	FrameAllocator::end_frame();
+
+	// everything above was freed, so each frame started over from the same memory
+	size_t usage=FrameAllocator::get_last_frame_usage();
+	ok = ok && usage>0 && usage<FrameAllocator::get_arena_size();
+
+	{
+		// more than an arena holds goes to the heap, and stays valid
+		uint32_t overflows=FrameAllocator::get_overflow_count();
+		List<Vector3,FrameAllocator> big;
+		int count=int(FrameAllocator::get_arena_size()/sizeof(Vector3));
+		for(int i=0;i<count;i++)
+			big.push_back(Vector3(i,0,0));
+		int i=0;
+		for(List<Vector3,FrameAllocator>::Element *E=big.front();E;E=E->next())
+			ok = ok && E->get().x==i++;
+		ok = ok && FrameAllocator::get_overflow_count()>overflows;
+	}
+
+	{
+		List<int,FrameAllocator> list;
+		Thread *thread=Thread::create(_frame_alloc_thread,&list);
+		if (thread) {
+			Thread::wait_to_finish(thread);
+			memdelete(thread);
+		}
+		ok = ok && list.size()==100 && list.back()->get()==99;
+	}
+
+	{
+		// threads that exited leave their arena to the next ones, so there's no running out of them
+		uint32_t overflows=FrameAllocator::get_overflow_count();
+		for(int i=0;i<100;i++) {
+			List<int,FrameAllocator> list;
+			Thread *thread=Thread::create(_frame_alloc_thread,&list);
+			if (!thread)
+				break;
+			Thread::wait_to_finish(thread);
+			memdelete(thread);
+		}
+		ok = ok && FrameAllocator::get_overflow_count()==overflows;
+	}
+
+	{
+		// memory kept past the end of a frame pins the arena, and gets counted
+		uint32_t pinned=FrameAllocator::get_pinned_frame_count();
+		{
+			List<int,FrameAllocator> kept;
+			kept.push_back(1);
+			FrameAllocator::end_frame();
+			FrameAllocator::end_frame();
+			ok = ok && FrameAllocator::get_pinned_frame_count()==pinned+1;
+		}
+		FrameAllocator::end_frame();
+		ok = ok && FrameAllocator::get_pinned_frame_count()==pinned+1;
+	}
+
+	return ok;
+}
+
+template<class A>
+static uint64_t _bench_frame_containers(int p_frames) {
+
+	uint64_t t=OS::get_singleton()->get_ticks_usec();
+	int check=0;
+	for(int frame=0;frame<p_frames;frame++) {
+
+		// the kind of temporaries culling and drawing build every frame
+		Set<int,Comparator<int>,A> set;
+		List<int,A> list;
+		Map<int,int,Comparator<int>,A> map;
+		for(int i=0;i<64;i++) {
+			set.insert((i*37)&63);
+			list.push_back(i);
+			map[i^frame]=i;
+		}
+		check+=set.size()+list.size()+map.size();
+	}
+	uint64_t elapsed=OS::get_singleton()->get_ticks_usec()-t;
+	return check==p_frames*192 ? elapsed : 0;
+}
+
+static void _bench_frame_allocator() {
+
+	const int frames=20000;
+	FrameAllocator::end_frame(); // so the usage reported is this benchmark's
+	uint64_t heap=_bench_frame_containers<DefaultAllocator>(frames);
+	uint64_t arena=_bench_frame_containers<FrameAllocator>(frames);
+	FrameAllocator::end_frame();
+
+	print_line("FrameAllocator "+itos(frames)+" frames of Set+List+Map temporaries: heap "+rtos(heap/1000.0)+"ms, arena "+rtos(arena/1000.0)+"ms, "+itos(FrameAllocator::get_last_frame_usage()/1024)+"KB of arena per frame");
+}
+
+static const char *_tracked_site="test_containers.cpp, tracked site";
+
+static bool _find_tracked_site(const char *p_site,Memory::AllocCategory p_category,Memory::AllocStats *r_stats) {
+
+	Vector<Memory::AllocStats> sites;
+	sites.resize(4096);
+	int count=Memory::get_tracked_sites(sites.ptr(),sites.size());
+	for(int i=0;i<count;i++) {
+		if (sites[i].site==p_site && sites[i].category==p_category) {
+			*r_stats=sites[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+static void _tracked_alloc_thread(void *p_ud) {
+
+	MemoryCategoryScope scope(Memory::ALLOC_SERVER);
+	for(int i=0;i<10000;i++) {
+		void *mem=Memory::alloc_static(16+(i&63),_tracked_site);
+		Memory::free_static(mem);
+	}
+}
+
+static bool _test_memory_tracking() {
+
+	bool ok=true;
+	bool was_enabled=Memory::is_tracking_enabled();
+	Memory::set_tracking_enabled(false);
+
+	void *before=Memory::alloc_static(32,_tracked_site); // not tracked, freeing it later must not underflow
+	Memory::set_tracking_enabled(true);
+
+	void *mem[3];
+	for(int i=0;i<3;i++)
+		mem[i]=Memory::alloc_static(100,_tracked_site);
+	mem[0]=Memory::realloc_static(mem[0],200);
+	Memory::free_static(mem[1]);
+	Memory::free_static(before);
+
+	Memory::AllocStats stats;
+	ok = ok && _find_tracked_site(_tracked_site,Memory::ALLOC_GENERAL,&stats);
+	ok = ok && stats.live_count==2 && stats.live_bytes==300 && stats.total_count==4;
+
+	Memory::tracking_end_frame();
+	ok = ok && _find_tracked_site(_tracked_site,Memory::ALLOC_GENERAL,&stats) && stats.frame_count==4;
+	Memory::tracking_end_frame();
+	ok = ok && _find_tracked_site(_tracked_site,Memory::ALLOC_GENERAL,&stats) && stats.frame_count==0;
+
+	{
+		// innermost scope wins, and leaving it restores the outer one
+		MemoryCategoryScope outer(Memory::ALLOC_NODE);
+		void *a=Memory::alloc_static(10,_tracked_site);
+		void *b;
+		{
+			MemoryCategoryScope inner(Memory::ALLOC_SCRIPT);
+			b=Memory::alloc_static(20,_tracked_site);
+		}
+		void *c=Memory::alloc_static(30,_tracked_site);
+
+		ok = ok && _find_tracked_site(_tracked_site,Memory::ALLOC_NODE,&stats) && stats.live_bytes==40;
+		ok = ok && _find_tracked_site(_tracked_site,Memory::ALLOC_SCRIPT,&stats) && stats.live_bytes==20;
+		Memory::free_static(a);
+		Memory::free_static(b);
+		Memory::free_static(c);
+		ok = ok && _find_tracked_site(_tracked_site,Memory::ALLOC_NODE,&stats) && stats.live_bytes==0 && stats.live_count==0;
+	}
+
+	{
+		Memory::AllocStats categories[Memory::ALLOC_CATEGORY_MAX];
+		Memory::get_tracked_categories(categories);
+		size_t string_bytes=categories[Memory::ALLOC_STRING].live_bytes;
+
+		String str;
+		for(int i=0;i<1000;i++)
+			str+="x";
+
+		Memory::get_tracked_categories(categories);
+		ok = ok && categories[Memory::ALLOC_STRING].live_bytes>=string_bytes+1000*sizeof(CharType);
+	}
+
+	{
+		Thread *threads[4];
+		for(int i=0;i<4;i++)
+			threads[i]=Thread::create(_tracked_alloc_thread,NULL);
+		for(int i=0;i<4;i++) {
+			if (threads[i]) {
+				Thread::wait_to_finish(threads[i]);
+				memdelete(threads[i]);
+			}
+		}
+		ok = ok && _find_tracked_site(_tracked_site,Memory::ALLOC_SERVER,&stats);
+		ok = ok && stats.live_count==0 && stats.live_bytes==0 && stats.total_count==40000;
+	}
+
+	Memory::free_static(mem[0]);
+	Memory::free_static(mem[2]);
+	ok = ok && _find_tracked_site(_tracked_site,Memory::ALLOC_GENERAL,&stats) && stats.live_count==0 && stats.live_bytes==0;
+
+	Memory::set_tracking_enabled(false);
+	// statistics stay readable after disabling
+	ok = ok && _find_tracked_site(_tracked_site,Memory::ALLOC_GENERAL,&stats) && stats.total_count==4;
+
+	Memory::set_tracking_enabled(was_enabled);
+	return ok;
+}
+
+static uint64_t _bench_alloc_free(int p_count) {
+
+	uint64_t t=OS::get_singleton()->get_ticks_usec();
+	for(int i=0;i<p_count;i++) {
+		Vector<int> v;
+		v.resize(1+(i&255));
+		String s=itos(i);
+	}
+	return OS::get_singleton()->get_ticks_usec()-t;
+}
+
+static void _bench_memory_tracking() {
+
+	const int count=200000;
+	uint64_t off=_bench_alloc_free(count);
+	Memory::set_tracking_enabled(true);
+	uint64_t on=_bench_alloc_free(count);
+	Memory::set_tracking_enabled(false);
+
+	print_line("Memory tracking "+itos(count)+" Vector+String temporaries: untracked "+rtos(off/1000.0)+"ms, tracked "+rtos(on/1000.0)+"ms");
+	Memory::print_tracking_report(8);
+}
+
 MainLoop * test() {
 
+	print_line("OAHashMap: "+String(_test_oa_hash_map()?"OK":"FAILED"));
+	_bench_hash_maps();
+
+	print_line("Dictionary: "+String(_test_dictionary()?"OK":"FAILED"));
+	_bench_dictionary();
+
+	print_line("DVector: "+String(_test_dvector()?"OK":"FAILED"));
+	_bench_dvector();
+
+	print_line("FrameAllocator: "+String(_test_frame_allocator()?"OK":"FAILED"));
+	_bench_frame_allocator();
+
+	print_line("Memory tracking: "+String(_test_memory_tracking()?"OK":"FAILED"));
+	_bench_memory_tracking();
+
 
 	/*
 	HashMap<int,int> int_map;
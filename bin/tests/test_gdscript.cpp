@@ -519,10 +519,18 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 
 			switch(code[ip]) {
 
-				case GDFunction::OPCODE_OPERATOR: {
+				case GDFunction::OPCODE_OPERATOR:
+				case GDFunction::OPCODE_OPERATOR_INT:
+				case GDFunction::OPCODE_OPERATOR_REAL:
+				case GDFunction::OPCODE_OPERATOR_VECTOR2: {
 
 					int op = code[ip+1];
-					txt+="op ";
+					switch(code[ip]) {
+						case GDFunction::OPCODE_OPERATOR_INT: txt+="op(int) "; break;
+						case GDFunction::OPCODE_OPERATOR_REAL: txt+="op(real) "; break;
+						case GDFunction::OPCODE_OPERATOR_VECTOR2: txt+="op(vector2) "; break;
+						default: txt+="op ";
+					}
 
 					String opname = Variant::get_operator_name(Variant::Operator(op));
 
@@ -668,11 +676,14 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 				} break;
 
 				case GDFunction::OPCODE_CALL:
-				case GDFunction::OPCODE_CALL_RETURN: {
+				case GDFunction::OPCODE_CALL_RETURN:
+				case GDFunction::OPCODE_CALL_PTRCALL: {
 
-					bool ret=code[ip]==GDFunction::OPCODE_CALL_RETURN;
+					bool ret=code[ip]!=GDFunction::OPCODE_CALL;
 
-					if (ret)
+					if (code[ip]==GDFunction::OPCODE_CALL_PTRCALL)
+						txt+=" call-ptr ";
+					else if (ret)
 						txt+=" call-ret ";
 					else
 						txt+=" call ";
@@ -788,6 +799,17 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 
 					incr=3;
 				} break;
+				case GDFunction::OPCODE_JUMP_IF_NOT_OPERATOR: {
+
+					String opname = Variant::get_operator_name(Variant::Operator(code[ip+1]));
+
+					txt+=" jump-if-not ";
+					txt+=DADDR(2)+" "+opname+" "+DADDR(3);
+					txt+=" to ";
+					txt+=itos(code[ip+4]);
+
+					incr=5;
+				} break;
 				case GDFunction::OPCODE_JUMP_TO_DEF_ARGUMENT: {
 
 
@@ -813,6 +835,18 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 					txt+=" for-loop "+DADDR(4)+" in "+DADDR(2)+" counter "+DADDR(1)+" end "+itos(code[ip+3]);
 					incr+=5;
 
+				} break;
+				case GDFunction::OPCODE_ITERATE_RANGE_BEGIN: {
+
+					txt+=" for-range-init "+DADDR(8)+" in range("+DADDR(4)+", "+DADDR(5)+", "+DADDR(6)+") counter "+DADDR(1)+" end "+itos(code[ip+7]);
+					incr+=9;
+
+				} break;
+				case GDFunction::OPCODE_ITERATE_RANGE: {
+
+					txt+=" for-range-loop "+DADDR(5)+" counter "+DADDR(1)+" to "+DADDR(2)+" step "+DADDR(3)+" end "+itos(code[ip+4]);
+					incr+=6;
+
 				} break;
 				case GDFunction::OPCODE_LINE: {
 
@@ -853,8 +887,148 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 	}
 }
 
+struct _BenchmarkScript {
+
+	const char *name;
+	const char *code;
+};
+
+//every script extends Reference and does its work in run(), returning a checksum
+
+static const _BenchmarkScript _benchmark_scripts[]={
+	{"fib",
+		"extends Reference\n"
+		"func fib(n):\n"
+		"\tif n<2:\n"
+		"\t\treturn n\n"
+		"\treturn fib(n-1)+fib(n-2)\n"
+		"func run():\n"
+		"\treturn fib(24)\n"
+	},
+	{"nbody",
+		"extends Reference\n"
+		"func run():\n"
+		"\tvar pos=[]\n"
+		"\tvar vel=[]\n"
+		"\tvar mass=[]\n"
+		"\tfor i in range(5):\n"
+		"\t\tpos.append(Vector3(i*1.5,i*0.5-1.0,2.0-i))\n"
+		"\t\tvel.append(Vector3(0.1*i,0.0,-0.05*i))\n"
+		"\t\tmass.append(1.0+i*0.25)\n"
+		"\tvar dt=0.01\n"
+		"\tfor step in range(2000):\n"
+		"\t\tfor i in range(5):\n"
+		"\t\t\tfor j in range(i+1,5):\n"
+		"\t\t\t\tvar d=pos[i]-pos[j]\n"
+		"\t\t\t\tvar dist2=d.dot(d)+0.01\n"
+		"\t\t\t\tvar mag=dt/(dist2*sqrt(dist2))\n"
+		"\t\t\t\tvel[i]-=d*(mass[j]*mag)\n"
+		"\t\t\t\tvel[j]+=d*(mass[i]*mag)\n"
+		"\t\tfor i in range(5):\n"
+		"\t\t\tpos[i]+=vel[i]*dt\n"
+		"\tvar e=0.0\n"
+		"\tfor i in range(5):\n"
+		"\t\te+=0.5*mass[i]*vel[i].dot(vel[i])\n"
+		"\treturn e\n"
+	},
+	{"string_build",
+		"extends Reference\n"
+		"func run():\n"
+		"\tvar s=\"\"\n"
+		"\tfor i in range(20000):\n"
+		"\t\ts+=str(i)\n"
+		"\t\tif i%100==0:\n"
+		"\t\t\ts+=\"\\n\"\n"
+		"\treturn s.length()\n"
+	},
+	{"dictionary_churn",
+		"extends Reference\n"
+		"func run():\n"
+		"\tvar d={}\n"
+		"\tvar total=0\n"
+		"\tfor i in range(20000):\n"
+		"\t\td[\"key\"+str(i%512)]=i\n"
+		"\t\tif d.has(\"key\"+str((i*7)%512)):\n"
+		"\t\t\ttotal+=1\n"
+		"\t\tif i%3==0:\n"
+		"\t\t\td.erase(\"key\"+str((i*13)%512))\n"
+		"\treturn total+d.size()\n"
+	},
+	{"array_iterate",
+		"extends Reference\n"
+		"func run():\n"
+		"\tvar a=[]\n"
+		"\ta.resize(100000)\n"
+		"\tfor i in range(a.size()):\n"
+		"\t\ta[i]=i\n"
+		"\tvar total=0\n"
+		"\tfor v in a:\n"
+		"\t\ttotal+=v\n"
+		"\tvar i=0\n"
+		"\twhile i<a.size():\n"
+		"\t\ttotal-=a[i]\n"
+		"\t\ti+=1\n"
+		"\treturn total\n"
+	},
+	{"arithmetic",
+		"extends Reference\n"
+		"func run():\n"
+		"\tvar s=0\n"
+		"\tvar f=0.5\n"
+		"\tvar v=Vector2(1,1)\n"
+		"\tfor i in range(100000):\n"
+		"\t\ts=(s+i*3-1)%65536\n"
+		"\t\tf=f*0.999+0.5\n"
+		"\t\tv=v+Vector2(1,2)*0.5\n"
+		"\treturn s+int(f)+int(v.y)\n"
+	},
+	{NULL,NULL}
+};
+
+static void _run_benchmarks() {
+
+	const int rounds=5;
+
+	print_line("GDScript benchmarks (best of "+itos(rounds)+" rounds)");
+
+	for(int i=0;_benchmark_scripts[i].name;i++) {
+
+		Ref<GDScript> script = memnew( GDScript );
+		script->set_source_code(String::utf8(_benchmark_scripts[i].code));
+		Error err = script->reload();
+		if (err) {
+			print_line(String(_benchmark_scripts[i].name)+": compile error");
+			continue;
+		}
+
+		Ref<Reference> instance = memnew( Reference );
+		instance->set_script(script.get_ref_ptr());
+
+		Variant result;
+		uint64_t best=0;
+		for(int j=0;j<rounds;j++) {
+
+			uint64_t from = OS::get_singleton()->get_ticks_usec();
+			result = instance->call("run");
+			uint64_t time = OS::get_singleton()->get_ticks_usec()-from;
+			if (j==0 || time<best)
+				best=time;
+		}
+
+		print_line(String(_benchmark_scripts[i].name)+": "+rtos(best/1000.0)+" msec (result "+String(result)+")");
+
+		instance->set_script(RefPtr());
+	}
+}
+
 MainLoop* test(TestType p_test) {
 
+	if (p_test==TEST_BENCHMARK) {
+
+		_run_benchmarks();
+		return NULL;
+	}
+
 	List<String> cmdlargs = OS::get_singleton()->get_cmdline_args();
 
 	if (cmdlargs.empty()) {
@@ -31,8 +31,442 @@
 #include "math_funcs.h"
 #include "print_string.h"
 #include "io/image_loader.h"
+#include "os/os.h"
+#include "os/worker_thread_pool.h"
+#include <string.h>
+
 namespace TestImage {
 
+/* reference versions of the original per pixel filters, the optimized ones must match them exactly */
+
+static void _ref_scale_bilinear(const uint8_t* p_src, uint8_t* p_dst, int CC, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+
+	for(uint32_t i=0;i<p_dst_height;i++) {
+
+		uint32_t src_yofs_up_fp = (i*p_src_height*256/p_dst_height);
+		uint32_t src_yofs_frac = src_yofs_up_fp & 0xFF;
+		uint32_t src_yofs_up = src_yofs_up_fp >> 8;
+		uint32_t src_yofs_down = (i+1)*p_src_height/p_dst_height;
+		if (src_yofs_down>=p_src_height)
+			src_yofs_down=p_src_height-1;
+
+		uint32_t y_ofs_up = src_yofs_up * p_src_width * CC;
+		uint32_t y_ofs_down = src_yofs_down * p_src_width * CC;
+
+		for(uint32_t j=0;j<p_dst_width;j++) {
+
+			uint32_t src_xofs_left_fp = (j*p_src_width*256/p_dst_width);
+			uint32_t src_xofs_frac = src_xofs_left_fp & 0xFF;
+			uint32_t src_xofs_left = (src_xofs_left_fp >> 8)*CC;
+			uint32_t src_xofs_right = (j+1)*p_src_width/p_dst_width;
+			if (src_xofs_right>=p_src_width)
+				src_xofs_right=p_src_width-1;
+			src_xofs_right*=CC;
+
+			for(uint32_t l=0;l<CC;l++) {
+
+				uint32_t p00=p_src[y_ofs_up+src_xofs_left+l]<<8;
+				uint32_t p10=p_src[y_ofs_up+src_xofs_right+l]<<8;
+				uint32_t p01=p_src[y_ofs_down+src_xofs_left+l]<<8;
+				uint32_t p11=p_src[y_ofs_down+src_xofs_right+l]<<8;
+
+				uint32_t interp_up = p00+(((p10-p00)*src_xofs_frac)>>8);
+				uint32_t interp_down = p01+(((p11-p01)*src_xofs_frac)>>8);
+				uint32_t interp = interp_up+(((interp_down-interp_up)*src_yofs_frac)>>8);
+				p_dst[i*p_dst_width*CC+j*CC+l]=interp>>8;
+			}
+		}
+	}
+}
+
+static double _ref_cubic_kernel( double x ) {
+
+	x = ABS(x);
+	if ( x <= 1 )
+		return ( 1.5 * x - 2.5 ) * x * x + 1;
+	else if ( x < 2 )
+		return ( ( -0.5 * x + 2.5 ) * x - 4 ) * x + 2;
+	return 0;
+}
+
+static void _ref_scale_cubic(const uint8_t* p_src, uint8_t* p_dst, int CC, int p_src_width, int p_src_height, int p_dst_width, int p_dst_height) {
+
+	double xfac = (double) p_src_width / p_dst_width;
+	double yfac = (double) p_src_height / p_dst_height;
+
+	for ( int y = 0; y < p_dst_height; y++ ) {
+
+		double oy = (double) y * yfac - 0.5f;
+		int oy1 = (int) oy;
+		double dy = oy - (double) oy1;
+
+		for ( int x = 0; x < p_dst_width; x++ ) {
+
+			double ox = (double) x * xfac - 0.5f;
+			int ox1 = (int) ox;
+			double dx = ox - (double) ox1;
+			double color[4]={0,0,0,0};
+
+			for ( int n = -1; n < 3; n++ ) {
+
+				double k1 = _ref_cubic_kernel( dy - (double) n );
+				int oy2 = CLAMP( oy1 + n, 0, p_src_height-1 );
+
+				for ( int m = -1; m < 3; m++ ) {
+
+					double k2 = k1 * _ref_cubic_kernel( (double) m - dx );
+					int ox2 = CLAMP( ox1 + m, 0, p_src_width-1 );
+					const uint8_t *p = p_src + (oy2 * p_src_width + ox2)*CC;
+					for(int i=0;i<CC;i++)
+						color[i]+=p[i]*k2;
+				}
+			}
+
+			for(int i=0;i<CC;i++)
+				p_dst[(y*p_dst_width+x)*CC+i]=CLAMP(Math::fast_ftoi(color[i]),0,255);
+		}
+	}
+}
+
+static Image _make_image(int p_width,int p_height,Image::Format p_format) {
+
+	int ps=Image::get_format_pixel_size(p_format);
+	DVector<uint8_t> data;
+	data.resize(p_width*p_height*ps);
+	{
+		DVector<uint8_t>::Write w=data.write();
+		uint32_t seed=12345;
+		for(int i=0;i<p_height;i++) {
+			for(int j=0;j<p_width;j++) {
+				for(int c=0;c<ps;c++) {
+					seed=seed*1103515245+12345;
+					// smooth gradients plus some noise, so every filter path matters
+					w[(i*p_width+j)*ps+c]=uint8_t(((i*(c+1)+j*(3-c))>>2)+((seed>>16)&0x1F));
+				}
+			}
+		}
+	}
+
+	return Image(p_width,p_height,0,p_format,data);
+}
+
+static bool _same_data(const DVector<uint8_t>& p_a,const DVector<uint8_t>& p_b) {
+
+	if (p_a.size()!=p_b.size())
+		return false;
+	DVector<uint8_t>::Read ra=p_a.read();
+	DVector<uint8_t>::Read rb=p_b.read();
+	return memcmp(ra.ptr(),rb.ptr(),p_a.size())==0;
+}
+
+static bool _check_resize(int p_sw,int p_sh,int p_dw,int p_dh,Image::Format p_format,Image::Interpolation p_interp) {
+
+	Image src=_make_image(p_sw,p_sh,p_format);
+	Image dst=src;
+	dst.resize(p_dw,p_dh,p_interp);
+
+	int ps=Image::get_format_pixel_size(p_format);
+	DVector<uint8_t> ref;
+	ref.resize(p_dw*p_dh*ps);
+	{
+		DVector<uint8_t> sd=src.get_data();
+		DVector<uint8_t>::Read r=sd.read();
+		DVector<uint8_t>::Write w=ref.write();
+		if (p_interp==Image::INTERPOLATE_CUBIC)
+			_ref_scale_cubic(r.ptr(),w.ptr(),ps,p_sw,p_sh,p_dw,p_dh);
+		else
+			_ref_scale_bilinear(r.ptr(),w.ptr(),ps,p_sw,p_sh,p_dw,p_dh);
+	}
+
+	bool ok=_same_data(dst.get_data(),ref);
+	if (!ok)
+		print_line("resize mismatch: "+itos(p_sw)+"x"+itos(p_sh)+" -> "+itos(p_dw)+"x"+itos(p_dh)+" format "+itos(p_format)+" interp "+itos(p_interp));
+	return ok;
+}
+
+static bool _check_mipmaps(int p_size,Image::Format p_format) {
+
+	Image img=_make_image(p_size,p_size,p_format);
+	DVector<uint8_t> base=img.get_data();
+	img.generate_mipmaps();
+
+	int ps=Image::get_format_pixel_size(p_format);
+	DVector<uint8_t> data=img.get_data();
+	DVector<uint8_t>::Read r=data.read();
+
+	int prev_ofs=0;
+	int prev_w=p_size;
+	for(int m=1;m<img.get_mipmaps();m++) {
+
+		int ofs=img.get_mipmap_offset(m);
+		int w=prev_w>>1;
+		for(int i=0;i<w;i++) {
+			for(int j=0;j<w;j++) {
+				for(int c=0;c<ps;c++) {
+					const uint8_t *s=&r[prev_ofs+((i*2)*prev_w+j*2)*ps+c];
+					int val=(int(s[0])+s[ps]+s[prev_w*ps]+s[prev_w*ps+ps])>>2;
+					if (r[ofs+(i*w+j)*ps+c]!=val) {
+						print_line("mipmap mismatch at level "+itos(m)+" format "+itos(p_format));
+						return false;
+					}
+				}
+			}
+		}
+		prev_ofs=ofs;
+		prev_w=w;
+	}
+	return true;
+}
+
+static void _report(const String& p_name,uint64_t p_usec,int64_t p_pixels) {
+
+	print_line(p_name+": "+rtos(p_usec/1000.0)+"ms, "+rtos(p_usec ? double(p_pixels)/p_usec : 0)+" MPix/s");
+}
+
+static Image _tile_image(const Image& p_tile,int p_count) {
+
+	int tw=p_tile.get_width();
+	int th=p_tile.get_height();
+	int ps=Image::get_format_pixel_size(p_tile.get_format());
+	int w=tw*p_count;
+
+	DVector<uint8_t> data;
+	data.resize(w*th*p_count*ps);
+	{
+		DVector<uint8_t> tile=p_tile.get_data();
+		DVector<uint8_t>::Read r=tile.read();
+		DVector<uint8_t>::Write wr=data.write();
+		for(int i=0;i<th*p_count;i++) {
+			for(int j=0;j<p_count;j++) {
+				memcpy(&wr[(i*w+j*tw)*ps],&r[(i%th)*tw*ps],tw*ps);
+			}
+		}
+	}
+
+	return Image(w,th*p_count,0,p_tile.get_format(),data);
+}
+
+/* compressing a tiled image must give the tiled blocks of compressing one tile,
+   no matter how block rows were split between threads */
+static bool _check_compress(Image::CompressMode p_mode,Image::Format p_format,Image::CompressQuality p_quality) {
+
+	const int tile_size=64;
+	const int count=16;
+
+	Image tile=_make_image(tile_size,tile_size,p_format);
+	Image big=_tile_image(tile,count);
+
+	if (tile.compress(p_mode,p_quality)!=OK || big.compress(p_mode,p_quality)!=OK)
+		return false;
+
+	// only level 0 is compared, ETC always generates mipmaps
+	int tile_blocks=(tile_size/4)*(tile_size/4);
+	int tile_len=tile.get_mipmaps() ? tile.get_mipmap_offset(1) : tile.get_data().size();
+	int block_len=tile_len/tile_blocks;
+	int row_blocks=tile_size/4*count;
+
+	DVector<uint8_t> td=tile.get_data();
+	DVector<uint8_t> bd=big.get_data();
+	DVector<uint8_t>::Read tr=td.read();
+	DVector<uint8_t>::Read br=bd.read();
+
+	for(int by=0;by<row_blocks;by++) {
+		for(int bx=0;bx<row_blocks;bx++) {
+
+			const uint8_t *a=&br[(by*row_blocks+bx)*block_len];
+			const uint8_t *b=&tr[((by%(tile_size/4))*(tile_size/4)+bx%(tile_size/4))*block_len];
+			if (memcmp(a,b,block_len)!=0) {
+				print_line("compress mismatch at block "+itos(bx)+","+itos(by));
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/* non square mipmaps reach 1 pixel on the short side first, every level must
+   still come out as compressing it alone would */
+static bool _check_compress_mipmaps(Image::CompressMode p_mode,int p_width,int p_height) {
+
+	Image src=_make_image(p_width,p_height,Image::FORMAT_RGB);
+	src.generate_mipmaps();
+	int mipmaps=src.get_mipmaps();
+
+	Image img=src;
+	if (img.compress(p_mode)!=OK || img.get_mipmaps()!=mipmaps)
+		return false;
+	if (img.get_data().size()!=Image::get_image_data_size(p_width,p_height,img.get_format(),mipmaps))
+		return false;
+
+	DVector<uint8_t> sd=src.get_data();
+	DVector<uint8_t> cd=img.get_data();
+	DVector<uint8_t>::Read sr=sd.read();
+	DVector<uint8_t>::Read cr=cd.read();
+
+	for(int i=0;i<=mipmaps;i++) {
+
+		int w=MAX(1,p_width>>i);
+		int h=MAX(1,p_height>>i);
+		if (w<4 || h<4)
+			break; // can't be compressed alone
+
+		DVector<uint8_t> ld;
+		ld.resize(w*h*3);
+		memcpy(ld.write().ptr(),&sr[src.get_mipmap_offset(i)],w*h*3);
+		Image level(w,h,0,Image::FORMAT_RGB,ld);
+		if (level.compress(p_mode)!=OK)
+			return false;
+
+		int len=level.get_mipmaps() ? level.get_mipmap_offset(1) : level.get_data().size();
+		if (memcmp(level.get_data().read().ptr(),&cr[img.get_mipmap_offset(i)],len)!=0) {
+			print_line("compress mismatch at mipmap "+itos(i)+" of "+itos(p_width)+"x"+itos(p_height));
+			return false;
+		}
+	}
+	return true;
+}
+
+static void _benchmark_compress(const String& p_name,Image::CompressMode p_mode,Image::Format p_format,Image::CompressQuality p_quality,int p_size) {
+
+	Image img=_make_image(p_size,p_size,p_format);
+	if (p_mode==Image::COMPRESS_ETC)
+		img.generate_mipmaps(); // so only block encoding is timed
+	uint64_t t=OS::get_singleton()->get_ticks_usec();
+	img.compress(p_mode,p_quality);
+	t=OS::get_singleton()->get_ticks_usec()-t;
+	int64_t blocks=int64_t(p_size/4)*(p_size/4)*4/3; // with mipmaps
+	print_line(p_name+" "+itos(p_size)+": "+rtos(t/1000.0)+"ms, "+rtos(t ? double(blocks)/t : 0)+" MBlocks/s");
+}
+
+static void _test_image_compress(int p_bench_size) {
+
+	Image probe=_make_image(4,4,Image::FORMAT_RGB);
+	bool have_bc=probe.compressed(Image::COMPRESS_BC).get_format()!=Image::FORMAT_RGB;
+	bool have_etc=probe.compressed(Image::COMPRESS_ETC).get_format()!=Image::FORMAT_RGB;
+
+	if (!have_bc && !have_etc) {
+		print_line("image compress: no compressors registered, skipped");
+		return;
+	}
+
+	bool ok=true;
+	if (have_bc) {
+		ok = _check_compress(Image::COMPRESS_BC,Image::FORMAT_RGB,Image::COMPRESS_QUALITY_FAST) && ok;
+		ok = _check_compress(Image::COMPRESS_BC,Image::FORMAT_RGBA,Image::COMPRESS_QUALITY_NORMAL) && ok;
+		ok = _check_compress_mipmaps(Image::COMPRESS_BC,64,256) && ok;
+		ok = _check_compress_mipmaps(Image::COMPRESS_BC,512,32) && ok;
+	}
+	if (have_etc) {
+		ok = _check_compress(Image::COMPRESS_ETC,Image::FORMAT_RGB,Image::COMPRESS_QUALITY_FAST) && ok;
+		ok = _check_compress_mipmaps(Image::COMPRESS_ETC,64,256) && ok;
+	}
+	print_line(String("image compress: ")+(ok?"OK":"FAIL"));
+
+	// same size for every encoder, so the timings compare directly
+	if (have_bc) {
+		_benchmark_compress("compress BC1 fast",Image::COMPRESS_BC,Image::FORMAT_RGB,Image::COMPRESS_QUALITY_FAST,p_bench_size);
+		_benchmark_compress("compress BC3 fast",Image::COMPRESS_BC,Image::FORMAT_RGBA,Image::COMPRESS_QUALITY_FAST,p_bench_size);
+		_benchmark_compress("compress BC1 normal",Image::COMPRESS_BC,Image::FORMAT_RGB,Image::COMPRESS_QUALITY_NORMAL,p_bench_size);
+		_benchmark_compress("compress BC1 high",Image::COMPRESS_BC,Image::FORMAT_RGB,Image::COMPRESS_QUALITY_HIGH,p_bench_size);
+	}
+	if (have_etc) {
+		_benchmark_compress("compress ETC1 fast",Image::COMPRESS_ETC,Image::FORMAT_RGB,Image::COMPRESS_QUALITY_FAST,p_bench_size);
+		_benchmark_compress("compress ETC1 normal",Image::COMPRESS_ETC,Image::FORMAT_RGB,Image::COMPRESS_QUALITY_NORMAL,p_bench_size);
+	}
+}
+
+static void _test_image_ops() {
+
+	bool ok=true;
+
+	ok = _check_resize(123,77,301,211,Image::FORMAT_RGBA,Image::INTERPOLATE_BILINEAR) && ok;
+	ok = _check_resize(640,480,97,53,Image::FORMAT_RGBA,Image::INTERPOLATE_BILINEAR) && ok;
+	ok = _check_resize(123,77,301,211,Image::FORMAT_RGB,Image::INTERPOLATE_BILINEAR) && ok;
+	ok = _check_resize(333,200,160,120,Image::FORMAT_GRAYSCALE_ALPHA,Image::INTERPOLATE_BILINEAR) && ok;
+	ok = _check_resize(123,77,301,211,Image::FORMAT_RGBA,Image::INTERPOLATE_CUBIC) && ok;
+	ok = _check_resize(640,480,97,53,Image::FORMAT_RGBA,Image::INTERPOLATE_CUBIC) && ok;
+	ok = _check_resize(123,77,64,301,Image::FORMAT_GRAYSCALE,Image::INTERPOLATE_CUBIC) && ok;
+	ok = _check_mipmaps(256,Image::FORMAT_RGBA) && ok;
+	ok = _check_mipmaps(128,Image::FORMAT_RGB) && ok;
+
+	{
+		Image rgba=_make_image(67,45,Image::FORMAT_RGBA);
+		Image rgb=rgba;
+		rgb.convert(Image::FORMAT_RGB);
+		Image back=rgb;
+		back.convert(Image::FORMAT_RGBA);
+		Color a=rgba.get_pixel(13,29);
+		Color b=back.get_pixel(13,29);
+		ok = ok && a.r==b.r && a.g==b.g && a.b==b.b && b.a==1.0;
+
+		Image pm=rgba;
+		pm.premultiply_alpha();
+		Color p=pm.get_pixel(13,29);
+		ok = ok && int(p.r*255+0.5)==((int(a.r*255+0.5)*int(a.a*255+0.5))>>8);
+	}
+
+	print_line(String("image ops: ")+(ok?"OK":"FAIL"));
+
+	WorkerThreadPool *pool=WorkerThreadPool::get_singleton();
+	print_line("image benchmark, threads: "+itos(pool?pool->get_thread_count():1));
+
+	const int size=4096;
+	Image src=_make_image(size,size,Image::FORMAT_RGBA);
+
+	uint64_t t;
+	{
+		Image img=src;
+		t=OS::get_singleton()->get_ticks_usec();
+		img.resize(size/2,size/2+7,Image::INTERPOLATE_BILINEAR);
+		_report("resize bilinear 4096->2048",OS::get_singleton()->get_ticks_usec()-t,int64_t(size/2)*(size/2+7));
+	}
+	{
+		Image img=src;
+		t=OS::get_singleton()->get_ticks_usec();
+		img.resize(size+size/2,size+size/2,Image::INTERPOLATE_BILINEAR);
+		_report("resize bilinear 4096->6144",OS::get_singleton()->get_ticks_usec()-t,int64_t(size+size/2)*(size+size/2));
+	}
+	{
+		Image img=src;
+		t=OS::get_singleton()->get_ticks_usec();
+		img.resize(size/2,size/2+7,Image::INTERPOLATE_CUBIC);
+		_report("resize cubic 4096->2048",OS::get_singleton()->get_ticks_usec()-t,int64_t(size/2)*(size/2+7));
+	}
+	{
+		Image img=src;
+		t=OS::get_singleton()->get_ticks_usec();
+		img.generate_mipmaps();
+		_report("generate_mipmaps 4096",OS::get_singleton()->get_ticks_usec()-t,int64_t(size)*size/3);
+	}
+	{
+		Image img=_make_image(size-1,size-1,Image::FORMAT_RGBA);
+		t=OS::get_singleton()->get_ticks_usec();
+		img.generate_mipmaps();
+		_report("generate_mipmaps 4095 (non po2)",OS::get_singleton()->get_ticks_usec()-t,int64_t(size)*size/3);
+	}
+	{
+		Image img=src;
+		t=OS::get_singleton()->get_ticks_usec();
+		img.convert(Image::FORMAT_RGB);
+		_report("convert RGBA->RGB",OS::get_singleton()->get_ticks_usec()-t,int64_t(size)*size);
+		t=OS::get_singleton()->get_ticks_usec();
+		img.convert(Image::FORMAT_RGBA);
+		_report("convert RGB->RGBA",OS::get_singleton()->get_ticks_usec()-t,int64_t(size)*size);
+		t=OS::get_singleton()->get_ticks_usec();
+		img.convert(Image::FORMAT_GRAYSCALE_ALPHA);
+		_report("convert RGBA->GrayscaleAlpha",OS::get_singleton()->get_ticks_usec()-t,int64_t(size)*size);
+	}
+	{
+		Image img=_make_image(size,size,Image::FORMAT_RGBA); // not shared, so no copy on write is timed
+		t=OS::get_singleton()->get_ticks_usec();
+		img.premultiply_alpha();
+		_report("premultiply_alpha",OS::get_singleton()->get_ticks_usec()-t,int64_t(size)*size);
+		t=OS::get_singleton()->get_ticks_usec();
+		img.srgb_to_linear();
+		_report("srgb_to_linear",OS::get_singleton()->get_ticks_usec()-t,int64_t(size)*size);
+	}
+}
+
 
 class TestMainLoop : public MainLoop {
 
@@ -65,10 +499,18 @@ public:
 
 MainLoop* test() {
 
-	Image img;
-	ImageLoader::load_image("as1.png",&img);
+	// the slow encoders take minutes at 4096, pass the size as last argument to change it
+	int compress_size=1024;
+	List<String> cmdlargs = OS::get_singleton()->get_cmdline_args();
+	if (!cmdlargs.empty() && cmdlargs.back()->get().is_valid_integer())
+		compress_size=MAX(cmdlargs.back()->get().to_int()&~3,4);
+
+	_test_image_ops();
+	_test_image_compress(compress_size);
 
-	img.resize(512,512);
+	Image img;
+	if (ImageLoader::load_image("as1.png",&img)==OK)
+		img.resize(512,512);
 
 	return memnew( TestMainLoop );
 
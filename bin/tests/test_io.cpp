@@ -28,6 +28,137 @@
 /*************************************************************************/
 #include "test_io.h"
 
+#include "os/os.h"
+#include "os/file_access.h"
+#include "os/dir_access.h"
+#include "io/file_access_pack.h"
+#include "io/pck_packer.h"
+#include "print_string.h"
+
+#ifdef UNIX_ENABLED
+#include "drivers/unix/file_access_unix.h"
+#endif
+
+namespace TestIO {
+
+static uint8_t _pack_byte(int p_file,int p_ofs) {
+
+	return uint8_t((p_file*131+p_ofs*7)^(p_ofs>>9));
+}
+
+static void _test_pack_reads() {
+
+	// packs a few big files and many small ones, then reads them back through
+	// PackedData. packs are mapped when the platform allows it, so the first pass
+	// shows cold cost (page faults) and the second one the warm, copy free path.
+
+	const int big_count=16;
+	const int big_size=8*1024*1024;
+	const int small_count=2048;
+	const int small_size=2048;
+
+	DirAccess *da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	String dir = da->get_current_dir().plus_file("pack_test");
+	da->make_dir_recursive(dir);
+
+	Vector<uint8_t> buf;
+	buf.resize(big_size);
+
+	Ref<PCKPacker> packer = memnew( PCKPacker );
+	String pack_path = dir.plus_file("test.pck");
+	packer->pck_start(pack_path,0);
+
+	for(int i=0;i<big_count+small_count;i++) {
+
+		int size = i<big_count ? big_size : small_size;
+		for(int j=0;j<size;j++)
+			buf[j]=_pack_byte(i,j);
+
+		String src = dir.plus_file(itos(i)+".bin");
+		FileAccess *f = FileAccess::open(src,FileAccess::WRITE);
+		f->store_buffer(buf.ptr(),size);
+		memdelete(f);
+		packer->add_file("res://pack_test/"+itos(i)+".bin",src);
+	}
+	packer->flush();
+	packer=Ref<PCKPacker>();
+
+	for(int i=0;i<big_count+small_count;i++)
+		da->remove(dir.plus_file(itos(i)+".bin"));
+
+	PackedData *packed = PackedData::get_singleton();
+	bool own_packed = !packed;
+	if (own_packed)
+		packed = memnew( PackedData );
+
+	bool ok = true;
+	bool map_packs = packed->is_map_packs_enabled();
+#ifdef UNIX_ENABLED
+	bool map_reads = FileAccessUnix::is_map_reads_enabled();
+#endif
+
+	// stdio first, then mapped. the pack is added again so the new mode applies
+	for(int mode=0;mode<2 && ok;mode++) {
+
+		packed->set_map_packs(mode==1);
+#ifdef UNIX_ENABLED
+		FileAccessUnix::set_map_reads(mode==1);
+#endif
+		Error err = packed->add_pack(pack_path);
+		if (err!=OK) {
+			print_line("pack reads: can't open "+pack_path);
+			ok=false;
+		}
+
+		for(int pass=0;pass<2 && ok;pass++) {
+
+			uint64_t t=OS::get_singleton()->get_ticks_usec();
+			for(int i=0;i<big_count && ok;i++) {
+
+				FileAccess *f = packed->try_open_path("res://pack_test/"+itos(i)+".bin");
+				ok = f && f->get_len()==(size_t)big_size && f->get_buffer(buf.ptr(),big_size)==big_size;
+				for(int j=0;j<big_size && ok;j+=4093)
+					ok = buf[j]==_pack_byte(i,j);
+				if (f)
+					memdelete(f);
+			}
+			uint64_t big_usec=OS::get_singleton()->get_ticks_usec()-t;
+
+			t=OS::get_singleton()->get_ticks_usec();
+			for(int i=big_count;i<big_count+small_count && ok;i++) {
+
+				FileAccess *f = packed->try_open_path("res://pack_test/"+itos(i)+".bin");
+				ok = f!=NULL;
+				for(int j=0;j<small_size && ok;j+=4) {
+					uint32_t v=f->get_32();
+					ok = v==(_pack_byte(i,j)|(_pack_byte(i,j+1)<<8)|(_pack_byte(i,j+2)<<16)|(uint32_t(_pack_byte(i,j+3))<<24));
+				}
+				ok = ok && !f->eof_reached();
+				if (f)
+					memdelete(f);
+			}
+			uint64_t small_usec=OS::get_singleton()->get_ticks_usec()-t;
+
+			print_line(String(mode==0?"stdio":"mapped")+", "+String(pass==0?"first":"second")+" pass pack reads: "+itos(big_count)+"x"+itos(big_size>>20)+"MB get_buffer "+rtos(big_usec/1000.0)+"ms, "+itos(small_count)+"x"+itos(small_size)+"B get_32 "+rtos(small_usec/1000.0)+"ms");
+		}
+	}
+
+	packed->set_map_packs(map_packs);
+#ifdef UNIX_ENABLED
+	FileAccessUnix::set_map_reads(map_reads);
+#endif
+
+	print_line(String("pack reads: ")+(ok?"OK":"FAIL"));
+
+	if (own_packed)
+		memdelete(packed);
+	da->remove(pack_path);
+	da->remove(dir);
+	memdelete(da);
+}
+
+}
+
 #ifdef MINIZIP_ENABLED
 
 
@@ -84,6 +215,7 @@ public:
 MainLoop* test() {
 
 	print_line("this is test io");
+	_test_pack_reads();
 	DirAccess* da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
 	da->change_dir(".");
 	print_line("Opening current dir "+ da->get_current_dir());
@@ -200,6 +332,7 @@ namespace TestIO {
 
 MainLoop* test() {
 
+	_test_pack_reads();
 	return NULL;
 }
 
@@ -47,6 +47,11 @@
 #include "test_shader_lang.h"
 #include "test_gdscript.h"
 #include "test_image.h"
+#include "test_rid.h"
+#include "test_string_name.h"
+#include "test_object.h"
+#include "test_threads.h"
+#include "test_scene.h"
 
 
 const char ** tests_get_names()  {
@@ -62,6 +67,12 @@ const char ** tests_get_names()  {
 		"io",
 		"shaderlang",
 		"physics",
+		"rid",
+		"string_name",
+		"object",
+		"threads",
+		"scene",
+		"gd_bench",
 		NULL
 	};
 
@@ -158,11 +169,41 @@ MainLoop* test_main(String p_test,const List<String>& p_args) {
 		return TestGDScript::test(TestGDScript::TEST_BYTECODE);
 	}
 
+	if (p_test=="gd_bench") {
+
+		return TestGDScript::test(TestGDScript::TEST_BENCHMARK);
+	}
+
 	if (p_test=="image") {
 
 		return TestImage::test();
 	}
 
+	if (p_test=="rid") {
+
+		return TestRID::test();
+	}
+
+	if (p_test=="string_name") {
+
+		return TestStringName::test();
+	}
+
+	if (p_test=="object") {
+
+		return TestObject::test();
+	}
+
+	if (p_test=="threads") {
+
+		return TestThreads::test();
+	}
+
+	if (p_test=="scene") {
+
+		return TestScene::test();
+	}
+
 	if (p_test=="detailer") {
 
 		return TestMultiMesh::test();
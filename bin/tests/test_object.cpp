@@ -0,0 +1,300 @@
+/*************************************************************************/
+/*  test_object.cpp                                                      */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2016 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "test_object.h"
+#include "object.h"
+#include "object_type_db.h"
+#include "message_queue.h"
+#include "os/os.h"
+#include "os/thread.h"
+#include "print_string.h"
+
+namespace TestObject {
+
+class SignalReceiver : public Object {
+
+	OBJ_TYPE(SignalReceiver,Object);
+protected:
+
+	static void _bind_methods() {
+
+		ObjectTypeDB::bind_method(_MD("_on_signal","value"),&SignalReceiver::_on_signal);
+		ObjectTypeDB::bind_method(_MD("_on_signal_bound","value","bound"),&SignalReceiver::_on_signal_bound);
+	}
+public:
+
+	int count;
+
+	void _on_signal(int p_value) { count+=p_value; }
+	void _on_signal_bound(int p_value,int p_bound) { count+=p_value+p_bound; }
+
+	SignalReceiver() { count=0; }
+};
+
+class DeferredReceiver : public Object {
+
+	OBJ_TYPE(DeferredReceiver,Object);
+protected:
+
+	static void _bind_methods() {
+
+		ObjectTypeDB::bind_method(_MD("_on_message","producer","seq"),&DeferredReceiver::_on_message);
+	}
+public:
+
+	enum { MAX_PRODUCERS=8 };
+
+	int next[MAX_PRODUCERS];
+	int received;
+	bool in_order;
+
+	void _on_message(int p_producer,int p_seq) {
+
+		if (p_producer<0 || p_producer>=MAX_PRODUCERS || next[p_producer]!=p_seq)
+			in_order=false;
+		else
+			next[p_producer]++;
+		received++;
+	}
+
+	DeferredReceiver() { for(int i=0;i<MAX_PRODUCERS;i++) next[i]=0; received=0; in_order=true; }
+};
+
+struct DeferredProducer {
+
+	DeferredReceiver *receiver;
+	int index;
+	int count;
+	int failed;
+};
+
+static void _deferred_producer_thread(void *p_ud) {
+
+	DeferredProducer *p = (DeferredProducer*)p_ud;
+	StringName method="_on_message";
+	for(int i=0;i<p->count;i++) {
+		if (MessageQueue::get_singleton()->push_call(p->receiver,method,p->index,i)!=OK)
+			p->failed++;
+	}
+}
+
+static bool _test_message_queue(int p_producers,int p_messages) {
+
+	DeferredReceiver *r = memnew( DeferredReceiver );
+	DeferredProducer producers[DeferredReceiver::MAX_PRODUCERS];
+	Thread *threads[DeferredReceiver::MAX_PRODUCERS];
+
+	uint64_t t = OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<p_producers;i++) {
+		producers[i].receiver=r;
+		producers[i].index=i;
+		producers[i].count=p_messages;
+		producers[i].failed=0;
+		threads[i]=Thread::create(_deferred_producer_thread,&producers[i]);
+	}
+
+	const int total=p_producers*p_messages;
+	int flushes=0;
+	// flush while the producers are still pushing, like the main loop would
+	while(r->received<total) {
+		MessageQueue::get_singleton()->flush();
+		flushes++;
+		if (flushes>total+1000)
+			break;
+	}
+
+	uint64_t elapsed = OS::get_singleton()->get_ticks_usec()-t;
+
+	int failed=0;
+	for(int i=0;i<p_producers;i++) {
+		Thread::wait_to_finish(threads[i]);
+		memdelete(threads[i]);
+		failed+=producers[i].failed;
+	}
+	MessageQueue::get_singleton()->flush();
+
+	bool ok = r->in_order && r->received==total && failed==0;
+	for(int i=0;i<p_producers;i++) {
+		if (r->next[i]!=p_messages)
+			ok=false;
+	}
+
+	print_line("MessageQueue: "+itos(p_producers)+" producer(s), "+itos(total)+" deferred calls in "+itos(elapsed/1000)+"ms, "+rtos(double(elapsed)*1000.0/total)+"ns/call, "+itos(flushes)+" flushes, "+itos(MessageQueue::get_singleton()->get_page_count())+" pages, high water "+itos(MessageQueue::get_singleton()->get_max_buffer_usage()/1024)+"KB: "+String(ok?"PASS":"FAILED"));
+
+	memdelete(r);
+	return ok;
+}
+
+static void _bench_signal(int p_connections,bool p_binds) {
+
+	Object *emitter = memnew( Object );
+	emitter->add_user_signal(MethodInfo("bench",PropertyInfo(Variant::INT,"value")));
+
+	Vector<SignalReceiver*> receivers;
+	for(int i=0;i<p_connections;i++) {
+
+		SignalReceiver *r = memnew( SignalReceiver );
+		receivers.push_back(r);
+		if (p_binds) {
+			Vector<Variant> binds;
+			binds.push_back(i);
+			emitter->connect("bench",r,"_on_signal_bound",binds);
+		} else {
+			emitter->connect("bench",r,"_on_signal");
+		}
+	}
+
+	const int emits = p_connections ? 1000000/p_connections : 1000000;
+	StringName signal="bench";
+	Variant arg=1;
+
+	uint64_t t = OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<emits;i++) {
+		emitter->emit_signal(signal,arg);
+	}
+
+	uint64_t elapsed = OS::get_singleton()->get_ticks_usec()-t;
+
+	int total=0;
+	for(int i=0;i<receivers.size();i++) {
+		total+=receivers[i]->count;
+		memdelete(receivers[i]);
+	}
+	memdelete(emitter);
+
+	print_line(itos(p_connections)+" connection(s)"+String(p_binds?" with binds":"")+": "+itos(emits)+" emits in "+itos(elapsed/1000)+"ms, "+rtos(double(elapsed)*1000.0/emits)+"ns/emit (received "+itos(total)+")");
+}
+
+static bool _test_oneshot() {
+
+	Object *emitter = memnew( Object );
+	emitter->add_user_signal(MethodInfo("bench",PropertyInfo(Variant::INT,"value")));
+	SignalReceiver *once = memnew( SignalReceiver );
+	SignalReceiver *always = memnew( SignalReceiver );
+	emitter->connect("bench",once,"_on_signal",Vector<Variant>(),Object::CONNECT_ONESHOT);
+	emitter->connect("bench",always,"_on_signal");
+
+	emitter->emit_signal("bench",1);
+	emitter->emit_signal("bench",1);
+
+	bool ok = once->count==1 && always->count==2 && !emitter->is_connected("bench",once,"_on_signal");
+
+	memdelete(once);
+	memdelete(always);
+	memdelete(emitter);
+	return ok;
+}
+
+static void _bench_call() {
+
+	SignalReceiver *r = memnew( SignalReceiver );
+	StringName method="_on_signal";
+	Variant arg=1;
+	const Variant *args[1]={&arg};
+	const int calls=1000000;
+
+	uint64_t hits=ObjectTypeDB::get_method_cache_hits();
+	uint64_t misses=ObjectTypeDB::get_method_cache_misses();
+	uint64_t t = OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<calls;i++) {
+		Variant::CallError ce;
+		r->call(method,args,1,ce);
+	}
+
+	uint64_t elapsed = OS::get_singleton()->get_ticks_usec()-t;
+	hits=ObjectTypeDB::get_method_cache_hits()-hits;
+	misses=ObjectTypeDB::get_method_cache_misses()-misses;
+
+	print_line("Object::call: "+itos(calls)+" calls in "+itos(elapsed/1000)+"ms, "+rtos(double(elapsed)*1000.0/calls)+"ns/call, method cache "+itos(hits)+" hits, "+itos(misses)+" misses (received "+itos(r->count)+")");
+	memdelete(r);
+}
+
+static void _method_lookup_thread(void *p_ud) {
+
+	StringName method="_on_signal";
+	StringName type="SignalReceiver";
+	for(int i=0;i<100000;i++)
+		ObjectTypeDB::get_method(type,method);
+}
+
+static bool _test_method_cache_counts() {
+
+	// lookups from several threads at once must all be counted
+	const int thread_count=4;
+	uint64_t before=ObjectTypeDB::get_method_cache_hits()+ObjectTypeDB::get_method_cache_misses();
+
+	Thread *threads[thread_count];
+	for(int i=0;i<thread_count;i++)
+		threads[i]=Thread::create(_method_lookup_thread,NULL);
+	for(int i=0;i<thread_count;i++) {
+		Thread::wait_to_finish(threads[i]);
+		memdelete(threads[i]);
+	}
+
+	uint64_t after=ObjectTypeDB::get_method_cache_hits()+ObjectTypeDB::get_method_cache_misses();
+	return after-before==uint64_t(thread_count)*100000;
+}
+
+MainLoop* test() {
+
+	ObjectTypeDB::register_type<SignalReceiver>();
+	ObjectTypeDB::register_type<DeferredReceiver>();
+
+	print_line("Oneshot check: "+String(_test_oneshot()?"PASS":"FAILED"));
+	print_line("Method cache counts: "+String(_test_method_cache_counts()?"PASS":"FAILED"));
+
+	int counts[4]={0,1,8,64};
+
+	for(int i=0;i<4;i++) {
+		_bench_signal(counts[i],false);
+	}
+	for(int i=1;i<4;i++) {
+		_bench_signal(counts[i],true);
+	}
+
+	_bench_call();
+
+	MessageQueue *own_queue=NULL;
+	if (!MessageQueue::get_singleton())
+		own_queue = memnew( MessageQueue );
+
+	int producers[4]={1,2,4,8};
+	for(int i=0;i<4;i++) {
+		_test_message_queue(producers[i],250000);
+	}
+
+	if (own_queue)
+		memdelete(own_queue);
+
+	return NULL;
+}
+
+}
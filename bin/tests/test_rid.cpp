@@ -0,0 +1,146 @@
+/*************************************************************************/
+/*  test_rid.cpp                                                         */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2016 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "test_rid.h"
+#include "rid.h"
+#include "os/os.h"
+#include "print_string.h"
+#include "math_funcs.h"
+
+namespace TestRID {
+
+struct Dummy {
+
+	int value;
+};
+
+template<class O>
+static void _bench_owner(const char *p_name,int p_count) {
+
+	O owner;
+	Vector<RID> rids;
+	rids.resize(p_count);
+
+	Dummy *dummies = memnew_arr(Dummy,p_count);
+
+	uint64_t t = OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<p_count;i++) {
+		dummies[i].value=i;
+		rids[i]=owner.make_rid(&dummies[i]);
+	}
+
+	uint64_t make_time = OS::get_singleton()->get_ticks_usec()-t;
+
+	// shuffle, so lookups don't happen in allocation order
+	for(int i=p_count-1;i>0;i--) {
+		int j=Math::rand()%(i+1);
+		SWAP(rids[i],rids[j]);
+	}
+
+	const int passes=20;
+	int checksum=0;
+	t = OS::get_singleton()->get_ticks_usec();
+
+	for(int p=0;p<passes;p++) {
+		for(int i=0;i<p_count;i++) {
+			checksum+=owner.get(rids[i])->value;
+		}
+	}
+
+	uint64_t get_time = OS::get_singleton()->get_ticks_usec()-t;
+
+	t = OS::get_singleton()->get_ticks_usec();
+
+	List<RID> owned;
+	owner.get_owned_list(&owned);
+	for(List<RID>::Element *E=owned.front();E;E=E->next()) {
+		checksum+=owner.get(E->get())->value;
+	}
+
+	uint64_t iter_time = OS::get_singleton()->get_ticks_usec()-t;
+
+	t = OS::get_singleton()->get_ticks_usec();
+
+	// churn: free half and reallocate it
+	for(int i=0;i<p_count;i+=2) {
+		owner.free(rids[i]);
+	}
+	for(int i=0;i<p_count;i+=2) {
+		rids[i]=owner.make_rid(&dummies[i]);
+	}
+
+	uint64_t churn_time = OS::get_singleton()->get_ticks_usec()-t;
+
+	for(int i=0;i<p_count;i++) {
+		owner.free(rids[i]);
+	}
+
+	memdelete_arr(dummies);
+
+	print_line(String(p_name)+" ("+itos(p_count)+" rids): make "+itos(make_time)+"us, get x"+itos(passes)+" "+itos(get_time)+"us, list+get "+itos(iter_time)+"us, free/make half "+itos(churn_time)+"us (checksum "+itos(checksum)+")");
+}
+
+static bool _test_stale() {
+
+	RID_Owner<Dummy> owner;
+	Dummy a,b;
+
+	RID ra = owner.make_rid(&a);
+	owner.free(ra);
+	RID rb = owner.make_rid(&b);
+
+	// the slot is reused, but the old RID must not resolve to the new object
+	if (owner.owns(ra) || !owner.owns(rb) || owner.get(rb)!=&b)
+		return false;
+
+	List<RID> owned;
+	owner.get_owned_list(&owned);
+	owner.free(rb);
+
+	return owned.size()==1 && owned.front()->get()==rb && owner.get_rid_count()==0;
+}
+
+MainLoop* test() {
+
+	print_line("Stale RID check: "+String(_test_stale()?"PASS":"FAILED"));
+
+	int counts[3]={1000,100000,1000000};
+
+	for(int i=0;i<3;i++) {
+
+		_bench_owner< RID_Owner<Dummy> >("RID_Owner",counts[i]);
+		_bench_owner< RID_HashOwner<Dummy> >("RID_HashOwner",counts[i]);
+		_bench_owner< RID_Owner<Dummy,true> >("RID_Owner (thread safe)",counts[i]);
+		_bench_owner< RID_HashOwner<Dummy,true> >("RID_HashOwner (thread safe)",counts[i]);
+	}
+
+	return NULL;
+}
+
+}
@@ -0,0 +1,999 @@
+/*************************************************************************/
+/*  test_scene.cpp                                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2016 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "test_scene.h"
+#include "scene/main/scene_main_loop.h"
+#include "scene/main/node.h"
+#include "scene/main/viewport.h"
+#include "scene/main/timer.h"
+#include "scene/2d/node_2d.h"
+#include "scene/2d/sprite.h"
+#include "scene/resources/packed_scene.h"
+#include "message_queue.h"
+#include "os/os.h"
+#include "os/thread.h"
+#include "os/worker_thread_pool.h"
+#include "print_string.h"
+
+#ifdef GDSCRIPT_ENABLED
+#include "modules/gdscript/gd_script.h"
+#endif
+
+namespace TestScene {
+
+/* Threaded process */
+
+class ProcessAgent : public Node {
+
+	OBJ_TYPE(ProcessAgent,Node);
+
+public:
+
+	Vector3 pos;
+	Vector3 vel;
+	Vector3 target;
+	int steps;
+	int frames;
+
+	bool spawn_child; // tries to change the tree from its process callback
+	bool tree_unchanged;
+	Node *doomed; // freed from the process callback, along with spawning
+
+	void _notification(int p_what) {
+
+		if (p_what!=NOTIFICATION_PROCESS)
+			return;
+
+		// some independent steering work
+		for(int i=0;i<steps;i++) {
+
+			Vector3 to=target-pos;
+			float len=to.length();
+			if (len<0.5) {
+				target=Vector3(-target.z,target.x*0.5,target.y+1.0);
+				continue;
+			}
+			vel=vel.linear_interpolate(to/len*4.0,0.1);
+			pos+=vel*(1.0/60.0);
+		}
+		frames++;
+
+		if (spawn_child) {
+			int count=get_child_count();
+			StringName name=get_name();
+			add_child(memnew(Node));
+			set_name(String(name)+"Renamed");
+			set_process(false);
+			if (doomed)
+				doomed->call("free");
+			tree_unchanged = tree_unchanged && get_child_count()==count && is_processing() && get_name()==name;
+		}
+	}
+
+	ProcessAgent() {
+		steps=32;
+		frames=0;
+		spawn_child=false;
+		tree_unchanged=true;
+		doomed=NULL;
+	}
+};
+
+class ProcessObserver : public Node {
+
+	OBJ_TYPE(ProcessObserver,Node);
+
+public:
+
+	Vector<ProcessAgent*> agents;
+	int frame;
+	bool barrier_ok;
+
+	void _notification(int p_what) {
+
+		if (p_what!=NOTIFICATION_PROCESS)
+			return;
+
+		// serial nodes run after every threaded one is done
+		frame++;
+		for(int i=0;i<agents.size();i++) {
+			if (agents[i]->frames!=frame)
+				barrier_ok=false;
+		}
+	}
+
+	ProcessObserver() { frame=0; barrier_ok=true; }
+};
+
+static SceneTree *_create_tree() {
+
+	SceneTree *tree = memnew( SceneTree );
+	tree->init();
+	return tree;
+}
+
+static void _free_tree(SceneTree *p_tree) {
+
+	MessageQueue::get_singleton()->flush();
+	p_tree->finish();
+	memdelete(p_tree);
+}
+
+static Vector<ProcessAgent*> _add_agents(SceneTree *p_tree,int p_count,bool p_threaded) {
+
+	Vector<ProcessAgent*> agents;
+	for(int i=0;i<p_count;i++) {
+		ProcessAgent *agent = memnew( ProcessAgent );
+		agent->pos=Vector3(i%100,(i/100)%100,0);
+		agent->target=Vector3(50,50,i%7);
+		agent->set_process_threaded(p_threaded);
+		p_tree->get_root()->add_child(agent);
+		agent->set_process(true);
+		agents.push_back(agent);
+	}
+	return agents;
+}
+
+static bool _test_threaded_process() {
+
+	bool ok=true;
+	const int count=2000;
+
+	// serial and threaded runs must compute exactly the same thing
+	Vector<Vector3> serial_pos;
+	{
+		SceneTree *tree=_create_tree();
+		Vector<ProcessAgent*> agents=_add_agents(tree,count,false);
+		for(int f=0;f<10;f++)
+			tree->idle(1.0/60.0);
+		for(int i=0;i<count;i++)
+			serial_pos.push_back(agents[i]->pos);
+		_free_tree(tree);
+	}
+
+	{
+		SceneTree *tree=_create_tree();
+		Vector<ProcessAgent*> agents=_add_agents(tree,count,true);
+
+		ProcessObserver *observer = memnew( ProcessObserver );
+		observer->agents=agents;
+		tree->get_root()->add_child(observer);
+		tree->get_root()->move_child(observer,0); // first in tree order, still runs after them
+		observer->set_process(true);
+
+		for(int f=0;f<10;f++)
+			tree->idle(1.0/60.0);
+
+		for(int i=0;i<count;i++)
+			ok = ok && agents[i]->pos==serial_pos[i] && agents[i]->frames==10;
+		ok = ok && observer->barrier_ok && observer->frame==10;
+
+		// tree changes from threaded callbacks wait for the message queue
+		Vector<ObjectID> doomed;
+		for(int i=0;i<count;i+=10) {
+			agents[i]->spawn_child=true;
+			agents[i]->doomed=memnew( Node );
+			tree->get_root()->add_child(agents[i]->doomed);
+			doomed.push_back(agents[i]->doomed->get_instance_ID());
+		}
+		tree->idle(1.0/60.0);
+		ok = ok && !tree->is_threaded_process_running();
+		for(int i=0;i<count;i+=10)
+			ok = ok && agents[i]->tree_unchanged && agents[i]->get_child_count()==0;
+		for(int i=0;i<doomed.size();i++)
+			ok = ok && ObjectDB::get_instance(doomed[i]);
+		MessageQueue::get_singleton()->flush();
+		for(int i=0;i<count;i+=10)
+			ok = ok && agents[i]->get_child_count()==1 && !agents[i]->is_processing() && String(agents[i]->get_name()).ends_with("Renamed");
+		for(int i=0;i<doomed.size();i++)
+			ok = ok && !ObjectDB::get_instance(doomed[i]);
+
+		_free_tree(tree);
+	}
+
+	return ok;
+}
+
+static void _bench_threaded_process() {
+
+	const int count=10000;
+	const int frames=30;
+
+	uint64_t serial=0,threaded=0,mixed=0,deferred=0;
+
+	for(int mode=0;mode<3;mode++) {
+
+		SceneTree *tree=_create_tree();
+		Vector<ProcessAgent*> agents=_add_agents(tree,count,mode==1);
+		if (mode==2) {
+			for(int i=0;i<count;i+=2)
+				agents[i]->set_process_threaded(true);
+		}
+
+		tree->idle(1.0/60.0); // warm up
+		uint64_t t=OS::get_singleton()->get_ticks_usec();
+		for(int f=0;f<frames;f++)
+			tree->idle(1.0/60.0);
+		uint64_t elapsed=(OS::get_singleton()->get_ticks_usec()-t)/frames;
+
+		if (mode==0) {
+			serial=elapsed;
+		} else if (mode==1) {
+			threaded=elapsed;
+
+			// every agent defers a tree change, then the queue applies them
+			for(int i=0;i<count;i++)
+				agents[i]->spawn_child=true;
+			tree->idle(1.0/60.0);
+			t=OS::get_singleton()->get_ticks_usec();
+			MessageQueue::get_singleton()->flush();
+			deferred=OS::get_singleton()->get_ticks_usec()-t;
+		} else {
+			mixed=elapsed;
+		}
+
+		_free_tree(tree);
+	}
+
+	int threads=WorkerThreadPool::get_singleton()?WorkerThreadPool::get_singleton()->get_thread_count():1;
+	print_line("Process "+itos(count)+" nodes ("+itos(threads)+" threads), per frame: serial "+rtos(serial/1000.0)+"ms, threaded "+rtos(threaded/1000.0)+"ms, half threaded "+rtos(mixed/1000.0)+"ms; "+itos(count)+" deferred add_child flushed in "+rtos(deferred/1000.0)+"ms");
+}
+
+/* Child name index */
+
+static bool _test_child_index() {
+
+	bool ok=true;
+	Node *parent = memnew( Node );
+
+	// enough children to build the index, with clashing names
+	Vector<Node*> childs;
+	for(int i=0;i<100;i++) {
+		Node *n = memnew( Node );
+		n->set_name(i%2 ? "Item" : "Thing");
+		parent->add_child(n,i>=50);
+		childs.push_back(n);
+	}
+
+	for(int i=0;i<childs.size();i++) {
+		ok = ok && parent->get_node(NodePath(childs[i]->get_name()))==childs[i];
+		for(int j=0;j<i;j++)
+			ok = ok && childs[i]->get_name()!=childs[j]->get_name();
+	}
+	ok = ok && String(childs[99]->get_name())=="Item 26"; // the 25th human readable "Item"
+
+	// renaming keeps the index up to date
+	childs[10]->set_name("Renamed");
+	ok = ok && parent->has_node(NodePath("Renamed")) && parent->get_node(NodePath("Renamed"))==childs[10];
+	childs[11]->set_name("Renamed");
+	ok = ok && String(childs[11]->get_name())!="Renamed" && parent->get_node(NodePath("Renamed"))==childs[10];
+
+	// a freed suffix is not handed out again, the next one is
+	StringName freed = childs[99]->get_name();
+	parent->remove_child(childs[99]);
+	memdelete(childs[99]);
+	childs.remove(99);
+	ok = ok && !parent->has_node(NodePath(freed));
+	Node *n = memnew( Node );
+	n->set_name("Item");
+	parent->add_child(n,true);
+	childs.push_back(n);
+	ok = ok && String(n->get_name())=="Item 27" && parent->get_node(NodePath("Item 27"))==n;
+
+	// removing from the middle, then going below the threshold where the index is dropped
+	while(childs.size()) {
+		int idx=childs.size()/2;
+		Node *c=childs[idx];
+		StringName name=c->get_name();
+		parent->remove_child(c);
+		memdelete(c);
+		childs.remove(idx);
+		ok = ok && !parent->has_node(NodePath(name));
+		for(int i=0;i<childs.size();i++)
+			ok = ok && parent->get_node(NodePath(childs[i]->get_name()))==childs[i] && childs[i]->get_position_in_parent()==i;
+	}
+
+	memdelete(parent);
+	return ok;
+}
+
+static void _bench_child_index() {
+
+	const int counts[3]={10,1000,100000};
+
+	for(int c=0;c<3;c++) {
+
+		int count=counts[c];
+		int rounds=MAX(1,100000/count);
+		uint64_t add=0,legible=0,lookup=0,remove=0;
+
+		for(int r=0;r<rounds;r++) {
+
+			Node *parent = memnew( Node );
+			Vector<Node*> childs;
+			Vector<NodePath> paths;
+			for(int i=0;i<count;i++) {
+				Node *n = memnew( Node );
+				n->set_name("Child"+itos(i));
+				childs.push_back(n);
+				paths.push_back(NodePath(n->get_name()));
+			}
+
+			uint64_t t=OS::get_singleton()->get_ticks_usec();
+			for(int i=0;i<count;i++)
+				parent->add_child(childs[i]);
+			add+=OS::get_singleton()->get_ticks_usec()-t;
+
+			t=OS::get_singleton()->get_ticks_usec();
+			for(int i=0;i<count;i++)
+				parent->get_node(paths[i]);
+			lookup+=OS::get_singleton()->get_ticks_usec()-t;
+
+			t=OS::get_singleton()->get_ticks_usec();
+			for(int i=count-1;i>=0;i--)
+				parent->remove_child(childs[i]);
+			remove+=OS::get_singleton()->get_ticks_usec()-t;
+
+			// all named alike, as the editor does when duplicating
+			for(int i=0;i<count;i++)
+				childs[i]->set_name("Item");
+			t=OS::get_singleton()->get_ticks_usec();
+			for(int i=0;i<count;i++)
+				parent->add_child(childs[i],true);
+			legible+=OS::get_singleton()->get_ticks_usec()-t;
+
+			memdelete(parent);
+		}
+
+		int64_t ops=int64_t(count)*rounds;
+		print_line("Children "+itos(count)+", ns per child: add "+rtos(add*1000.0/ops)+", add human readable "+rtos(legible*1000.0/ops)+", get_node "+rtos(lookup*1000.0/ops)+", remove "+rtos(remove*1000.0/ops));
+	}
+}
+
+/* Node path cache */
+
+static Node *_add_named(Node *p_parent,const String& p_name) {
+
+	Node *n = memnew( Node );
+	n->set_name(p_name);
+	p_parent->add_child(n);
+	return n;
+}
+
+static bool _test_node_path_cache() {
+
+	bool ok=true;
+	SceneTree *tree=_create_tree();
+	Node *root=tree->get_root();
+
+	Node *a=_add_named(root,"A");
+	Node *b=_add_named(a,"B");
+	Node *c=_add_named(b,"C");
+	Node *d=_add_named(a,"D");
+
+	uint64_t hits=tree->get_node_path_cache_hits();
+	for(int i=0;i<3;i++) {
+		ok = ok && root->get_node(NodePath("A/B/C"))==c;
+		ok = ok && c->get_node(NodePath("../../D"))==d;
+		ok = ok && c->get_node(NodePath("/root/A"))==a;
+	}
+	ok = ok && tree->get_node_path_cache_hits()-hits==6;
+
+	// renames, removals and moves must not be answered from the cache
+	b->set_name("B2");
+	ok = ok && !root->has_node(NodePath("A/B/C")) && root->get_node(NodePath("A/B2/C"))==c;
+	ok = ok && c->get_node(NodePath("../../D"))==d;
+
+	b->remove_child(c);
+	ok = ok && !root->has_node(NodePath("A/B2/C"));
+	d->add_child(c);
+	ok = ok && root->get_node(NodePath("A/D/C"))==c && c->get_node(NodePath("../../D"))==a->get_node(NodePath("D"));
+
+	ok = ok && root->get_node(NodePath("A/D"))==d;
+	memdelete(d); // takes c along
+	ok = ok && !root->has_node(NodePath("A/D")) && !root->has_node(NodePath("A/D/C"));
+
+	// a node leaving the tree forgets what it resolved
+	ok = ok && b->get_node(NodePath("/root/A"))==a;
+	a->remove_child(b);
+	Node *other=_add_named(root,"A2");
+	other->add_child(b);
+	ok = ok && b->get_node(NodePath("..")) == other;
+
+	_free_tree(tree);
+	return ok;
+}
+
+static void _bench_node_path_cache() {
+
+	const int lookups=200000;
+
+	SceneTree *tree=_create_tree();
+	Node *level=_add_named(tree->get_root(),"Level");
+	Node *enemies=_add_named(level,"Enemies");
+	Node *player=_add_named(level,"Player");
+	for(int i=0;i<20;i++)
+		_add_named(_add_named(enemies,"Enemy"+itos(i)),"Sprite");
+	Node *weapon=_add_named(_add_named(player,"Body"),"Weapon");
+
+	NodePath path("../../../Enemies/Enemy10/Sprite");
+	NodePath abs_path("/root/Level/Enemies/Enemy19/Sprite");
+
+	uint64_t t=OS::get_singleton()->get_ticks_usec();
+	for(int i=0;i<lookups;i++) {
+		weapon->get_node(path);
+		weapon->get_node(abs_path);
+	}
+	uint64_t cached=OS::get_singleton()->get_ticks_usec()-t;
+
+	// the same relative lookup with the branch outside the tree, where nothing is cached
+	tree->get_root()->remove_child(level);
+	t=OS::get_singleton()->get_ticks_usec();
+	for(int i=0;i<lookups;i++) {
+		weapon->get_node(path);
+		weapon->get_node(path);
+	}
+	uint64_t walked=OS::get_singleton()->get_ticks_usec()-t;
+	memdelete(level);
+
+	print_line("get_node of 5-6 element paths, ns per lookup: walked "+rtos(walked*1000.0/(lookups*2))+", cached "+rtos(cached*1000.0/(lookups*2))+" ("+itos(tree->get_node_path_cache_hits())+" hits, "+itos(tree->get_node_path_cache_misses())+" misses)");
+
+	_free_tree(tree);
+}
+
+/* Compiled instancing and instance pools */
+
+static Node2D *_add_2d(Node *p_parent,Node *p_owner,const String& p_name) {
+
+	Node2D *n = memnew( Node2D );
+	n->set_name(p_name);
+	p_parent->add_child(n);
+	n->set_owner(p_owner);
+	return n;
+}
+
+static Ref<PackedScene> _pack_scene(int p_children,int p_depth,bool p_script=false) {
+
+	Node2D *root = memnew( Node2D );
+	root->set_name("Root");
+	root->set_pos(Vector2(1,2));
+
+	for(int i=0;i<p_children;i++) {
+		Node2D *c=_add_2d(root,root,"Child"+itos(i));
+		c->set_pos(Vector2(i,-i));
+		c->set_rot(0.5);
+		c->set_z(0); // the default, compiled instancing skips it
+		c->add_to_group("enemies",true);
+		c->connect("visibility_changed",root,"update",varray(),Object::CONNECT_PERSIST);
+	}
+
+	Node *parent=root;
+	for(int i=0;i<p_depth;i++) {
+		Node2D *c=_add_2d(parent,root,"Level"+itos(i));
+		c->set_z(i%10);
+		parent=c;
+	}
+
+#ifdef GDSCRIPT_ENABLED
+	if (p_script) {
+		Ref<GDScript> script = memnew( GDScript );
+		script->set_source_code("extends Node2D\nexport var hp=10\n");
+		script->reload();
+		root->set_script(script.get_ref_ptr());
+		root->set("hp",5);
+	}
+#endif
+
+	Ref<PackedScene> scene = memnew( PackedScene );
+	scene->pack(root);
+	memdelete(root);
+	return scene;
+}
+
+static bool _same_state(Node *p_a,Node *p_b) {
+
+	if (p_a->get_name()!=p_b->get_name() || p_a->get_type_name()!=p_b->get_type_name() || p_a->get_child_count()!=p_b->get_child_count())
+		return false;
+
+	List<PropertyInfo> plist;
+	p_a->get_property_list(&plist);
+	for(List<PropertyInfo>::Element *E=plist.front();E;E=E->next()) {
+		if (E->get().usage&PROPERTY_USAGE_STORAGE && !(p_a->get(E->get().name)==p_b->get(E->get().name)))
+			return false;
+	}
+
+	List<Node::GroupInfo> ga,gb;
+	p_a->get_groups(&ga);
+	p_b->get_groups(&gb);
+	List<Object::Connection> ca,cb;
+	p_a->get_all_signal_connections(&ca);
+	p_b->get_all_signal_connections(&cb);
+	if (ga.size()!=gb.size() || ca.size()!=cb.size())
+		return false;
+
+	for(int i=0;i<p_a->get_child_count();i++) {
+		if (!_same_state(p_a->get_child(i),p_b->get_child(i)))
+			return false;
+	}
+
+	return true;
+}
+
+struct InstancingThread {
+
+	Ref<PackedScene> scene;
+	volatile bool done;
+	int instanced;
+	int failed;
+};
+
+static void _instancing_thread(void *p_userdata) {
+
+	InstancingThread *it=(InstancingThread*)p_userdata;
+	while(!atomic_load(&it->done)) {
+		Node *n=it->scene->instance();
+		if (n) {
+			it->instanced++;
+			memdelete(n);
+		} else {
+			it->failed++;
+		}
+	}
+}
+
+static bool _test_compiled_instancing() {
+
+	bool ok=true;
+
+	Ref<PackedScene> scenes[3]={ _pack_scene(0,0,true), _pack_scene(20,3), _pack_scene(0,50) };
+
+	// same result as going through the node data one property at a time
+	for(int i=0;i<3;i++) {
+		Node *compiled=scenes[i]->instance();
+		Node *interpreted=scenes[i]->get_state()->instance(true);
+		ok = ok && compiled && interpreted && _same_state(compiled,interpreted);
+		memdelete(compiled);
+		memdelete(interpreted);
+	}
+
+	SceneTree *tree=_create_tree();
+	Node *root=tree->get_root();
+	Node *outside=_add_named(root,"Outside");
+
+	Ref<PackedScene> scene=scenes[1];
+	scene->set_instance_pool_size(2);
+
+	Node *a=scene->instance();
+	root->add_child(a);
+	Node2D *child=a->get_child(0)->cast_to<Node2D>();
+	child->set_pos(Vector2(100,100));
+	child->set_z(5);
+	child->add_to_group("extra");
+	child->connect("visibility_changed",outside,"queue_free");
+	outside->connect("renamed",child,"update");
+	a->set_name("Renamed");
+	a->queue_delete();
+	tree->idle(1.0/60.0);
+
+	// comes back as new, without what was done to it
+	Node *b=scene->instance();
+	Node *fresh=scene->get_state()->instance(true);
+	ok = ok && b==a && _same_state(b,fresh) && !b->is_queued_for_deletion();
+	ok = ok && !outside->is_connected("renamed",child,"update") && child->is_connected("visibility_changed",b,"update");
+	memdelete(fresh);
+
+	// not once its nodes changed
+	root->add_child(b);
+	_add_named(b,"Extra");
+	ObjectID b_id=b->get_instance_ID();
+	b->queue_delete();
+	tree->idle(1.0/60.0);
+	ok = ok && ObjectDB::get_instance(b_id)==NULL;
+
+	// null objects and metadata go back to how the scene has them
+	Sprite *sprite = memnew( Sprite );
+	sprite->set_meta("kind","enemy");
+	Ref<PackedScene> sprite_scene = memnew( PackedScene );
+	sprite_scene->pack(sprite);
+	memdelete(sprite);
+	sprite_scene->set_instance_pool_size(1);
+	Sprite *sp=sprite_scene->instance()->cast_to<Sprite>();
+	Ref<ImageTexture> texture = memnew( ImageTexture );
+	sp->set_texture(texture);
+	sp->set_meta("hit",true);
+	sp->set_meta("kind","boss");
+	root->add_child(sp);
+	sp->queue_delete();
+	tree->idle(1.0/60.0);
+	Node *sp2=sprite_scene->instance();
+	ok = ok && sp2==sp && sp->get_texture().is_null() && !sp->has_meta("hit") && String(sp->get_meta("kind"))=="enemy";
+	memdelete(sp2);
+
+	// connections to resources and timers go too, those the setters made for the scene stay
+	Ref<ImageTexture> scene_texture = memnew( ImageTexture );
+	sprite = memnew( Sprite );
+	sprite->set_texture(scene_texture);
+	Ref<PackedScene> texture_scene = memnew( PackedScene );
+	texture_scene->pack(sprite);
+	memdelete(sprite);
+	texture_scene->set_instance_pool_size(1);
+	sp=texture_scene->instance()->cast_to<Sprite>();
+	scene_texture->connect("changed",sp,"hide");
+	Ref<SceneTreeTimer> timer=tree->create_timer(2);
+	timer->connect("timeout",sp,"queue_free");
+	root->add_child(sp);
+	sp->queue_delete();
+	tree->idle(1.0/60.0);
+	sp2=texture_scene->instance();
+	ok = ok && sp2==sp && sp->get_texture()==scene_texture;
+	ok = ok && !scene_texture->is_connected("changed",sp,"hide") && !timer->is_connected("timeout",sp,"queue_free");
+#ifdef DEBUG_ENABLED
+	ok = ok && scene_texture->is_connected("changed",sp,"update");
+#endif
+	memdelete(sp2);
+
+#ifdef GDSCRIPT_ENABLED
+	// scripts start over
+	scenes[0]->set_instance_pool_size(1);
+	Node *s=scenes[0]->instance();
+	ok = ok && int(s->get("hp"))==5;
+	s->set("hp",1);
+	root->add_child(s);
+	s->queue_delete();
+	tree->idle(1.0/60.0);
+	Node *s2=scenes[0]->instance();
+	ok = ok && s2==s && int(s2->get("hp"))==5;
+	memdelete(s2);
+#endif
+
+	_free_tree(tree);
+
+	// other threads keep instancing while turning pooling on compiles it again
+	InstancingThread it[2];
+	Thread *threads[2];
+	for(int i=0;i<2;i++) {
+		it[i].scene=scenes[1];
+		it[i].done=false;
+		it[i].instanced=0;
+		it[i].failed=0;
+		threads[i]=Thread::create(_instancing_thread,&it[i]);
+	}
+	for(int i=0;i<200;i++) {
+		scenes[1]->set_instance_pool_size(0);
+		scenes[1]->set_instance_pool_size(1);
+		memdelete(scenes[1]->instance());
+		OS::get_singleton()->delay_usec(100);
+	}
+	for(int i=0;i<2;i++) {
+		atomic_store(&it[i].done,true);
+		Thread::wait_to_finish(threads[i]);
+		memdelete(threads[i]);
+		ok = ok && it[i].instanced>0 && it[i].failed==0;
+	}
+
+	return ok;
+}
+
+static void _bench_compiled_instancing() {
+
+	const char *labels[3]={"small (1 node)","medium (24 nodes)","deep (51 nodes)"};
+	Ref<PackedScene> scenes[3]={ _pack_scene(0,0), _pack_scene(20,3), _pack_scene(0,50) };
+	const int batch=100;
+	const int batches=20;
+
+	SceneTree *tree=_create_tree();
+	Node *root=tree->get_root();
+
+	for(int i=0;i<3;i++) {
+
+		uint64_t usec[2];
+
+		for(int pooled=0;pooled<2;pooled++) {
+
+			scenes[i]->set_instance_pool_size(pooled ? batch : 0);
+			Vector<Node*> nodes;
+			nodes.resize(batch);
+
+			uint64_t t=0;
+			for(int b=0;b<=batches;b++) {
+
+				uint64_t from=OS::get_singleton()->get_ticks_usec();
+				for(int j=0;j<batch;j++) {
+					nodes[j]=scenes[i]->instance();
+					root->add_child(nodes[j]);
+				}
+				for(int j=0;j<batch;j++)
+					nodes[j]->queue_delete();
+				tree->idle(1.0/60.0);
+				if (b>0) // the first batch fills the pool
+					t+=OS::get_singleton()->get_ticks_usec()-from;
+			}
+			usec[pooled]=t;
+		}
+
+		scenes[i]->set_instance_pool_size(0);
+		int count=batch*batches;
+		print_line(String("Instance, add and free ")+labels[i]+": "+itos(count*1000000.0/usec[0])+" instances/s, pooled "+itos(count*1000000.0/usec[1])+" instances/s");
+	}
+
+	_free_tree(tree);
+}
+
+/* Timer queues */
+
+class TimeoutRecorder : public Object {
+
+	OBJ_TYPE(TimeoutRecorder,Object);
+
+protected:
+
+	static void _bind_methods() {
+
+		ObjectTypeDB::bind_method(_MD("_timeout","id"),&TimeoutRecorder::_timeout);
+	}
+
+public:
+
+	Vector<int> order;
+
+	void _timeout(int p_id) { order.push_back(p_id); }
+};
+
+class TimerStarter : public Node {
+
+	OBJ_TYPE(TimerStarter,Node);
+
+public:
+
+	Timer *timer; // started once from the threaded process callback
+	bool deferred;
+
+	void _notification(int p_what) {
+
+		if (p_what!=NOTIFICATION_PROCESS || !timer)
+			return;
+
+		timer->set_wait_time(0.2);
+		timer->start();
+		deferred = timer->get_wait_time()==0.1f && timer->get_time_left()==0;
+		timer=NULL;
+	}
+
+	TimerStarter() { timer=NULL; deferred=false; }
+};
+
+static Ref<SceneTreeTimer> _add_tree_timer(SceneTree *p_tree,TimeoutRecorder *p_recorder,float p_time,int p_id) {
+
+	Ref<SceneTreeTimer> timer=p_tree->create_timer(p_time);
+	timer->connect("timeout",p_recorder,"_timeout",varray(p_id));
+	return timer;
+}
+
+static Timer *_add_timer(Node *p_parent,TimeoutRecorder *p_recorder,float p_time,bool p_one_shot,int p_id) {
+
+	Timer *timer = memnew( Timer );
+	timer->set_wait_time(p_time);
+	timer->set_one_shot(p_one_shot);
+	timer->connect("timeout",p_recorder,"_timeout",varray(p_id));
+	p_parent->add_child(timer);
+	return timer;
+}
+
+static bool _recorded(TimeoutRecorder *p_recorder,int p_a=-1,int p_b=-1,int p_c=-1,int p_d=-1) {
+
+	int ids[4]={p_a,p_b,p_c,p_d};
+	int count=0;
+	while(count<4 && ids[count]>=0)
+		count++;
+
+	if (p_recorder->order.size()!=count)
+		return false;
+	for(int i=0;i<count;i++) {
+		if (p_recorder->order[i]!=ids[i])
+			return false;
+	}
+	return true;
+}
+
+static bool _test_timers() {
+
+	bool ok=true;
+	SceneTree *tree=_create_tree();
+	Node *root=tree->get_root();
+	TimeoutRecorder *rec = memnew( TimeoutRecorder );
+
+	// tree timers time out in the order they are due
+	Ref<SceneTreeTimer> t0=_add_tree_timer(tree,rec,0.5,0);
+	_add_tree_timer(tree,rec,0.1,1);
+	Ref<SceneTreeTimer> t2=_add_tree_timer(tree,rec,0.3,2);
+	_add_tree_timer(tree,rec,10,3); // only the tree keeps it
+	tree->idle(0.2);
+	ok = ok && _recorded(rec,1) && Math::abs(t0->get_time_left()-0.3)<0.001;
+	t2->set_time_left(1.0);
+	tree->idle(0.35);
+	ok = ok && _recorded(rec,1,0) && t0->get_time_left()<0;
+	tree->idle(0.8);
+	ok = ok && _recorded(rec,1,0,2);
+	tree->idle(10);
+	ok = ok && _recorded(rec,1,0,2,3);
+	t0->set_time_left(0.1); // timed out already, nothing happens
+	tree->idle(1);
+	ok = ok && _recorded(rec,1,0,2,3);
+	rec->order.clear();
+
+	// timer nodes, repeating and one shot, idle and fixed
+	Timer *repeat=_add_timer(root,rec,0.1,false,0);
+	Timer *once=_add_timer(root,rec,0.25,true,1);
+	once->set_timer_process_mode(Timer::TIMER_PROCESS_FIXED);
+	repeat->start();
+	once->start();
+	for(int i=0;i<6;i++)
+		tree->idle(0.04);
+	ok = ok && _recorded(rec,0,0) && Math::abs(repeat->get_time_left()-0.1)<0.001 && Math::abs(once->get_time_left()-0.25)<0.001;
+	for(int i=0;i<3;i++)
+		tree->iteration(0.1);
+	ok = ok && _recorded(rec,0,0,1) && once->get_time_left()==0;
+	once->start();
+	rec->order.clear();
+
+	// paused timers keep their time, unless they process while paused
+	Timer *pausing=_add_timer(root,rec,0.1,true,2);
+	pausing->set_pause_mode(Node::PAUSE_MODE_PROCESS);
+	pausing->start();
+	tree->set_pause(true);
+	tree->idle(0.5);
+	tree->iteration(0.5);
+	ok = ok && _recorded(rec,2) && Math::abs(repeat->get_time_left()-0.1)<0.001 && Math::abs(once->get_time_left()-0.25)<0.001;
+	tree->set_pause(false);
+
+	// and so do those out of the tree or inactive
+	root->remove_child(repeat);
+	once->set_active(false);
+	tree->idle(0.5);
+	tree->iteration(0.5);
+	ok = ok && _recorded(rec,2) && Math::abs(repeat->get_time_left()-0.1)<0.001 && Math::abs(once->get_time_left()-0.25)<0.001;
+	root->add_child(repeat);
+	once->set_active(true);
+	tree->idle(0.15);
+	tree->iteration(0.3);
+	ok = ok && _recorded(rec,2,0,1);
+
+	// stopped or moved to another clock
+	repeat->stop();
+	tree->idle(0.5);
+	ok = ok && _recorded(rec,2,0,1) && repeat->get_time_left()==0;
+	repeat->start();
+	repeat->set_timer_process_mode(Timer::TIMER_PROCESS_FIXED);
+	tree->idle(0.5);
+	ok = ok && _recorded(rec,2,0,1);
+	tree->iteration(0.15);
+	ok = ok && _recorded(rec,2,0,1,0);
+
+	// changing the pause mode while paused stops and resumes them
+	rec->order.clear();
+	Node *holder=_add_named(root,"Holder");
+	Timer *inherited=_add_timer(holder,rec,0.1,true,4);
+	inherited->start();
+	tree->set_pause(true);
+	holder->set_pause_mode(Node::PAUSE_MODE_PROCESS);
+	tree->idle(0.15);
+	ok = ok && _recorded(rec,4);
+	inherited->start();
+	holder->set_pause_mode(Node::PAUSE_MODE_STOP);
+	tree->idle(0.15);
+	ok = ok && _recorded(rec,4) && Math::abs(inherited->get_time_left()-0.1)<0.001;
+	inherited->set_pause_mode(Node::PAUSE_MODE_PROCESS);
+	tree->idle(0.15);
+	ok = ok && _recorded(rec,4,4);
+	tree->set_pause(false);
+
+	// started from a threaded process callback, once it is done
+	Timer *started=_add_timer(root,rec,0.1,true,5);
+	TimerStarter *starter = memnew( TimerStarter );
+	starter->timer=started;
+	starter->set_process_threaded(true);
+	root->add_child(starter);
+	starter->set_process(true);
+	tree->idle(0.05);
+	MessageQueue::get_singleton()->flush();
+	ok = ok && starter->deferred && started->get_wait_time()==0.2f && started->get_time_left()>0.1;
+	tree->idle(0.25);
+	ok = ok && _recorded(rec,4,4,5);
+
+	// pending tree timers outlive the tree
+	Ref<SceneTreeTimer> pending=tree->create_timer(100);
+	tree->idle(1);
+	_free_tree(tree);
+	ok = ok && Math::abs(pending->get_time_left()-99)<0.001;
+
+	memdelete(rec);
+	return ok;
+}
+
+static void _bench_timers() {
+
+	const int count=100000;
+	const int frames=100;
+
+	SceneTree *tree=_create_tree();
+	Node *root=tree->get_root();
+	TimeoutRecorder *rec = memnew( TimeoutRecorder );
+
+	Vector<Ref<SceneTreeTimer> > tree_timers;
+	for(int i=0;i<count;i++)
+		tree_timers.push_back(_add_tree_timer(tree,rec,1000+i,0));
+	for(int i=0;i<count;i++)
+		_add_timer(root,rec,1000+i,true,0)->start();
+
+	// none of them due
+	uint64_t t=OS::get_singleton()->get_ticks_usec();
+	for(int i=0;i<frames;i++)
+		tree->idle(1.0/60.0);
+	uint64_t pending=OS::get_singleton()->get_ticks_usec()-t;
+
+	// a thousand due every frame
+	for(int i=0;i<count;i++)
+		tree_timers[i]->set_time_left((i%frames+0.5)/60.0);
+	rec->order.clear();
+	t=OS::get_singleton()->get_ticks_usec();
+	for(int i=0;i<frames;i++)
+		tree->idle(1.0/60.0);
+	uint64_t expiring=OS::get_singleton()->get_ticks_usec()-t;
+
+	print_line(itos(count)+" tree timers and "+itos(count)+" timer nodes, usec per frame: none due "+rtos(pending/double(frames))+", "+itos(count/frames)+" tree timers due "+rtos(expiring/double(frames))+" ("+itos(rec->order.size())+" timed out)");
+
+	_free_tree(tree);
+	memdelete(rec);
+}
+
+MainLoop* test() {
+
+	ObjectTypeDB::register_type<ProcessAgent>();
+	ObjectTypeDB::register_type<ProcessObserver>();
+	ObjectTypeDB::register_type<TimeoutRecorder>();
+	ObjectTypeDB::register_type<TimerStarter>();
+
+	print_line("Threaded process: "+String(_test_threaded_process()?"OK":"FAILED"));
+	_bench_threaded_process();
+
+	print_line("Child name index: "+String(_test_child_index()?"OK":"FAILED"));
+	_bench_child_index();
+
+	print_line("Node path cache: "+String(_test_node_path_cache()?"OK":"FAILED"));
+	_bench_node_path_cache();
+
+	print_line("Compiled instancing: "+String(_test_compiled_instancing()?"OK":"FAILED"));
+	_bench_compiled_instancing();
+
+	print_line("Timers: "+String(_test_timers()?"OK":"FAILED"));
+	_bench_timers();
+
+	return NULL;
+}
+
+}
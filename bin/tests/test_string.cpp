@@ -31,6 +31,7 @@
 //#include "math_funcs.h"
 #include <stdio.h>
 #include "os/os.h"
+#include "os/memory_pool_static.h"
 #include "drivers/nrex/regex.h"
 
 #include "test_string.h"
@@ -843,6 +844,221 @@ bool test_28() {
 	return state;
 }
 
+bool test_29() {
+
+	OS::get_singleton()->print("\n\nTest 29: Fast paths\n");
+
+	bool state=true;
+
+	String ascii;
+	for(int i=0;i<10;i++)
+		ascii+="The Quick Brown Fox, ";
+	String mixed=ascii+String::utf8("Größe ÀÉÎ ñ \xe6\x97\xa5\xe6\x9c\xac ")+ascii;
+
+	// utf8 round trips, long ascii runs on both sides of multibyte characters
+	if (String::utf8(mixed.utf8().get_data())!=mixed) {
+		OS::get_singleton()->print("\tutf8 round trip failed\n");
+		state=false;
+	}
+	if (mixed.utf8().length()!=mixed.length()+10) {
+		OS::get_singleton()->print("\tutf8 length wrong: %i\n",mixed.utf8().length());
+		state=false;
+	}
+	String clipped;
+	clipped.parse_utf8("abc\0def",7);
+	if (clipped!="abc") {
+		OS::get_singleton()->print("\tparse_utf8 didn't stop at zero\n");
+		state=false;
+	}
+
+	// case changes, unchanged strings share the data
+	String lower=mixed.to_lower();
+	if (lower.find(String::utf8("the quick brown fox, größe àéî ñ"))<0 || lower.find("T")>=0) {
+		OS::get_singleton()->print("\tto_lower failed: %ls\n",lower.c_str());
+		state=false;
+	}
+	if (lower.to_upper().find(String::utf8("THE QUICK BROWN FOX, GRÖßE ÀÉÎ Ñ"))<0) {
+		OS::get_singleton()->print("\tto_upper failed\n");
+		state=false;
+	}
+	if (lower.to_lower().c_str()!=lower.c_str()) {
+		OS::get_singleton()->print("\tto_lower copied an unchanged string\n");
+		state=false;
+	}
+
+	// find and replace
+	if (mixed.find("Fox",ascii.length())!=ascii.length()+String::utf8("Größe ÀÉÎ ñ \xe6\x97\xa5\xe6\x9c\xac The Quick Brown ").length()) {
+		OS::get_singleton()->print("\tfind from failed\n");
+		state=false;
+	}
+	if (String("aaa").find("aaaa")!=-1 || String("abab").find("ab",3)!=-1 || String("abab").find("ab",2)!=2) {
+		OS::get_singleton()->print("\tfind bounds failed\n");
+		state=false;
+	}
+	if (String("xxax").replace("x","")!="a" || String("xx").replace("x","")!="" || String("abc").replace("b","[b]")!="a[b]c" || String("aaa").replace("aa","b")!="ba") {
+		OS::get_singleton()->print("\treplace failed\n");
+		state=false;
+	}
+
+	// appending to itself
+	String twice="abc";
+	twice+=twice;
+	if (twice!="abcabc") {
+		OS::get_singleton()->print("\tself append failed: %ls\n",twice.c_str());
+		state=false;
+	}
+
+	// the cached hash follows changes
+	String h="hash me";
+	uint32_t before=h.hash();
+	h[0]='c';
+	if (h.hash()!=String("cash me").hash() || h.hash()==before) {
+		OS::get_singleton()->print("\tcached hash is stale\n");
+		state=false;
+	}
+
+	return state;
+}
+
+/* Counts allocations going through the static pool, so the benchmark can
+   report them along with the times. It's put in front of the real pool the
+   first time it's needed and stays there, only counting while enabled. */
+
+class AllocCounter : public MemoryPoolStatic {
+
+	MemoryPoolStatic *pool;
+public:
+
+	bool enabled;
+	uint64_t count;
+
+	virtual void* alloc(size_t p_bytes,const char *p_description) { if (enabled) count++; return pool->alloc(p_bytes,p_description); }
+	virtual void* realloc(void * p_memory,size_t p_bytes) { if (enabled) count++; return pool->realloc(p_memory,p_bytes); }
+	virtual void free(void *p_ptr) { pool->free(p_ptr); }
+
+	virtual size_t get_available_mem() const { return pool->get_available_mem(); }
+	virtual size_t get_total_usage() { return pool->get_total_usage(); }
+	virtual size_t get_max_usage() { return pool->get_max_usage(); }
+
+	virtual int get_alloc_count() { return pool->get_alloc_count(); }
+	virtual void * get_alloc_ptr(int p_alloc_idx) { return pool->get_alloc_ptr(p_alloc_idx); }
+	virtual const char* get_alloc_description(int p_alloc_idx) { return pool->get_alloc_description(p_alloc_idx); }
+	virtual size_t get_alloc_size(int p_alloc_idx) { return pool->get_alloc_size(p_alloc_idx); }
+
+	virtual void dump_mem_to_file(const char* p_file) { pool->dump_mem_to_file(p_file); }
+
+	AllocCounter(MemoryPoolStatic *p_pool) { pool=p_pool; enabled=false; count=0; }
+};
+
+static AllocCounter *alloc_counter=NULL;
+
+static void _bench_begin(uint64_t &r_usec) {
+
+	if (!alloc_counter)
+		alloc_counter=memnew(AllocCounter(MemoryPoolStatic::get_singleton()));
+
+	alloc_counter->count=0;
+	alloc_counter->enabled=true;
+	r_usec=OS::get_singleton()->get_ticks_usec();
+}
+
+static void _bench_end(const char *p_name,int p_iterations,uint64_t p_usec) {
+
+	uint64_t usec=OS::get_singleton()->get_ticks_usec()-p_usec;
+	alloc_counter->enabled=false;
+	OS::get_singleton()->print("\t%-24s %8i in %9.3fms, %8i allocs\n",p_name,p_iterations,usec/1000.0,int(alloc_counter->count));
+}
+
+bool test_30() {
+
+	OS::get_singleton()->print("\n\nTest 30: Benchmark\n");
+
+	const int n=100000;
+	uint64_t t;
+	int check=0;
+
+	String text;
+	for(int i=0;i<200;i++)
+		text+="Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor. ";
+	String names[8]={ "position", "rotation", "scale", "visible", "modulate", "name", "script", "z" };
+	CharString text_utf8=text.utf8();
+
+	_bench_begin(t);
+	for(int i=0;i<n;i++) {
+		String s="node_name";
+		check+=s.length();
+	}
+	_bench_end("from cstr",n,t);
+
+	_bench_begin(t);
+	for(int i=0;i<n;i++) {
+		String s=names[i&7]+names[(i+1)&7];
+		check+=s.length();
+	}
+	_bench_end("concat",n,t);
+
+	_bench_begin(t);
+	for(int i=0;i<n;i++) {
+		String s="node";
+		s+="_";
+		s+=names[i&7];
+		check+=s.length();
+	}
+	_bench_end("append",n,t);
+
+	_bench_begin(t);
+	for(int i=0;i<n;i++)
+		check+=names[i&7].hash();
+	_bench_end("hash",n,t);
+
+	_bench_begin(t);
+	for(int i=0;i<n;i++)
+		check+=names[i&7]==names[(i*3)&7];
+	_bench_end("compare",n,t);
+
+	_bench_begin(t);
+	for(int i=0;i<n;i++)
+		check+=names[i&7].to_lower().length();
+	_bench_end("to_lower (unchanged)",n,t);
+
+	_bench_begin(t);
+	for(int i=0;i<n/100;i++)
+		check+=text.to_upper().length();
+	_bench_end("to_upper (text)",n/100,t);
+
+	_bench_begin(t);
+	for(int i=0;i<n/100;i++)
+		check+=text.find("tempor!");
+	_bench_end("find (text)",n/100,t);
+
+	_bench_begin(t);
+	for(int i=0;i<n/100;i++)
+		check+=text.replace("dolor","pain").length();
+	_bench_end("replace (text)",n/100,t);
+
+	_bench_begin(t);
+	for(int i=0;i<n/100;i++)
+		check+=text.split(" ").size();
+	_bench_end("split (text)",n/100,t);
+
+	_bench_begin(t);
+	for(int i=0;i<n/100;i++)
+		check+=text.utf8().length();
+	_bench_end("utf8 encode (text)",n/100,t);
+
+	_bench_begin(t);
+	for(int i=0;i<n/100;i++) {
+		String s;
+		s.parse_utf8(text_utf8.get_data());
+		check+=s.length();
+	}
+	_bench_end("utf8 decode (text)",n/100,t);
+
+	OS::get_singleton()->print("\tcheck %i\n",check);
+
+	return true;
+}
+
 typedef bool (*TestFunc)(void);
 
 TestFunc test_funcs[] = {
@@ -875,6 +1091,8 @@ TestFunc test_funcs[] = {
 	test_26,
 	test_27,
 	test_28,
+	test_29,
+	test_30,
 	0
 
 };
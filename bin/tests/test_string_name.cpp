@@ -0,0 +1,119 @@
+/*************************************************************************/
+/*  test_string_name.cpp                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2016 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "test_string_name.h"
+#include "string_db.h"
+#include "os/os.h"
+#include "os/thread.h"
+#include "print_string.h"
+
+namespace TestStringName {
+
+enum {
+	NAME_COUNT=4096,
+	ITERATIONS=200
+};
+
+struct BenchData {
+
+	const Vector<String> *names;
+	int offset;
+	int checksum;
+};
+
+static void _hammer(void *p_userdata) {
+
+	BenchData *bd=(BenchData*)p_userdata;
+	const Vector<String> &names=*bd->names;
+	int checksum=0;
+
+	for(int i=0;i<ITERATIONS;i++) {
+		for(int j=0;j<NAME_COUNT;j++) {
+
+			// half the names are shared between threads, half are private to this one
+			StringName sn(names[(j+bd->offset)%names.size()]);
+			checksum+=sn.hash()&1;
+		}
+	}
+
+	bd->checksum=checksum;
+}
+
+static void _bench_threads(int p_threads,const Vector<String>& p_names) {
+
+	Vector<BenchData> data;
+	data.resize(p_threads);
+	Vector<Thread*> threads;
+	threads.resize(p_threads);
+
+	uint64_t t=OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<p_threads;i++) {
+		data[i].names=&p_names;
+		data[i].offset=i*(NAME_COUNT/2);
+		data[i].checksum=0;
+		threads[i]=Thread::create(_hammer,&data[i]);
+	}
+
+	for(int i=0;i<p_threads;i++) {
+		Thread::wait_to_finish(threads[i]);
+		memdelete(threads[i]);
+	}
+
+	uint64_t elapsed=OS::get_singleton()->get_ticks_usec()-t;
+	uint64_t ops=uint64_t(p_threads)*ITERATIONS*NAME_COUNT;
+
+	print_line(itos(p_threads)+" thread(s): "+itos(ops)+" StringNames in "+itos(elapsed/1000)+"ms, "+rtos(double(ops)/double(elapsed))+" M/s");
+}
+
+MainLoop* test() {
+
+	Vector<String> names;
+	for(int i=0;i<NAME_COUNT*8;i++) {
+		names.push_back("name_"+itos(i));
+	}
+
+	{
+		// names must intern to the same pointer, even after the tables grow
+		StringName a("name_1234");
+		Vector<StringName> keep;
+		for(int i=0;i<names.size();i++) {
+			keep.push_back(names[i]);
+		}
+		bool ok = a==StringName(String("name_1234")) && a==StringName::search("name_1234") && a=="name_1234" && StringName::search("not_interned")==StringName();
+		print_line("Interning check: "+String(ok?"PASS":"FAILED"));
+	}
+
+	for(int i=1;i<=8;i*=2) {
+		_bench_threads(i,names);
+	}
+
+	return NULL;
+}
+
+}
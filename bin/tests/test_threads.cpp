@@ -0,0 +1,473 @@
+/*************************************************************************/
+/*  test_threads.cpp                                                     */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2016 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "test_threads.h"
+#include "command_queue_mt.h"
+#include "os/os.h"
+#include "os/thread.h"
+#include "os/worker_thread_pool.h"
+#include "safe_refcount.h"
+#include "print_string.h"
+#include "os/dir_access.h"
+#include "io/resource_loader.h"
+#include "io/resource_saver.h"
+
+namespace TestThreads {
+
+/* CommandQueueMT */
+
+class CommandTarget {
+public:
+
+	uint32_t count;
+	uint64_t sum;
+	bool in_order;
+	bool exit;
+
+	void add(int p_value) {
+		if (uint32_t(p_value)!=count)
+			in_order=false;
+		count++;
+		sum+=p_value;
+	}
+	void add_transform(const Matrix32& p_xform) { count++; sum+=int(p_xform.elements[2].x); }
+	int get_count() { return count; }
+	void quit() { exit=true; }
+
+	CommandTarget() { count=0; sum=0; in_order=true; exit=false; }
+};
+
+struct CommandConsumer {
+
+	CommandQueueMT *queue;
+	CommandTarget *target;
+};
+
+static void _command_consumer_thread(void *p_ud) {
+
+	CommandConsumer *c = (CommandConsumer*)p_ud;
+	while(!c->target->exit) {
+		c->queue->wait_and_flush();
+	}
+	c->queue->flush_all();
+}
+
+static bool _bench_command_queue(bool p_transforms) {
+
+	const int commands=1000000;
+
+	CommandQueueMT queue(true);
+	CommandTarget target;
+	CommandConsumer consumer;
+	consumer.queue=&queue;
+	consumer.target=&target;
+
+	Thread *thread=Thread::create(_command_consumer_thread,&consumer);
+
+	uint64_t t = OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<commands;i++) {
+
+		if (p_transforms) {
+			Matrix32 xform;
+			xform.elements[2].x=1;
+			queue.push(&target,&CommandTarget::add_transform,xform);
+		} else {
+			queue.push(&target,&CommandTarget::add,i);
+		}
+		if ((i%10000)==9999)
+			queue.mark_frame(); // as if every 10000 commands were a frame
+	}
+
+	uint64_t pushed = OS::get_singleton()->get_ticks_usec()-t;
+
+	int count=0;
+	queue.push_and_ret(&target,&CommandTarget::get_count,&count); // waits for everything before it
+	uint64_t elapsed = OS::get_singleton()->get_ticks_usec()-t;
+
+	queue.push(&target,&CommandTarget::quit);
+	Thread::wait_to_finish(thread);
+	memdelete(thread);
+
+	bool ok = count==commands && target.count==uint32_t(commands) && (p_transforms ? target.sum==uint64_t(commands) : target.in_order && target.sum==uint64_t(commands)*(commands-1)/2);
+
+	print_line("CommandQueueMT "+String(p_transforms?"Matrix32":"int")+": "+itos(commands)+" commands pushed in "+itos(pushed/1000)+"ms ("+rtos(double(pushed)*1000.0/commands)+"ns/push), flushed in "+itos(elapsed/1000)+"ms, "+itos(queue.get_frame_bytes_pushed()/1024)+"KB/frame, "+itos(queue.get_chunk_count())+" chunks, "+itos(queue.get_stall_count())+" stalls: "+String(ok?"PASS":"FAILED"));
+	return ok;
+}
+
+struct CommandProducer {
+
+	CommandQueueMT *queue;
+	CommandTarget *target;
+	int count;
+};
+
+static void _command_producer_thread(void *p_ud) {
+
+	CommandProducer *p = (CommandProducer*)p_ud;
+	for(int i=0;i<p->count;i++) {
+		p->queue->push(p->target,&CommandTarget::add_transform,Matrix32(0,Vector2(1,0)));
+	}
+}
+
+static bool _test_command_queue_producers() {
+
+	/* several producers, flushed from the main thread like the non threaded server wrappers do */
+
+	const int producers=4;
+	const int commands=100000;
+
+	CommandQueueMT queue(false);
+	CommandTarget target;
+	CommandProducer p[producers];
+	Thread *threads[producers];
+
+	for(int i=0;i<producers;i++) {
+		p[i].queue=&queue;
+		p[i].target=&target;
+		p[i].count=commands;
+		threads[i]=Thread::create(_command_producer_thread,&p[i]);
+	}
+
+	while(target.count<uint32_t(producers*commands)) {
+		queue.flush_all();
+	}
+
+	for(int i=0;i<producers;i++) {
+		Thread::wait_to_finish(threads[i]);
+		memdelete(threads[i]);
+	}
+	queue.flush_all();
+
+	bool ok = target.count==uint32_t(producers*commands) && target.sum==uint64_t(producers*commands);
+	print_line("CommandQueueMT "+itos(producers)+" producers: "+itos(target.count)+" commands, "+itos(queue.get_chunk_count())+" chunks, "+itos(queue.get_stall_count())+" stalls: "+String(ok?"PASS":"FAILED"));
+	return ok;
+}
+
+/* Threaded resource loading */
+
+class ThreadLoadResource : public Resource {
+
+	OBJ_TYPE(ThreadLoadResource,Resource);
+
+	int value;
+	DVector<uint8_t> data;
+	Array children;
+protected:
+
+	bool _set(const StringName& p_name, const Variant& p_value) {
+
+		if (p_name=="value") value=p_value;
+		else if (p_name=="data") data=p_value;
+		else if (p_name=="children") children=p_value;
+		else return false;
+		return true;
+	}
+	bool _get(const StringName& p_name,Variant &r_ret) const {
+
+		if (p_name=="value") r_ret=value;
+		else if (p_name=="data") r_ret=data;
+		else if (p_name=="children") r_ret=children;
+		else return false;
+		return true;
+	}
+	void _get_property_list( List<PropertyInfo> *p_list) const {
+
+		p_list->push_back( PropertyInfo(Variant::INT,"value") );
+		p_list->push_back( PropertyInfo(Variant::RAW_ARRAY,"data") );
+		p_list->push_back( PropertyInfo(Variant::ARRAY,"children") );
+	}
+public:
+
+	int get_value() const { return value; }
+	const Array& get_children() const { return children; }
+
+	ThreadLoadResource() { value=0; }
+};
+
+static bool _check_loaded_tree(const RES& p_root,int p_children) {
+
+	Ref<ThreadLoadResource> root=p_root;
+	if (root.is_null() || root->get_children().size()!=p_children)
+		return false;
+
+	for(int i=0;i<p_children;i++) {
+
+		Ref<ThreadLoadResource> child=root->get_children()[i];
+		if (child.is_null() || child->get_value()!=i)
+			return false;
+	}
+	return true;
+}
+
+static bool _test_threaded_loading() {
+
+	const int children=64;
+
+	ObjectTypeDB::register_type<ThreadLoadResource>();
+
+	DirAccess *da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	String dir=da->get_current_dir()+"/threaded_load_test";
+	da->make_dir_recursive(dir);
+
+	/* a root resource with external children, each big enough to take a while */
+	String root_path=dir+"/root.res";
+	{
+		Ref<ThreadLoadResource> root = memnew( ThreadLoadResource );
+		Array list;
+		for(int i=0;i<children;i++) {
+
+			Ref<ThreadLoadResource> child = memnew( ThreadLoadResource );
+			DVector<uint8_t> data;
+			data.resize(256*1024);
+			child->set("value",i);
+			child->set("data",data);
+			String path=dir+"/child_"+itos(i)+".res";
+			child->set_path(path);
+			ResourceSaver::save(path,child);
+			list.push_back(child);
+		}
+		root->set("children",list);
+		ResourceSaver::save(root_path,root);
+	}
+
+	bool ok=true;
+
+	uint64_t t=OS::get_singleton()->get_ticks_usec();
+	{
+		RES root=ResourceLoader::load(root_path);
+		ok = ok && _check_loaded_tree(root,children);
+	}
+	uint64_t sync_time=OS::get_singleton()->get_ticks_usec()-t;
+
+	t=OS::get_singleton()->get_ticks_usec();
+	float last_progress=0;
+	int polls=0;
+	{
+		ok = ok && ResourceLoader::load_threaded_request(root_path)==OK;
+
+		float progress=0;
+		while(ResourceLoader::load_threaded_poll(root_path,&progress)==ResourceLoader::THREAD_LOAD_IN_PROGRESS) {
+
+			if (progress<last_progress)
+				ok=false; // should never go back
+			last_progress=progress;
+			polls++;
+			OS::get_singleton()->delay_usec(100);
+		}
+
+		RES root=ResourceLoader::load_threaded_get(root_path);
+		ok = ok && _check_loaded_tree(root,children);
+		ok = ok && ResourceLoader::load_threaded_poll(root_path)==ResourceLoader::THREAD_LOAD_INVALID_RESOURCE; // collected
+	}
+	uint64_t threaded_time=OS::get_singleton()->get_ticks_usec()-t;
+
+	{
+		/* loading something that is queued or loading takes it over or waits for it, never loads it twice */
+		ok = ok && ResourceLoader::load_threaded_request(root_path)==OK;
+		RES child=ResourceLoader::load(dir+"/child_7.res");
+		RES root=ResourceLoader::load_threaded_get(root_path);
+		ok = ok && _check_loaded_tree(root,children) && Ref<ThreadLoadResource>(root)->get_children()[7]==Variant(child);
+	}
+
+	for(int i=0;i<children;i++) {
+		da->remove(dir+"/child_"+itos(i)+".res");
+	}
+	da->remove(root_path);
+	da->remove(dir);
+	memdelete(da);
+
+	print_line("ResourceLoader "+itos(children)+" dependencies: load "+rtos(sync_time/1000.0)+"ms, threaded "+rtos(threaded_time/1000.0)+"ms ("+itos(polls)+" polls, progress "+rtos(last_progress)+"): "+String(ok?"PASS":"FAILED"));
+	return ok;
+}
+
+/* WorkerThreadPool */
+
+struct TaskChain {
+
+	volatile uint32_t next;
+	bool in_order;
+};
+
+struct ChainLink {
+
+	TaskChain *chain;
+	uint32_t index;
+};
+
+static void _chain_task(void *p_ud) {
+
+	ChainLink *link=(ChainLink*)p_ud;
+	if (atomic_add(&link->chain->next,1)!=link->index+1)
+		link->chain->in_order=false; // ran before the task it depends on
+}
+
+struct GroupSum {
+
+	volatile uint64_t sum;
+	volatile uint32_t calls;
+};
+
+static void _group_sum(void *p_ud,int p_from,int p_to) {
+
+	GroupSum *gs=(GroupSum*)p_ud;
+	uint64_t s=0;
+	for(int i=p_from;i<p_to;i++)
+		s+=i;
+	atomic_add(&gs->sum,s);
+	atomic_add(&gs->calls,1);
+}
+
+static void _nested_task(void *p_ud) {
+
+	GroupSum *gs=(GroupSum*)p_ud;
+	WorkerThreadPool::get_singleton()->parallel_for(10000,_group_sum,gs,100); // nested, waits helping
+}
+
+static void _tiny_task(void *p_ud) {
+
+	atomic_add((volatile uint32_t*)p_ud,1);
+}
+
+static void _tiny_range(void *p_ud,int p_from,int p_to) {
+
+	atomic_add((volatile uint32_t*)p_ud,p_to-p_from);
+}
+
+static bool _test_worker_thread_pool() {
+
+	WorkerThreadPool *pool=WorkerThreadPool::get_singleton();
+	bool ok=true;
+
+	{
+		/* a chain where every task depends on the previous one, added in reverse so nothing is ready early */
+		const int links=1000;
+		TaskChain chain;
+		chain.next=0;
+		chain.in_order=true;
+		Vector<ChainLink> data;
+		data.resize(links);
+		Vector<WorkerThreadPool::TaskID> ids;
+		ids.resize(links);
+
+		WorkerThreadPool::TaskID gate=pool->add_group_task(_tiny_range,(void*)&chain.next,0); // completes right away
+		for(int i=0;i<links;i++) {
+			data[i].chain=&chain;
+			data[i].index=i;
+		}
+		ids[0]=pool->add_task(_chain_task,&data[0],&gate,1);
+		for(int i=1;i<links;i++)
+			ids[i]=pool->add_task(_chain_task,&data[i],&ids[i-1],1);
+		pool->wait_for_task(gate);
+
+		pool->wait_for_task(ids[links-1]);
+		ok = ok && pool->is_task_completed(ids[links/2]);
+		for(int i=0;i<links-1;i++)
+			pool->wait_for_task(ids[i]);
+		ok = ok && chain.in_order && chain.next==uint32_t(links);
+	}
+
+	{
+		/* groups depending on groups, and tasks that run parallel_for inside */
+		GroupSum a,b,n;
+		a.sum=b.sum=n.sum=0;
+		a.calls=b.calls=n.calls=0;
+		WorkerThreadPool::TaskID ga=pool->add_group_task(_group_sum,&a,1000000,1000);
+		WorkerThreadPool::TaskID gb=pool->add_group_task(_group_sum,&b,1000,7,&ga,1);
+		WorkerThreadPool::TaskID nested[8];
+		for(int i=0;i<8;i++)
+			nested[i]=pool->add_task(_nested_task,&n,&gb,1);
+		for(int i=0;i<8;i++)
+			pool->wait_for_task(nested[i]);
+		ok = ok && a.sum==uint64_t(1000000)*999999/2 && a.calls==1000;
+		ok = ok && b.sum==uint64_t(1000)*999/2 && b.calls==143;
+		ok = ok && n.sum==uint64_t(10000)*9999/2*8;
+		pool->wait_for_task(gb);
+		pool->wait_for_task(ga);
+	}
+
+	print_line("WorkerThreadPool "+itos(pool->get_thread_count())+" threads, dependencies and groups: "+String(ok?"PASS":"FAILED"));
+
+	/* scheduling overhead */
+	Vector<WorkerThreadPool::TaskID> ids;
+	for(int count=1000;count<=1000000;count*=10) {
+
+		volatile uint32_t counter=0;
+		ids.resize(count);
+
+		uint64_t t=OS::get_singleton()->get_ticks_usec();
+		for(int i=0;i<count;i++)
+			ids[i]=pool->add_task(_tiny_task,(void*)&counter);
+		for(int i=0;i<count;i++)
+			pool->wait_for_task(ids[i]);
+		uint64_t tasks_usec=OS::get_singleton()->get_ticks_usec()-t;
+		ok = ok && counter==uint32_t(count);
+
+		String line="WorkerThreadPool "+itos(count)+" tiny tasks: add+wait "+rtos(tasks_usec*1000.0/count)+"ns/task";
+
+		if (pool->get_thread_count()==1) {
+			// without workers parallel_for is a single direct call, there's no grain to compare
+			counter=0;
+			pool->parallel_for(count,_tiny_range,(void*)&counter,1);
+			ok = ok && counter==uint32_t(count);
+			print_line(line+", parallel_for grain sweep skipped (no worker threads)");
+			continue;
+		}
+
+		counter=0;
+		t=OS::get_singleton()->get_ticks_usec();
+		pool->parallel_for(count,_tiny_range,(void*)&counter,1);
+		uint64_t grain1_usec=OS::get_singleton()->get_ticks_usec()-t;
+		ok = ok && counter==uint32_t(count);
+
+		counter=0;
+		int grain=MAX(1,count/(pool->get_thread_count()*8));
+		t=OS::get_singleton()->get_ticks_usec();
+		pool->parallel_for(count,_tiny_range,(void*)&counter,grain);
+		uint64_t grain_usec=OS::get_singleton()->get_ticks_usec()-t;
+		ok = ok && counter==uint32_t(count);
+
+		print_line(line+", parallel_for grain 1 "+rtos(grain1_usec*1000.0/count)+"ns/element, grain "+itos(grain)+" "+rtos(grain_usec*1000.0/count)+"ns/element");
+	}
+
+	print_line(String("WorkerThreadPool scheduling: ")+(ok?"PASS":"FAILED"));
+	return ok;
+}
+
+MainLoop* test() {
+
+	_bench_command_queue(false);
+	_bench_command_queue(true);
+	_test_command_queue_producers();
+	_test_threaded_loading();
+	_test_worker_thread_pool();
+
+	return NULL;
+}
+
+}
@@ -132,16 +132,19 @@ void Array::operator=(const Array& p_array) {
 }
 void Array::push_back(const Variant& p_value) {
 
+	MemoryCategoryScope scope(Memory::ALLOC_VARIANT);
 	_p->array.push_back(p_value);
 }
 
 Error Array::resize(int p_new_size) {
 
+	MemoryCategoryScope scope(Memory::ALLOC_VARIANT);
 	return _p->array.resize(p_new_size);
 }
 
 void Array::insert(int p_pos, const Variant& p_value) {
 
+	MemoryCategoryScope scope(Memory::ALLOC_VARIANT);
 	_p->array.insert(p_pos,p_value);
 }
 
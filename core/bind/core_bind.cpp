@@ -69,6 +69,28 @@ RES _ResourceLoader::load(const String &p_path,const String& p_type_hint, bool p
 	return ret;
 }
 
+Error _ResourceLoader::load_threaded_request(const String &p_path,const String& p_type_hint) {
+
+	return ResourceLoader::load_threaded_request(p_path,p_type_hint);
+}
+
+int _ResourceLoader::load_threaded_poll(const String &p_path) {
+
+	return ResourceLoader::load_threaded_poll(p_path);
+}
+
+float _ResourceLoader::load_threaded_get_progress(const String &p_path) {
+
+	float progress=0;
+	ResourceLoader::load_threaded_poll(p_path,&progress);
+	return progress;
+}
+
+RES _ResourceLoader::load_threaded_get(const String &p_path) {
+
+	return ResourceLoader::load_threaded_get(p_path);
+}
+
 DVector<String> _ResourceLoader::get_recognized_extensions_for_type(const String& p_type) {
 
 	List<String> exts;
@@ -116,11 +138,20 @@ void _ResourceLoader::_bind_methods() {
 
 	ObjectTypeDB::bind_method(_MD("load_interactive:ResourceInteractiveLoader","path","type_hint"),&_ResourceLoader::load_interactive,DEFVAL(""));
 	ObjectTypeDB::bind_method(_MD("load:Resource","path","type_hint", "p_no_cache"),&_ResourceLoader::load,DEFVAL(""), DEFVAL(false));
+	ObjectTypeDB::bind_method(_MD("load_threaded_request","path","type_hint"),&_ResourceLoader::load_threaded_request,DEFVAL(""));
+	ObjectTypeDB::bind_method(_MD("load_threaded_poll","path"),&_ResourceLoader::load_threaded_poll);
+	ObjectTypeDB::bind_method(_MD("load_threaded_get_progress","path"),&_ResourceLoader::load_threaded_get_progress);
+	ObjectTypeDB::bind_method(_MD("load_threaded_get:Resource","path"),&_ResourceLoader::load_threaded_get);
 	ObjectTypeDB::bind_method(_MD("load_import_metadata:ResourceImportMetadata","path"),&_ResourceLoader::load_import_metadata);
 	ObjectTypeDB::bind_method(_MD("get_recognized_extensions_for_type","type"),&_ResourceLoader::get_recognized_extensions_for_type);
 	ObjectTypeDB::bind_method(_MD("set_abort_on_missing_resources","abort"),&_ResourceLoader::set_abort_on_missing_resources);
 	ObjectTypeDB::bind_method(_MD("get_dependencies","path"),&_ResourceLoader::get_dependencies);
 	ObjectTypeDB::bind_method(_MD("has","path"),&_ResourceLoader::has);
+
+	BIND_CONSTANT(THREAD_LOAD_INVALID_RESOURCE);
+	BIND_CONSTANT(THREAD_LOAD_IN_PROGRESS);
+	BIND_CONSTANT(THREAD_LOAD_FAILED);
+	BIND_CONSTANT(THREAD_LOAD_LOADED);
 }
 
 _ResourceLoader::_ResourceLoader() {
@@ -2375,3 +2406,153 @@ _Thread::~_Thread() {
 	}
 	ERR_FAIL_COND(active==true);
 }
+
+///////////////
+
+_WorkerThreadPool *_WorkerThreadPool::singleton=NULL;
+
+_WorkerThreadPool *_WorkerThreadPool::get_singleton() {
+
+	return singleton;
+}
+
+void _WorkerThreadPool::_call(ScriptTask *p_task,const Variant **p_args,int p_argcount) {
+
+	Object *obj=ObjectDB::get_instance(p_task->instance);
+	ERR_FAIL_COND(!obj);
+
+	Variant::CallError ce;
+	obj->call(p_task->method,p_args,p_argcount,ce);
+	if (ce.error!=Variant::CallError::CALL_OK) {
+
+		ERR_EXPLAIN("Error calling task method '"+String(p_task->method)+"': "+Variant::get_call_error_text(obj,p_task->method,p_args,p_argcount,ce));
+		ERR_FAIL();
+	}
+}
+
+void _WorkerThreadPool::_task_func(void *p_userdata) {
+
+	ScriptTask *task=(ScriptTask*)p_userdata;
+	const Variant *args[1]={&task->userdata};
+	_call(task,args,1);
+}
+
+void _WorkerThreadPool::_group_func(void *p_userdata,int p_from,int p_to) {
+
+	ScriptTask *task=(ScriptTask*)p_userdata;
+	for(int i=p_from;i<p_to;i++) {
+
+		Variant index=i;
+		const Variant *args[2]={&index,&task->userdata};
+		_call(task,args,2);
+	}
+}
+
+int _WorkerThreadPool::_add_script_task(Object *p_instance,const StringName& p_method,const Variant& p_userdata,const Array& p_dependencies,bool p_group,int p_elements,int p_grain) {
+
+	WorkerThreadPool *pool=WorkerThreadPool::get_singleton();
+	ERR_FAIL_COND_V(!pool,WorkerThreadPool::INVALID_TASK_ID);
+	ERR_FAIL_COND_V(!p_instance,WorkerThreadPool::INVALID_TASK_ID);
+	ERR_FAIL_COND_V(p_method==StringName(),WorkerThreadPool::INVALID_TASK_ID);
+
+	ScriptTask *task=memnew(ScriptTask);
+	task->instance=p_instance->get_instance_ID();
+	task->method=p_method;
+	task->userdata=p_userdata;
+
+	Vector<WorkerThreadPool::TaskID> deps;
+	deps.resize(p_dependencies.size());
+	for(int i=0;i<p_dependencies.size();i++)
+		deps[i]=int(p_dependencies[i]);
+
+	if (mutex)
+		mutex->lock(); // so the task can't be waited for before it's known
+
+	WorkerThreadPool::TaskID id;
+	if (p_group)
+		id=pool->add_group_task(_group_func,task,p_elements,p_grain,deps.ptr(),deps.size());
+	else
+		id=pool->add_task(_task_func,task,deps.ptr(),deps.size());
+
+	if (id!=WorkerThreadPool::INVALID_TASK_ID)
+		script_tasks.set(id,task);
+	else
+		memdelete(task);
+
+	if (mutex)
+		mutex->unlock();
+
+	return id;
+}
+
+int _WorkerThreadPool::add_task(Object *p_instance,const StringName& p_method,const Variant& p_userdata,const Array& p_dependencies) {
+
+	return _add_script_task(p_instance,p_method,p_userdata,p_dependencies,false,1,1);
+}
+
+int _WorkerThreadPool::add_group_task(Object *p_instance,const StringName& p_method,int p_elements,const Variant& p_userdata,const Array& p_dependencies) {
+
+	// every element is a script call, which outweighs the scheduling, so one element per chunk
+	return _add_script_task(p_instance,p_method,p_userdata,p_dependencies,true,p_elements,1);
+}
+
+bool _WorkerThreadPool::is_task_completed(int p_task) const {
+
+	ERR_FAIL_COND_V(!WorkerThreadPool::get_singleton(),false);
+	return WorkerThreadPool::get_singleton()->is_task_completed(p_task);
+}
+
+void _WorkerThreadPool::wait_for_task(int p_task) {
+
+	ERR_FAIL_COND(!WorkerThreadPool::get_singleton());
+
+	if (mutex)
+		mutex->lock();
+	ScriptTask **taskp=script_tasks.getptr(p_task);
+	ScriptTask *task=taskp ? *taskp : NULL;
+	if (task)
+		script_tasks.erase(p_task);
+	if (mutex)
+		mutex->unlock();
+
+	ERR_FAIL_COND(!task);
+
+	WorkerThreadPool::get_singleton()->wait_for_task(p_task);
+	memdelete(task);
+}
+
+int _WorkerThreadPool::get_thread_count() const {
+
+	return WorkerThreadPool::get_singleton() ? WorkerThreadPool::get_singleton()->get_thread_count() : 1;
+}
+
+void _WorkerThreadPool::_bind_methods() {
+
+	ObjectTypeDB::bind_method(_MD("add_task","instance","method","userdata","dependencies"),&_WorkerThreadPool::add_task,DEFVAL(Variant()),DEFVAL(Array()));
+	ObjectTypeDB::bind_method(_MD("add_group_task","instance","method","elements","userdata","dependencies"),&_WorkerThreadPool::add_group_task,DEFVAL(Variant()),DEFVAL(Array()));
+	ObjectTypeDB::bind_method(_MD("is_task_completed","task"),&_WorkerThreadPool::is_task_completed);
+	ObjectTypeDB::bind_method(_MD("wait_for_task","task"),&_WorkerThreadPool::wait_for_task);
+	ObjectTypeDB::bind_method(_MD("get_thread_count"),&_WorkerThreadPool::get_thread_count);
+
+}
+
+_WorkerThreadPool::_WorkerThreadPool() {
+
+	singleton=this;
+	mutex=Mutex::create();
+}
+
+_WorkerThreadPool::~_WorkerThreadPool() {
+
+	const int *k=NULL;
+	while((k=script_tasks.next(k))) {
+
+		// never waited for, but it may still run and use its data
+		WorkerThreadPool::get_singleton()->wait_for_task(*k);
+		memdelete(script_tasks[*k]);
+	}
+
+	if (mutex)
+		memdelete(mutex);
+	singleton=NULL;
+}
@@ -35,6 +35,7 @@
 #include "os/dir_access.h"
 #include "os/thread.h"
 #include "os/semaphore.h"
+#include "os/worker_thread_pool.h"
 
 
 class _ResourceLoader : public Object  {
@@ -46,10 +47,20 @@ protected:
 	static _ResourceLoader *singleton;
 public:
 
+	enum ThreadLoadStatus {
+		THREAD_LOAD_INVALID_RESOURCE=ResourceLoader::THREAD_LOAD_INVALID_RESOURCE,
+		THREAD_LOAD_IN_PROGRESS=ResourceLoader::THREAD_LOAD_IN_PROGRESS,
+		THREAD_LOAD_FAILED=ResourceLoader::THREAD_LOAD_FAILED,
+		THREAD_LOAD_LOADED=ResourceLoader::THREAD_LOAD_LOADED
+	};
 
 	static _ResourceLoader *get_singleton() { return singleton; }
 	Ref<ResourceInteractiveLoader> load_interactive(const String& p_path,const String& p_type_hint="");
 	RES load(const String &p_path,const String& p_type_hint="", bool p_no_cache = false);
+	Error load_threaded_request(const String &p_path,const String& p_type_hint="");
+	int load_threaded_poll(const String &p_path);
+	float load_threaded_get_progress(const String &p_path);
+	RES load_threaded_get(const String &p_path);
 	DVector<String> get_recognized_extensions_for_type(const String& p_type);
 	void set_abort_on_missing_resources(bool p_abort);
 	StringArray get_dependencies(const String& p_path);
@@ -586,4 +597,43 @@ public:
 	~_Thread();
 };
 
+class _WorkerThreadPool : public Object {
+
+	OBJ_TYPE(_WorkerThreadPool,Object);
+
+	struct ScriptTask {
+
+		ObjectID instance;
+		StringName method;
+		Variant userdata;
+	};
+
+	Mutex *mutex;
+	HashMap<int,ScriptTask*> script_tasks;
+
+	static _WorkerThreadPool *singleton;
+
+	static void _call(ScriptTask *p_task,const Variant **p_args,int p_argcount);
+	static void _task_func(void *p_userdata);
+	static void _group_func(void *p_userdata,int p_from,int p_to);
+
+	int _add_script_task(Object *p_instance,const StringName& p_method,const Variant& p_userdata,const Array& p_dependencies,bool p_group,int p_elements,int p_grain);
+
+protected:
+
+	static void _bind_methods();
+public:
+
+	static _WorkerThreadPool *get_singleton();
+
+	int add_task(Object *p_instance,const StringName& p_method,const Variant& p_userdata=Variant(),const Array& p_dependencies=Array());
+	int add_group_task(Object *p_instance,const StringName& p_method,int p_elements,const Variant& p_userdata=Variant(),const Array& p_dependencies=Array());
+	bool is_task_completed(int p_task) const;
+	void wait_for_task(int p_task);
+	int get_thread_count() const;
+
+	_WorkerThreadPool();
+	~_WorkerThreadPool();
+};
+
 #endif // CORE_BIND_H
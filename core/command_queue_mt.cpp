@@ -29,16 +29,13 @@
 #include "command_queue_mt.h"
 #include "os/os.h"
 
-void CommandQueueMT::lock() {
+void CommandQueueMT::_lock_contended() {
 
-	if (mutex)
-		mutex->lock();
-}
-
-void CommandQueueMT::unlock() {
-
-	if (mutex)
-		mutex->unlock();
+	// another thread is pushing, rare enough to just yield until it is done
+	atomic_add(&stalls,1);
+	while(!atomic_cas(&producer_lock,uint32_t(0),uint32_t(1))) {
+		OS::get_singleton()->delay_usec(0);
+	}
 }
 
 void CommandQueueMT::wait_for_flush() {
@@ -47,6 +44,72 @@ void CommandQueueMT::wait_for_flush() {
 	OS::get_singleton()->delay_usec(1000);
 }
 
+CommandQueueMT::Chunk *CommandQueueMT::_alloc_chunk() {
+
+	Chunk *chunk = (Chunk*)memalloc(sizeof(Chunk)+CHUNK_SIZE);
+	chunk->next=NULL;
+	chunk->written=0;
+	chunk->read=0;
+	chunk->free_next=NULL;
+	chunk_count++;
+	return chunk;
+}
+
+void CommandQueueMT::_next_write_chunk() {
+
+	if (!spare_chunks)
+		spare_chunks=atomic_exchange(&free_chunks,(Chunk*)NULL);
+
+	Chunk *chunk;
+	if (spare_chunks) {
+		chunk=spare_chunks;
+		spare_chunks=chunk->free_next;
+		chunk->next=NULL;
+		chunk->written=0;
+		chunk->read=0;
+		chunk->free_next=NULL;
+	} else {
+		chunk=_alloc_chunk(); // consumer is behind, grow instead of waiting for it
+	}
+
+	// everything written so far is published before the consumer can see the next chunk
+	atomic_store(&write_chunk->written,write_pos);
+	atomic_store(&write_chunk->next,chunk);
+	write_chunk=chunk;
+	write_pos=0;
+}
+
+void CommandQueueMT::_release_chunk(Chunk *p_chunk) {
+
+	// only the consumer pushes here and the producer takes the whole list, so no ABA
+	while(true) {
+		Chunk *first=atomic_load(&free_chunks);
+		p_chunk->free_next=first;
+		if (atomic_cas(&free_chunks,first,p_chunk))
+			break;
+	}
+}
+
+void CommandQueueMT::_wait_for_commands() {
+
+	atomic_cas(&consumer_waiting,uint32_t(0),uint32_t(1)); // full barrier
+
+	Chunk *chunk=read_chunk;
+	bool pending = chunk->read!=atomic_load(&chunk->written) || atomic_load(&chunk->next)!=NULL;
+
+	if (pending && atomic_cas(&consumer_waiting,uint32_t(1),uint32_t(0)))
+		return;
+
+	// either nothing to do, or a producer already took the flag and is posting
+	sync->wait();
+}
+
+void CommandQueueMT::mark_frame() {
+
+	frame_bytes=uint32_t(bytes_pushed-frame_start_bytes);
+	frame_start_bytes=bytes_pushed;
+}
+
 CommandQueueMT::SyncSemaphore* CommandQueueMT::_alloc_sync_sem() {
 
 	int idx=-1;
@@ -63,6 +126,7 @@ CommandQueueMT::SyncSemaphore* CommandQueueMT::_alloc_sync_sem() {
 		}
 
 		if (idx==-1) {
+			atomic_add(&stalls,1);
 			wait_for_flush();
 		} else {
 			break;
@@ -75,9 +139,25 @@ CommandQueueMT::SyncSemaphore* CommandQueueMT::_alloc_sync_sem() {
 
 CommandQueueMT::CommandQueueMT(bool p_sync){
 
-	read_ptr=0;
-	write_ptr=0;
-	mutex = Mutex::create();
+	chunk_count=0;
+	bytes_pushed=0;
+	frame_start_bytes=0;
+	frame_bytes=0;
+	stalls=0;
+	producer_lock=0;
+	consumer_waiting=0;
+
+	write_chunk=_alloc_chunk();
+	read_chunk=write_chunk;
+	write_pos=0;
+	free_chunks=NULL;
+	spare_chunks=NULL;
+
+	for(int i=1;i<(COMMAND_MEM_SIZE_KB*1024)/CHUNK_SIZE;i++) {
+		Chunk *chunk=_alloc_chunk();
+		chunk->free_next=spare_chunks;
+		spare_chunks=chunk;
+	}
 
 	for(int i=0;i<SYNC_SEMAPHORES;i++) {
 
@@ -97,11 +177,19 @@ CommandQueueMT::~CommandQueueMT() {
 
 	if (sync)
 		memdelete(sync);
-	memdelete(mutex);
 	for(int i=0;i<SYNC_SEMAPHORES;i++) {
 
 		memdelete(sync_sems[i].sem);
 	}
-}
 
+	Chunk *lists[3]={read_chunk,spare_chunks,free_chunks};
+	for(int i=0;i<3;i++) {
 
+		Chunk *chunk=lists[i];
+		while(chunk) {
+			Chunk *next = i==0 ? chunk->next : chunk->free_next;
+			memfree(chunk);
+			chunk=next;
+		}
+	}
+}
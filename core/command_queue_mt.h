@@ -32,6 +32,7 @@
 #include "typedefs.h"
 #include "os/semaphore.h"
 #include "os/mutex.h"
+#include "safe_refcount.h"
 #include "os/memory.h"
 #include "simple_type.h"
 /**
@@ -43,7 +44,7 @@ class CommandQueueMT {
 	struct SyncSemaphore {
 
 		Semaphore *sem;
-		bool in_use;
+		volatile bool in_use;
 	};
 
 	struct CommandBase {
@@ -447,115 +448,133 @@ class CommandQueueMT {
 
 	/***** BASE *******/
 
+	/* Commands are written to a chain of chunks that grows as needed, so pushing never has to
+	   wait for the consumer. Producers claim the write side with an atomic flag (usually there
+	   is only one, the main thread), the consumer never takes a lock. Flushed chunks go back to
+	   the producer through a lock-free free list. */
+
 	enum {
-		COMMAND_MEM_SIZE_KB=256,
-		COMMAND_MEM_SIZE=COMMAND_MEM_SIZE_KB*1024,
+		COMMAND_MEM_SIZE_KB=256, // preallocated
+		CHUNK_SIZE=64*1024,
+		COMMAND_ALIGN=8,
 		SYNC_SEMAPHORES=8
 	};
 
+	struct Chunk {
 
-	uint8_t command_mem[COMMAND_MEM_SIZE];
-	uint32_t read_ptr;
-	uint32_t write_ptr;
-	SyncSemaphore sync_sems[SYNC_SEMAPHORES];
-	Mutex *mutex;
-	Semaphore *sync;
-
+		Chunk * volatile next; // set by the producer once it stops writing here
+		volatile uint32_t written; // bytes published by the producer
+		uint32_t read; // consumer only
+		Chunk *free_next;
 
-	template<class T>
-	T* allocate() {
+		_FORCE_INLINE_ uint8_t *data() { return reinterpret_cast<uint8_t*>(this+1); }
+	};
 
-		// alloc size is size+T+safeguard
-		uint32_t alloc_size=sizeof(T)+sizeof(uint32_t);
+	Chunk *read_chunk; // consumer side
+	Chunk *write_chunk; // producer side
+	uint32_t write_pos;
+	Chunk *spare_chunks; // producer side
+	Chunk * volatile free_chunks; // flushed by the consumer, taken all at once by the producer
 
-		tryagain:
+	volatile uint32_t producer_lock;
+	volatile uint32_t consumer_waiting;
 
-		if (write_ptr < read_ptr) {
-			// behind read_ptr, check that there is room
-			if ( (read_ptr-write_ptr) <= alloc_size )
-				return NULL;
-		} else if (write_ptr >= read_ptr) {
-			// ahead of read_ptr, check that there is room
+	SyncSemaphore sync_sems[SYNC_SEMAPHORES];
+	Semaphore *sync;
 
+	/* statistics */
+	uint64_t bytes_pushed;
+	uint64_t frame_start_bytes;
+	uint32_t frame_bytes;
+	volatile uint32_t stalls;
+	uint32_t chunk_count;
+
+	Chunk *_alloc_chunk();
+	void _next_write_chunk();
+	void _release_chunk(Chunk *p_chunk);
+	void _lock_contended();
+	void _wait_for_commands();
+	void wait_for_flush();
 
-			if ( (COMMAND_MEM_SIZE-write_ptr) < alloc_size+4 ) {
-				// no room at the end, wrap down;
+	template<class T>
+	T* allocate() {
 
-				if (read_ptr==0) // dont want write_ptr to become read_ptr
-					return NULL;
+		// size header, then the command
+		uint32_t alloc_size=(sizeof(uint32_t)*2+sizeof(T)+COMMAND_ALIGN-1)&~uint32_t(COMMAND_ALIGN-1);
+		ERR_FAIL_COND_V(alloc_size>CHUNK_SIZE,NULL);
 
-				// if this happens, it's a bug
-				ERR_FAIL_COND_V( (COMMAND_MEM_SIZE-write_ptr) < sizeof(uint32_t), NULL );
-				// zero means, wrap to begining
+		if (write_pos+alloc_size>CHUNK_SIZE)
+			_next_write_chunk();
 
-				uint32_t * p = (uint32_t*)&command_mem[write_ptr];
-				*p=0;
-				write_ptr=0;
-				goto tryagain;
-			}
-		}
-		// allocate the size
-		uint32_t * p = (uint32_t*)&command_mem[write_ptr];
-		*p=sizeof(T);
-		write_ptr+=sizeof(uint32_t);
-		// allocate the command
-		T* cmd = memnew_placement( &command_mem[write_ptr], T );
-		write_ptr+=sizeof(T);
-		return cmd;
+		uint8_t *ptr=&write_chunk->data()[write_pos];
+		*(uint32_t*)ptr=alloc_size;
+		write_pos+=alloc_size;
+		bytes_pushed+=alloc_size;
 
+		return memnew_placement( ptr+sizeof(uint32_t)*2, T );
 	}
 
 	template<class T>
 	T* allocate_and_lock() {
 
 		lock();
-		T* ret;
+		return allocate<T>();
+	}
 
-		while ( (ret=allocate<T>())==NULL ) {
+	_FORCE_INLINE_ void lock() {
 
-			unlock();
-			// sleep a little until fetch happened and some room is made
-			wait_for_flush();
-			lock();
+		if (!atomic_cas(&producer_lock,uint32_t(0),uint32_t(1)))
+			_lock_contended();
+	}
 
-		}
+	_FORCE_INLINE_ void unlock() {
 
-		return ret;
+		atomic_store(&producer_lock,uint32_t(0));
 	}
 
+	_FORCE_INLINE_ void commit_and_unlock() {
+
+		atomic_store(&write_chunk->written,write_pos);
+		unlock();
+
+		// full barrier, pairs with the one in _wait_for_commands() so a sleeping consumer is never missed
+		if (sync && atomic_cas(&consumer_waiting,uint32_t(1),uint32_t(0)))
+			sync->post();
+	}
 
 	bool flush_one() {
 
-		tryagain:
+		Chunk *chunk=read_chunk;
 
-		// tried to read an empty queue
-		if (read_ptr == write_ptr )
-			return false;
+		while(chunk->read==atomic_load(&chunk->written)) {
 
-		uint32_t size = *(uint32_t*)( &command_mem[read_ptr] );
+			Chunk *next=atomic_load(&chunk->next);
+			if (!next)
+				return false; // tried to read an empty queue
+
+			// the producer publishes everything before linking the next chunk
+			if (chunk->read!=atomic_load(&chunk->written))
+				break;
 
-		if (size==0) {
-			//end of ringbuffer, wrap
-			read_ptr=0;
-			goto tryagain;
+			read_chunk=next;
+			_release_chunk(chunk);
+			chunk=next;
 		}
 
-		read_ptr+=sizeof(uint32_t);
+		uint8_t *ptr=&chunk->data()[chunk->read];
+		uint32_t size=*(uint32_t*)ptr;
 
-		CommandBase *cmd = reinterpret_cast<CommandBase*>( &command_mem[read_ptr] );
+		CommandBase *cmd = reinterpret_cast<CommandBase*>( ptr+sizeof(uint32_t)*2 );
 
 		cmd->call();
 		cmd->~CommandBase();
 
-		read_ptr+=size;
+		chunk->read+=size;
 
 		return true;
 	}
 
 
-	void lock();
-	void unlock();
-	void wait_for_flush();
 	SyncSemaphore* _alloc_sync_sem();
 
 
@@ -571,9 +590,7 @@ public:
 		cmd->instance=p_instance;
 		cmd->method=p_method;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1>
@@ -585,9 +602,7 @@ public:
 		cmd->method=p_method;
 		cmd->p1=p1;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2>
@@ -600,9 +615,7 @@ public:
 		cmd->p1=p1;
 		cmd->p2=p2;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2, class P3>
@@ -616,9 +629,7 @@ public:
 		cmd->p2=p2;
 		cmd->p3=p3;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2, class P3, class P4>
@@ -633,9 +644,7 @@ public:
 		cmd->p3=p3;
 		cmd->p4=p4;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2, class P3, class P4, class P5>
@@ -651,9 +660,7 @@ public:
 		cmd->p4=p4;
 		cmd->p5=p5;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2, class P3, class P4, class P5, class P6>
@@ -670,9 +677,7 @@ public:
 		cmd->p5=p5;
 		cmd->p6=p6;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2, class P3, class P4, class P5, class P6, class P7>
@@ -690,9 +695,7 @@ public:
 		cmd->p6=p6;
 		cmd->p7=p7;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2, class P3, class P4, class P5, class P6, class P7,class P8>
@@ -711,9 +714,7 @@ public:
 		cmd->p7=p7;
 		cmd->p8=p8;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 	/*** PUSH AND RET COMMANDS ***/
 
@@ -729,9 +730,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -747,9 +746,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -766,9 +763,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -786,9 +781,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -807,9 +800,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -829,9 +820,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -852,9 +841,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -876,9 +863,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -901,9 +886,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -919,9 +902,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -937,9 +918,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -956,9 +935,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -976,9 +953,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -997,9 +972,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -1019,9 +992,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -1042,9 +1013,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -1066,9 +1035,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -1091,32 +1058,42 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
+	/* flushing must always happen from the same thread */
+
 	void wait_and_flush_one() {
 		ERR_FAIL_COND(!sync);
-		sync->wait();
-		lock();
-		flush_one();
-		unlock();
+		while(!flush_one())
+			_wait_for_commands();
+	}
+
+	void wait_and_flush() {
+		ERR_FAIL_COND(!sync);
+		while(!flush_one())
+			_wait_for_commands();
+		while(flush_one()) {} // run everything available in one go
 	}
 
 	void flush_all() {
 
 		//ERR_FAIL_COND(sync);
-		lock();
 		while (true) {
 			bool exit = !flush_one();
 			if (exit)
 				break;
 		}
-		unlock();
 	}
 
+	void mark_frame(); // called by the producer once per frame, see get_frame_bytes_pushed()
+
+	uint64_t get_bytes_pushed() const { return bytes_pushed; }
+	uint32_t get_frame_bytes_pushed() const { return frame_bytes; } // during the last frame
+	uint32_t get_stall_count() const { return stalls; } // times a push had to wait for another thread
+	int get_chunk_count() const { return chunk_count; }
+
 	CommandQueueMT(bool p_sync);
 	~CommandQueueMT();
 
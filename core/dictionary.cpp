@@ -31,35 +31,310 @@
 #include "variant.h"
 #include "io/json.h"
 
-struct _DictionaryVariantHash {
+/* Entries are kept in insertion order, in blocks that double in size, so growing never moves them.
+   An open addressing table of entry indices is used for lookups. Erased entries are left as holes,
+   so erasing never moves the others either. The holes are compacted away when they are the
+   majority and an insert would need a new block; that insert moves every entry, so references to
+   values only stay valid until an insert follows erasing most of the dictionary (see dictionary.h). */
 
-	static _FORCE_INLINE_ uint32_t hash(const Variant &p_variant)  { return p_variant.hash(); }
-};
+struct DictionaryPrivate {
 
+	enum {
+		MIN_BLOCK_SHIFT=3,
+		MAX_BLOCKS=32-MIN_BLOCK_SHIFT,
+		MIN_INDEX_SIZE=16,
+		INDEX_EMPTY=0,
+		INDEX_ERASED=0xFFFFFFFF // other values are entry index + 1
+	};
 
-struct DictionaryPrivate {
+	struct Entry {
+
+		Variant key; //first, so a key pointer is an entry pointer
+		Variant value;
+		uint32_t hash;
+		bool erased;
+	};
 
 	SafeRefCount refcount;
-	HashMap<Variant,Variant,_DictionaryVariantHash> variant_map;
 	bool shared;
 
+	Entry *blocks[MAX_BLOCKS];
+	uint32_t used; // entries, including the erased ones
+	uint32_t erased;
+
+	uint32_t *index;
+	uint32_t index_size; // power of two
+	uint32_t index_used; // including erased markers
+
+	static _FORCE_INLINE_ uint32_t _msb(uint32_t p_value) {
+#if defined(__GNUC__) || defined(__clang__)
+		return 31-__builtin_clz(p_value);
+#else
+		uint32_t bit=0;
+		while(p_value>>=1)
+			bit++;
+		return bit;
+#endif
+	}
+
+	_FORCE_INLINE_ Entry* entry(uint32_t p_idx) const {
+
+		uint32_t pos=p_idx+(1<<MIN_BLOCK_SHIFT);
+		uint32_t bit=_msb(pos);
+		return &blocks[bit-MIN_BLOCK_SHIFT][pos-(1<<bit)];
+	}
+
+	_FORCE_INLINE_ uint32_t size() const {
+
+		return used-erased;
+	}
+
+	int32_t find(const Variant& p_key,uint32_t p_hash) const {
+
+		if (!index)
+			return -1;
+
+		uint32_t mask=index_size-1;
+		uint32_t pos=p_hash&mask;
+
+		while(true) {
+
+			uint32_t idx=index[pos];
+			if (idx==INDEX_EMPTY)
+				return -1;
+			if (idx!=INDEX_ERASED) {
+				const Entry *e=entry(idx-1);
+				if (e->hash==p_hash && e->key==p_key)
+					return idx-1;
+			}
+			pos=(pos+1)&mask;
+		}
+
+		return -1;
+	}
+
+	_FORCE_INLINE_ const Entry* find_entry(const Variant& p_key) const {
+
+		int32_t idx=find(p_key,p_key.hash());
+		return idx<0 ? NULL : entry(idx);
+	}
+
+	void rebuild_index(uint32_t p_size) {
+
+		if (index)
+			memfree(index);
+		index_size=p_size;
+		index=(uint32_t*)memalloc(sizeof(uint32_t)*index_size);
+		for(uint32_t i=0;i<index_size;i++)
+			index[i]=INDEX_EMPTY;
+		index_used=0;
+
+		uint32_t mask=index_size-1;
+		for(uint32_t i=0;i<used;i++) {
+
+			const Entry *e=entry(i);
+			if (e->erased)
+				continue;
+			uint32_t pos=e->hash&mask;
+			while(index[pos]!=INDEX_EMPTY)
+				pos=(pos+1)&mask;
+			index[pos]=i+1;
+			index_used++;
+		}
+	}
+
+	Entry* insert(const Variant& p_key) {
+
+		uint32_t hash=p_key.hash();
+		int32_t found=find(p_key,hash);
+		if (found>=0)
+			return entry(found);
+
+		if (erased*2>used && !blocks[_msb(used+(1<<MIN_BLOCK_SHIFT))-MIN_BLOCK_SHIFT])
+			compact();
+
+		/* at most 3/4 of the index table used, erased markers included */
+		if ((index_used+1)*4 > index_size*3) {
+			uint32_t new_size=MIN_INDEX_SIZE;
+			while((size()+1)*2 > new_size)
+				new_size<<=1;
+			rebuild_index(new_size);
+		}
+
+		uint32_t pos=used+(1<<MIN_BLOCK_SHIFT);
+		uint32_t bit=_msb(pos);
+		Entry *&block=blocks[bit-MIN_BLOCK_SHIFT];
+		if (!block)
+			block=(Entry*)memalloc(sizeof(Entry)*(1<<bit));
+
+		Entry *e=memnew_placement(&block[pos-(1<<bit)],Entry);
+		e->key=p_key;
+		e->hash=hash;
+		e->erased=false;
+
+		uint32_t mask=index_size-1;
+		uint32_t ipos=hash&mask;
+		while(index[ipos]!=INDEX_EMPTY && index[ipos]!=INDEX_ERASED)
+			ipos=(ipos+1)&mask;
+		if (index[ipos]==INDEX_EMPTY)
+			index_used++;
+		index[ipos]=used+1;
+		used++;
+
+		return e;
+	}
+
+	bool erase(const Variant& p_key) {
+
+		uint32_t hash=p_key.hash();
+		int32_t found=find(p_key,hash);
+		if (found<0)
+			return false;
+
+		uint32_t mask=index_size-1;
+		uint32_t ipos=hash&mask;
+		while(index[ipos]!=uint32_t(found+1))
+			ipos=(ipos+1)&mask;
+		index[ipos]=INDEX_ERASED;
+
+		Entry *e=entry(found);
+		e->key=Variant();
+		e->value=Variant();
+		e->erased=true;
+		erased++;
+
+		if (erased==used)
+			clear();
+
+		return true;
+	}
+
+	void compact() {
+
+		uint32_t to=0;
+		for(uint32_t i=0;i<used;i++) {
+
+			Entry *e=entry(i);
+			if (e->erased)
+				continue;
+			if (i!=to) {
+				Entry *dst=entry(to);
+				dst->key=e->key;
+				dst->value=e->value;
+				dst->hash=e->hash;
+				dst->erased=false;
+			}
+			to++;
+		}
+
+		for(uint32_t i=to;i<used;i++)
+			entry(i)->~Entry();
+
+		used=to;
+		erased=0;
+		_free_unused_blocks();
+		rebuild_index(index_size);
+	}
+
+	void _free_unused_blocks() {
+
+		for(int i=0;i<MAX_BLOCKS;i++) {
+
+			if (!blocks[i])
+				continue;
+			uint32_t first=(1<<(i+MIN_BLOCK_SHIFT))-(1<<MIN_BLOCK_SHIFT); //index of the first entry in block
+			if (first>=used) {
+				memfree(blocks[i]);
+				blocks[i]=NULL;
+			}
+		}
+	}
+
+	void clear() {
+
+		for(uint32_t i=0;i<used;i++)
+			entry(i)->~Entry();
+		used=0;
+		erased=0;
+		_free_unused_blocks();
+
+		if (index)
+			memfree(index);
+		index=NULL;
+		index_size=0;
+		index_used=0;
+	}
+
+	void copy_from(const DictionaryPrivate *p_from) {
+
+		/* entries are copied as they are (holes compacted away), the index table only if it maps them as they were */
+		for(uint32_t i=0;i<p_from->used;i++) {
+
+			const Entry *src=p_from->entry(i);
+			if (src->erased)
+				continue;
+
+			uint32_t pos=used+(1<<MIN_BLOCK_SHIFT);
+			uint32_t bit=_msb(pos);
+			Entry *&block=blocks[bit-MIN_BLOCK_SHIFT];
+			if (!block)
+				block=(Entry*)memalloc(sizeof(Entry)*(1<<bit));
+			memnew_placement(&block[pos-(1<<bit)],Entry(*src));
+			used++;
+		}
+
+		if (!used)
+			return;
+
+		if (!p_from->erased) {
+			index_size=p_from->index_size;
+			index_used=p_from->index_used;
+			index=(uint32_t*)memalloc(sizeof(uint32_t)*index_size);
+			for(uint32_t i=0;i<index_size;i++)
+				index[i]=p_from->index[i];
+		} else {
+			rebuild_index(p_from->index_size);
+		}
+	}
+
+	DictionaryPrivate() {
+
+		shared=false;
+		for(int i=0;i<MAX_BLOCKS;i++)
+			blocks[i]=NULL;
+		used=0;
+		erased=0;
+		index=NULL;
+		index_size=0;
+		index_used=0;
+	}
+
+	~DictionaryPrivate() {
+
+		clear();
+	}
 };
 
 
 void Dictionary::get_key_list( List<Variant> *p_keys) const {
 
-	_p->variant_map.get_key_list(p_keys);
+	for(uint32_t i=0;i<_p->used;i++) {
+
+		const DictionaryPrivate::Entry *e=_p->entry(i);
+		if (!e->erased)
+			p_keys->push_back(e->key);
+	}
 }
 
 void Dictionary::_copy_on_write() const {
 
-	//make a copy of what we have
-	if (_p->shared)
+	//make a copy of what we have, unless nobody else is holding it
+	if (_p->shared || _p->refcount.get()==1)
 		return;
 
 	DictionaryPrivate *p = memnew(DictionaryPrivate);
 	p->shared=_p->shared;
-	p->variant_map=_p->variant_map;
+	p->copy_from(_p);
 	p->refcount.init();
 	_unref();
 	_p=p;
@@ -67,24 +342,29 @@ void Dictionary::_copy_on_write() const {
 
 Variant& Dictionary::operator[](const Variant& p_key) {
 
+	MemoryCategoryScope scope(Memory::ALLOC_VARIANT);
 	_copy_on_write();
 
-	return _p->variant_map[p_key];
+	return _p->insert(p_key)->value;
 }
 
 const Variant& Dictionary::operator[](const Variant& p_key) const {
 
-	return _p->variant_map[p_key];
+	const DictionaryPrivate::Entry *e=_p->find_entry(p_key);
+	ERR_FAIL_COND_V(!e,*(const Variant*)NULL);
+	return e->value;
 
 }
 const Variant* Dictionary::getptr(const Variant& p_key) const {
 
-	return _p->variant_map.getptr(p_key);
+	const DictionaryPrivate::Entry *e=_p->find_entry(p_key);
+	return e ? &e->value : NULL;
 }
 Variant* Dictionary::getptr(const Variant& p_key) {
 
 	_copy_on_write();
-	return _p->variant_map.getptr(p_key);
+	DictionaryPrivate::Entry *e=const_cast<DictionaryPrivate::Entry*>(_p->find_entry(p_key));
+	return e ? &e->value : NULL;
 }
 
 Variant Dictionary::get_valid(const Variant& p_key) const {
@@ -98,17 +378,17 @@ Variant Dictionary::get_valid(const Variant& p_key) const {
 
 int Dictionary::size() const {
 
-	return _p->variant_map.size();
+	return _p->size();
 
 }
 bool Dictionary::empty() const {
 
-	return !_p->variant_map.size();
+	return !_p->size();
 }
 
 bool Dictionary::has(const Variant& p_key) const {
 
-	return _p->variant_map.has(p_key);
+	return _p->find_entry(p_key)!=NULL;
 }
 
 bool Dictionary::has_all(const Array& p_keys) const {
@@ -122,7 +402,7 @@ bool Dictionary::has_all(const Array& p_keys) const {
 
 void Dictionary::erase(const Variant& p_key) {
 	_copy_on_write();
-	_p->variant_map.erase(p_key);
+	_p->erase(p_key);
 }
 
 bool Dictionary::operator==(const Dictionary& p_dictionary) const {
@@ -150,7 +430,7 @@ void Dictionary::_ref(const Dictionary& p_from) const {
 void Dictionary::clear() {
 
 	_copy_on_write();
-	_p->variant_map.clear();
+	_p->clear();
 }
 
 bool Dictionary::is_shared() const {
@@ -172,14 +452,14 @@ uint32_t Dictionary::hash() const {
 
 	uint32_t h=hash_djb2_one_32(Variant::DICTIONARY);
 
-	List<Variant> keys;
-	get_key_list(&keys);
+	for(uint32_t i=0;i<_p->used;i++) {
 
-	for (List<Variant>::Element *E=keys.front();E;E=E->next()) {
-
-		h = hash_djb2_one_32( E->get().hash(), h);
-		h = hash_djb2_one_32( operator[](E->get()).hash(), h);
+		const DictionaryPrivate::Entry *e=_p->entry(i);
+		if (e->erased)
+			continue;
 
+		h = hash_djb2_one_32( e->hash, h);
+		h = hash_djb2_one_32( e->value.hash(), h);
 	}
 
 
@@ -190,10 +470,12 @@ Array Dictionary::keys() const {
 
 	Array karr;
 	karr.resize(size());
-	const Variant *K=NULL;
 	int idx=0;
-	while((K=next(K))) {
-		karr[idx++]=(*K);
+	for(uint32_t i=0;i<_p->used;i++) {
+
+		const DictionaryPrivate::Entry *e=_p->entry(i);
+		if (!e->erased)
+			karr[idx++]=e->key;
 	}
 	return karr;
 
@@ -203,17 +485,50 @@ Array Dictionary::values() const {
 
 	Array varr;
 	varr.resize(size());
-	const Variant *key=NULL;
-	int i=0;
-	while((key=next(key))){
-		varr[i++] = _p->variant_map[*key];
+	int idx=0;
+	for(uint32_t i=0;i<_p->used;i++) {
+
+		const DictionaryPrivate::Entry *e=_p->entry(i);
+		if (!e->erased)
+			varr[idx++]=e->value;
 	}
 	return varr;
 }
 
 const Variant* Dictionary::next(const Variant* p_key) const {
 
-	return _p->variant_map.next(p_key);
+	uint32_t from=0;
+
+	if (p_key) {
+
+		/* keys returned by next() point into the blocks, others (copies) are looked up */
+		const DictionaryPrivate::Entry *e=reinterpret_cast<const DictionaryPrivate::Entry*>(p_key);
+		int32_t idx=-1;
+		for(int i=0;i<DictionaryPrivate::MAX_BLOCKS && _p->blocks[i];i++) {
+
+			const DictionaryPrivate::Entry *block=_p->blocks[i];
+			int block_size=1<<(i+DictionaryPrivate::MIN_BLOCK_SHIFT);
+			if (e>=block && e<block+block_size) {
+				idx=(block_size-(1<<DictionaryPrivate::MIN_BLOCK_SHIFT))+(e-block);
+				break;
+			}
+		}
+
+		if (idx<0 || uint32_t(idx)>=_p->used)
+			idx=_p->find(*p_key,p_key->hash());
+
+		ERR_FAIL_COND_V(idx<0,NULL); // invalid key supplied
+		from=idx+1;
+	}
+
+	for(uint32_t i=from;i<_p->used;i++) {
+
+		const DictionaryPrivate::Entry *e=_p->entry(i);
+		if (!e->erased)
+			return &e->key;
+	}
+
+	return NULL;
 }
 
 
@@ -235,14 +550,7 @@ Error Dictionary::parse_json(const String& p_json) {
 Dictionary Dictionary::copy() const {
 
 	Dictionary n(is_shared());
-
-	List<Variant> keys;
-	get_key_list(&keys);
-
-	for(List<Variant>::Element *E=keys.front();E;E=E->next()) {
-		n[E->get()]=operator[](E->get());
-	}
-
+	n._p->copy_from(_p);
 	return n;
 }
 
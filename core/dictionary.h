@@ -39,6 +39,11 @@ class Variant;
 struct DictionaryPrivate;
 
 
+/* Values don't move when other keys are inserted or erased, so pointers from operator[] and
+   getptr() stay valid until their own key is erased or the dictionary is cleared. The exception
+   is an insert that finds most entries erased and needs more room: it compacts the storage,
+   which moves every value and also invalidates next() iteration. */
+
 class Dictionary {
 
 	mutable DictionaryPrivate *_p;
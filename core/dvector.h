@@ -30,189 +30,192 @@
 #define DVECTOR_H
 
 #include "os/memory.h"
+#include "safe_refcount.h"
 
 
 /**
 	@author Juan Linietsky <reduzio@gmail.com>
 */
 
-
-extern Mutex* dvector_lock;
+/* Data lives in a single directly addressed allocation with an atomic refcount, so copies,
+   copy on write and Read/Write handles never take a lock and can cross threads freely.
+   Handles hold a reference, a Read keeps seeing the data it was created with even if the
+   DVector is modified later. A Write also counts as a lock, resize() fails while one exists. */
 
 template<class T>
 class DVector {
 
-	mutable MID mem;
+	struct Alloc {
 
+		SafeRefCount refcount; // DVectors and handles using it
+		volatile uint32_t lock; // Write handles, each also holds a reference
+		int size;
+		int capacity;
+	};
 
-	void copy_on_write() {
+	enum {
+		DATA_OFFSET=(sizeof(Alloc)+15)&~15
+	};
 
-		if (!mem.is_valid())
-			return;
+	mutable Alloc *alloc;
 
-		if (dvector_lock)
-			dvector_lock->lock();
+	_FORCE_INLINE_ static T* _get_data(Alloc *p_alloc) {
 
-		MID_Lock lock( mem );
+		return reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(p_alloc)+DATA_OFFSET);
+	}
 
+	static Alloc *_ref(Alloc *p_alloc) {
 
-		if ( *(int*)lock.data()  == 1 ) {
-			// one reference, means no refcount changes
-			if (dvector_lock)
-				dvector_lock->unlock();
+		if (p_alloc && p_alloc->refcount.ref())
+			return p_alloc;
+		return NULL;
+	}
+
+	static void _unref(Alloc *p_alloc) {
+
+		if (!p_alloc || !p_alloc->refcount.unref())
 			return;
+
+		T *data=_get_data(p_alloc);
+		for(int i=0;i<p_alloc->size;i++) {
+
+			data[i].~T();
 		}
 
-		MID new_mem= dynalloc( mem.get_size() );
+		memfree(p_alloc);
+	}
 
-		if (!new_mem.is_valid()) {
+	static Alloc *_alloc(int p_capacity) {
 
-			if (dvector_lock)
-				dvector_lock->unlock();
-			ERR_FAIL_COND( new_mem.is_valid() ); // out of memory
-		}
+		Alloc *alloc = (Alloc*)memalloc( DATA_OFFSET+p_capacity*sizeof(T) );
+		ERR_FAIL_COND_V( !alloc, NULL );
+		alloc->refcount.init();
+		alloc->lock=0;
+		alloc->size=0;
+		alloc->capacity=p_capacity;
+		return alloc;
+	}
 
-		MID_Lock dst_lock( new_mem );
+	void copy_on_write(int p_count=-1) {
 
-		int *rc = (int*)dst_lock.data();
+		if (!alloc)
+			return;
 
-		*rc=1;
+		// our own Write handles don't count as other users
+		if ( alloc->refcount.get()-long(atomic_load(&alloc->lock)) <= 1 )
+			return;
 
-		T * dst = (T*)(rc + 1 );
+		// when about to resize, only what is kept gets copied
+		int count = p_count<0 ? alloc->size : MIN(p_count,alloc->size);
 
-		T * src =(T*) ((int*)lock.data() + 1 );
+		Alloc *new_alloc = _alloc( p_count<0 ? count : p_count );
+		ERR_FAIL_COND( !new_alloc ); // out of memory
 
-		int count = (mem.get_size() - sizeof(int)) / sizeof(T);
+		T * dst = _get_data(new_alloc);
+		const T * src = _get_data(alloc);
 
 		for (int i=0;i<count;i++) {
 
 			memnew_placement( &dst[i], T(src[i]) );
 		}
+		new_alloc->size=count;
 
-		(*(int*)lock.data())--;
-
-		// unlock all
-		dst_lock=MID_Lock();
-		lock=MID_Lock();
-
-		mem=new_mem;
-
-		if (dvector_lock)
-			dvector_lock->unlock();
-
+		_unref(alloc);
+		alloc=new_alloc;
 	}
 
 	void reference( const DVector& p_dvector ) {
 
-		unreference();
-
-		if (dvector_lock)
-			dvector_lock->lock();
-
-		if (!p_dvector.mem.is_valid()) {
-
-			if (dvector_lock)
-				dvector_lock->unlock();
+		if (alloc==p_dvector.alloc)
 			return;
-		}
-
-		MID_Lock lock(p_dvector.mem);
-
-		int * rc = (int*)lock.data();
-		(*rc)++;
-
-		lock = MID_Lock();
-		mem=p_dvector.mem;
-
-		if (dvector_lock)
-			dvector_lock->unlock();
 
+		Alloc *new_alloc=_ref(p_dvector.alloc);
+		_unref(alloc);
+		alloc=new_alloc;
 	}
 
-
 	void unreference() {
 
-		if (dvector_lock)
-			dvector_lock->lock();
-
-		if (!mem.is_valid()) {
-
-			if (dvector_lock)
-				dvector_lock->unlock();
-			return;
-		}
-
-		MID_Lock lock(mem);
-
-		int * rc = (int*)lock.data();
-		(*rc)--;
-
-		if (*rc==0) {
-			// no one else using it, destruct
-
-			T * t= (T*)(rc+1);
-			int count = (mem.get_size() - sizeof(int)) / sizeof(T);
-
-			for (int i=0;i<count;i++) {
-
-				t[i].~T();
-			}
-
-		}
-
-
-		lock = MID_Lock();
-
-		mem = MID ();
-
-		if (dvector_lock)
-			dvector_lock->unlock();
-
+		_unref(alloc);
+		alloc=NULL;
 	}
 
 public:
 
 	class Read {
 	friend class DVector;
-		MID_Lock lock;
+		Alloc *alloc;
 		const T * mem;
+
+		void _set(Alloc *p_alloc) {
+
+			if (p_alloc==alloc)
+				return;
+			Alloc *new_alloc=_ref(p_alloc);
+			_unref(alloc);
+			alloc=new_alloc;
+			mem = alloc ? _get_data(alloc) : NULL;
+		}
 	public:
 
 		_FORCE_INLINE_ const T& operator[](int p_index) const { return mem[p_index]; }
 		_FORCE_INLINE_ const T *ptr() const { return mem; }
 
-		Read() { mem=NULL; }
+		void operator=(const Read& p_read) { _set(p_read.alloc); }
+		Read(const Read& p_read) { alloc=NULL; mem=NULL; _set(p_read.alloc); }
+		Read() { alloc=NULL; mem=NULL; }
+		~Read() { _unref(alloc); }
 	};
 
 	class Write {
 	friend class DVector;
-		MID_Lock lock;
+		Alloc *alloc;
 		T * mem;
+
+		void _set(Alloc *p_alloc) {
+
+			if (p_alloc==alloc)
+				return;
+			Alloc *new_alloc=_ref(p_alloc);
+			if (new_alloc)
+				atomic_add(&new_alloc->lock,1);
+			_release();
+			alloc=new_alloc;
+			mem = alloc ? _get_data(alloc) : NULL;
+		}
+
+		void _release() {
+
+			if (!alloc)
+				return;
+			atomic_add(&alloc->lock,-1);
+			_unref(alloc);
+			alloc=NULL;
+		}
 	public:
 
 		_FORCE_INLINE_ T& operator[](int p_index) { return mem[p_index]; }
 		_FORCE_INLINE_ T *ptr() { return mem; }
 
-		Write() { mem=NULL; }
+		void operator=(const Write& p_write) { _set(p_write.alloc); }
+		Write(const Write& p_write) { alloc=NULL; mem=NULL; _set(p_write.alloc); }
+		Write() { alloc=NULL; mem=NULL; }
+		~Write() { _release(); }
 	};
 
 
 	Read read() const {
 
 		Read r;
-		if (mem.is_valid()) {
-			r.lock = MID_Lock( mem );
-			r.mem = (const T*)((int*)r.lock.data()+1);
-		}
+		r._set(alloc);
 		return r;
 	}
 	Write write() {
 
 		Write w;
-		if (mem.is_valid()) {
+		if (alloc) {
 			copy_on_write();
-			w.lock = MID_Lock( mem );
-			w.mem = (T*)((int*)w.lock.data()+1);
+			w._set(alloc);
 		}
 		return w;
 	}
@@ -307,7 +310,7 @@ public:
 	}
 
 
-	bool is_locked() const { return mem.is_locked(); }
+	bool is_locked() const { return alloc && atomic_load(&alloc->lock)!=0; }
 
 	inline const T operator[](int p_index) const;
 
@@ -316,8 +319,8 @@ public:
 	void invert();
 
 	void operator=(const DVector& p_dvector) { reference(p_dvector); }
-	DVector() {}
-	DVector(const DVector& p_dvector) { reference(p_dvector); }
+	DVector() { alloc=NULL; }
+	DVector(const DVector& p_dvector) { alloc=NULL; reference(p_dvector); }
 	~DVector() { unreference(); }
 
 };
@@ -325,7 +328,7 @@ public:
 template<class T>
 int DVector<T>::size() const {
 
-	return mem.is_valid() ? ((mem.get_size() - sizeof(int)) / sizeof(T) ) : 0;
+	return alloc ? alloc->size : 0;
 }
 
 template<class T>
@@ -341,15 +344,17 @@ void DVector<T>::set(int p_index, const T& p_val) {
 		ERR_FAIL_COND(p_index<0 || p_index>=size());
 	}
 
-	Write w = write();
-	w[p_index]=p_val;
+	copy_on_write();
+	_get_data(alloc)[p_index]=p_val;
 }
 
 template<class T>
 void DVector<T>::push_back(const T& p_val) {
 
-	resize( size() + 1 );
-	set( size() -1, p_val );
+	int s=size();
+	if (resize( s + 1 )!=OK)
+		return;
+	_get_data(alloc)[s]=p_val;
 }
 
 template<class T>
@@ -360,96 +365,74 @@ const T DVector<T>::operator[](int p_index) const {
 		ERR_FAIL_COND_V(p_index<0 || p_index>=size(),aux);
 	}
 
-	Read r = read();
-
-	return r[p_index];
+	return _get_data(alloc)[p_index];
 }
 
 
 template<class T>
 Error DVector<T>::resize(int p_size) {
 
-	if (dvector_lock)
-		dvector_lock->lock();
+	ERR_FAIL_COND_V( p_size<0, ERR_INVALID_PARAMETER );
 
-	bool same = p_size==size();
+	int oldsize=size();
 
-	if (dvector_lock)
-		dvector_lock->unlock();
-	// no further locking is necesary because we are supposed to own the only copy of this (using copy on write)
-
-	if (same)
+	if (p_size==oldsize)
 		return OK;
 
+	// checked on the current memory, copying first would leave a Write pointing at the old one
+	ERR_FAIL_COND_V( is_locked(), ERR_LOCKED );
+
 	if (p_size == 0 ) {
 
-		unreference();
+		unreference(); // Read handles keep their own reference
 		return OK;
 	}
 
+	copy_on_write(p_size); // make it unique
+	oldsize=size();
 
-	copy_on_write(); // make it unique
-
-	ERR_FAIL_COND_V( mem.is_locked(), ERR_LOCKED ); // if after copy on write, memory is locked, fail.
-
-	if (p_size > size() ) {
-
-		int oldsize=size();
+	if (!alloc) {
 
-		MID_Lock lock;
+		alloc = _alloc(p_size);
+		ERR_FAIL_COND_V( !alloc, ERR_OUT_OF_MEMORY );
 
-		if (oldsize==0) {
+	} else if (p_size > alloc->capacity || p_size < alloc->capacity/4) {
 
-			mem = dynalloc( p_size * sizeof(T) + sizeof(int) );
-			lock=MID_Lock(mem);
-			int *rc = ((int*)lock.data());
-			*rc=1;
+		// grow geometrically when growing by small steps (push_back), exact size otherwise
+		int capacity = p_size;
+		if (p_size > alloc->capacity && p_size < alloc->capacity+alloc->capacity/2)
+			capacity=alloc->capacity+alloc->capacity/2;
 
-		} else {
+		if (p_size < oldsize) {
+			// destruct before the data may move
+			T *t = _get_data(alloc);
+			for (int i=p_size;i<oldsize;i++) {
 
-			if (dynrealloc( mem, p_size * sizeof(T) + sizeof(int) )!=OK ) {
-
-				ERR_FAIL_V(ERR_OUT_OF_MEMORY); // out of memory
+				t[i].~T();
 			}
-
-			lock=MID_Lock(mem);
+			alloc->size=p_size;
 		}
 
+		Alloc *new_alloc = (Alloc*)memrealloc( alloc, DATA_OFFSET+capacity*sizeof(T) );
+		ERR_FAIL_COND_V( !new_alloc, ERR_OUT_OF_MEMORY );
+		alloc=new_alloc;
+		alloc->capacity=capacity;
+	}
 
+	T *t = _get_data(alloc);
 
+	for (int i=oldsize;i<p_size;i++) {
 
-		T *t = (T*)((int*)lock.data() + 1);
-
-		for (int i=oldsize;i<p_size;i++) {
-
-			memnew_placement(&t[i], T );
-		}
-
-		lock = MID_Lock(); // clear
-	} else {
-
-		int oldsize=size();
-
-		MID_Lock lock(mem);
-
-
-		T *t = (T*)((int*)lock.data() + 1);
-
-		for (int i=p_size;i<oldsize;i++) {
-
-			t[i].~T();
-		}
-
-		lock = MID_Lock(); // clear
-
-		if (dynrealloc( mem, p_size * sizeof(T) + sizeof(int) )!=OK ) {
-
-			ERR_FAIL_V(ERR_OUT_OF_MEMORY); // wtf error
-		}
+		memnew_placement(&t[i], T );
+	}
 
+	for (int i=p_size;i<alloc->size;i++) {
 
+		t[i].~T();
 	}
 
+	alloc->size=p_size;
+
 	return OK;
 }
 
@@ -32,7 +32,41 @@
 #include "core/os/copymem.h"
 #include "hq2x.h"
 #include "print_string.h"
+#include "os/worker_thread_pool.h"
 #include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define IMAGE_SSE2
+#endif
+
+/* Pixel loops below work on ranges of destination rows, so the worker pool can
+   split them. Whatever depends only on the column is computed once up front. */
+
+enum {
+	PARALLEL_ROW_PIXELS=16384 // pixels per chunk of rows given to a thread
+};
+
+static void _process_rows(int p_rows,int p_row_pixels,WorkerThreadPool::RangeFunc p_func,void *p_userdata) {
+
+	WorkerThreadPool *pool=WorkerThreadPool::get_singleton();
+	int grain=MAX(1,PARALLEL_ROW_PIXELS/MAX(p_row_pixels,1));
+
+	if (!pool || p_rows<=grain) {
+		p_func(p_userdata,0,p_rows);
+		return;
+	}
+
+	pool->parallel_for(p_rows,p_func,p_userdata,grain);
+}
+
+static _FORCE_INLINE_ uint32_t _load_pixel32(const uint8_t *p_ptr) {
+
+	uint32_t v;
+	memcpy(&v,p_ptr,4);
+	return v;
+}
 
 
 const char* Image::format_names[Image::FORMAT_MAX]={
@@ -360,6 +394,55 @@ Color Image::get_pixel(int p_x,int p_y,int p_mipmap) const {
 	return Color( c.r/255.0,c.g/255.0,c.b/255.0,c.a/255.0 );
 }
 
+struct _ConvertJob {
+
+	const Image *src;
+	Image *dst;
+	const uint8_t *src_data;
+	int src_len;
+	uint8_t *dst_data;
+};
+
+void Image::_convert_rows(void *p_userdata,int p_from,int p_to) {
+
+	const _ConvertJob *job=(const _ConvertJob*)p_userdata;
+	const Image *src=job->src;
+	Image *dst=job->dst;
+	int w=src->width;
+
+	if (src->format==FORMAT_RGB && dst->format==FORMAT_RGBA) {
+
+		for(int i=p_from;i<p_to;i++) {
+			const uint8_t *r=&job->src_data[i*w*3];
+			uint8_t *d=&job->dst_data[i*w*4];
+			for(int j=0;j<w;j++,r+=3,d+=4) {
+				d[0]=r[0];
+				d[1]=r[1];
+				d[2]=r[2];
+				d[3]=255;
+			}
+		}
+
+	} else if (src->format==FORMAT_RGBA && dst->format==FORMAT_RGB) {
+
+		for(int i=p_from;i<p_to;i++) {
+			const uint8_t *r=&job->src_data[i*w*4];
+			uint8_t *d=&job->dst_data[i*w*3];
+			for(int j=0;j<w;j++,r+=4,d+=3) {
+				d[0]=r[0];
+				d[1]=r[1];
+				d[2]=r[2];
+			}
+		}
+
+	} else {
+
+		for(int i=p_from;i<p_to;i++)
+			for(int j=0;j<w;j++)
+				dst->_put_pixel(j,i,src->_get_pixel(j,i,job->src_data,job->src_len),job->dst_data);
+	}
+}
+
 void Image::convert( Format p_new_format ){
 
 	if (data.size()==0)
@@ -403,10 +486,13 @@ void Image::convert( Format p_new_format ){
 
 	} else {
 
-		//this is temporary, must find a faster way to do it.
-		for(int i=0;i<width;i++)
-			for(int j=0;j<height;j++)
-				new_img._put_pixel(i,j,_get_pixel(i,j,rptr,len),wptr);
+		_ConvertJob job;
+		job.src=this;
+		job.dst=&new_img;
+		job.src_data=rptr;
+		job.src_len=len;
+		job.dst_data=wptr;
+		_process_rows(height,width,_convert_rows,&job);
 	}
 
 	r = DVector<uint8_t>::Read();
@@ -442,73 +528,92 @@ static double _bicubic_interp_kernel( double x ) {
 	return bc;
 }
 
-template<int CC>
-static void _scale_cubic(const uint8_t* p_src, uint8_t* p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+struct _ScaleJob {
 
+	const uint8_t *src;
+	uint8_t *dst;
+	uint32_t src_width,src_height,dst_width,dst_height;
 
-	// get source image size
-	int width   = p_src_width;
-	int height  = p_src_height;
-	double xfac = (double) width / p_dst_width;
-	double yfac = (double) height / p_dst_height;
-	// coordinates of source points and cooefficiens
-	double  ox, oy, dx, dy, k1, k2;
-	int     ox1, oy1, ox2, oy2;
-	// destination pixel values
-	// width and height decreased by 1
-	int ymax = height - 1;
-	int xmax = width - 1;
-	// temporary pointer
-
-	for ( int y = 0; y < p_dst_height; y++ ) {
-		// Y coordinates
-		oy  = (double) y * yfac - 0.5f;
-		oy1 = (int) oy;
-		dy  = oy - (double) oy1;
+	DVector<uint32_t> col_ofs; // per destination column (nearest: 1, bilinear: left and right, cubic: 4 taps), byte offsets
+	DVector<uint32_t> col_frac; // bilinear
+	DVector<double> col_k; // cubic, 4 weights per column
+};
 
-		for ( int x = 0; x < p_dst_width; x++ )	{
-			// X coordinates
-			ox  = (double) x * xfac - 0.5f;
-			ox1 = (int) ox;
-			dx  = ox - (double) ox1;
+template<int CC>
+static void _scale_cubic_rows(void *p_userdata,int p_from,int p_to) {
 
-			// initial pixel value
+	const _ScaleJob *job=(const _ScaleJob*)p_userdata;
 
-			uint8_t *dst=p_dst + (y*p_dst_width+x)*CC;
+	double yfac = (double) job->src_height / job->dst_height;
+	int ymax = job->src_height - 1;
+	uint32_t src_pitch = job->src_width*CC;
 
-			double color[CC];
-			for(int i=0;i<CC;i++) {
-				color[i]=0;
-			}
+	DVector<uint32_t>::Read col_ofs=job->col_ofs.read();
+	DVector<double>::Read col_k=job->col_k.read();
+
+	for ( int y = p_from; y < p_to; y++ ) {
+		// Y coordinates
+		double oy  = (double) y * yfac - 0.5f;
+		int oy1 = (int) oy;
+		double dy  = oy - (double) oy1;
+
+		const uint8_t *rows[4];
+		double ky[4];
+		for ( int n = -1; n < 3; n++ ) {
+			ky[n+1] = _bicubic_interp_kernel( dy - (double) n );
+			rows[n+1] = job->src + CLAMP( oy1 + n, 0, ymax ) * src_pitch;
+		}
 
+		uint8_t *dst=job->dst + y*job->dst_width*CC;
 
+		for ( uint32_t x = 0; x < job->dst_width; x++ , dst+=CC )	{
 
-			for ( int n = -1; n < 3; n++ ) {
-				// get Y cooefficient
-				k1 = _bicubic_interp_kernel( dy - (double) n );
+			const uint32_t *ofs = &col_ofs[x*4];
+			const double *kx = &col_k[x*4];
 
-				oy2 = oy1 + n;
-				if ( oy2 < 0 )
-					oy2 = 0;
-				if ( oy2 > ymax )
-					oy2 = ymax;
+			double color[CC];
 
-				for ( int m = -1; m < 3; m++ ) {
-					// get X cooefficient
-					k2 = k1 * _bicubic_interp_kernel( (double) m - dx );
+#ifdef IMAGE_SSE2
+			if (CC==4) {
+				// same operations in the same order as the scalar loop, two channels at a time
+				__m128d c01=_mm_setzero_pd();
+				__m128d c23=_mm_setzero_pd();
+				__m128i zero=_mm_setzero_si128();
+
+				for ( int n = 0; n < 4; n++ ) {
+					for ( int m = 0; m < 4; m++ ) {
+
+						__m128d k2 = _mm_set1_pd( ky[n] * kx[m] );
+						__m128i p = _mm_cvtsi32_si128( _load_pixel32( rows[n] + ofs[m] ) );
+						p = _mm_unpacklo_epi16( _mm_unpacklo_epi8( p, zero ), zero );
+						c01 = _mm_add_pd( c01, _mm_mul_pd( _mm_cvtepi32_pd( p ), k2 ) );
+						c23 = _mm_add_pd( c23, _mm_mul_pd( _mm_cvtepi32_pd( _mm_srli_si128( p, 8 ) ), k2 ) );
+					}
+				}
+
+				double c[4];
+				_mm_storeu_pd( &c[0], c01 );
+				_mm_storeu_pd( &c[2], c23 );
+				for(int i=0;i<CC;i++) {
+					color[i]=c[i];
+				}
+			} else
+#endif
+			{
+				for(int i=0;i<CC;i++) {
+					color[i]=0;
+				}
 
-					ox2 = ox1 + m;
-					if ( ox2 < 0 )
-						ox2 = 0;
-					if ( ox2 > xmax )
-						ox2 = xmax;
+				for ( int n = 0; n < 4; n++ ) {
+					for ( int m = 0; m < 4; m++ ) {
 
-					// get pixel of original image
-					const uint8_t *p = p_src + (oy2 * p_src_width + ox2)*CC;
+						double k2 = ky[n] * kx[m];
+						const uint8_t *p = rows[n] + ofs[m];
 
-					for(int i=0;i<CC;i++) {
+						for(int i=0;i<CC;i++) {
 
-						color[i]+=p[i]*k2;
+							color[i]+=p[i]*k2;
+						}
 					}
 				}
 			}
@@ -520,89 +625,209 @@ static void _scale_cubic(const uint8_t* p_src, uint8_t* p_dst, uint32_t p_src_wi
 	}
 }
 
+template<int CC>
+static void _scale_cubic(const uint8_t* p_src, uint8_t* p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+
+	_ScaleJob job;
+	job.src=p_src;
+	job.dst=p_dst;
+	job.src_width=p_src_width;
+	job.src_height=p_src_height;
+	job.dst_width=p_dst_width;
+	job.dst_height=p_dst_height;
+
+	job.col_ofs.resize(p_dst_width*4);
+	job.col_k.resize(p_dst_width*4);
 
+	{
+		double xfac = (double) p_src_width / p_dst_width;
+		int xmax = p_src_width - 1;
+		DVector<uint32_t>::Write col_ofs=job.col_ofs.write();
+		DVector<double>::Write col_k=job.col_k.write();
+
+		for ( uint32_t x = 0; x < p_dst_width; x++ )	{
+			// X coordinates
+			double ox  = (double) x * xfac - 0.5f;
+			int ox1 = (int) ox;
+			double dx  = ox - (double) ox1;
+
+			for ( int m = -1; m < 3; m++ ) {
+				col_k[x*4+m+1] = _bicubic_interp_kernel( (double) m - dx );
+				col_ofs[x*4+m+1] = CLAMP( ox1 + m, 0, xmax ) * CC;
+			}
+		}
+	}
+
+	_process_rows(p_dst_height,p_dst_width*16,_scale_cubic_rows<CC>,&job);
+}
 
 
 template<int CC>
-static void _scale_bilinear(const uint8_t* p_src, uint8_t* p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+static void _scale_bilinear_rows(void *p_userdata,int p_from,int p_to) {
 
-	enum {
-		FRAC_BITS=8,
-		FRAC_LEN=(1<<FRAC_BITS),
-		FRAC_MASK=FRAC_LEN-1
+	/* Exactly the classic 8 bit fixed point bilinear filter, rewritten as weighted sums:
+	   up = a*(256-fx)+b*fx fits 16 bits and the result is (up*(256-fy)+down*fy)>>16.
+	   This lets SSE2 do two RGBA pixels per iteration with the same output. */
 
-	};
+	const _ScaleJob *job=(const _ScaleJob*)p_userdata;
+	uint32_t src_pitch = job->src_width*CC;
 
-	for(uint32_t i=0;i<p_dst_height;i++) {
+	DVector<uint32_t>::Read col_ofs=job->col_ofs.read();
+	DVector<uint32_t>::Read col_frac=job->col_frac.read();
 
-		uint32_t src_yofs_up_fp = (i*p_src_height*FRAC_LEN/p_dst_height);
-		uint32_t src_yofs_frac = src_yofs_up_fp & FRAC_MASK;
-		uint32_t src_yofs_up = src_yofs_up_fp >> FRAC_BITS;
+	for(int i=p_from;i<p_to;i++) {
 
+		uint64_t src_yofs_up_fp = (uint64_t(i)*job->src_height*256/job->dst_height);
+		uint32_t fy = src_yofs_up_fp & 0xFF;
+		uint32_t src_yofs_up = src_yofs_up_fp >> 8;
 
-		uint32_t src_yofs_down = (i+1)*p_src_height/p_dst_height;
-		if (src_yofs_down>=p_src_height)
-			src_yofs_down=p_src_height-1;
+		uint32_t src_yofs_down = uint64_t(i+1)*job->src_height/job->dst_height;
+		if (src_yofs_down>=job->src_height)
+			src_yofs_down=job->src_height-1;
 
-		//src_yofs_up*=CC;
-		//src_yofs_down*=CC;
+		const uint8_t *up_row = job->src + src_yofs_up*src_pitch;
+		const uint8_t *down_row = job->src + src_yofs_down*src_pitch;
+		uint8_t *dst = job->dst + i*job->dst_width*CC;
 
-		uint32_t y_ofs_up = src_yofs_up * p_src_width * CC;
-		uint32_t y_ofs_down = src_yofs_down * p_src_width * CC;
+		uint32_t j=0;
 
-		for(uint32_t j=0;j<p_dst_width;j++) {
+#ifdef IMAGE_SSE2
+		if (CC==4) {
 
-			uint32_t src_xofs_left_fp = (j*p_src_width*FRAC_LEN/p_dst_width);
-			uint32_t src_xofs_frac = src_xofs_left_fp & FRAC_MASK;
-			uint32_t src_xofs_left = src_xofs_left_fp >> FRAC_BITS;
-			uint32_t src_xofs_right = (j+1)*p_src_width/p_dst_width;
-			if (src_xofs_right>=p_src_width)
-				src_xofs_right=p_src_width-1;
+			__m128i zero=_mm_setzero_si128();
+			__m128i w256=_mm_set1_epi16(256);
+			__m128i wy=_mm_set1_epi16(fy);
+			__m128i wyi=_mm_set1_epi16(256-fy);
 
-			src_xofs_left*=CC;
-			src_xofs_right*=CC;
+			for(;j+2<=job->dst_width;j+=2) {
 
-			for(uint32_t l=0;l<CC;l++) {
+				uint32_t l0=col_ofs[j*2],r0=col_ofs[j*2+1];
+				uint32_t l1=col_ofs[j*2+2],r1=col_ofs[j*2+3];
 
-				uint32_t p00=p_src[y_ofs_up+src_xofs_left+l]<<FRAC_BITS;
-				uint32_t p10=p_src[y_ofs_up+src_xofs_right+l]<<FRAC_BITS;
-				uint32_t p01=p_src[y_ofs_down+src_xofs_left+l]<<FRAC_BITS;
-				uint32_t p11=p_src[y_ofs_down+src_xofs_right+l]<<FRAC_BITS;
+				__m128i a = _mm_unpacklo_epi8( _mm_unpacklo_epi32( _mm_cvtsi32_si128(_load_pixel32(up_row+l0)), _mm_cvtsi32_si128(_load_pixel32(up_row+l1)) ), zero);
+				__m128i b = _mm_unpacklo_epi8( _mm_unpacklo_epi32( _mm_cvtsi32_si128(_load_pixel32(up_row+r0)), _mm_cvtsi32_si128(_load_pixel32(up_row+r1)) ), zero);
+				__m128i c = _mm_unpacklo_epi8( _mm_unpacklo_epi32( _mm_cvtsi32_si128(_load_pixel32(down_row+l0)), _mm_cvtsi32_si128(_load_pixel32(down_row+l1)) ), zero);
+				__m128i d = _mm_unpacklo_epi8( _mm_unpacklo_epi32( _mm_cvtsi32_si128(_load_pixel32(down_row+r0)), _mm_cvtsi32_si128(_load_pixel32(down_row+r1)) ), zero);
 
-				uint32_t interp_up = p00+(((p10-p00)*src_xofs_frac)>>FRAC_BITS);
-				uint32_t interp_down = p01+(((p11-p01)*src_xofs_frac)>>FRAC_BITS);
-				uint32_t interp = interp_up+(((interp_down-interp_up)*src_yofs_frac)>>FRAC_BITS);
-				interp>>=FRAC_BITS;
-				p_dst[i*p_dst_width*CC+j*CC+l]=interp;
+				__m128i wx = _mm_set_epi16(col_frac[j+1],col_frac[j+1],col_frac[j+1],col_frac[j+1],col_frac[j],col_frac[j],col_frac[j],col_frac[j]);
+				__m128i wxi = _mm_sub_epi16(w256,wx);
+
+				__m128i up = _mm_add_epi16( _mm_mullo_epi16(a,wxi), _mm_mullo_epi16(b,wx) );
+				__m128i down = _mm_add_epi16( _mm_mullo_epi16(c,wxi), _mm_mullo_epi16(d,wx) );
+
+				__m128i up_lo = _mm_mullo_epi16(up,wyi);
+				__m128i up_hi = _mm_mulhi_epu16(up,wyi);
+				__m128i down_lo = _mm_mullo_epi16(down,wy);
+				__m128i down_hi = _mm_mulhi_epu16(down,wy);
+
+				__m128i p0 = _mm_srli_epi32( _mm_add_epi32( _mm_unpacklo_epi16(up_lo,up_hi), _mm_unpacklo_epi16(down_lo,down_hi) ), 16 );
+				__m128i p1 = _mm_srli_epi32( _mm_add_epi32( _mm_unpackhi_epi16(up_lo,up_hi), _mm_unpackhi_epi16(down_lo,down_hi) ), 16 );
+
+				__m128i res = _mm_packs_epi32(p0,p1);
+				res = _mm_packus_epi16(res,res);
+				_mm_storel_epi64((__m128i*)&dst[j*4],res);
+			}
+		}
+#endif
+
+		for(;j<job->dst_width;j++) {
+
+			uint32_t l=col_ofs[j*2],r=col_ofs[j*2+1];
+			uint32_t fx=col_frac[j];
+
+			for(uint32_t c=0;c<CC;c++) {
+
+				uint32_t up = up_row[l+c]*(256-fx)+up_row[r+c]*fx;
+				uint32_t down = down_row[l+c]*(256-fx)+down_row[r+c]*fx;
+				dst[j*CC+c]=(up*(256-fy)+down*fy)>>16;
 			}
 		}
 	}
 }
 
-
 template<int CC>
-static void _scale_nearest(const uint8_t* p_src, uint8_t* p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+static void _scale_bilinear(const uint8_t* p_src, uint8_t* p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
 
+	_ScaleJob job;
+	job.src=p_src;
+	job.dst=p_dst;
+	job.src_width=p_src_width;
+	job.src_height=p_src_height;
+	job.dst_width=p_dst_width;
+	job.dst_height=p_dst_height;
 
-	for(uint32_t i=0;i<p_dst_height;i++) {
+	job.col_ofs.resize(p_dst_width*2);
+	job.col_frac.resize(p_dst_width);
 
-		uint32_t src_yofs = i*p_src_height/p_dst_height;
-		uint32_t y_ofs = src_yofs * p_src_width * CC;
+	{
+		DVector<uint32_t>::Write col_ofs=job.col_ofs.write();
+		DVector<uint32_t>::Write col_frac=job.col_frac.write();
 
 		for(uint32_t j=0;j<p_dst_width;j++) {
 
-			uint32_t src_xofs = j*p_src_width/p_dst_width;
-			src_xofs*=CC;
+			uint64_t src_xofs_left_fp = (uint64_t(j)*p_src_width*256/p_dst_width);
+			uint32_t src_xofs_right = uint64_t(j+1)*p_src_width/p_dst_width;
+			if (src_xofs_right>=p_src_width)
+				src_xofs_right=p_src_width-1;
+
+			col_ofs[j*2+0]=uint32_t(src_xofs_left_fp>>8)*CC;
+			col_ofs[j*2+1]=src_xofs_right*CC;
+			col_frac[j]=src_xofs_left_fp&0xFF;
+		}
+	}
+
+	_process_rows(p_dst_height,p_dst_width,_scale_bilinear_rows<CC>,&job);
+}
+
+
+template<int CC>
+static void _scale_nearest_rows(void *p_userdata,int p_from,int p_to) {
+
+	const _ScaleJob *job=(const _ScaleJob*)p_userdata;
+	DVector<uint32_t>::Read col_ofs=job->col_ofs.read();
+
+	for(int i=p_from;i<p_to;i++) {
+
+		uint32_t src_yofs = uint64_t(i)*job->src_height/job->dst_height;
+		const uint8_t *src_row = job->src + src_yofs * job->src_width * CC;
+		uint8_t *dst = job->dst + i*job->dst_width*CC;
+
+		for(uint32_t j=0;j<job->dst_width;j++) {
+
+			const uint8_t *src = src_row + col_ofs[j];
 
 			for(uint32_t l=0;l<CC;l++) {
 
-				uint32_t p=p_src[y_ofs+src_xofs+l];
-				p_dst[i*p_dst_width*CC+j*CC+l]=p;
+				dst[l]=src[l];
 			}
+			dst+=CC;
 		}
 	}
 }
 
+template<int CC>
+static void _scale_nearest(const uint8_t* p_src, uint8_t* p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+
+	_ScaleJob job;
+	job.src=p_src;
+	job.dst=p_dst;
+	job.src_width=p_src_width;
+	job.src_height=p_src_height;
+	job.dst_width=p_dst_width;
+	job.dst_height=p_dst_height;
+
+	job.col_ofs.resize(p_dst_width);
+
+	{
+		DVector<uint32_t>::Write col_ofs=job.col_ofs.write();
+		for(uint32_t j=0;j<p_dst_width;j++) {
+			col_ofs[j]=uint32_t(uint64_t(j)*p_src_width/p_dst_width)*CC;
+		}
+	}
+
+	_process_rows(p_dst_height,p_dst_width,_scale_nearest_rows<CC>,&job);
+}
+
 
 void Image::resize_to_po2(bool p_square) {
 
@@ -865,20 +1090,48 @@ bool Image::_can_modify(Format p_format) const {
 	return false;
 }
 
+struct _MipmapJob {
+
+	const uint8_t *src;
+	uint8_t *dst;
+	uint32_t width,height;
+};
+
 template<int CC>
-static void _generate_po2_mipmap(const uint8_t* p_src, uint8_t* p_dst, uint32_t p_width, uint32_t p_height) {
+static void _generate_po2_mipmap_rows(void *p_userdata,int p_from,int p_to) {
 
-	//fast power of 2 mipmap generation
+	const _MipmapJob *job=(const _MipmapJob*)p_userdata;
+	uint32_t p_width=job->width;
 	uint32_t dst_w = p_width >> 1;
-	uint32_t dst_h = p_height >> 1;
 
-	for(uint32_t i=0;i<dst_h;i++) {
+	for(int i=p_from;i<p_to;i++) {
 
-		const uint8_t *rup_ptr = &p_src[i*2*p_width*CC];
+		const uint8_t *rup_ptr = &job->src[i*2*p_width*CC];
 		const uint8_t *rdown_ptr = rup_ptr + p_width * CC;
-		uint8_t *dst_ptr = &p_dst[i*dst_w*CC];
+		uint8_t *dst_ptr = &job->dst[i*dst_w*CC];
 		uint32_t count=dst_w;
 
+#ifdef IMAGE_SSE2
+		if (CC==4) {
+			// 2x2 box of 4 source pixels per iteration, same rounding as the scalar loop
+			__m128i zero=_mm_setzero_si128();
+			while(count>=2) {
+
+				__m128i up = _mm_loadu_si128((const __m128i*)rup_ptr);
+				__m128i down = _mm_loadu_si128((const __m128i*)rdown_ptr);
+				__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(up,zero),_mm_unpacklo_epi8(down,zero));
+				__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(up,zero),_mm_unpackhi_epi8(down,zero));
+				__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo,hi),_mm_unpackhi_epi64(lo,hi));
+				sum = _mm_srli_epi16(sum,2);
+				_mm_storel_epi64((__m128i*)dst_ptr,_mm_packus_epi16(sum,sum));
+
+				dst_ptr+=8;
+				rup_ptr+=16;
+				rdown_ptr+=16;
+				count-=2;
+			}
+		}
+#endif
 
 		while(count--) {
 
@@ -900,6 +1153,19 @@ static void _generate_po2_mipmap(const uint8_t* p_src, uint8_t* p_dst, uint32_t
 	}
 }
 
+template<int CC>
+static void _generate_po2_mipmap(const uint8_t* p_src, uint8_t* p_dst, uint32_t p_width, uint32_t p_height) {
+
+	//fast power of 2 mipmap generation
+	_MipmapJob job;
+	job.src=p_src;
+	job.dst=p_dst;
+	job.width=p_width;
+	job.height=p_height;
+
+	_process_rows(p_height>>1,p_width,_generate_po2_mipmap_rows<CC>,&job);
+}
+
 
 void Image::expand_x2_hq2x() {
 
@@ -2097,14 +2363,14 @@ Error Image::decompress() {
 }
 
 
-Error Image::compress(CompressMode p_mode) {
+Error Image::compress(CompressMode p_mode,CompressQuality p_quality) {
 
 	switch(p_mode) {
 
 		case COMPRESS_BC: {
 
 			ERR_FAIL_COND_V(!_image_compress_bc_func, ERR_UNAVAILABLE);
-			_image_compress_bc_func(this);
+			_image_compress_bc_func(this,p_quality);
 		} break;
 		case COMPRESS_PVRTC2: {
 
@@ -2119,7 +2385,7 @@ Error Image::compress(CompressMode p_mode) {
 		case COMPRESS_ETC: {
 
 			ERR_FAIL_COND_V(!_image_compress_etc_func, ERR_UNAVAILABLE);
-			_image_compress_etc_func(this);
+			_image_compress_etc_func(this,p_quality);
 		} break;
 	}
 
@@ -2127,10 +2393,10 @@ Error Image::compress(CompressMode p_mode) {
 	return OK;
 }
 
-Image Image::compressed(int p_mode) {
+Image Image::compressed(int p_mode,int p_quality) {
 
 	Image ret = *this;
-	ret.compress((Image::CompressMode)p_mode);
+	ret.compress((Image::CompressMode)p_mode,(Image::CompressQuality)p_quality);
 
 	return ret;
 };
@@ -2330,10 +2596,10 @@ void Image::blit_rect(const Image& p_src, const Rect2& p_src_rect,const Point2&
 Image (*Image::_png_mem_loader_func)(const uint8_t*,int)=NULL;
 Image (*Image::_jpg_mem_loader_func)(const uint8_t*,int)=NULL;
 
-void (*Image::_image_compress_bc_func)(Image *)=NULL;
+void (*Image::_image_compress_bc_func)(Image *,CompressQuality)=NULL;
 void (*Image::_image_compress_pvrtc2_func)(Image *)=NULL;
 void (*Image::_image_compress_pvrtc4_func)(Image *)=NULL;
-void (*Image::_image_compress_etc_func)(Image *)=NULL;
+void (*Image::_image_compress_etc_func)(Image *,CompressQuality)=NULL;
 void (*Image::_image_decompress_pvrtc)(Image *)=NULL;
 void (*Image::_image_decompress_bc)(Image *)=NULL;
 void (*Image::_image_decompress_etc)(Image *)=NULL;
@@ -2343,7 +2609,7 @@ Image (*Image::lossy_unpacker)(const DVector<uint8_t>& )=NULL;
 DVector<uint8_t> (*Image::lossless_packer)(const Image& )=NULL;
 Image (*Image::lossless_unpacker)(const DVector<uint8_t>& )=NULL;
 
-void Image::set_compress_bc_func(void (*p_compress_func)(Image *)) {
+void Image::set_compress_bc_func(void (*p_compress_func)(Image *,CompressQuality)) {
 
 	_image_compress_bc_func=p_compress_func;
 }
@@ -2370,43 +2636,56 @@ void Image::normalmap_to_xy() {
 	convert(Image::FORMAT_GRAYSCALE_ALPHA);
 }
 
+static const uint8_t _srgb2lin[256]={0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10, 10, 11, 11, 11, 12, 12, 13, 13, 13, 14, 14, 15, 15, 16, 16, 16, 17, 17, 18, 18, 19, 19, 20, 20, 21, 22, 22, 23, 23, 24, 24, 25, 26, 26, 27, 27, 28, 29, 29, 30, 31, 31, 32, 33, 33, 34, 35, 36, 36, 37, 38, 38, 39, 40, 41, 42, 42, 43, 44, 45, 46, 47, 47, 48, 49, 50, 51, 52, 53, 54, 55, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 70, 71, 72, 73, 74, 75, 76, 77, 78, 80, 81, 82, 83, 84, 85, 87, 88, 89, 90, 92, 93, 94, 95, 97, 98, 99, 101, 102, 103, 105, 106, 107, 109, 110, 112, 113, 114, 116, 117, 119, 120, 122, 123, 125, 126, 128, 129, 131, 132, 134, 135, 137, 139, 140, 142, 144, 145, 147, 148, 150, 152, 153, 155, 157, 159, 160, 162, 164, 166, 167, 169, 171, 173, 175, 176, 178, 180, 182, 184, 186, 188, 190, 192, 193, 195, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 218, 220, 222, 224, 226, 228, 230, 232, 235, 237, 239, 241, 243, 245, 248, 250, 252};
+
+struct _SRGBToLinearJob {
+
+	uint8_t *data;
+	int pixel_size;
+};
+
+static void _srgb_to_linear_rows(void *p_userdata,int p_from,int p_to) {
+
+	const _SRGBToLinearJob *job=(const _SRGBToLinearJob*)p_userdata;
+	uint8_t *p=&job->data[p_from*job->pixel_size];
+
+	for(int i=p_from;i<p_to;i++,p+=job->pixel_size) {
+
+		p[0]=_srgb2lin[ p[0] ];
+		p[1]=_srgb2lin[ p[1] ];
+		p[2]=_srgb2lin[ p[2] ];
+	}
+}
+
 void Image::srgb_to_linear() {
 
 	if (data.size()==0)
 		return;
 
-	static const uint8_t srgb2lin[256]={0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10, 10, 11, 11, 11, 12, 12, 13, 13, 13, 14, 14, 15, 15, 16, 16, 16, 17, 17, 18, 18, 19, 19, 20, 20, 21, 22, 22, 23, 23, 24, 24, 25, 26, 26, 27, 27, 28, 29, 29, 30, 31, 31, 32, 33, 33, 34, 35, 36, 36, 37, 38, 38, 39, 40, 41, 42, 42, 43, 44, 45, 46, 47, 47, 48, 49, 50, 51, 52, 53, 54, 55, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 70, 71, 72, 73, 74, 75, 76, 77, 78, 80, 81, 82, 83, 84, 85, 87, 88, 89, 90, 92, 93, 94, 95, 97, 98, 99, 101, 102, 103, 105, 106, 107, 109, 110, 112, 113, 114, 116, 117, 119, 120, 122, 123, 125, 126, 128, 129, 131, 132, 134, 135, 137, 139, 140, 142, 144, 145, 147, 148, 150, 152, 153, 155, 157, 159, 160, 162, 164, 166, 167, 169, 171, 173, 175, 176, 178, 180, 182, 184, 186, 188, 190, 192, 193, 195, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 218, 220, 222, 224, 226, 228, 230, 232, 235, 237, 239, 241, 243, 245, 248, 250, 252};
-
-
 	ERR_FAIL_COND( format!=FORMAT_RGB && format!=FORMAT_RGBA  );
 
-	if (format==FORMAT_RGBA) {
+	_SRGBToLinearJob job;
+	job.pixel_size=format==FORMAT_RGBA?4:3;
 
-		int len = data.size()/4;
-		DVector<uint8_t>::Write wp = data.write();
-		unsigned char *data_ptr=wp.ptr();
+	int len = data.size()/job.pixel_size;
+	DVector<uint8_t>::Write wp = data.write();
+	job.data=wp.ptr();
 
-		for(int i=0;i<len;i++) {
+	_process_rows(len,1,_srgb_to_linear_rows,&job);
+}
 
-			data_ptr[(i<<2)+0]=srgb2lin[ data_ptr[(i<<2)+0] ];
-			data_ptr[(i<<2)+1]=srgb2lin[ data_ptr[(i<<2)+1] ];
-			data_ptr[(i<<2)+2]=srgb2lin[ data_ptr[(i<<2)+2] ];
-		}
+static void _premultiply_alpha_rows(void *p_userdata,int p_from,int p_to) {
 
-	} else if (format==FORMAT_RGB) {
+	uint8_t *data_ptr=(uint8_t*)p_userdata;
 
-		int len = data.size()/3;
-		DVector<uint8_t>::Write wp = data.write();
-		unsigned char *data_ptr=wp.ptr();
+	for(int i=p_from;i<p_to;i++) {
 
-		for(int i=0;i<len;i++) {
-
-			data_ptr[(i*3)+0]=srgb2lin[ data_ptr[(i*3)+0] ];
-			data_ptr[(i*3)+1]=srgb2lin[ data_ptr[(i*3)+1] ];
-			data_ptr[(i*3)+2]=srgb2lin[ data_ptr[(i*3)+2] ];
-		}
+		uint8_t *p=&data_ptr[i<<2];
+		int a=p[3];
+		p[0]=(int(p[0])*a)>>8;
+		p[1]=(int(p[1])*a)>>8;
+		p[2]=(int(p[2])*a)>>8;
 	}
-
 }
 
 void Image::premultiply_alpha() {
@@ -2420,17 +2699,8 @@ void Image::premultiply_alpha() {
 	DVector<uint8_t>::Write wp = data.write();
 	unsigned char *data_ptr=wp.ptr();
 
-
-	for(int i=0;i<height;i++) {
-		for(int j=0;j<width;j++) {
-
-			BColor bc = _get_pixel(j,i,data_ptr,0);
-			bc.r=(int(bc.r)*int(bc.a))>>8;
-			bc.g=(int(bc.g)*int(bc.a))>>8;
-			bc.b=(int(bc.b)*int(bc.a))>>8;
-			_put_pixel(j,i,bc,data_ptr);
-		}
-	}
+	//like before, only the base level is premultiplied
+	_process_rows(width*height,1,_premultiply_alpha_rows,data_ptr);
 }
 
 void Image::fix_alpha_edges() {
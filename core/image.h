@@ -96,12 +96,18 @@ public:
 		/* INTERPOLATE GAUSS */
 	};
 
+	enum CompressQuality {
+		COMPRESS_QUALITY_FAST, ///< quickest encoder settings (the default, used for import)
+		COMPRESS_QUALITY_NORMAL,
+		COMPRESS_QUALITY_HIGH ///< best quality, much slower
+	};
+
 	static Image (*_png_mem_loader_func)(const uint8_t* p_png,int p_size);
 	static Image (*_jpg_mem_loader_func)(const uint8_t* p_png,int p_size);
-	static void (*_image_compress_bc_func)(Image *);
+	static void (*_image_compress_bc_func)(Image *,CompressQuality);
 	static void (*_image_compress_pvrtc2_func)(Image *);
 	static void (*_image_compress_pvrtc4_func)(Image *);
-	static void (*_image_compress_etc_func)(Image *);
+	static void (*_image_compress_etc_func)(Image *,CompressQuality);
 	static void (*_image_decompress_pvrtc)(Image *);
 	static void (*_image_decompress_bc)(Image *);
 	static void (*_image_decompress_etc)(Image *);
@@ -198,6 +204,7 @@ private:
 
 	static int _get_dst_image_size(int p_width, int p_height, Format p_format,int &r_mipmaps,int p_mipmaps=-1);
 	bool _can_modify(Format p_format) const;
+	static void _convert_rows(void *p_userdata,int p_from,int p_to);
 
 
 
@@ -337,8 +344,8 @@ public:
 		COMPRESS_ETC
 	};
 
-	Error compress(CompressMode p_mode=COMPRESS_BC);
-	Image compressed(int p_mode); /* from the Image::CompressMode enum */
+	Error compress(CompressMode p_mode=COMPRESS_BC,CompressQuality p_quality=COMPRESS_QUALITY_FAST);
+	Image compressed(int p_mode,int p_quality=COMPRESS_QUALITY_FAST); /* from the Image::CompressMode and Image::CompressQuality enums */
 	Error decompress();
 	Image decompressed() const;
 	bool is_compressed() const;
@@ -355,7 +362,7 @@ public:
 	Rect2 get_used_rect() const;
 	Image get_rect(const Rect2& p_area) const;
 
-	static void set_compress_bc_func(void (*p_compress_func)(Image *));
+	static void set_compress_bc_func(void (*p_compress_func)(Image *,CompressQuality));
 	static String get_format_name(Format p_format);
 
 	Image(const uint8_t* p_mem_png_jpg, int p_len=-1);
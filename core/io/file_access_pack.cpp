@@ -28,8 +28,10 @@
 /*************************************************************************/
 #include "file_access_pack.h"
 #include "version.h"
+#include "io/marshalls.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #define PACK_VERSION 0
 
@@ -105,6 +107,7 @@ PackedData::PackedData() {
 	root=memnew(PackedDir);
 	root->parent=NULL;
 	disabled=false;
+	map_packs=true;
 
 	add_pack_source(memnew(PackedSourcePCK));
 }
@@ -197,14 +200,33 @@ bool PackedSourcePCK::try_open_pack(const String& p_path) {
 		PackedData::get_singleton()->add_path(p_path, path, ofs, size, md5,this);
 	};
 
+	if (!mapped_packs.has(p_path) && PackedData::get_singleton()->is_map_packs_enabled() && f->map_data()==OK) {
+		mapped_packs[p_path]=f; //files in it are read from memory, keep it open
+	} else {
+		memdelete(f);
+	}
+
 	return true;
 };
 
 FileAccess* PackedSourcePCK::get_file(const String &p_path, PackedData::PackedFile* p_file) {
 
+	Map<String,FileAccess*>::Element *E=mapped_packs.find(p_file->pack);
+	if (E && p_file->offset+p_file->size <= E->get()->get_len()) {
+
+		return memnew( FileAccessPack(p_path, *p_file, E->get()->get_mapped_data()+p_file->offset));
+	}
+
 	return memnew( FileAccessPack(p_path, *p_file));
 };
 
+PackedSourcePCK::~PackedSourcePCK() {
+
+	for (Map<String,FileAccess*>::Element *E=mapped_packs.front();E;E=E->next()) {
+		memdelete(E->get());
+	}
+}
+
 //////////////////////////////////////////////////////////////////
 
 
@@ -216,11 +238,15 @@ Error FileAccessPack::_open(const String& p_path, int p_mode_flags) {
 
 void FileAccessPack::close() {
 
-	f->close();
+	if (f)
+		f->close();
+	data=NULL;
 }
 
 bool FileAccessPack::is_open() const{
 
+	if (!f)
+		return data!=NULL;
 	return f->is_open();
 }
 
@@ -232,7 +258,8 @@ void FileAccessPack::seek(size_t p_position){
 		eof=false;
 	}
 
-	f->seek(pf.offset+p_position);
+	if (f)
+		f->seek(pf.offset+p_position);
 	pos=p_position;
 }
 void FileAccessPack::seek_end(int64_t p_position){
@@ -261,10 +288,43 @@ uint8_t FileAccessPack::get_8() const {
 		return 0;
 	}
 
+	if (data)
+		return data[pos++];
+
 	pos++;
 	return f->get_8();
 }
 
+uint16_t FileAccessPack::get_16() const {
+
+	if (!data || pos>pf.size || pf.size-pos<2)
+		return FileAccess::get_16();
+
+	uint16_t res=decode_uint16(&data[pos]);
+	pos+=2;
+	return endian_swap?BSWAP16(res):res;
+}
+
+uint32_t FileAccessPack::get_32() const {
+
+	if (!data || pos>pf.size || pf.size-pos<4)
+		return FileAccess::get_32();
+
+	uint32_t res=decode_uint32(&data[pos]);
+	pos+=4;
+	return endian_swap?BSWAP32(res):res;
+}
+
+uint64_t FileAccessPack::get_64() const {
+
+	if (!data || pos>pf.size || pf.size-pos<8)
+		return FileAccess::get_64();
+
+	uint64_t res=decode_uint64(&data[pos]);
+	pos+=8;
+	return endian_swap?BSWAP64(res):res;
+}
+
 
 int FileAccessPack::get_buffer(uint8_t *p_dst,int p_length) const {
 
@@ -277,18 +337,24 @@ int FileAccessPack::get_buffer(uint8_t *p_dst,int p_length) const {
 		to_read=int64_t(pf.size)-int64_t(pos);
 	}
 
-	pos+=p_length;
-
-	if (to_read<=0)
+	if (to_read<=0) {
+		pos+=p_length;
 		return 0;
-	f->get_buffer(p_dst,to_read);
+	}
+
+	if (data)
+		memcpy(p_dst,&data[pos],to_read);
+	else
+		f->get_buffer(p_dst,to_read);
+	pos+=p_length;
 
 	return to_read;
 }
 
 void FileAccessPack::set_endian_swap(bool p_swap) {
 	FileAccess::set_endian_swap(p_swap);
-	f->set_endian_swap(p_swap);
+	if (f)
+		f->set_endian_swap(p_swap);
 }
 
 Error FileAccessPack::get_error() const {
@@ -316,9 +382,16 @@ bool FileAccessPack::file_exists(const String& p_name) {
 }
 
 
-FileAccessPack::FileAccessPack(const String& p_path, const PackedData::PackedFile& p_file) {
+FileAccessPack::FileAccessPack(const String& p_path, const PackedData::PackedFile& p_file, const uint8_t *p_data) {
 
 	pf=p_file;
+	pos=0;
+	eof=false;
+	data=p_data;
+	f=NULL;
+	if (data)
+		return;
+
 	f=FileAccess::open(pf.pack,FileAccess::READ);
 	if (!f) {
 		ERR_EXPLAIN("Can't open pack-referenced file: "+String(pf.pack));
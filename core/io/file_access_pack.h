@@ -95,6 +95,7 @@ private:
 
 	static PackedData *singleton;
 	bool disabled;
+	bool map_packs;
 
 	void _free_packed_dirs(PackedDir *p_dir);
 
@@ -106,6 +107,9 @@ public:
 	void set_disabled(bool p_disabled) { disabled=p_disabled; }
 	_FORCE_INLINE_ bool is_disabled() const { return disabled; }
 
+	void set_map_packs(bool p_enable) { map_packs=p_enable; } ///< keep packs added from now on mapped, when the platform can
+	bool is_map_packs_enabled() const { return map_packs; }
+
 	static PackedData *get_singleton() { return singleton; }
 	Error add_pack(const String& p_path);
 
@@ -127,10 +131,14 @@ public:
 
 class PackedSourcePCK : public PackSource {
 
+	Map<String,FileAccess*> mapped_packs; //packs kept open and mapped, files read straight from memory
+
 public:
 
 	virtual bool try_open_pack(const String &p_path);
 	virtual FileAccess* get_file(const String& p_path, PackedData::PackedFile* p_file);
+
+	~PackedSourcePCK();
 };
 
 
@@ -142,6 +150,7 @@ class FileAccessPack : public FileAccess {
 	mutable bool eof;
 
 	FileAccess *f;
+	const uint8_t *data; //file contents, when the pack is mapped (f is NULL then)
 	virtual Error _open(const String& p_path, int p_mode_flags);
 	virtual uint64_t _get_modified_time(const String& p_file) { return 0; }
 
@@ -159,10 +168,15 @@ public:
 	virtual bool eof_reached() const;
 
 	virtual uint8_t get_8() const;
-
+	virtual uint16_t get_16() const;
+	virtual uint32_t get_32() const;
+	virtual uint64_t get_64() const;
 
 	virtual int get_buffer(uint8_t *p_dst,int p_length) const;
 
+	virtual Error map_data() { return data?OK:ERR_UNAVAILABLE; }
+	virtual const uint8_t *get_mapped_data() const { return data; }
+
 	virtual void set_endian_swap(bool p_swap);
 
 	virtual Error get_error() const;
@@ -174,7 +188,7 @@ public:
 	virtual bool file_exists(const String& p_name);
 
 
-	FileAccessPack(const String& p_path, const PackedData::PackedFile& p_file);
+	FileAccessPack(const String& p_path, const PackedData::PackedFile& p_file, const uint8_t *p_data=NULL);
 	~FileAccessPack();
 };
 
@@ -841,9 +841,27 @@ static void save_ustring(FileAccess* f,const String& p_string) {
 }
 
 
+static bool _get_mapped_ustring(FileAccess *f,int p_len,String& r_str) {
+
+	//strings in mapped files (packs, exported builds) are parsed in place, no intermediate copy
+	const uint8_t *mapped = f->get_mapped_data();
+	if (!mapped || p_len<=0)
+		return false;
+	size_t pos = f->get_pos();
+	if (pos+p_len > f->get_len())
+		return false;
+
+	r_str.parse_utf8((const char*)&mapped[pos],p_len);
+	f->seek(pos+p_len);
+	return true;
+}
+
 static String get_ustring(FileAccess *f) {
 
 	int len = f->get_32();
+	String mapped_str;
+	if (_get_mapped_ustring(f,len,mapped_str))
+		return mapped_str;
 	Vector<char> str_buf;
 	str_buf.resize(len);
 	f->get_buffer((uint8_t*)&str_buf[0],len);
@@ -855,13 +873,15 @@ static String get_ustring(FileAccess *f) {
 String ResourceInteractiveLoaderBinary::get_unicode_string() {
 
 	int len = f->get_32();
+	if (len==0)
+		return String();
+	String s;
+	if (_get_mapped_ustring(f,len,s))
+		return s;
 	if (len>str_buf.size()) {
 		str_buf.resize(len);
 	}
-	if (len==0)
-		return String();
 	f->get_buffer((uint8_t*)&str_buf[0],len);
-	String s;
 	s.parse_utf8(&str_buf[0]);
 	return s;
 }
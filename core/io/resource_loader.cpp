@@ -32,6 +32,9 @@
 #include "path_remap.h"
 #include "os/file_access.h"
 #include "os/os.h"
+#include "os/mutex.h"
+#include "os/semaphore.h"
+#include "os/thread.h"
 ResourceFormatLoader *ResourceLoader::loader[MAX_LOADERS];
 
 int ResourceLoader::loader_count=0;
@@ -157,6 +160,8 @@ void ResourceFormatLoader::get_dependencies(const String& p_path, List<String> *
 
 RES ResourceLoader::load(const String &p_path, const String& p_type_hint, bool p_no_cache, Error *r_error) {
 
+	MemoryCategoryScope mem_scope(Memory::ALLOC_RESOURCE);
+
 	if (r_error)
 		*r_error=ERR_CANT_OPEN;
 
@@ -169,6 +174,13 @@ RES ResourceLoader::load(const String &p_path, const String& p_type_hint, bool p
 	local_path=find_complete_path(local_path,p_type_hint);
 	ERR_FAIL_COND_V(local_path=="",RES());
 
+	if (!p_no_cache) {
+
+		RES res;
+		if (_load_from_thread_task(local_path,&res,r_error))
+			return res;
+	}
+
 	if (!p_no_cache && ResourceCache::has(local_path)) {
 
 		if (OS::get_singleton()->is_stdout_verbose())
@@ -461,6 +473,357 @@ String ResourceLoader::get_resource_type(const String &p_path) {
 	return "";
 
 }
+String ResourceLoader::_localize_path(const String& p_path) {
+
+	if (p_path.is_rel_path())
+		return "res://"+p_path;
+	else
+		return Globals::get_singleton()->localize_path(p_path);
+}
+
+/* Threaded loading. All the task bookkeeping happens with thread_load_mutex held,
+   the loading itself runs unlocked. */
+
+ResourceLoader::ThreadLoadTask *ResourceLoader::_request_task(const String& p_local_path,const String& p_type_hint) {
+
+	ThreadLoadTask **existing=thread_load_tasks.getptr(p_local_path);
+	if (existing) {
+		(*existing)->users++;
+		return *existing;
+	}
+
+	ThreadLoadTask *task = memnew( ThreadLoadTask );
+	task->local_path=p_local_path;
+	task->type_hint=p_type_hint;
+	task->status=THREAD_LOAD_IN_PROGRESS;
+	task->started=false;
+	task->error=OK;
+	task->stage=0;
+	task->stage_count=0;
+	task->users=1;
+	task->waiters=0;
+	task->done=NULL;
+	thread_load_tasks[p_local_path]=task;
+
+	if (ResourceCache::has(p_local_path)) {
+
+		task->resource=RES( ResourceCache::get(p_local_path) );
+		if (task->resource.is_valid()) {
+			task->status=THREAD_LOAD_LOADED;
+			task->started=true;
+			return task;
+		}
+	}
+
+	if (thread_load_thread_count==0) {
+
+		thread_load_thread_count=CLAMP(OS::get_singleton()->get_processor_count()-1,1,int(MAX_LOAD_THREADS));
+		for(int i=0;i<thread_load_thread_count;i++) {
+			thread_load_threads[i]=Thread::create(_thread_load_function,NULL);
+		}
+	}
+
+	thread_load_queue.push_back(task);
+	thread_load_semaphore->post();
+
+	return task;
+}
+
+void ResourceLoader::_release_task(ThreadLoadTask *p_task) {
+
+	p_task->users--;
+	if (p_task->users>0)
+		return;
+
+	if (p_task->status==THREAD_LOAD_IN_PROGRESS) {
+
+		if (p_task->started)
+			return; // freed when it finishes
+		thread_load_queue.erase(p_task); // only queued as a dependency, no longer needed
+	}
+
+	thread_load_tasks.erase(p_task->local_path);
+	if (p_task->done)
+		memdelete(p_task->done);
+	memdelete(p_task);
+}
+
+void ResourceLoader::_run_task(ThreadLoadTask *p_task) {
+
+	p_task->started=true;
+	String local_path=p_task->local_path;
+	String type_hint=p_task->type_hint;
+
+	thread_load_mutex->unlock();
+
+	List<String> dependencies;
+	get_dependencies(local_path,&dependencies);
+
+	thread_load_mutex->lock();
+
+	// queue what this depends on, so other threads load it meanwhile
+	for(List<String>::Element *E=dependencies.front();E;E=E->next()) {
+
+		String dependency=_localize_path(E->get());
+		if (dependency==local_path || ResourceCache::has(dependency))
+			continue;
+		p_task->dependencies.push_back( _request_task(dependency,"") );
+	}
+
+	thread_load_mutex->unlock();
+
+	Error err=ERR_CANT_OPEN;
+	RES res;
+	Ref<ResourceInteractiveLoader> ril = load_interactive(local_path,type_hint,false,&err);
+	if (ril.is_valid()) {
+
+		// stages are only read to report progress, no need to lock for them
+		p_task->stage_count=ril->get_stage_count();
+		while(true) {
+
+			err=ril->poll();
+			p_task->stage=ril->get_stage();
+
+			if (err==ERR_FILE_EOF) {
+				err=OK;
+				res=ril->get_resource();
+				break;
+			}
+			if (err!=OK)
+				break;
+		}
+	}
+
+	if (res.is_valid() && res->get_path()=="")
+		res->set_path(local_path); // loaders without interactive support don't set it
+
+	thread_load_mutex->lock();
+
+	p_task->resource=res;
+	p_task->error=(res.is_null() && err==OK)?ERR_CANT_OPEN:err;
+	p_task->status=res.is_valid()?THREAD_LOAD_LOADED:THREAD_LOAD_FAILED;
+
+	for(int i=0;i<p_task->dependencies.size();i++) {
+		_release_task(p_task->dependencies[i]);
+	}
+	p_task->dependencies.clear();
+
+	for(int i=0;i<p_task->waiters;i++) {
+		p_task->done->post();
+	}
+	p_task->waiters=0;
+}
+
+void ResourceLoader::_wait_for_task(ThreadLoadTask *p_task) {
+
+	if (p_task->status!=THREAD_LOAD_IN_PROGRESS)
+		return;
+
+	if (!p_task->started) {
+		// still queued, load it right here instead of waiting for a load thread
+		thread_load_queue.erase(p_task);
+		_run_task(p_task);
+		return;
+	}
+
+	if (!p_task->done)
+		p_task->done=Semaphore::create();
+
+	p_task->waiters++;
+	thread_load_mutex->unlock();
+	p_task->done->wait();
+	thread_load_mutex->lock();
+}
+
+float ResourceLoader::_get_task_progress(const ThreadLoadTask *p_task) {
+
+	if (p_task->status!=THREAD_LOAD_IN_PROGRESS)
+		return 1.0;
+
+	float progress = p_task->stage_count>0 ? float(p_task->stage)/p_task->stage_count : 0.0;
+	for(int i=0;i<p_task->dependencies.size();i++) {
+		progress+=_get_task_progress(p_task->dependencies[i]);
+	}
+
+	return progress/(p_task->dependencies.size()+1);
+}
+
+bool ResourceLoader::_load_from_thread_task(const String& p_local_path,RES *r_res,Error *r_error) {
+
+	if (!thread_load_mutex)
+		return false;
+
+	thread_load_mutex->lock();
+
+	ThreadLoadTask **task_ptr=thread_load_tasks.getptr(p_local_path);
+	if (!task_ptr || (*task_ptr)->status!=THREAD_LOAD_IN_PROGRESS) {
+		thread_load_mutex->unlock();
+		return false; // not loading, or already in the cache
+	}
+
+	ThreadLoadTask *task=*task_ptr;
+	task->users++;
+	_wait_for_task(task);
+
+	*r_res=task->resource;
+	if (r_error)
+		*r_error=task->error;
+
+	_release_task(task);
+	thread_load_mutex->unlock();
+
+	return true;
+}
+
+void ResourceLoader::_thread_load_function(void *p_userdata) {
+
+	while(true) {
+
+		thread_load_semaphore->wait();
+
+		thread_load_mutex->lock();
+
+		if (thread_load_exit) {
+			thread_load_mutex->unlock();
+			break;
+		}
+
+		if (!thread_load_queue.empty()) {
+
+			ThreadLoadTask *task=thread_load_queue.front()->get();
+			thread_load_queue.pop_front();
+
+			task->users++;
+			_run_task(task);
+			_release_task(task);
+		}
+
+		thread_load_mutex->unlock();
+	}
+}
+
+Error ResourceLoader::load_threaded_request(const String &p_path,const String& p_type_hint) {
+
+	ERR_FAIL_COND_V(!thread_load_mutex,ERR_UNCONFIGURED);
+
+	String local_path=find_complete_path(_localize_path(p_path),p_type_hint);
+	ERR_FAIL_COND_V(local_path=="",ERR_FILE_NOT_FOUND);
+
+	if (OS::get_singleton()->is_stdout_verbose())
+		print_line("load resource threaded: "+local_path);
+
+	thread_load_mutex->lock();
+	_request_task(local_path,p_type_hint);
+	thread_load_mutex->unlock();
+
+	return OK;
+}
+
+ResourceLoader::ThreadLoadStatus ResourceLoader::load_threaded_poll(const String &p_path,float *r_progress) {
+
+	ERR_FAIL_COND_V(!thread_load_mutex,THREAD_LOAD_INVALID_RESOURCE);
+
+	String local_path=find_complete_path(_localize_path(p_path),"");
+
+	thread_load_mutex->lock();
+
+	ThreadLoadTask **task=thread_load_tasks.getptr(local_path);
+	if (!task) {
+		thread_load_mutex->unlock();
+		return THREAD_LOAD_INVALID_RESOURCE;
+	}
+
+	ThreadLoadStatus status=(*task)->status;
+	if (r_progress)
+		*r_progress=_get_task_progress(*task);
+
+	thread_load_mutex->unlock();
+
+	return status;
+}
+
+RES ResourceLoader::load_threaded_get(const String &p_path,Error *r_error) {
+
+	if (r_error)
+		*r_error=ERR_INVALID_PARAMETER;
+
+	ERR_FAIL_COND_V(!thread_load_mutex,RES());
+
+	String local_path=find_complete_path(_localize_path(p_path),"");
+
+	thread_load_mutex->lock();
+
+	ThreadLoadTask **task_ptr=thread_load_tasks.getptr(local_path);
+	if (!task_ptr) {
+		thread_load_mutex->unlock();
+		ERR_EXPLAIN("Resource was not requested for threaded loading: "+p_path);
+		ERR_FAIL_V(RES());
+	}
+
+	ThreadLoadTask *task=*task_ptr;
+	_wait_for_task(task);
+
+	RES res=task->resource;
+	if (r_error)
+		*r_error=task->error;
+
+	_release_task(task); // done with this request
+	thread_load_mutex->unlock();
+
+	return res;
+}
+
+void ResourceLoader::initialize() {
+
+	thread_load_mutex=Mutex::create();
+	thread_load_semaphore=Semaphore::create();
+	thread_load_exit=false;
+}
+
+void ResourceLoader::finalize() {
+
+	if (!thread_load_mutex)
+		return;
+
+	thread_load_mutex->lock();
+	thread_load_exit=true;
+	thread_load_queue.clear();
+	thread_load_mutex->unlock();
+
+	for(int i=0;i<thread_load_thread_count;i++) {
+		thread_load_semaphore->post();
+	}
+	for(int i=0;i<thread_load_thread_count;i++) {
+		Thread::wait_to_finish(thread_load_threads[i]);
+		memdelete(thread_load_threads[i]);
+	}
+	thread_load_thread_count=0;
+
+	// requests that were never collected
+	const String *K=NULL;
+	while((K=thread_load_tasks.next(K))) {
+
+		ThreadLoadTask *task=thread_load_tasks[*K];
+		if (task->done)
+			memdelete(task->done);
+		memdelete(task);
+	}
+	thread_load_tasks.clear();
+
+	memdelete(thread_load_semaphore);
+	thread_load_semaphore=NULL;
+	memdelete(thread_load_mutex);
+	thread_load_mutex=NULL;
+}
+
+Mutex *ResourceLoader::thread_load_mutex=NULL;
+Semaphore *ResourceLoader::thread_load_semaphore=NULL;
+Thread *ResourceLoader::thread_load_threads[MAX_LOAD_THREADS];
+int ResourceLoader::thread_load_thread_count=0;
+bool ResourceLoader::thread_load_exit=false;
+HashMap<String,ResourceLoader::ThreadLoadTask*> ResourceLoader::thread_load_tasks;
+List<ResourceLoader::ThreadLoadTask*> ResourceLoader::thread_load_queue;
+
 ResourceLoadErrorNotify ResourceLoader::err_notify=NULL;
 void *ResourceLoader::err_notify_ud=NULL;
 
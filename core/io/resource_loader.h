@@ -76,10 +76,41 @@ typedef void (*ResourceLoadErrorNotify)(void *p_ud,const String& p_text);
 typedef void (*DependencyErrorNotify)(void *p_ud,const String& p_loading,const String& p_which,const String& p_type);
 
 
+class Mutex;
+class Semaphore;
+class Thread;
+
 class ResourceLoader {
+public:
+
+	enum ThreadLoadStatus {
+		THREAD_LOAD_INVALID_RESOURCE,
+		THREAD_LOAD_IN_PROGRESS,
+		THREAD_LOAD_FAILED,
+		THREAD_LOAD_LOADED
+	};
+
+private:
 
 	enum {
-		MAX_LOADERS=64
+		MAX_LOADERS=64,
+		MAX_LOAD_THREADS=8
+	};
+
+	struct ThreadLoadTask {
+
+		String local_path;
+		String type_hint;
+		ThreadLoadStatus status;
+		bool started; // picked up by a load thread, or by a thread that needed it right away
+		Error error;
+		RES resource;
+		int stage;
+		int stage_count;
+		int users; // requests plus tasks depending on this one, freed when it reaches zero
+		int waiters;
+		Semaphore *done;
+		Vector<ThreadLoadTask*> dependencies;
 	};
 
 	static ResourceFormatLoader *loader[MAX_LOADERS];
@@ -92,6 +123,23 @@ class ResourceLoader {
 	static DependencyErrorNotify dep_err_notify;
 	static bool abort_on_missing_resource;
 
+	static Mutex *thread_load_mutex;
+	static Semaphore *thread_load_semaphore;
+	static Thread *thread_load_threads[MAX_LOAD_THREADS];
+	static int thread_load_thread_count;
+	static bool thread_load_exit;
+	static HashMap<String,ThreadLoadTask*> thread_load_tasks;
+	static List<ThreadLoadTask*> thread_load_queue;
+
+	static ThreadLoadTask *_request_task(const String& p_local_path,const String& p_type_hint);
+	static void _release_task(ThreadLoadTask *p_task);
+	static void _run_task(ThreadLoadTask *p_task);
+	static void _wait_for_task(ThreadLoadTask *p_task);
+	static float _get_task_progress(const ThreadLoadTask *p_task);
+	static bool _load_from_thread_task(const String& p_local_path,RES *r_res,Error *r_error);
+	static void _thread_load_function(void *p_userdata);
+
+	static String _localize_path(const String& p_path);
 	static String find_complete_path(const String& p_path,const String& p_type);
 public:
 
@@ -101,6 +149,13 @@ public:
 	static RES load(const String &p_path,const String& p_type_hint="",bool p_no_cache=false,Error *r_error=NULL);
 	static Ref<ResourceImportMetadata> load_import_metadata(const String &p_path);
 
+	/* Loading in the background: a request queues the resource for the load threads, which
+	   also queue its dependencies so they load in parallel. Loading something that is queued
+	   (from load() or load_threaded_get()) takes it over, or waits for it if already loading. */
+	static Error load_threaded_request(const String &p_path,const String& p_type_hint="");
+	static ThreadLoadStatus load_threaded_poll(const String &p_path,float *r_progress=NULL);
+	static RES load_threaded_get(const String &p_path,Error *r_error=NULL);
+
 	static void get_recognized_extensions_for_type(const String& p_type,List<String> *p_extensions);
 	static void add_resource_format_loader(ResourceFormatLoader *p_format_loader,bool p_at_front=false);
 	static String get_resource_type(const String &p_path);
@@ -120,6 +175,9 @@ public:
 
 	static void set_abort_on_missing_resources(bool p_abort) { abort_on_missing_resource=p_abort; }
 	static bool get_abort_on_missing_resources() { return abort_on_missing_resource; }
+
+	static void initialize();
+	static void finalize();
 };
 
 #endif
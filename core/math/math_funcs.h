@@ -134,7 +134,7 @@ public:
 	//this function should be as fast as possible and rounding mode should not matter
 	static _FORCE_INLINE_ int fast_ftoi(float a) {
 
-		static int b;
+		int b; //not static, this is called from several threads at once
 
 #if (defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0603) || WINAPI_FAMILY == WINAPI_FAMILY_PHONE_APP // windows 8 phone?
 		b = (int)((a>0.0f) ? (a + 0.5f):(a -0.5f));
@@ -36,23 +36,89 @@ MessageQueue *MessageQueue::get_singleton() {
 	return singleton;
 }
 
-Error MessageQueue::push_call(ObjectID p_id,const StringName& p_method,const Variant** p_args,int p_argcount,bool p_show_error) {
+MessageQueue::Page *MessageQueue::_alloc_page() {
+
+	Page *page = (Page*)memalloc(sizeof(Page)+PAGE_SIZE);
+	page->next=NULL;
+	page->reserved=0;
+	page->read=0;
+	page->retired_next=NULL;
+	page->pins=0;
+	zeromem(page->data(),PAGE_SIZE);
+	return page;
+}
+
+void MessageQueue::_append_page(Page *p_page) {
+
+	/* pages are only linked at the end of the chain, producers may be linking new ones too */
+	Page *last=head;
+	while(true) {
+
+		Page *next=atomic_load(&last->next);
+		if (next) {
+			last=next;
+			continue;
+		}
+		if (atomic_cas(&last->next,(Page*)NULL,p_page))
+			return;
+	}
+}
+
+MessageQueue::Message *MessageQueue::_push_begin(uint32_t p_size,Page **r_page) {
+
+	ERR_FAIL_COND_V(p_size>PAGE_SIZE,NULL);
+
+	while(true) {
+
+		Page *page=atomic_load(&tail);
 
-	_THREAD_SAFE_METHOD_
+		/* Pin the page so it is not recycled under us. If the tail moved in the meantime the page
+		   may already be retired, so try again. If it was retired and recycled back into the tail,
+		   it is a valid tail again, so writing to it is fine. */
+		atomic_add(&page->pins,1);
+		if (atomic_load(&tail)!=page) {
+			atomic_add(&page->pins,-1);
+			continue;
+		}
+
+		uint32_t ofs=atomic_add(&page->reserved,p_size)-p_size;
 
-	int room_needed=sizeof(Message)+sizeof(Variant)*p_argcount;
+		if (ofs+p_size<=PAGE_SIZE) {
+			*r_page=page;
+			return (Message*)&page->data()[ofs];
+		}
 
-	if ((buffer_end+room_needed) >= buffer_size) {
-		String type;
-		if (ObjectDB::get_instance(p_id))
-			type=ObjectDB::get_instance(p_id)->get_type();
-		print_line("failed method: "+type+":"+p_method+" target ID: "+itos(p_id));
-		statistics();
+		/* did not fit, the first one to overflow tells the consumer to skip the rest of the page */
+		if (ofs+sizeof(uint32_t)<=PAGE_SIZE)
+			atomic_store((volatile uint32_t*)&page->data()[ofs],uint32_t(SIZE_SKIP_PAGE));
+
+		Page *next=atomic_load(&page->next);
+		if (!next) {
+			Page *new_page=_alloc_page();
+			if (atomic_cas(&page->next,(Page*)NULL,new_page)) {
+				atomic_add(&page_count,1);
+			} else {
+				memfree(new_page); // someone else linked one first
+			}
+			next=atomic_load(&page->next);
+		}
 
+		atomic_cas(&tail,page,next);
+		atomic_add(&page->pins,-1);
 	}
 
-	ERR_FAIL_COND_V( (buffer_end+room_needed) >= buffer_size , ERR_OUT_OF_MEMORY );
-	Message * msg = memnew_placement( &buffer[ buffer_end ], Message );
+	return NULL;
+}
+
+Error MessageQueue::push_call(ObjectID p_id,const StringName& p_method,const Variant** p_args,int p_argcount,bool p_show_error) {
+
+	uint32_t room_needed=sizeof(Message)+sizeof(Variant)*p_argcount;
+
+	Page *page;
+	Message * msg = _push_begin(room_needed,&page);
+	ERR_FAIL_COND_V( !msg, ERR_OUT_OF_MEMORY );
+
+	memnew_placement( msg, Message );
 	msg->args=p_argcount;
 	msg->instance_ID=p_id;
 	msg->target=p_method;
@@ -60,16 +126,14 @@ Error MessageQueue::push_call(ObjectID p_id,const StringName& p_method,const Var
 	if (p_show_error)
 		msg->type|=FLAG_SHOW_ERROR;
 
-	buffer_end+=sizeof(Message);
-
+	Variant *args=(Variant*)(msg+1);
 	for(int i=0;i<p_argcount;i++) {
 
-		Variant * v = memnew_placement( &buffer[ buffer_end ], Variant );
-		buffer_end+=sizeof(Variant);
-		*v=*p_args[i];
-
+		memnew_placement( &args[i], Variant(*p_args[i]) );
 	}
 
+	_push_end(page,msg,room_needed);
+
 	return OK;
 }
 
@@ -91,67 +155,42 @@ Error MessageQueue::push_call(ObjectID p_id, const StringName& p_method, VARIANT
 
 Error MessageQueue::push_set(ObjectID p_id, const StringName& p_prop, const Variant& p_value) {
 
-	_THREAD_SAFE_METHOD_
-
-	uint8_t room_needed=sizeof(Message)+sizeof(Variant);
-
-	if ((buffer_end+room_needed) >= buffer_size) {
-		String type;
-		if (ObjectDB::get_instance(p_id))
-			type=ObjectDB::get_instance(p_id)->get_type();
-		print_line("failed set: "+type+":"+p_prop+" target ID: "+itos(p_id));
-		statistics();
-
-	}
+	uint32_t room_needed=sizeof(Message)+sizeof(Variant);
 
-	ERR_FAIL_COND_V( (buffer_end+room_needed) >= buffer_size , ERR_OUT_OF_MEMORY );
+	Page *page;
+	Message * msg = _push_begin(room_needed,&page);
+	ERR_FAIL_COND_V( !msg, ERR_OUT_OF_MEMORY );
 
-	Message * msg = memnew_placement( &buffer[ buffer_end ], Message );
+	memnew_placement( msg, Message );
 	msg->args=1;
 	msg->instance_ID=p_id;
 	msg->target=p_prop;
 	msg->type=TYPE_SET;
 
-	buffer_end+=sizeof(Message);
-
-	Variant * v = memnew_placement( &buffer[ buffer_end ], Variant );
-	buffer_end+=sizeof(Variant);
-	*v=p_value;
+	memnew_placement( (Variant*)(msg+1), Variant(p_value) );
 
+	_push_end(page,msg,room_needed);
 
 	return OK;
 }
 
 Error MessageQueue::push_notification(ObjectID p_id, int p_notification) {
 
-	_THREAD_SAFE_METHOD_
-
 	ERR_FAIL_COND_V(p_notification<0, ERR_INVALID_PARAMETER );
 
-	uint8_t room_needed=sizeof(Message);
-
-	if ((buffer_end+room_needed) >= buffer_size) {
-		String type;
-		if (ObjectDB::get_instance(p_id))
-			type=ObjectDB::get_instance(p_id)->get_type();
-		print_line("failed notification: "+itos(p_notification)+" target ID: "+itos(p_id));
-		statistics();
-
-	}
-
+	uint32_t room_needed=sizeof(Message);
 
+	Page *page;
+	Message * msg = _push_begin(room_needed,&page);
+	ERR_FAIL_COND_V( !msg, ERR_OUT_OF_MEMORY );
 
-
-	ERR_FAIL_COND_V( (buffer_end+room_needed) >= buffer_size , ERR_OUT_OF_MEMORY );
-	Message * msg = memnew_placement( &buffer[ buffer_end ], Message );
-
+	memnew_placement( msg, Message );
 	msg->type=TYPE_NOTIFICATION;
 	msg->instance_ID=p_id;
 	//msg->target;
 	msg->notification=p_notification;
 
-	buffer_end+=sizeof(Message);
-
+	_push_end(page,msg,room_needed);
 
 	return OK;
 }
@@ -178,60 +217,70 @@ void MessageQueue::statistics() {
 	Map<StringName,int> call_count;
 	int null_count=0;
 
-	uint32_t read_pos=0;
-	while (read_pos < buffer_end ) {
-		Message *message = (Message*)&buffer[ read_pos ];
+	uint32_t total=0;
 
-		Object *target = ObjectDB::get_instance(message->instance_ID);
+	for(Page *page=head;page;page=atomic_load(&page->next)) {
 
-		if (target!=NULL) {
+		uint32_t read_pos=page->read;
+		uint32_t end=MIN(atomic_load(&page->reserved),uint32_t(PAGE_SIZE));
 
+		while (read_pos+sizeof(uint32_t)<=end) {
 
-			switch(message->type&FLAG_MASK) {
+			Message *message = (Message*)&page->data()[ read_pos ];
+			uint32_t size=atomic_load(&message->size);
+			if (size==0 || size==SIZE_SKIP_PAGE)
+				break;
 
-				case TYPE_CALL: {
+			Object *target = ObjectDB::get_instance(message->instance_ID);
 
-					if (!call_count.has(message->target))
-						call_count[message->target]=0;
+			if (target!=NULL) {
 
-					call_count[message->target]++;
 
-				} break;
-				case TYPE_NOTIFICATION: {
+				switch(message->type&FLAG_MASK) {
 
-					if (!notify_count.has(message->notification))
-						notify_count[message->notification]=0;
+					case TYPE_CALL: {
 
-					notify_count[message->notification]++;
+						if (!call_count.has(message->target))
+							call_count[message->target]=0;
 
-				} break;
-				case TYPE_SET: {
+						call_count[message->target]++;
 
-					if (!set_count.has(message->target))
-						set_count[message->target]=0;
+					} break;
+					case TYPE_NOTIFICATION: {
 
-					set_count[message->target]++;
+						if (!notify_count.has(message->notification))
+							notify_count[message->notification]=0;
 
-				} break;
+						notify_count[message->notification]++;
 
-			}
+					} break;
+					case TYPE_SET: {
 
-			//object was deleted
-			//WARN_PRINT("Object was deleted while awaiting a callback")
-			//should it print a warning?
-		} else {
+						if (!set_count.has(message->target))
+							set_count[message->target]=0;
 
-			null_count++;
-		}
+						set_count[message->target]++;
 
+					} break;
 
-		read_pos+=sizeof(Message);
-		if ((message->type&FLAG_MASK)!=TYPE_NOTIFICATION)
-			read_pos+=sizeof(Variant)*message->args;
+				}
+
+				//object was deleted
+				//WARN_PRINT("Object was deleted while awaiting a callback")
+				//should it print a warning?
+			} else {
+
+				null_count++;
+			}
+
+			read_pos+=size;
+			total+=size;
+		}
 	}
 
 
-	print_line("TOTAL BYTES: "+itos(buffer_end));
+	print_line("TOTAL BYTES: "+itos(total));
+	print_line("PAGES: "+itos(page_count));
 	print_line("NULL count: "+itos(null_count));
 
 	for(Map<StringName,int>::Element *E=set_count.front();E;E=E->next()) {
@@ -297,6 +346,23 @@ int MessageQueue::get_max_buffer_usage() const {
 	return buffer_max_used;
 }
 
+int MessageQueue::get_page_count() const {
+
+	return page_count;
+}
+
+uint32_t MessageQueue::_get_pending_bytes() const {
+
+	uint32_t pending=0;
+	for(Page *page=head;page;page=atomic_load(&page->next)) {
+
+		uint32_t end=MIN(atomic_load(&page->reserved),uint32_t(PAGE_SIZE));
+		if (end>page->read)
+			pending+=end-page->read;
+	}
+	return pending;
+}
+
 
 void MessageQueue::_call_function(Object* p_target, const StringName& p_func, const Variant *p_args, int p_argcount,bool p_show_error) {
 
@@ -317,78 +383,118 @@ void MessageQueue::_call_function(Object* p_target, const StringName& p_func, co
 	}
 }
 
-void MessageQueue::flush() {
+void MessageQueue::_destroy_message(Message *p_message) {
 
+	if ((p_message->type&FLAG_MASK)!=TYPE_NOTIFICATION) {
+		Variant *args= (Variant*)(p_message+1);
+		for(int i=0;i<p_message->args;i++)
+			args[i].~Variant();
+	}
+	p_message->~Message();
+}
 
-	if (buffer_end > buffer_max_used) {
-		buffer_max_used=buffer_end;
-		//statistics();
+void MessageQueue::_recycle_retired_pages() {
+
+	/* The tail was moved past every retired page, so once a page has no pins left no producer
+	   can reach it anymore (see _push_begin). Pinned ones wait for the next flush. */
+	Page **ptr=&retired;
+
+	while(*ptr) {
+
+		Page *page=*ptr;
+		if (atomic_load(&page->pins)!=0) {
+			ptr=&page->retired_next;
+			continue;
+		}
+		*ptr=page->retired_next;
+
+		// pins is left alone, stale producers may still briefly touch it
+		zeromem(page->data(),MIN(page->reserved,uint32_t(PAGE_SIZE)));
+		page->read=0;
+		page->retired_next=NULL;
+		page->next=NULL;
+		atomic_store(&page->reserved,uint32_t(0));
+		_append_page(page);
 	}
+}
 
-	uint32_t read_pos=0;
+void MessageQueue::flush() {
+
+	uint32_t pending=_get_pending_bytes();
+	if (pending > buffer_max_used) {
+		buffer_max_used=pending;
+		//statistics();
+	}
 
-	//using reverse locking strategy
-	_THREAD_SAFE_LOCK_
+	while(true) {
 
-	while (read_pos<buffer_end) {
+		Page *page=head;
+		uint32_t reserved=atomic_load(&page->reserved);
+		uint32_t end=MIN(reserved,uint32_t(PAGE_SIZE));
 
-		_THREAD_SAFE_UNLOCK_
+		if (page->read<end && page->read+sizeof(uint32_t)<=PAGE_SIZE) {
 
-		//lock on each interation, so a call can re-add itself to the message queue
+			Message *message = (Message*)&page->data()[ page->read ];
+			uint32_t size=atomic_load(&message->size);
 
-		Message *message = (Message*)&buffer[ read_pos ];
+			if (size==0)
+				break; // still being written by another thread, goes in the next flush
 
-		Object *target = ObjectDB::get_instance(message->instance_ID);
+			if (size!=SIZE_SKIP_PAGE) {
 
-		if (target!=NULL) {
+				Object *target = ObjectDB::get_instance(message->instance_ID);
 
-			switch(message->type&FLAG_MASK) {
-				case TYPE_CALL: {
+				if (target!=NULL) {
 
-					Variant *args= (Variant*)(message+1);
+					switch(message->type&FLAG_MASK) {
+						case TYPE_CALL: {
 
-					// messages don't expect a return value
+							Variant *args= (Variant*)(message+1);
 
+							// messages don't expect a return value
+							_call_function(target,message->target,args,message->args,message->type&FLAG_SHOW_ERROR);
 
-					_call_function(target,message->target,args,message->args,message->type&FLAG_SHOW_ERROR);
+						} break;
+						case TYPE_NOTIFICATION: {
 
-					for(int i=0;i<message->args;i++) {
-						args[i].~Variant();
-					}
+							// messages don't expect a return value
+							target->notification(message->notification);
 
-				} break;
-				case TYPE_NOTIFICATION: {
+						} break;
+						case TYPE_SET: {
 
-					// messages don't expect a return value
-					target->notification(message->notification);
+							Variant *arg= (Variant*)(message+1);
+							// messages don't expect a return value
+							target->set(message->target,*arg);
 
-				} break;
-				case TYPE_SET: {
+						} break;
+					}
 
-					Variant *arg= (Variant*)(message+1);
-					// messages don't expect a return value
-					target->set(message->target,*arg);
+				}
 
-					arg->~Variant();
-				} break;
+				_destroy_message(message);
+				page->read+=size;
+				continue; // calls can push more messages, which are flushed too
 			}
 
+		} else if (reserved<=PAGE_SIZE) {
+			break; // all flushed
 		}
 
-		uint32_t advance = sizeof(Message);
-		if ((message->type&FLAG_MASK)!=TYPE_NOTIFICATION)
-			advance+=sizeof(Variant)*message->args;
-		message->~Message();
-
-		_THREAD_SAFE_LOCK_
-		read_pos+=advance;
+		/* done with this page */
+		Page *next=atomic_load(&page->next);
+		if (!next)
+			break; // the producer that overflowed it is still linking the next one
 
+		head=next;
+		atomic_cas(&tail,page,next);
+		page->retired_next=retired;
+		retired=page;
+		_recycle_retired_pages(); // right away, producers may keep this flush busy for long
 	}
 
-
-	buffer_end=0; // reset buffer
-	_THREAD_SAFE_UNLOCK_
-
+	if (retired)
+		_recycle_retired_pages();
 }
 
 MessageQueue::MessageQueue() {
@@ -396,34 +502,44 @@ MessageQueue::MessageQueue() {
 	ERR_FAIL_COND(singleton!=NULL);
 	singleton=this;
 
-	buffer_end=0;
 	buffer_max_used=0;
-	buffer_size=GLOBAL_DEF( "core/message_queue_size_kb", DEFAULT_QUEUE_SIZE_KB );
-	buffer_size*=1024;
-	buffer = memnew_arr( uint8_t, buffer_size );
+	retired=NULL;
+
+	int size_kb=GLOBAL_DEF( "core/message_queue_size_kb", DEFAULT_QUEUE_SIZE_KB ); //initial size, grows as needed
+	page_count=MAX(1,(size_kb*1024)/PAGE_SIZE);
+
+	head=_alloc_page();
+	tail=head;
+	for(uint32_t i=1;i<page_count;i++)
+		_append_page(_alloc_page());
 }
 
 
 MessageQueue::~MessageQueue() {
 
-	uint32_t read_pos=0;
+	Page *page=head;
+	while(page) {
 
-	while (read_pos < buffer_end ) {
+		uint32_t end=MIN(page->reserved,uint32_t(PAGE_SIZE));
+		while (page->read+sizeof(uint32_t)<=end) {
 
-		Message *message = (Message*)&buffer[ read_pos ];
-		Variant *args= (Variant*)(message+1);
-		int argc = message->args;
-		if ((message->type&FLAG_MASK)!=TYPE_NOTIFICATION) {
-			for (int i=0;i<argc;i++)
-				args[i].~Variant();
+			Message *message = (Message*)&page->data()[ page->read ];
+			if (message->size==0 || message->size==SIZE_SKIP_PAGE)
+				break;
+			page->read+=message->size;
+			_destroy_message(message);
 		}
-		message->~Message();
 
-		read_pos+=sizeof(Message);
-		if ((message->type&FLAG_MASK)!=TYPE_NOTIFICATION)
-			read_pos+=sizeof(Variant)*message->args;
+		Page *next=page->next;
+		memfree(page);
+		page=next;
+	}
+
+	while(retired) {
+		Page *next=retired->retired_next;
+		memfree(retired);
+		retired=next;
 	}
 
 	singleton=NULL;
-	memdelete_arr( buffer );
 }
@@ -30,19 +30,21 @@
 #define MESSAGE_QUEUE_H
 
 #include "object.h"
-#include "os/mutex.h"
-#include "os/thread_safe.h"
-class MessageQueue {
+#include "safe_refcount.h"
+
+/* Messages are pushed without locking from any thread (each producer reserves room with an atomic
+   add) into a chain of fixed size pages that grows as needed, and flushed from the main thread.
+   Messages from a single thread are always flushed in the order they were pushed. */
 
-	_THREAD_SAFE_CLASS_
+class MessageQueue {
 
 	enum {
 
-        DEFAULT_QUEUE_SIZE_KB=1024
+		DEFAULT_QUEUE_SIZE_KB=1024,
+		PAGE_SIZE=64*1024,
+		SIZE_SKIP_PAGE=0xFFFFFFFF // marks the end of a page, when the next message did not fit
 	};
 
-	Mutex *mutex;
-
 	enum {
 		TYPE_CALL,
 		TYPE_NOTIFICATION,
@@ -54,6 +56,7 @@ class MessageQueue {
 
 	struct Message {
 
+		volatile uint32_t size; // stored last by the producer, zero while being written
 		ObjectID instance_ID;
 		StringName target;
 		int16_t type;
@@ -63,11 +66,37 @@ class MessageQueue {
 		};
 	};
 
-	uint8_t *buffer;
-	uint32_t buffer_end;
+	struct Page {
+
+		Page * volatile next;
+		volatile uint32_t reserved; // bytes reserved by producers, can go past PAGE_SIZE
+		uint32_t read; // bytes flushed (consumer only)
+		volatile uint32_t pins; // producers currently writing to this page
+		Page *retired_next;
+
+		_FORCE_INLINE_ uint8_t *data() { return reinterpret_cast<uint8_t*>(this+1); }
+	};
+
+	Page *head; // consumer side
+	Page * volatile tail; // producer side
+	Page *retired; // flushed pages, reused once no producer holds a pin on them
+
 	uint32_t buffer_max_used;
-	uint32_t buffer_size;
+	uint32_t page_count;
+
+	Page *_alloc_page();
+	void _append_page(Page *p_page);
+	void _recycle_retired_pages();
+	uint32_t _get_pending_bytes() const;
+
+	Message *_push_begin(uint32_t p_size,Page **r_page);
+	_FORCE_INLINE_ void _push_end(Page *p_page,Message *p_message,uint32_t p_size) {
+
+		atomic_store(&p_message->size,p_size);
+		atomic_add(&p_page->pins,-1);
+	}
 
+	void _destroy_message(Message *p_message);
 	void _call_function(Object* p_target,const StringName& p_func,const Variant *p_args,int p_argcount,bool p_show_error);
 
 	static MessageQueue *singleton;
@@ -88,7 +117,8 @@ public:
 	void statistics();
 	void flush();
 
-	int get_max_buffer_usage() const;
+	int get_max_buffer_usage() const; // high water mark of the bytes waiting for a flush
+	int get_page_count() const;
 
 	MessageQueue();
 	~MessageQueue();
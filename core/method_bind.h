@@ -39,7 +39,8 @@
 	@author Juan Linietsky <reduzio@gmail.com>
 */
 
-#ifdef DEBUG_ENABLED
+#if defined(DEBUG_ENABLED) || defined(PTRCALL_ENABLED)
+//ptrcall callers need the argument types to check what they pass
 #define DEBUG_METHODS_ENABLED
 #endif
 
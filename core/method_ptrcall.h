@@ -33,11 +33,13 @@ struct PtrToArg<const m_type&> {\
 }
 
 
+//types stored in a wider Variant representation are passed as that representation
+
 #define MAKE_PTRARGR(m_type,m_ret) \
 template<>\
 struct PtrToArg<m_type> {\
 	_FORCE_INLINE_ static m_type convert(const void* p_ptr) {\
-		return *reinterpret_cast<const m_type*>(p_ptr);\
+		return m_type(*reinterpret_cast<const m_ret*>(p_ptr));\
 	}\
 	_FORCE_INLINE_ static void encode(m_type p_val, void* p_ptr) {\
 		*((m_ret*)p_ptr)=p_val;\
@@ -46,7 +48,7 @@ struct PtrToArg<m_type> {\
 template<>\
 struct PtrToArg<const m_type&> {\
 	_FORCE_INLINE_ static m_type convert(const void* p_ptr) {\
-		return *reinterpret_cast<const m_type*>(p_ptr);\
+		return m_type(*reinterpret_cast<const m_ret*>(p_ptr));\
 	}\
 	_FORCE_INLINE_ static void encode(m_type p_val, void* p_ptr) {\
 		*((m_ret*)p_ptr)=p_val;\
@@ -64,8 +66,8 @@ MAKE_PTRARGR(uint32_t,int);
 MAKE_PTRARGR(int32_t,int);
 MAKE_PTRARGR(int64_t,int);
 MAKE_PTRARGR(uint64_t,int);
-MAKE_PTRARG(float);
-MAKE_PTRARGR(double,float);
+MAKE_PTRARGR(float,double);
+MAKE_PTRARG(double);
 
 MAKE_PTRARG(String);
 MAKE_PTRARG(Vector2);
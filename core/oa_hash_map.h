@@ -0,0 +1,476 @@
+/*************************************************************************/
+/*  oa_hash_map.h                                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2016 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#ifndef OA_HASH_MAP_H
+#define OA_HASH_MAP_H
+
+#include "hash_map.h"
+
+/**
+ * @class OAHashMap
+ *
+ * Open addressing alternative to HashMap, with the same interface.
+ * Pairs live in a single array (no allocation per element). A parallel array of control bytes
+ * holds 7 bits of the hash for every used slot (or the EMPTY/DELETED markers), so lookups
+ * test 8 slots at once on a 64 bits word, and compare keys only on a likely match.
+ * Probing is linear, by groups of 8 slots.
+ *
+ * Unlike HashMap, inserting may move the existing pairs, so pointers returned by getptr()
+ * or operator[] are only valid until the next insertion.
+ *
+ * @param TKey  Key, search is based on it, needs to be hasheable. It is unique in this container.
+ * @param TData Data, data associated with the key
+ * @param Hasher Hasher object, needs to provide a valid static hash function for TKey
+ * @param MIN_CAPACITY_POWER Minimum amount of slots, as a power of two (at least 3).
+ */
+
+template<class TKey, class TData, class Hasher=HashMapHahserDefault,uint8_t MIN_CAPACITY_POWER=3>
+class OAHashMap {
+public:
+
+	typedef typename HashMap<TKey,TData,Hasher>::Pair Pair;
+
+private:
+
+	enum {
+		CTRL_EMPTY=0x80,
+		CTRL_DELETED=0xFE,
+		GROUP_SIZE=8
+	};
+
+	uint8_t *ctrl; // capacity+GROUP_SIZE bytes, the tail mirrors the first group so groups never wrap
+	Pair *pairs;
+	uint32_t capacity;
+	uint32_t elements;
+	uint32_t deleted;
+
+	static _FORCE_INLINE_ uint32_t _hash(uint32_t p_hash) {
+
+		// hashers may return the key itself (ints), spread it so the control bits are useful
+		return p_hash*0x9E3779B1;
+	}
+
+	static _FORCE_INLINE_ uint8_t _h2(uint32_t p_hash) {
+
+		return p_hash>>25;
+	}
+
+	_FORCE_INLINE_ uint64_t _load_group(uint32_t p_pos) const {
+
+		// byte by byte so it's endian independent, compilers turn it into a single load
+		const uint8_t *c=&ctrl[p_pos];
+		return uint64_t(c[0])|(uint64_t(c[1])<<8)|(uint64_t(c[2])<<16)|(uint64_t(c[3])<<24)|
+				(uint64_t(c[4])<<32)|(uint64_t(c[5])<<40)|(uint64_t(c[6])<<48)|(uint64_t(c[7])<<56);
+	}
+
+	/* bit 7 of every byte is set for the matching slots */
+
+	static _FORCE_INLINE_ uint64_t _match_h2(uint64_t p_group,uint8_t p_h2) {
+
+		// may report a few false positives, keys are compared anyway
+		uint64_t x = p_group ^ (0x0101010101010101ULL*p_h2);
+		return (x-0x0101010101010101ULL) & ~x & 0x8080808080808080ULL;
+	}
+
+	static _FORCE_INLINE_ uint64_t _match_empty(uint64_t p_group) {
+
+		return p_group & (~p_group<<6) & 0x8080808080808080ULL;
+	}
+
+	static _FORCE_INLINE_ uint64_t _match_empty_or_deleted(uint64_t p_group) {
+
+		return p_group & 0x8080808080808080ULL;
+	}
+
+	static _FORCE_INLINE_ uint32_t _first_slot(uint64_t p_mask) {
+
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctzll(p_mask)>>3;
+#else
+		uint32_t slot=0;
+		while(!(p_mask&0x80)) {
+			p_mask>>=8;
+			slot++;
+		}
+		return slot;
+#endif
+	}
+
+	_FORCE_INLINE_ void _set_ctrl(uint32_t p_pos,uint8_t p_value) {
+
+		ctrl[p_pos]=p_value;
+		if (p_pos<GROUP_SIZE)
+			ctrl[capacity+p_pos]=p_value;
+	}
+
+	template<class C>
+	_FORCE_INLINE_ int32_t _find(const C& p_key,uint32_t p_hash) const {
+
+		if (!ctrl)
+			return -1;
+
+		uint32_t mask=capacity-1;
+		uint8_t h2=_h2(p_hash);
+		uint32_t pos=p_hash&mask;
+
+		while(true) {
+
+			uint64_t group=_load_group(pos);
+			uint64_t match=_match_h2(group,h2);
+			while(match) {
+
+				uint32_t slot=_first_slot(match);
+				uint32_t idx=(pos+slot)&mask;
+				if (pairs[idx].key==p_key)
+					return idx;
+				match&=~(uint64_t(0x80)<<(slot*8));
+			}
+
+			if (_match_empty(group))
+				return -1;
+
+			pos=(pos+GROUP_SIZE)&mask;
+		}
+
+		return -1;
+	}
+
+	_FORCE_INLINE_ uint32_t _find_free_slot(uint32_t p_hash) const {
+
+		uint32_t mask=capacity-1;
+		uint32_t pos=p_hash&mask;
+
+		while(true) {
+
+			uint64_t match=_match_empty_or_deleted(_load_group(pos));
+			if (match)
+				return (pos+_first_slot(match))&mask;
+
+			pos=(pos+GROUP_SIZE)&mask;
+		}
+	}
+
+	void _allocate(uint32_t p_capacity) {
+
+		capacity=p_capacity;
+		ctrl=(uint8_t*)memalloc(capacity+GROUP_SIZE);
+		pairs=(Pair*)memalloc(sizeof(Pair)*capacity);
+		for(uint32_t i=0;i<capacity+GROUP_SIZE;i++)
+			ctrl[i]=CTRL_EMPTY;
+		elements=0;
+		deleted=0;
+	}
+
+	void _rehash(uint32_t p_capacity) {
+
+		uint8_t *old_ctrl=ctrl;
+		Pair *old_pairs=pairs;
+		uint32_t old_capacity=capacity;
+
+		_allocate(p_capacity);
+
+		if (!old_ctrl)
+			return;
+
+		for(uint32_t i=0;i<old_capacity;i++) {
+
+			if (old_ctrl[i]&0x80)
+				continue;
+
+			uint32_t hash=_hash(Hasher::hash(old_pairs[i].key));
+			uint32_t idx=_find_free_slot(hash);
+			_set_ctrl(idx,_h2(hash));
+			memnew_placement(&pairs[idx],Pair);
+			pairs[idx]=old_pairs[i];
+			old_pairs[i].~Pair();
+			elements++;
+		}
+
+		memfree(old_ctrl);
+		memfree(old_pairs);
+	}
+
+	Pair* _insert(const TKey& p_key) {
+
+		uint32_t hash=_hash(Hasher::hash(p_key));
+
+		if (!ctrl) {
+			_allocate(1<<MIN_CAPACITY_POWER);
+		} else {
+			int32_t idx=_find(p_key,hash);
+			if (idx>=0)
+				return &pairs[idx];
+		}
+
+		/* keep at most 7/8 of the slots used (deleted ones count, they lengthen probes) */
+		if ((elements+deleted+1)*8 > capacity*7) {
+
+			if ((elements+1)*2 > capacity)
+				_rehash(capacity*2);
+			else
+				_rehash(capacity); //mostly tombstones, just clean up
+		}
+
+		uint32_t idx=_find_free_slot(hash);
+		if (ctrl[idx]==CTRL_DELETED)
+			deleted--;
+		_set_ctrl(idx,_h2(hash));
+		memnew_placement(&pairs[idx],Pair);
+		pairs[idx].key=p_key;
+		elements++;
+
+		return &pairs[idx];
+	}
+
+	int32_t _index_of(const TKey* p_key) const {
+
+		/* keys handed out by next() point inside the pair array, others (copies) are looked up */
+		const Pair *p=reinterpret_cast<const Pair*>(p_key);
+		if (p>=pairs && p<pairs+capacity)
+			return p-pairs;
+
+		return _find(*p_key,_hash(Hasher::hash(*p_key)));
+	}
+
+	void copy_from(const OAHashMap& p_t) {
+
+		if (&p_t==this)
+			return;
+
+		clear();
+
+		if (!p_t.ctrl)
+			return;
+
+		_allocate(p_t.capacity);
+		for(uint32_t i=0;i<capacity+GROUP_SIZE;i++)
+			ctrl[i]=p_t.ctrl[i];
+
+		for(uint32_t i=0;i<capacity;i++) {
+
+			if (ctrl[i]&0x80)
+				continue;
+			memnew_placement(&pairs[i],Pair);
+			pairs[i]=p_t.pairs[i];
+		}
+
+		elements=p_t.elements;
+		deleted=p_t.deleted;
+	}
+
+public:
+
+	void set( const TKey& p_key, const TData& p_data ) {
+
+		_insert(p_key)->data=p_data;
+	}
+
+	void set( const Pair& p_pair ) {
+
+		_insert(p_pair.key)->data=p_pair.data;
+	}
+
+	bool has( const TKey& p_key ) const {
+
+		return getptr(p_key)!=NULL;
+	}
+
+	const TData& get( const TKey& p_key ) const {
+
+		const TData* res = getptr(p_key);
+		ERR_FAIL_COND_V(!res,*res);
+		return *res;
+	}
+
+	TData& get( const TKey& p_key )  {
+
+		TData* res = getptr(p_key);
+		ERR_FAIL_COND_V(!res,*res);
+		return *res;
+	}
+
+	_FORCE_INLINE_ TData* getptr( const TKey& p_key ) {
+
+		int32_t idx=_find(p_key,_hash(Hasher::hash(p_key)));
+		return idx<0 ? NULL : &pairs[idx].data;
+	}
+
+	_FORCE_INLINE_ const TData* getptr( const TKey& p_key ) const {
+
+		int32_t idx=_find(p_key,_hash(Hasher::hash(p_key)));
+		return idx<0 ? NULL : &pairs[idx].data;
+	}
+
+	template<class C>
+	_FORCE_INLINE_ TData* custom_getptr( C p_custom_key,uint32_t p_custom_hash )  {
+
+		int32_t idx=_find(p_custom_key,_hash(p_custom_hash));
+		return idx<0 ? NULL : &pairs[idx].data;
+	}
+
+	template<class C>
+	_FORCE_INLINE_ const TData* custom_getptr( C p_custom_key,uint32_t p_custom_hash ) const {
+
+		int32_t idx=_find(p_custom_key,_hash(p_custom_hash));
+		return idx<0 ? NULL : &pairs[idx].data;
+	}
+
+	bool erase( const TKey& p_key ) {
+
+		int32_t idx=_find(p_key,_hash(Hasher::hash(p_key)));
+		if (idx<0)
+			return false;
+
+		pairs[idx].~Pair();
+		elements--;
+
+		/* the slot can go back to empty unless it's part of 8 consecutive used slots, a probe may have gone past it then */
+		uint32_t mask=capacity-1;
+		uint32_t run=1;
+		for(uint32_t i=1;i<GROUP_SIZE && ctrl[(idx-i)&mask]!=CTRL_EMPTY;i++)
+			run++;
+		for(uint32_t i=1;i<GROUP_SIZE && ctrl[(idx+i)&mask]!=CTRL_EMPTY;i++)
+			run++;
+
+		if (run<GROUP_SIZE) {
+			_set_ctrl(idx,CTRL_EMPTY);
+		} else {
+			_set_ctrl(idx,CTRL_DELETED);
+			deleted++;
+		}
+
+		if (elements==0)
+			clear();
+
+		return true;
+	}
+
+	inline const TData& operator[](const TKey& p_key) const {
+
+		return get(p_key);
+	}
+
+	inline TData& operator[](const TKey& p_key ) {
+
+		return _insert(p_key)->data;
+	}
+
+	/**
+	 * Same as HashMap::next(), iterates in slot order.
+	 * Adding/Removing elements while iterating will, of course, have unexpected results, don't do it.
+	 */
+	const TKey* next(const TKey* p_key) const {
+
+		if (!ctrl)
+			return NULL;
+
+		uint32_t from=0;
+		if (p_key) {
+			int32_t idx=_index_of(p_key);
+			ERR_FAIL_COND_V( idx<0, NULL ); /* invalid key supplied */
+			from=idx+1;
+		}
+
+		for(uint32_t i=from;i<capacity;i++) {
+
+			if (!(ctrl[i]&0x80))
+				return &pairs[i].key;
+		}
+
+		return NULL;
+	}
+
+	inline unsigned int size() const {
+
+		return elements;
+	}
+
+	inline bool empty() const {
+
+		return elements==0;
+	}
+
+	void clear() {
+
+		if (ctrl) {
+			for(uint32_t i=0;i<capacity;i++) {
+				if (!(ctrl[i]&0x80))
+					pairs[i].~Pair();
+			}
+			memfree(ctrl);
+			memfree(pairs);
+		}
+
+		ctrl=NULL;
+		pairs=NULL;
+		capacity=0;
+		elements=0;
+		deleted=0;
+	}
+
+	void get_key_list(List<TKey> *p_keys) const {
+
+		for(uint32_t i=0;i<capacity;i++) {
+
+			if (!(ctrl[i]&0x80))
+				p_keys->push_back(pairs[i].key);
+		}
+	}
+
+	void operator=(const OAHashMap& p_table) {
+
+		copy_from(p_table);
+	}
+
+	OAHashMap() {
+
+		ctrl=NULL;
+		pairs=NULL;
+		capacity=0;
+		elements=0;
+		deleted=0;
+	}
+
+	OAHashMap(const OAHashMap& p_table) {
+
+		ctrl=NULL;
+		pairs=NULL;
+		capacity=0;
+		elements=0;
+		deleted=0;
+
+		copy_from(p_table);
+	}
+
+	~OAHashMap() {
+
+		clear();
+	}
+};
+
+#endif
@@ -681,6 +681,11 @@ void Object::call_multilevel(const StringName& p_method,const Variant** p_args,i
 		}
 #endif
 
+		if (_must_defer_free()) {
+			MessageQueue::get_singleton()->push_call(this,CoreStringNames::get_singleton()->_free);
+			return;
+		}
+
 		//must be here, must be before everything,
 		memdelete(this);
 		return;
@@ -945,6 +950,11 @@ Variant Object::call(const StringName& p_method,const Variant** p_args,int p_arg
 		}
 
 #endif
+		if (_must_defer_free()) {
+			MessageQueue::get_singleton()->push_call(this,CoreStringNames::get_singleton()->_free);
+			return Variant();
+		}
+
 		//must be here, must be before everything,
 		memdelete(this);
 		r_error.error=Variant::CallError::CALL_OK;
@@ -1152,14 +1162,6 @@ bool Object::_has_user_signal(const StringName& p_name) const {
 	return signal_map[p_name].user.name.length()>0;
 }
 
-struct _ObjectSignalDisconnectData {
-
-	StringName signal;
-	Object *target;
-	StringName method;
-
-};
-
 #if 0
 void Object::_emit_signal(const StringName& p_name,const Array& p_pargs){
 
@@ -1228,20 +1230,21 @@ void Object::emit_signal(const StringName& p_name,const Variant** p_args,int p_a
 	}
 
 
-	List<_ObjectSignalDisconnectData> disconnect_data;
-
-
 	//copy on write will ensure that disconnecting the signal or even deleting the object will not affect the signal calling.
 	//this happens automatically and will not change the performance of calling.
 	//awesome, isn't it?
-	VMap<Signal::Target,Signal::Slot> slot_map = s->slot_map;
+	//the copy must stay const, as non-const access would force it to be duplicated on every emission.
+	const VMap<Signal::Target,Signal::Slot> slot_map = s->slot_map;
 
 	int ssize = slot_map.size();
+	if (ssize==0)
+		return;
 
 	OBJ_DEBUG_LOCK
 
-	Vector<const Variant*> bind_mem;
-
+	//arguments plus binds are assembled on the stack, allocated once for the connection with most binds
+	const Variant **bind_mem=NULL;
+	bool has_oneshot=false;
 
 	for(int i=0;i<ssize;i++) {
 
@@ -1261,17 +1264,25 @@ void Object::emit_signal(const StringName& p_name,const Variant** p_args,int p_a
 
 		if (c.binds.size()) {
 			//handle binds
-			bind_mem.resize(p_argcount+c.binds.size());
+			if (!bind_mem) {
 
-			for(int j=0;j<p_argcount;j++) {
-				bind_mem[j]=p_args[j];
+				int max_binds=0;
+				for(int j=i;j<ssize;j++) {
+					max_binds=MAX(max_binds,slot_map.getv(j).conn.binds.size());
+				}
+
+				bind_mem=(const Variant**)alloca(sizeof(Variant*)*(p_argcount+max_binds));
+				for(int j=0;j<p_argcount;j++) {
+					bind_mem[j]=p_args[j];
+				}
 			}
+
 			for(int j=0;j<c.binds.size();j++) {
 				bind_mem[p_argcount+j]=&c.binds[j];
 			}
 
-			args=bind_mem.ptr();
-			argc=bind_mem.size();
+			args=bind_mem;
+			argc=p_argcount+c.binds.size();
 		}
 
 		if (c.flags&CONNECT_DEFERRED) {
@@ -1290,21 +1301,24 @@ void Object::emit_signal(const StringName& p_name,const Variant** p_args,int p_a
 		}
 
 		if (c.flags&CONNECT_ONESHOT) {
-			_ObjectSignalDisconnectData dd;
-			dd.signal=p_name;
-			dd.target=target;
-			dd.method=c.method;
-			disconnect_data.push_back(dd);
+			has_oneshot=true;
 		}
 
 	}
 
+	if (has_oneshot) {
+		//disconnect after emitting, walking the same snapshot
+		for(int i=0;i<ssize;i++) {
 
-	while (!disconnect_data.empty()) {
+			const Connection &c = slot_map.getv(i).conn;
+			if (!(c.flags&CONNECT_ONESHOT))
+				continue;
 
-		const _ObjectSignalDisconnectData &dd = disconnect_data.front()->get();
-		disconnect(dd.signal,dd.target,dd.method);
-		disconnect_data.pop_front();
+			Object *target = ObjectDB::get_instance(slot_map.getk(i)._id);
+			if (!target)
+				continue;
+			disconnect(p_name,target,c.method);
+		}
 	}
 
 }
@@ -1937,9 +1951,9 @@ void postinitialize_handler(Object *p_object) {
 	p_object->_postinitialize();
 }
 
-HashMap<uint32_t,Object*> ObjectDB::instances;
+ObjectDB::InstanceMap ObjectDB::instances;
 uint32_t ObjectDB::instance_counter=1;
-HashMap<Object*,ObjectID,ObjectDB::ObjectPtrHash> ObjectDB::instance_checks;
+ObjectDB::InstanceCheckMap ObjectDB::instance_checks;
 uint32_t ObjectDB::add_instance(Object *p_object) {
 
 	GLOBAL_LOCK_FUNCTION;
@@ -34,6 +34,9 @@
 #include "set.h"
 #include "map.h"
 #include "vmap.h"
+#ifdef OA_HASH_MAP_ENABLED
+#include "oa_hash_map.h"
+#endif
 
 #define VARIANT_ARG_LIST const Variant& p_arg1=Variant(),const Variant& p_arg2=Variant(),const Variant& p_arg3=Variant(),const Variant& p_arg4=Variant(),const Variant& p_arg5=Variant()
 #define VARIANT_ARG_PASS p_arg1,p_arg2,p_arg3,p_arg4,p_arg5
@@ -431,6 +434,7 @@ friend void postinitialize_handler(Object*);
 protected:
 
 	virtual bool _use_builtin_script() const { return false; }
+	virtual bool _must_defer_free() const { return false; } // free() goes through the message queue while true
 	virtual void _initialize_typev() { initialize_type(); }
 	virtual bool _setv(const StringName& p_name,const Variant &p_property) { return false; };
 	virtual bool _getv(const StringName& p_name,Variant &r_property) const { return false; };
@@ -678,8 +682,16 @@ class ObjectDB {
 		}
 	};
 
-	static HashMap<uint32_t,Object*> instances;
-	static HashMap<Object*,ObjectID,ObjectPtrHash> instance_checks;
+#ifdef OA_HASH_MAP_ENABLED
+	typedef OAHashMap<uint32_t,Object*> InstanceMap;
+	typedef OAHashMap<Object*,ObjectID,ObjectPtrHash> InstanceCheckMap;
+#else
+	typedef HashMap<uint32_t,Object*> InstanceMap;
+	typedef HashMap<Object*,ObjectID,ObjectPtrHash> InstanceCheckMap;
+#endif
+
+	static InstanceMap instances;
+	static InstanceCheckMap instance_checks;
 
 	static uint32_t instance_counter;
 friend class Object;
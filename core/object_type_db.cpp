@@ -460,6 +460,22 @@ Object *ObjectTypeDB::instance(const StringName &p_type) {
 
 	return ti->creation_func();
 }
+
+ObjectTypeDB::CreationFunc ObjectTypeDB::get_creation_func(const StringName &p_type) {
+
+	OBJTYPE_LOCK;
+	TypeInfo *ti=types.getptr(p_type);
+	if (!ti || ti->disabled || !ti->creation_func) {
+		if (compat_types.has(p_type)) {
+			ti=types.getptr(compat_types[p_type]);
+		}
+	}
+	if (!ti || ti->disabled)
+		return NULL;
+
+	return ti->creation_func;
+}
+
 bool ObjectTypeDB::can_instance(const StringName &p_type) {
 
 	OBJTYPE_LOCK;
@@ -570,7 +586,23 @@ void ObjectTypeDB::get_method_list(StringName p_type,List<MethodInfo> *p_methods
 }
 
 
-MethodBind *ObjectTypeDB::get_method(StringName p_type, StringName p_name) {
+MethodBind *ObjectTypeDB::get_method(const StringName& p_type, const StringName& p_name) {
+
+	const void *type_key=p_type.data_unique_pointer();
+	const void *name_key=p_name.data_unique_pointer();
+	MethodCacheEntry &e=method_cache[hash_djb2_one_32(p_name.hash(),p_type.hash())&(METHOD_CACHE_SIZE-1)];
+
+	uint32_t version=atomic_load(&e.version);
+	if (!(version&1)) {
+
+		MethodBind *method=atomic_load(&e.method);
+		if (atomic_load(&e.type)==type_key && atomic_load(&e.name)==name_key && atomic_load(&e.epoch)==atomic_load(&method_cache_epoch) && atomic_load(&e.version)==version) {
+			atomic_add(&method_cache_hits,1);
+			return method;
+		}
+	}
+
+	atomic_add(&method_cache_misses,1);
 
 	OBJTYPE_LOCK;
 
@@ -579,13 +611,36 @@ MethodBind *ObjectTypeDB::get_method(StringName p_type, StringName p_name) {
 	while(type) {
 
 		MethodBind **method=type->method_map.getptr(p_name);
-		if (method && *method)
+		if (method && *method) {
+
+			// only found methods are cached, as the names are then kept alive by the type
+			if (!(version&1) && atomic_cas(&e.version,version,version+1)) {
+				atomic_store(&e.type,type_key);
+				atomic_store(&e.name,name_key);
+				atomic_store(&e.method,*method);
+				atomic_store(&e.epoch,method_cache_epoch);
+				atomic_store(&e.version,version+2);
+			}
 			return *method;
+		}
 		type=type->inherits_ptr;
 	}
 	return NULL;
 }
 
+void ObjectTypeDB::_invalidate_method_cache() {
+
+	atomic_add(&method_cache_epoch,1);
+}
+
+void ObjectTypeDB::method_cache_end_frame() {
+
+	method_cache_frame_hits[0]=method_cache_frame_hits[1];
+	method_cache_frame_hits[1]=atomic_load(&method_cache_hits);
+	method_cache_frame_misses[0]=method_cache_frame_misses[1];
+	method_cache_frame_misses[1]=atomic_load(&method_cache_misses);
+}
+
 
 void ObjectTypeDB::bind_integer_constant(const StringName& p_type, const StringName &p_name, int p_constant) {
 
@@ -948,6 +1003,29 @@ Variant::Type ObjectTypeDB::get_property_type(const StringName& p_type, const St
 
 }
 
+bool ObjectTypeDB::get_property_setter(const StringName& p_type, const StringName& p_property, MethodBind **r_setter, int *r_index) {
+
+	OBJTYPE_LOCK;
+
+	TypeInfo *check=types.getptr(p_type);
+	while(check) {
+		const PropertySetGet *psg = check->property_setget.getptr(p_property);
+		if (psg) {
+
+			if (!psg->_setptr)
+				return false; // set by name, or not settable
+
+			*r_setter=psg->_setptr;
+			*r_index=psg->index;
+			return true;
+		}
+
+		check=check->inherits_ptr;
+	}
+
+	return false;
+}
+
 
 void ObjectTypeDB::set_method_flags(StringName p_type,StringName p_method,int p_flags) {
 
@@ -1036,6 +1114,7 @@ MethodBind* ObjectTypeDB::bind_methodfi(uint32_t p_flags, MethodBind *p_bind , c
 	type->method_order.push_back(mdname);
 #endif
 	type->method_map[mdname]=p_bind;
+	_invalidate_method_cache();
 
 
 	Vector<Variant> defvals;
@@ -1149,6 +1228,13 @@ void ObjectTypeDB::get_extensions_for_type(const StringName& p_type,List<String>
 
 Mutex *ObjectTypeDB::lock=NULL;
 
+ObjectTypeDB::MethodCacheEntry ObjectTypeDB::method_cache[ObjectTypeDB::METHOD_CACHE_SIZE];
+uint32_t ObjectTypeDB::method_cache_epoch=1;
+volatile uint64_t ObjectTypeDB::method_cache_hits=0;
+volatile uint64_t ObjectTypeDB::method_cache_misses=0;
+uint64_t ObjectTypeDB::method_cache_frame_hits[2]={0,0};
+uint64_t ObjectTypeDB::method_cache_frame_misses[2]={0,0};
+
 void ObjectTypeDB::init() {
 
 #ifndef NO_THREADS
@@ -1180,6 +1266,7 @@ void ObjectTypeDB::cleanup() {
 		}
 	}
 	types.clear();
+	_invalidate_method_cache();
 	resource_base_extensions.clear();
 	compat_types.clear();
 }
@@ -115,6 +115,8 @@ public:
 		API_EDITOR,
 		API_NONE
 	};
+
+	typedef Object* (*CreationFunc)();
 public:
 	struct PropertySetGet {
 
@@ -146,7 +148,7 @@ public:
 		StringName inherits;
 		StringName name;
 		bool disabled;
-		Object* (*creation_func)();
+		CreationFunc creation_func;
 		TypeInfo();
 		~TypeInfo();
 	};
@@ -170,6 +172,30 @@ public:
 
 	static APIType current_api;
 
+	// lock free cache of resolved methods, keyed by type and method name. Entries are
+	// written seqlock style (version is odd while writing) and dropped by bumping the epoch.
+	struct MethodCacheEntry {
+
+		uint32_t version;
+		uint32_t epoch;
+		const void *type;
+		const void *name;
+		MethodBind *method;
+	};
+
+	enum {
+		METHOD_CACHE_SIZE=2048
+	};
+
+	static MethodCacheEntry method_cache[METHOD_CACHE_SIZE];
+	static uint32_t method_cache_epoch;
+	static volatile uint64_t method_cache_hits; // updated from any thread
+	static volatile uint64_t method_cache_misses;
+	static uint64_t method_cache_frame_hits[2]; // totals when the last frame began and ended
+	static uint64_t method_cache_frame_misses[2];
+
+	static void _invalidate_method_cache();
+
 	static void _add_type2(const StringName& p_type, const StringName& p_inherits);
 public:
 
@@ -244,6 +270,7 @@ public:
 	static bool is_type(const StringName &p_type,const StringName& p_inherits);
 	static bool can_instance(const StringName &p_type);
 	static Object *instance(const StringName &p_type);
+	static CreationFunc get_creation_func(const StringName &p_type); ///< same lookup as instance(), for creating many objects of one type
 	static APIType get_api_type(const StringName &p_type);
 
 	static uint64_t get_api_hash(APIType p_api);
@@ -481,6 +508,7 @@ public:
 	static bool set_property(Object* p_object, const StringName& p_property, const Variant& p_value, bool *r_valid=NULL);
 	static bool get_property(Object* p_object,const StringName& p_property, Variant& r_value);
 	static Variant::Type get_property_type(const StringName& p_type, const StringName& p_property,bool *r_is_valid=NULL);
+	static bool get_property_setter(const StringName& p_type, const StringName& p_property, MethodBind **r_setter, int *r_index);
 
 
 
@@ -489,7 +517,12 @@ public:
 
 
 	static void get_method_list(StringName p_type,List<MethodInfo> *p_methods,bool p_no_inheritance=false);
-	static MethodBind *get_method(StringName p_type, StringName p_name);
+	static MethodBind *get_method(const StringName& p_type, const StringName& p_name);
+	static uint64_t get_method_cache_hits() { return atomic_load(&method_cache_hits); }
+	static uint64_t get_method_cache_misses() { return atomic_load(&method_cache_misses); }
+	static uint64_t get_method_cache_frame_hits() { return method_cache_frame_hits[1]-method_cache_frame_hits[0]; } ///< during the last frame
+	static uint64_t get_method_cache_frame_misses() { return method_cache_frame_misses[1]-method_cache_frame_misses[0]; }
+	static void method_cache_end_frame(); ///< called once per frame by the main loop
 
 	static void add_virtual_method(const StringName& p_type,const MethodInfo& p_method,bool p_virtual=true );
 	static void get_virtual_methods(const StringName& p_type,List<MethodInfo> * p_methods,bool p_no_inheritance=false );
@@ -107,6 +107,8 @@ public:
 	virtual real_t get_real() const;
 
 	virtual int get_buffer(uint8_t *p_dst,int p_length) const; ///< get an array of bytes
+	virtual Error map_data() { return ERR_UNAVAILABLE; } ///< map a file open for reading in memory, so reads don't copy through a buffer
+	virtual const uint8_t *get_mapped_data() const { return NULL; } ///< whole file contents if mapped (read only, valid until close), NULL otherwise
 	virtual String get_line() const;
 	virtual Vector<String> get_csv_line(String delim=",") const;
 
@@ -0,0 +1,191 @@
+/*************************************************************************/
+/*  frame_allocator.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2016 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "frame_allocator.h"
+
+FrameAllocator::Arena FrameAllocator::arenas[FrameAllocator::MAX_ARENAS];
+volatile uint32_t FrameAllocator::arena_count=0;
+size_t FrameAllocator::arena_size=1024*1024;
+size_t FrameAllocator::last_frame_usage=0;
+size_t FrameAllocator::max_usage=0;
+volatile uint32_t FrameAllocator::overflows=0;
+uint32_t FrameAllocator::pinned_frames=0;
+
+FrameAllocator::Arena *FrameAllocator::_create_arena(Thread::ID p_thread) {
+
+	if (arena_size==0)
+		return NULL;
+
+	uint32_t count=MIN(atomic_load(&arena_count),uint32_t(MAX_ARENAS));
+	for(uint32_t i=0;i<count;i++) {
+
+		// take over the arena of a thread that exited, memory and all
+		Arena *arena=&arenas[i];
+		if (atomic_load(&arena->released) && atomic_cas(&arena->released,uint32_t(1),uint32_t(0))) {
+			arena->frame_peak=0;
+			arena->pinned_frames=0;
+			atomic_store(&arena->thread,p_thread);
+			return arena;
+		}
+	}
+
+	if (count>=MAX_ARENAS)
+		return NULL;
+
+	uint32_t index=atomic_add(&arena_count,1)-1;
+	if (index>=MAX_ARENAS)
+		return NULL; // other threads were faster
+
+	Arena *arena=&arenas[index];
+	arena->size=arena_size;
+	arena->memory=(uint8_t*)Memory::alloc_static(arena->size,"FrameAllocator");
+	arena->used=0;
+	arena->frame_peak=0;
+	arena->live=0;
+	arena->released=0;
+	arena->rewound=false;
+	arena->pinned_frames=0;
+	if (!arena->memory)
+		arena->size=0; // everything goes to the heap, but the slot is still taken
+
+	atomic_store(&arena->thread,p_thread); // only now other threads can see it's taken
+
+	return arena;
+}
+
+void *FrameAllocator::_alloc_heap(size_t p_size) {
+
+	atomic_add(&overflows,1);
+
+	Header *h=(Header*)Memory::alloc_static(p_size+HEADER_SIZE,"FrameAllocator");
+	ERR_FAIL_COND_V(!h,NULL);
+	h->arena=NULL;
+	h->size=p_size+HEADER_SIZE;
+	return ((uint8_t*)h)+HEADER_SIZE;
+}
+
+void FrameAllocator::end_frame() {
+
+	size_t usage=0;
+	bool pinned=false;
+
+	uint32_t count=MIN(atomic_load(&arena_count),uint32_t(MAX_ARENAS));
+	for(uint32_t i=0;i<count;i++) {
+
+		Arena *arena=&arenas[i];
+		uint32_t live=atomic_load(&arena->live);
+
+		// statistics only, a thread still allocating may bump frame_peak right now
+		usage=MAX(usage,arena->frame_peak);
+		arena->frame_peak=live ? arena->used : 0;
+
+		// allocating from an empty arena always rewinds it, so if it didn't, it held memory the whole frame
+		if (live && !arena->rewound) {
+			pinned=true;
+			arena->pinned_frames++;
+			if (arena->pinned_frames==PINNED_WARN_FRAMES) {
+				WARN_PRINT("FrameAllocator: memory outlived its frame, the arena can't rewind until it's freed.");
+			}
+		} else {
+			arena->pinned_frames=0;
+		}
+		arena->rewound=false;
+	}
+
+	if (pinned)
+		pinned_frames++;
+
+	last_frame_usage=usage;
+	max_usage=MAX(max_usage,usage);
+}
+
+void FrameAllocator::set_arena_size(size_t p_bytes) {
+
+	arena_size=p_bytes;
+}
+
+size_t FrameAllocator::get_arena_size() {
+
+	return arena_size;
+}
+
+size_t FrameAllocator::get_last_frame_usage() {
+
+	return last_frame_usage;
+}
+
+size_t FrameAllocator::get_max_usage() {
+
+	return max_usage;
+}
+
+uint32_t FrameAllocator::get_overflow_count() {
+
+	return overflows;
+}
+
+uint32_t FrameAllocator::get_pinned_frame_count() {
+
+	return pinned_frames;
+}
+
+void FrameAllocator::thread_exit() {
+
+	Thread::ID id=Thread::get_caller_ID();
+	uint32_t count=MIN(atomic_load(&arena_count),uint32_t(MAX_ARENAS));
+	for(uint32_t i=0;i<count;i++) {
+
+		Arena *arena=&arenas[i];
+		if (arena->thread!=id || atomic_load(&arena->released))
+			continue;
+
+		// anything still allocated from it stays valid, the next owner only rewinds once it's freed
+		atomic_store(&arena->thread,Thread::ID(0));
+		atomic_store(&arena->released,uint32_t(1));
+		return;
+	}
+}
+
+void FrameAllocator::cleanup() {
+
+	uint32_t count=MIN(atomic_load(&arena_count),uint32_t(MAX_ARENAS));
+	for(uint32_t i=0;i<count;i++) {
+
+		Arena *arena=&arenas[i];
+		if (arena->live) {
+			ERR_PRINT("FrameAllocator: memory still in use at exit.");
+			continue; // leak it rather than leave dangling pointers
+		}
+		if (arena->memory)
+			Memory::free_static(arena->memory);
+		arena->memory=NULL;
+		arena->thread=0;
+		arena->released=0;
+	}
+	arena_count=0;
+}
@@ -0,0 +1,157 @@
+/*************************************************************************/
+/*  frame_allocator.h                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2016 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+#include "os/memory.h"
+#include "os/thread.h"
+#include "safe_refcount.h"
+
+/**
+	Allocator for short lived memory, meant for containers that only live during
+	a frame (culling sets, temporary lists, etc). Pass it as the allocator of
+	List, Set or Map, like DefaultAllocator:
+
+		Set<Instance*,Comparator<Instance*>,FrameAllocator> rooms;
+
+	Every thread bumps through its own arena, so allocating takes no locks and
+	freeing is almost free. An arena rewinds as soon as everything allocated from
+	it was freed, which always happens by the end of a frame. Allocations that
+	don't fit (arena full, too many threads) go to the heap instead.
+
+	A single allocation that outlives its frame keeps the whole arena from
+	rewinding, so it only fills up from then on. end_frame() counts those frames
+	and warns when an arena stays pinned. Threads release their arena when they
+	exit, so another thread can take it over.
+*/
+
+class FrameAllocator {
+
+	struct Arena {
+
+		volatile Thread::ID thread;
+		uint8_t *memory;
+		size_t size;
+		size_t used;
+		size_t frame_peak;
+		volatile uint32_t live; // allocations not freed yet, only the owner thread increments it
+		volatile uint32_t released; // owner thread exited, the slot can be taken over
+		bool rewound; // since the last end_frame(), statistics only
+		uint32_t pinned_frames; // in a row that ended without rewinding
+	};
+
+	struct Header {
+
+		Arena *arena; // NULL for heap allocations
+		size_t size;
+	};
+
+	enum {
+		MAX_ARENAS=64,
+		PINNED_WARN_FRAMES=60,
+		ALIGN=16,
+		HEADER_SIZE=(sizeof(Header)+ALIGN-1)&~(ALIGN-1)
+	};
+
+	static Arena arenas[MAX_ARENAS];
+	static volatile uint32_t arena_count;
+	static size_t arena_size;
+	static size_t last_frame_usage;
+	static size_t max_usage;
+	static volatile uint32_t overflows;
+	static uint32_t pinned_frames;
+
+	static Arena *_create_arena(Thread::ID p_thread);
+	static void *_alloc_heap(size_t p_size);
+
+	_FORCE_INLINE_ static Arena *_get_arena() {
+
+		Thread::ID id=Thread::get_caller_ID();
+		uint32_t count=MIN(atomic_load(&arena_count),uint32_t(MAX_ARENAS));
+		for(uint32_t i=0;i<count;i++) {
+			if (arenas[i].thread==id)
+				return &arenas[i];
+		}
+		return _create_arena(id);
+	}
+
+public:
+
+	_FORCE_INLINE_ static void *alloc(size_t p_memory) {
+
+		Arena *arena=_get_arena();
+		if (!arena)
+			return _alloc_heap(p_memory);
+
+		if (atomic_load(&arena->live)==0) {
+			arena->used=0; // everything was freed, rewind
+			arena->rewound=true;
+		}
+
+		size_t size=(p_memory+HEADER_SIZE+ALIGN-1)&~size_t(ALIGN-1);
+		if (arena->used+size>arena->size)
+			return _alloc_heap(p_memory);
+
+		Header *h=(Header*)&arena->memory[arena->used];
+		h->arena=arena;
+		h->size=size;
+		arena->used+=size;
+		if (arena->used>arena->frame_peak)
+			arena->frame_peak=arena->used;
+		atomic_add(&arena->live,1);
+
+		return ((uint8_t*)h)+HEADER_SIZE;
+	}
+
+	_FORCE_INLINE_ static void free(void *p_ptr) {
+
+		if (!p_ptr)
+			return;
+
+		Header *h=(Header*)(((uint8_t*)p_ptr)-HEADER_SIZE);
+		if (h->arena)
+			atomic_add(&h->arena->live,-1); // may be another thread, so the owner rewinds
+		else
+			Memory::free_static(h);
+	}
+
+	static void end_frame(); ///< collects usage statistics, called once per frame by the main loop
+	static void set_arena_size(size_t p_bytes); ///< for arenas created from now on
+	static size_t get_arena_size();
+
+	static size_t get_last_frame_usage(); ///< most any thread had in use during the last frame
+	static size_t get_max_usage(); ///< most any thread had in use during any frame
+	static uint32_t get_overflow_count(); ///< allocations that went to the heap
+	static uint32_t get_pinned_frame_count(); ///< frames an arena could not rewind in, because something outlived its frame
+
+	static void thread_exit(); ///< releases the arena of the calling thread, called by the thread implementations
+	static void cleanup();
+};
+
+#endif // FRAME_ALLOCATOR_H
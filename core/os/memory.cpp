@@ -28,8 +28,12 @@
 /*************************************************************************/
 #include "memory.h"
 #include "error_macros.h"
+#include "sort.h"
+#include "os/os.h"
+#include "os/thread.h"
 #include "copymem.h"
 #include <stdio.h>
+#include <string.h>
 void * operator new(size_t p_size,const char *p_description) {
 
 	return Memory::alloc_static( p_size, p_description );
@@ -45,20 +49,481 @@ void * operator new(size_t p_size,void* (*p_allocfunc)(size_t p_size)) {
 void * Memory::alloc_static(size_t p_bytes,const char *p_alloc_from) {
 
 	ERR_FAIL_COND_V( !MemoryPoolStatic::get_singleton(), NULL );
-	return MemoryPoolStatic::get_singleton()->alloc(p_bytes,p_alloc_from);
+	void *mem = MemoryPoolStatic::get_singleton()->alloc(p_bytes,p_alloc_from);
+	if (tracking && mem)
+		_track_alloc(mem,p_bytes,p_alloc_from);
+	return mem;
 }
 void * Memory::realloc_static(void *p_memory,size_t p_bytes) {
 
 	ERR_FAIL_COND_V( !MemoryPoolStatic::get_singleton(), NULL );
-	return MemoryPoolStatic::get_singleton()->realloc(p_memory,p_bytes);
+	void *mem = MemoryPoolStatic::get_singleton()->realloc(p_memory,p_bytes);
+	if (tracking)
+		_track_realloc(p_memory,mem,p_bytes);
+	return mem;
 }
 
 void Memory::free_static(void *p_ptr) {
 
 	ERR_FAIL_COND( !MemoryPoolStatic::get_singleton());
+	if (tracking && p_ptr)
+		_track_free(p_ptr);
 	MemoryPoolStatic::get_singleton()->free(p_ptr);
 }
 
+/* Allocation tracking.
+ *
+ * Everything here runs inside the allocator, so it must not allocate through Memory
+ * (nor print, which allocates strings). Tables are taken straight from MemoryPoolStatic
+ * and everything is guarded by a spinlock, as the work done while holding it is tiny.
+ */
+
+bool Memory::tracking=false;
+
+namespace {
+
+struct TrackedSite {
+
+	const char *site;
+	uint32_t category; // ALLOC_CATEGORY_MAX means unused slot
+	size_t live_bytes;
+	uint32_t live_count;
+	uint32_t frame_count;
+	uint32_t last_frame_count;
+	uint64_t total_count;
+	uint64_t total_bytes;
+};
+
+struct TrackedPtr {
+
+	void *ptr; // NULL is empty, TOMBSTONE was removed
+	uint32_t site;
+	size_t bytes;
+};
+
+struct ThreadCategory {
+
+	volatile Thread::ID thread;
+	Memory::AllocCategory category;
+};
+
+enum {
+	MAX_TRACKED_SITES=4096, // power of two
+	MAX_CATEGORY_THREADS=64,
+	MIN_TRACKED_PTRS=4096
+};
+
+void *const TOMBSTONE=(void*)1;
+
+TrackedSite tracked_sites[MAX_TRACKED_SITES];
+uint32_t tracked_site_count=0;
+TrackedSite category_totals[Memory::ALLOC_CATEGORY_MAX];
+
+TrackedPtr *tracked_ptrs=NULL;
+uint32_t tracked_ptr_capacity=0; // power of two
+uint32_t tracked_ptr_used=0; // including tombstones
+
+ThreadCategory thread_categories[MAX_CATEGORY_THREADS];
+volatile uint32_t thread_category_count=0;
+
+volatile uint32_t tracking_lock=0;
+
+const char *category_names[Memory::ALLOC_CATEGORY_MAX]={
+	"General",
+	"String",
+	"Variant",
+	"Node",
+	"Resource",
+	"Server",
+	"Script"
+};
+
+struct TrackingLock {
+
+	TrackingLock() { while(!atomic_cas(&tracking_lock,uint32_t(0),uint32_t(1))) {} }
+	~TrackingLock() { atomic_store(&tracking_lock,uint32_t(0)); }
+};
+
+_FORCE_INLINE_ uint32_t _hash_ptr(const void *p_ptr) {
+
+	uint64_t v=(uint64_t)(uintptr_t)p_ptr;
+	v=(v>>4)^(v>>32);
+	return uint32_t(v)*2654435761u;
+}
+
+ThreadCategory *_get_thread_category(Thread::ID p_thread,bool p_create) {
+
+	uint32_t count=MIN(atomic_load(&thread_category_count),uint32_t(MAX_CATEGORY_THREADS));
+	for(uint32_t i=0;i<count;i++) {
+		if (thread_categories[i].thread==p_thread)
+			return &thread_categories[i];
+	}
+
+	if (!p_create || count>=MAX_CATEGORY_THREADS)
+		return NULL;
+
+	uint32_t index=atomic_add(&thread_category_count,1)-1;
+	if (index>=MAX_CATEGORY_THREADS)
+		return NULL;
+
+	ThreadCategory *tc=&thread_categories[index];
+	tc->category=Memory::ALLOC_GENERAL;
+	atomic_store(&tc->thread,p_thread);
+	return tc;
+}
+
+Memory::AllocCategory _category_from_site(const char *p_site) {
+
+	// sites are file:line on DEBUG_MEMORY_ENABLED builds
+	if (strstr(p_site,"core/ustring"))
+		return Memory::ALLOC_STRING;
+	if (strstr(p_site,"core/variant") || strstr(p_site,"core/array") || strstr(p_site,"core/dictionary"))
+		return Memory::ALLOC_VARIANT;
+	if (strstr(p_site,"core/io/resource") || strstr(p_site,"core/resource"))
+		return Memory::ALLOC_RESOURCE;
+	if (strstr(p_site,"scene/"))
+		return Memory::ALLOC_NODE;
+	if (strstr(p_site,"servers/"))
+		return Memory::ALLOC_SERVER;
+	if (strstr(p_site,"modules/gdscript"))
+		return Memory::ALLOC_SCRIPT;
+	return Memory::ALLOC_GENERAL;
+}
+
+uint32_t _find_site(const char *p_site,Memory::AllocCategory p_category) {
+
+	uint32_t h=(_hash_ptr(p_site)^(uint32_t(p_category)*0x9E3779B9u))&(MAX_TRACKED_SITES-1);
+	while(true) {
+
+		TrackedSite &ts=tracked_sites[h];
+		if (ts.category==uint32_t(p_category) && ts.site==p_site)
+			return h;
+		if (ts.category==Memory::ALLOC_CATEGORY_MAX) {
+			if (p_site && tracked_site_count>=MAX_TRACKED_SITES*3/4) {
+				// table almost full, fold into the description-less site of the category
+				// (there is always room left for those)
+				return _find_site(NULL,p_category);
+			}
+			ts.site=p_site;
+			ts.category=p_category;
+			tracked_site_count++;
+			return h;
+		}
+		h=(h+1)&(MAX_TRACKED_SITES-1);
+	}
+}
+
+TrackedPtr *_find_ptr(void *p_ptr) {
+
+	if (!tracked_ptrs)
+		return NULL;
+
+	uint32_t mask=tracked_ptr_capacity-1;
+	uint32_t h=_hash_ptr(p_ptr)&mask;
+	while(tracked_ptrs[h].ptr) {
+		if (tracked_ptrs[h].ptr==p_ptr)
+			return &tracked_ptrs[h];
+		h=(h+1)&mask;
+	}
+	return NULL;
+}
+
+bool _insert_ptr(void *p_ptr,uint32_t p_site,size_t p_bytes) {
+
+	if ((tracked_ptr_used+1)*2>tracked_ptr_capacity) {
+
+		uint32_t new_capacity=MAX(tracked_ptr_capacity*2,uint32_t(MIN_TRACKED_PTRS));
+		TrackedPtr *new_ptrs=(TrackedPtr*)MemoryPoolStatic::get_singleton()->alloc(sizeof(TrackedPtr)*new_capacity,"Memory tracking");
+		if (!new_ptrs)
+			return false;
+		zeromem(new_ptrs,sizeof(TrackedPtr)*new_capacity);
+
+		uint32_t used=0;
+		for(uint32_t i=0;i<tracked_ptr_capacity;i++) {
+
+			TrackedPtr &tp=tracked_ptrs[i];
+			if (!tp.ptr || tp.ptr==TOMBSTONE)
+				continue;
+			uint32_t h=_hash_ptr(tp.ptr)&(new_capacity-1);
+			while(new_ptrs[h].ptr)
+				h=(h+1)&(new_capacity-1);
+			new_ptrs[h]=tp;
+			used++;
+		}
+
+		if (tracked_ptrs)
+			MemoryPoolStatic::get_singleton()->free(tracked_ptrs);
+		tracked_ptrs=new_ptrs;
+		tracked_ptr_capacity=new_capacity;
+		tracked_ptr_used=used;
+	}
+
+	uint32_t mask=tracked_ptr_capacity-1;
+	uint32_t h=_hash_ptr(p_ptr)&mask;
+	while(tracked_ptrs[h].ptr && tracked_ptrs[h].ptr!=TOMBSTONE)
+		h=(h+1)&mask;
+
+	if (!tracked_ptrs[h].ptr)
+		tracked_ptr_used++;
+	tracked_ptrs[h].ptr=p_ptr;
+	tracked_ptrs[h].site=p_site;
+	tracked_ptrs[h].bytes=p_bytes;
+	return true;
+}
+
+void _add_live(uint32_t p_site,size_t p_bytes,bool p_new) {
+
+	TrackedSite *stats[2]={ &tracked_sites[p_site], &category_totals[tracked_sites[p_site].category] };
+	for(int i=0;i<2;i++) {
+		stats[i]->live_bytes+=p_bytes;
+		stats[i]->total_bytes+=p_bytes;
+		if (p_new)
+			stats[i]->live_count++;
+		stats[i]->frame_count++;
+		stats[i]->total_count++;
+	}
+}
+
+void _remove_live(uint32_t p_site,size_t p_bytes,bool p_freed) {
+
+	TrackedSite *stats[2]={ &tracked_sites[p_site], &category_totals[tracked_sites[p_site].category] };
+	for(int i=0;i<2;i++) {
+		stats[i]->live_bytes-=p_bytes;
+		if (p_freed)
+			stats[i]->live_count--;
+	}
+}
+
+void _copy_stats(const TrackedSite &p_from,Memory::AllocStats *r_to) {
+
+	r_to->site=p_from.site;
+	r_to->category=Memory::AllocCategory(p_from.category);
+	r_to->live_bytes=p_from.live_bytes;
+	r_to->live_count=p_from.live_count;
+	r_to->frame_count=p_from.last_frame_count;
+	r_to->total_count=p_from.total_count;
+	r_to->total_bytes=p_from.total_bytes;
+}
+
+struct AllocStatsSort {
+
+	_FORCE_INLINE_ bool operator()(const Memory::AllocStats& p_a,const Memory::AllocStats& p_b) const {
+
+		if (p_a.live_bytes!=p_b.live_bytes)
+			return p_a.live_bytes>p_b.live_bytes;
+		return p_a.frame_count>p_b.frame_count;
+	}
+};
+
+}
+
+void Memory::_track_alloc(void *p_ptr,size_t p_bytes,const char *p_descr) {
+
+	const char *site=(p_descr && p_descr[0]) ? p_descr : NULL;
+
+	AllocCategory category=ALLOC_GENERAL;
+	ThreadCategory *tc=_get_thread_category(Thread::get_caller_ID(),false);
+	if (tc)
+		category=tc->category;
+	if (category==ALLOC_GENERAL && site)
+		category=_category_from_site(site);
+
+	TrackingLock lock;
+	if (!tracking)
+		return; // disabled while waiting for the lock
+
+	uint32_t idx=_find_site(site,category);
+	if (_insert_ptr(p_ptr,idx,p_bytes))
+		_add_live(idx,p_bytes,true);
+}
+
+void Memory::_track_realloc(void *p_old,void *p_new,size_t p_bytes) {
+
+	if (!p_old) {
+		if (p_new)
+			_track_alloc(p_new,p_bytes,NULL);
+		return;
+	}
+
+	if (!p_new) {
+		if (p_bytes==0)
+			_track_free(p_old); // realloc to zero frees
+		return; // otherwise it failed and the old block is still there
+	}
+
+	bool tracked;
+	{
+		TrackingLock lock;
+		if (!tracking)
+			return;
+
+		TrackedPtr *tp=_find_ptr(p_old);
+		tracked=tp!=NULL;
+		if (tp) {
+
+			uint32_t site=tp->site;
+			_remove_live(site,tp->bytes,false);
+			if (p_new==p_old) {
+				tp->bytes=p_bytes;
+				_add_live(site,p_bytes,false);
+			} else {
+				tp->ptr=TOMBSTONE;
+				if (_insert_ptr(p_new,site,p_bytes))
+					_add_live(site,p_bytes,false);
+				else
+					_remove_live(site,0,true);
+			}
+		}
+	}
+
+	if (!tracked)
+		_track_alloc(p_new,p_bytes,NULL); // allocated before tracking was enabled, count it from now on
+}
+
+void Memory::_track_free(void *p_ptr) {
+
+	TrackingLock lock;
+	if (!tracking)
+		return;
+
+	TrackedPtr *tp=_find_ptr(p_ptr);
+	if (!tp)
+		return; // allocated before tracking was enabled
+
+	_remove_live(tp->site,tp->bytes,true);
+	tp->ptr=TOMBSTONE;
+}
+
+void Memory::set_tracking_enabled(bool p_enabled) {
+
+	TrackingLock lock;
+
+	if (p_enabled==tracking)
+		return;
+
+	if (p_enabled) {
+
+		for(int i=0;i<MAX_TRACKED_SITES;i++) {
+			zeromem(&tracked_sites[i],sizeof(TrackedSite));
+			tracked_sites[i].category=ALLOC_CATEGORY_MAX;
+		}
+		tracked_site_count=0;
+
+		for(int i=0;i<ALLOC_CATEGORY_MAX;i++) {
+			zeromem(&category_totals[i],sizeof(TrackedSite));
+			category_totals[i].category=i;
+		}
+
+	} else if (tracked_ptrs) {
+
+		// sites and totals are kept, so they can still be reported
+		MemoryPoolStatic::get_singleton()->free(tracked_ptrs);
+		tracked_ptrs=NULL;
+		tracked_ptr_capacity=0;
+		tracked_ptr_used=0;
+	}
+
+	tracking=p_enabled;
+}
+
+Memory::AllocCategory Memory::set_thread_alloc_category(AllocCategory p_category) {
+
+	ThreadCategory *tc=_get_thread_category(Thread::get_caller_ID(),true);
+	if (!tc)
+		return ALLOC_GENERAL; // too many threads, they go untagged
+
+	AllocCategory prev=tc->category;
+	tc->category=p_category;
+	return prev;
+}
+
+void Memory::tracking_end_frame() {
+
+	TrackingLock lock;
+
+	for(int i=0;i<MAX_TRACKED_SITES;i++) {
+		tracked_sites[i].last_frame_count=tracked_sites[i].frame_count;
+		tracked_sites[i].frame_count=0;
+	}
+	for(int i=0;i<ALLOC_CATEGORY_MAX;i++) {
+		category_totals[i].last_frame_count=category_totals[i].frame_count;
+		category_totals[i].frame_count=0;
+	}
+}
+
+int Memory::get_tracked_sites(AllocStats *r_sites,int p_max) {
+
+	if (p_max<=0)
+		return 0;
+
+	// copy all of them so sorting doesn't happen while holding the lock
+	AllocStats *sites=(AllocStats*)MemoryPoolStatic::get_singleton()->alloc(sizeof(AllocStats)*MAX_TRACKED_SITES,"Memory tracking");
+	ERR_FAIL_COND_V(!sites,0);
+
+	int count=0;
+	{
+		TrackingLock lock;
+		for(int i=0;i<MAX_TRACKED_SITES;i++) {
+			if (tracked_sites[i].category!=ALLOC_CATEGORY_MAX)
+				_copy_stats(tracked_sites[i],&sites[count++]);
+		}
+	}
+
+	SortArray<AllocStats,AllocStatsSort> sorter;
+	sorter.sort(sites,count);
+
+	count=MIN(count,p_max);
+	copymem(r_sites,sites,sizeof(AllocStats)*count);
+	MemoryPoolStatic::get_singleton()->free(sites);
+
+	return count;
+}
+
+void Memory::get_tracked_categories(AllocStats *r_categories) {
+
+	TrackingLock lock;
+	for(int i=0;i<ALLOC_CATEGORY_MAX;i++)
+		_copy_stats(category_totals[i],&r_categories[i]);
+}
+
+void Memory::print_tracking_report(int p_max_sites) {
+
+	OS *os=OS::get_singleton();
+	ERR_FAIL_COND(!os);
+
+	AllocStats categories[ALLOC_CATEGORY_MAX];
+	get_tracked_categories(categories);
+
+	os->print("Memory tracking report%s\n",tracking?"":" (tracking disabled)");
+	os->print("%-10s %14s %10s %12s %14s\n","Category","Live Bytes","Live","Allocs/Frame","Total Allocs");
+	for(int i=0;i<ALLOC_CATEGORY_MAX;i++) {
+		const AllocStats &c=categories[i];
+		os->print("%-10s %14llu %10u %12u %14llu\n",category_names[i],(unsigned long long)c.live_bytes,c.live_count,c.frame_count,(unsigned long long)c.total_count);
+	}
+
+	if (p_max_sites<=0)
+		return;
+
+	AllocStats *sites=(AllocStats*)MemoryPoolStatic::get_singleton()->alloc(sizeof(AllocStats)*p_max_sites,"Memory tracking");
+	ERR_FAIL_COND(!sites);
+	int count=get_tracked_sites(sites,p_max_sites);
+
+	os->print("\nTop %i allocation sites by live bytes:\n",count);
+	os->print("%14s %10s %12s %-10s %s\n","Live Bytes","Live","Allocs/Frame","Category","Site");
+	for(int i=0;i<count;i++) {
+		const AllocStats &s=sites[i];
+		os->print("%14llu %10u %12u %-10s %s\n",(unsigned long long)s.live_bytes,s.live_count,s.frame_count,category_names[s.category],s.site?s.site:"(no description)");
+	}
+
+	MemoryPoolStatic::get_singleton()->free(sites);
+}
+
+const char *Memory::get_alloc_category_name(AllocCategory p_category) {
+
+	ERR_FAIL_INDEX_V(p_category,ALLOC_CATEGORY_MAX,"");
+	return category_names[p_category];
+}
+
 
 size_t Memory::get_static_mem_available() {
 
@@ -173,6 +173,46 @@ public:
 class Memory{
 
 	Memory();
+public:
+
+	/**
+	 * Allocation tracking (off by default). When enabled, every static allocation is
+	 * tagged with its site (the description given to the allocator, which is file:line
+	 * on DEBUG_MEMORY_ENABLED builds) and a category. The category comes from the
+	 * innermost MemoryCategoryScope of the calling thread or, if there is none, from
+	 * the source path of the site.
+	 */
+
+	enum AllocCategory {
+		ALLOC_GENERAL,
+		ALLOC_STRING,
+		ALLOC_VARIANT,
+		ALLOC_NODE,
+		ALLOC_RESOURCE,
+		ALLOC_SERVER,
+		ALLOC_SCRIPT,
+		ALLOC_CATEGORY_MAX
+	};
+
+	struct AllocStats {
+
+		const char *site; ///< NULL for allocations without a description, and for category totals
+		AllocCategory category;
+		size_t live_bytes;
+		uint32_t live_count;
+		uint32_t frame_count; ///< allocations during the last finished frame
+		uint64_t total_count;
+		uint64_t total_bytes;
+	};
+
+private:
+
+	static bool tracking;
+
+	static void _track_alloc(void *p_ptr,size_t p_bytes,const char *p_descr);
+	static void _track_realloc(void *p_old,void *p_new,size_t p_bytes);
+	static void _track_free(void *p_ptr);
+
 public:
 
 	static void * alloc_static(size_t p_bytes,const char *p_descr="");
@@ -189,6 +229,36 @@ public:
 	static size_t get_dynamic_mem_available();
 	static size_t get_dynamic_mem_usage();
 
+	static void set_tracking_enabled(bool p_enabled); ///< enabling resets all the tracking statistics
+	_FORCE_INLINE_ static bool is_tracking_enabled() { return tracking; }
+	static AllocCategory set_thread_alloc_category(AllocCategory p_category); ///< returns the previous one
+	static void tracking_end_frame();
+	static int get_tracked_sites(AllocStats *r_sites,int p_max); ///< sorted by live bytes, returns the amount written
+	static void get_tracked_categories(AllocStats *r_categories); ///< fills ALLOC_CATEGORY_MAX entries
+	static void print_tracking_report(int p_max_sites=32);
+	static const char *get_alloc_category_name(AllocCategory p_category);
+
+};
+
+/**
+ * Tags the allocations done by the current thread while it's alive, when
+ * allocation tracking is enabled. Costs a flag check otherwise.
+ */
+class MemoryCategoryScope {
+
+	Memory::AllocCategory prev;
+	bool active;
+public:
+
+	_FORCE_INLINE_ MemoryCategoryScope(Memory::AllocCategory p_category) {
+		active=Memory::is_tracking_enabled();
+		if (active)
+			prev=Memory::set_thread_alloc_category(p_category);
+	}
+	_FORCE_INLINE_ ~MemoryCategoryScope() {
+		if (active)
+			Memory::set_thread_alloc_category(prev);
+	}
 };
 
 template<class T>
@@ -0,0 +1,567 @@
+/*************************************************************************/
+/*  worker_thread_pool.cpp                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2016 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "worker_thread_pool.h"
+#include "os/os.h"
+#include "os/memory.h"
+#include "safe_refcount.h"
+
+#define SHARED_QUEUE MAX_THREADS
+
+WorkerThreadPool *WorkerThreadPool::singleton=NULL;
+
+WorkerThreadPool *WorkerThreadPool::get_singleton() {
+
+	return singleton;
+}
+
+/* Queue */
+
+void WorkerThreadPool::Queue::push_back(Task *p_task,int p_times) {
+
+	if (mutex)
+		mutex->lock();
+
+	if (count+p_times>capacity) {
+
+		int new_capacity=MAX(capacity,32);
+		while(new_capacity<count+p_times)
+			new_capacity<<=1;
+
+		Task **new_items=(Task**)memalloc(sizeof(Task*)*new_capacity);
+		for(int i=0;i<count;i++)
+			new_items[i]=items[(head+i)&(capacity-1)];
+		if (items)
+			memfree(items);
+		items=new_items;
+		capacity=new_capacity;
+		head=0;
+	}
+
+	for(int i=0;i<p_times;i++)
+		items[(head+count+i)&(capacity-1)]=p_task;
+	atomic_store(&count,count+p_times);
+
+	if (mutex)
+		mutex->unlock();
+}
+
+WorkerThreadPool::Task *WorkerThreadPool::Queue::pop_back() {
+
+	if (atomic_load(&count)==0)
+		return NULL; // checked again below, this only avoids locking empty queues
+
+	if (mutex)
+		mutex->lock();
+
+	Task *task=NULL;
+	if (count>0) {
+		atomic_store(&count,count-1);
+		task=items[(head+count)&(capacity-1)];
+	}
+
+	if (mutex)
+		mutex->unlock();
+
+	return task;
+}
+
+WorkerThreadPool::Task *WorkerThreadPool::Queue::pop_front() {
+
+	if (atomic_load(&count)==0)
+		return NULL;
+
+	if (mutex)
+		mutex->lock();
+
+	Task *task=NULL;
+	if (count>0) {
+		task=items[head];
+		head=(head+1)&(capacity-1);
+		atomic_store(&count,count-1);
+	}
+
+	if (mutex)
+		mutex->unlock();
+
+	return task;
+}
+
+/* Scheduling */
+
+int WorkerThreadPool::_get_thread_index() const {
+
+	Thread::ID id=Thread::get_caller_ID();
+	for(int i=0;i<thread_count;i++) {
+		if (atomic_load(&thread_ids[i])==id)
+			return i;
+	}
+	return -1;
+}
+
+WorkerThreadPool::Task *WorkerThreadPool::_alloc_task(TaskFunc p_task_func,RangeFunc p_range_func,void *p_userdata,int p_count,int p_grain) {
+
+	// call with mutex locked
+
+	Task *task=free_tasks;
+	if (task)
+		free_tasks=task->next_free;
+	else
+		task=memnew(Task);
+
+	task->id=INVALID_TASK_ID;
+	task->task_func=p_task_func;
+	task->range_func=p_range_func;
+	task->userdata=p_userdata;
+	task->count=MAX(p_count,0);
+	task->grain=MAX(p_grain,1);
+	task->chunks=(task->count+task->grain-1)/task->grain;
+	task->next_chunk=0;
+	task->pending_chunks=task->chunks;
+	task->pending_dependencies=0;
+	task->refcount=1;
+	task->completed=0;
+	task->done=NULL;
+	task->next_free=NULL;
+
+	return task;
+}
+
+void WorkerThreadPool::_release_task(Task *p_task) {
+
+	if (atomic_add(&p_task->refcount,-1)!=0)
+		return;
+
+	if (p_task->done) {
+		memdelete(p_task->done);
+		p_task->done=NULL;
+	}
+
+	if (mutex)
+		mutex->lock();
+	p_task->next_free=free_tasks;
+	free_tasks=p_task;
+	if (mutex)
+		mutex->unlock();
+}
+
+void WorkerThreadPool::_add_dependencies(Task *p_task,const TaskID *p_dependencies,int p_dependency_count) {
+
+	p_task->pending_dependencies=1; // so it can't be scheduled while dependencies are added
+
+	if (p_dependency_count>0) {
+
+		if (mutex)
+			mutex->lock();
+
+		for(int i=0;i<p_dependency_count;i++) {
+
+			Task **dep=tasks.getptr(p_dependencies[i]);
+			if (!dep || (*dep)->completed)
+				continue; // already waited for or completed
+
+			(*dep)->dependents.push_back(p_task);
+			atomic_add(&p_task->pending_dependencies,1);
+		}
+
+		if (mutex)
+			mutex->unlock();
+	}
+
+	if (atomic_add(&p_task->pending_dependencies,-1)==0)
+		_schedule(p_task);
+}
+
+void WorkerThreadPool::_schedule(Task *p_task) {
+
+	if (p_task->chunks==0) {
+		_complete(p_task); // empty group
+		return;
+	}
+
+	if (!threads_started && thread_count>0)
+		_start_threads();
+
+	// a group is queued once per thread that can help with it, each one takes chunks until none are left
+	int entries=MIN(p_task->chunks,thread_count+1);
+	atomic_add(&p_task->refcount,entries);
+
+	int index=_get_thread_index();
+	queues[index<0 ? SHARED_QUEUE : index].push_back(p_task,entries);
+
+	// the atomic operation orders the push against workers announcing they go to sleep
+	int sleeping=atomic_add(&sleeping_threads,0);
+	for(int i=MIN(sleeping,entries);i>0;i--)
+		work_semaphore->post();
+}
+
+WorkerThreadPool::Task *WorkerThreadPool::_pop_task(int p_index) {
+
+	Task *task=NULL;
+
+	if (p_index>=0)
+		task=queues[p_index].pop_back(); // newest first, it's likely still in cache
+
+	if (!task)
+		task=queues[SHARED_QUEUE].pop_front();
+
+	for(int i=1;!task && i<=thread_count;i++) {
+
+		int victim=(MAX(p_index,0)+i)%thread_count;
+		if (victim!=p_index)
+			task=queues[victim].pop_front(); // steal the oldest, usually the biggest piece of work
+	}
+
+	return task;
+}
+
+void WorkerThreadPool::_process(Task *p_task) {
+
+	if (p_task->task_func) {
+
+		p_task->task_func(p_task->userdata);
+		_complete(p_task);
+
+	} else {
+
+		int done=0;
+		while(true) {
+
+			int chunk=int(atomic_add(&p_task->next_chunk,1))-1;
+			if (chunk>=p_task->chunks)
+				break;
+
+			int from=chunk*p_task->grain;
+			int to=MIN(from+p_task->grain,p_task->count);
+			p_task->range_func(p_task->userdata,from,to);
+			done++;
+		}
+
+		if (done && atomic_add(&p_task->pending_chunks,-done)==0)
+			_complete(p_task);
+	}
+
+	_release_task(p_task);
+}
+
+void WorkerThreadPool::_complete(Task *p_task) {
+
+	Vector<Task*> dependents;
+
+	if (mutex)
+		mutex->lock();
+
+	atomic_store(&p_task->completed,uint32_t(1));
+	if (p_task->done)
+		p_task->done->post();
+	if (p_task->dependents.size()) {
+		dependents=p_task->dependents;
+		p_task->dependents.clear();
+	}
+
+	if (mutex)
+		mutex->unlock();
+
+	for(int i=0;i<dependents.size();i++) {
+
+		Task *dep=dependents[i];
+		if (atomic_add(&dep->pending_dependencies,-1)==0)
+			_schedule(dep);
+	}
+}
+
+void WorkerThreadPool::_wait(Task *p_task) {
+
+	int index=_get_thread_index();
+
+	while(!atomic_load(&p_task->completed)) {
+
+		Task *task=_pop_task(index);
+		if (task) {
+			_process(task); // help instead of sleeping
+			continue;
+		}
+
+		if (!mutex)
+			break; // no threads, nothing else can be running it
+
+		// out of work, the task is running (or waiting for dependencies) on other threads
+		mutex->lock();
+		if (p_task->completed) {
+			mutex->unlock();
+			break;
+		}
+		if (!p_task->done)
+			p_task->done=Semaphore::create();
+		mutex->unlock();
+
+		p_task->done->wait();
+		break;
+	}
+}
+
+void WorkerThreadPool::_thread_function(void *p_userdata) {
+
+	ThreadData *td=(ThreadData*)p_userdata;
+	WorkerThreadPool *pool=td->pool;
+	int index=td->index;
+
+	atomic_store(&pool->thread_ids[index],Thread::get_caller_ID());
+
+	while(true) {
+
+		Task *task=pool->_pop_task(index);
+		if (task) {
+			pool->_process(task);
+			continue;
+		}
+
+		if (atomic_load(&pool->exit_threads))
+			break;
+
+		// announce before checking the queues again, so a push in between always posts
+		atomic_add(&pool->sleeping_threads,1);
+		task=pool->_pop_task(index);
+		if (!task && !atomic_load(&pool->exit_threads))
+			pool->work_semaphore->wait();
+		atomic_add(&pool->sleeping_threads,-1);
+
+		if (task)
+			pool->_process(task);
+	}
+}
+
+void WorkerThreadPool::_start_threads() {
+
+	mutex->lock();
+	if (!threads_started) {
+
+		for(int i=0;i<thread_count;i++) {
+
+			thread_data[i].pool=this;
+			thread_data[i].index=i;
+			threads[i]=Thread::create(_thread_function,&thread_data[i]);
+			if (!threads[i]) {
+				thread_count=i; // no thread support, whatever was created is used
+				break;
+			}
+		}
+		threads_started=true;
+	}
+	mutex->unlock();
+}
+
+/* API */
+
+WorkerThreadPool::TaskID WorkerThreadPool::add_task(TaskFunc p_func,void *p_userdata,const TaskID *p_dependencies,int p_dependency_count) {
+
+	ERR_FAIL_COND_V(!p_func,INVALID_TASK_ID);
+
+	if (mutex)
+		mutex->lock();
+
+	Task *task=_alloc_task(p_func,NULL,p_userdata,1,1);
+	do {
+		last_id++;
+	} while(last_id==INVALID_TASK_ID || tasks.has(last_id));
+	task->id=last_id;
+	tasks.set(task->id,task);
+
+	if (mutex)
+		mutex->unlock();
+
+	TaskID id=task->id; // task may complete before _add_dependencies returns
+	_add_dependencies(task,p_dependencies,p_dependency_count);
+	return id;
+}
+
+WorkerThreadPool::TaskID WorkerThreadPool::add_group_task(RangeFunc p_func,void *p_userdata,int p_count,int p_grain,const TaskID *p_dependencies,int p_dependency_count) {
+
+	ERR_FAIL_COND_V(!p_func,INVALID_TASK_ID);
+
+	if (mutex)
+		mutex->lock();
+
+	Task *task=_alloc_task(NULL,p_func,p_userdata,p_count,p_grain);
+	do {
+		last_id++;
+	} while(last_id==INVALID_TASK_ID || tasks.has(last_id));
+	task->id=last_id;
+	tasks.set(task->id,task);
+
+	if (mutex)
+		mutex->unlock();
+
+	TaskID id=task->id;
+	_add_dependencies(task,p_dependencies,p_dependency_count);
+	return id;
+}
+
+bool WorkerThreadPool::is_task_completed(TaskID p_task) const {
+
+	if (mutex)
+		mutex->lock();
+
+	Task * const *task=tasks.getptr(p_task);
+	bool completed = task && (*task)->completed;
+
+	if (mutex)
+		mutex->unlock();
+
+	ERR_FAIL_COND_V(!task,false);
+	return completed;
+}
+
+void WorkerThreadPool::wait_for_task(TaskID p_task) {
+
+	if (mutex)
+		mutex->lock();
+
+	Task **taskp=tasks.getptr(p_task);
+	Task *task=taskp ? *taskp : NULL;
+	if (task)
+		tasks.erase(p_task);
+
+	if (mutex)
+		mutex->unlock();
+
+	ERR_FAIL_COND(!task);
+
+	_wait(task);
+	_release_task(task);
+}
+
+void WorkerThreadPool::parallel_for(int p_count,RangeFunc p_func,void *p_userdata,int p_grain) {
+
+	if (p_count<=0)
+		return;
+
+	int grain=MAX(p_grain,1);
+	int chunks=(p_count+grain-1)/grain;
+
+	if (chunks==1 || thread_count==0 || !mutex) {
+
+		p_func(p_userdata,0,p_count);
+		return;
+	}
+
+	mutex->lock();
+	Task *task=_alloc_task(NULL,p_func,p_userdata,p_count,grain);
+	mutex->unlock();
+
+	_schedule(task);
+	_wait(task);
+	_release_task(task);
+}
+
+int WorkerThreadPool::get_thread_count() const {
+
+	return thread_count+1;
+}
+
+WorkerThreadPool::WorkerThreadPool(int p_threads) {
+
+	singleton=this;
+
+	mutex=Mutex::create();
+	work_semaphore=Semaphore::create();
+	threads_started=false;
+	exit_threads=0;
+	sleeping_threads=0;
+	free_tasks=NULL;
+	last_id=INVALID_TASK_ID;
+
+	if (p_threads<0)
+		p_threads=OS::get_singleton() ? OS::get_singleton()->get_processor_count()-1 : 0;
+	thread_count=(mutex && work_semaphore) ? CLAMP(p_threads,0,int(MAX_THREADS)) : 0;
+
+	for(int i=0;i<=MAX_THREADS;i++) {
+
+		if (i<MAX_THREADS) {
+			threads[i]=NULL;
+			thread_ids[i]=0;
+		}
+		queues[i].mutex=(i<thread_count || i==SHARED_QUEUE) ? Mutex::create() : NULL;
+		queues[i].items=NULL;
+		queues[i].capacity=0;
+		queues[i].head=0;
+		queues[i].count=0;
+	}
+}
+
+WorkerThreadPool::~WorkerThreadPool() {
+
+	if (threads_started) {
+
+		atomic_store(&exit_threads,uint32_t(1));
+
+		for(int i=0;i<thread_count;i++)
+			work_semaphore->post();
+		for(int i=0;i<thread_count;i++) {
+			Thread::wait_to_finish(threads[i]);
+			memdelete(threads[i]);
+		}
+	}
+
+	for(int i=0;i<=MAX_THREADS;i++) {
+
+		Task *task;
+		while((task=queues[i].pop_front()))
+			_release_task(task); // leftover entries of groups that are already done
+	}
+
+	const TaskID *k=NULL;
+	while((k=tasks.next(k))) {
+		ERR_PRINT("WorkerThreadPool: task was never waited for.");
+		Task *task=tasks[*k];
+		if (task->done)
+			memdelete(task->done);
+		memdelete(task);
+	}
+
+	while(free_tasks) {
+		Task *task=free_tasks;
+		free_tasks=task->next_free;
+		memdelete(task);
+	}
+
+	for(int i=0;i<=MAX_THREADS;i++) {
+		if (queues[i].items)
+			memfree(queues[i].items);
+		if (queues[i].mutex)
+			memdelete(queues[i].mutex);
+	}
+
+	if (work_semaphore)
+		memdelete(work_semaphore);
+	if (mutex)
+		memdelete(mutex);
+
+	if (singleton==this)
+		singleton=NULL;
+}
@@ -0,0 +1,147 @@
+/*************************************************************************/
+/*  worker_thread_pool.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2016 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#ifndef WORKER_THREAD_POOL_H
+#define WORKER_THREAD_POOL_H
+
+#include "os/thread.h"
+#include "os/mutex.h"
+#include "os/semaphore.h"
+#include "hash_map.h"
+#include "vector.h"
+
+/**
+	Shared pool of worker threads for engine work (image processing, compression,
+	script jobs, etc).
+
+	Every worker owns a deque: tasks it creates are pushed and popped at the back,
+	idle workers steal from the front of the others. Threads that are not workers
+	push to a shared queue. Waiting for a task (or a parallel_for) runs other
+	queued tasks instead of sleeping, so the calling thread always takes part in
+	the work and nesting is safe. Without thread support everything runs on the
+	thread that waits.
+*/
+
+class WorkerThreadPool {
+public:
+
+	typedef void (*TaskFunc)(void *p_userdata);
+	typedef void (*RangeFunc)(void *p_userdata,int p_from,int p_to); ///< processes elements [p_from,p_to)
+	typedef uint32_t TaskID;
+
+	enum {
+		MAX_THREADS=64,
+		INVALID_TASK_ID=0
+	};
+
+private:
+
+	struct Task {
+
+		TaskID id;
+		TaskFunc task_func;
+		RangeFunc range_func;
+		void *userdata;
+		int count;
+		int grain;
+		int chunks;
+		volatile uint32_t next_chunk;
+		volatile uint32_t pending_chunks;
+		volatile uint32_t pending_dependencies;
+		volatile uint32_t refcount; // one per queue entry, plus one until waited for
+		volatile uint32_t completed;
+		Semaphore *done; // created by a waiter that ran out of work, protected by mutex
+		Vector<Task*> dependents; // protected by mutex
+		Task *next_free;
+	};
+
+	struct Queue {
+
+		Mutex *mutex;
+		Task **items;
+		int capacity;
+		int head;
+		volatile int count; // also read without locking, as a hint
+
+		void push_back(Task *p_task,int p_times);
+		Task *pop_back();
+		Task *pop_front();
+	};
+
+	Thread *threads[MAX_THREADS];
+	volatile Thread::ID thread_ids[MAX_THREADS];
+	Queue queues[MAX_THREADS+1]; // one per worker, the last one is shared by other threads
+	int thread_count;
+	bool threads_started;
+	volatile uint32_t exit_threads;
+	volatile int sleeping_threads;
+
+	Mutex *mutex;
+	Semaphore *work_semaphore;
+	HashMap<TaskID,Task*> tasks;
+	Task *free_tasks;
+	TaskID last_id;
+
+	static WorkerThreadPool *singleton;
+
+	struct ThreadData {
+		WorkerThreadPool *pool;
+		int index;
+	};
+	ThreadData thread_data[MAX_THREADS];
+
+	static void _thread_function(void *p_userdata);
+	void _start_threads();
+
+	int _get_thread_index() const;
+	Task *_alloc_task(TaskFunc p_task_func,RangeFunc p_range_func,void *p_userdata,int p_count,int p_grain);
+	void _release_task(Task *p_task);
+	void _add_dependencies(Task *p_task,const TaskID *p_dependencies,int p_dependency_count);
+	void _schedule(Task *p_task);
+	Task *_pop_task(int p_index);
+	void _process(Task *p_task);
+	void _complete(Task *p_task);
+	void _wait(Task *p_task);
+
+public:
+
+	static WorkerThreadPool *get_singleton();
+
+	TaskID add_task(TaskFunc p_func,void *p_userdata,const TaskID *p_dependencies=NULL,int p_dependency_count=0); ///< runs once all dependencies completed
+	TaskID add_group_task(RangeFunc p_func,void *p_userdata,int p_count,int p_grain=1,const TaskID *p_dependencies=NULL,int p_dependency_count=0); ///< elements are split in chunks of p_grain, run in parallel
+	bool is_task_completed(TaskID p_task) const;
+	void wait_for_task(TaskID p_task); ///< every added task must be waited for exactly once, runs other tasks meanwhile
+
+	void parallel_for(int p_count,RangeFunc p_func,void *p_userdata,int p_grain=1); ///< blocks until all elements are processed
+	int get_thread_count() const; ///< threads that can take part in a parallel_for, counting the caller
+
+	WorkerThreadPool(int p_threads=-1);
+	~WorkerThreadPool();
+};
+
+#endif // WORKER_THREAD_POOL_H
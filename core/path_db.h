@@ -98,4 +98,9 @@ public:
 	~NodePath();
 };
 
+struct NodePathHasher {
+
+	static _FORCE_INLINE_ uint32_t hash(const NodePath &p_path) { return p_path.hash(); }
+};
+
 #endif
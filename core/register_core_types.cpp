@@ -54,6 +54,8 @@
 #include "func_ref.h"
 #include "input_map.h"
 #include "undo_redo.h"
+#include "os/worker_thread_pool.h"
+#include "os/frame_allocator.h"
 
 #ifdef XML_ENABLED
 static ResourceFormatSaverXML *resource_saver_xml=NULL;
@@ -67,12 +69,15 @@ static _ResourceLoader *_resource_loader=NULL;
 static _ResourceSaver *_resource_saver=NULL;
 static _OS *_os=NULL;
 static _Marshalls *_marshalls = NULL;
+static _WorkerThreadPool *_worker_thread_pool = NULL;
 static TranslationLoaderPO *resource_format_po=NULL;
 
 static IP* ip = NULL;
 
 static _Geometry *_geometry=NULL;
 
+static WorkerThreadPool *worker_thread_pool=NULL;
+
 extern Mutex *_global_mutex;
 
 
@@ -89,6 +94,9 @@ void register_core_types() {
 
 	StringName::setup();
 
+	ResourceLoader::initialize();
+
+	worker_thread_pool = memnew( WorkerThreadPool );
 
 	register_variant_methods();
 
@@ -163,6 +171,7 @@ void register_core_types() {
 	_resource_saver=memnew(_ResourceSaver);
 	_os=memnew(_OS);
 	_marshalls = memnew(_Marshalls);
+	_worker_thread_pool = memnew(_WorkerThreadPool);
 
 
 
@@ -178,6 +187,7 @@ void register_core_singletons() {
 	Globals::get_singleton()->add_singleton( Globals::Singleton("PathRemap",PathRemap::get_singleton() ) );
 	Globals::get_singleton()->add_singleton( Globals::Singleton("OS",_OS::get_singleton() ) );
 	Globals::get_singleton()->add_singleton( Globals::Singleton("Marshalls",_marshalls ) );
+	Globals::get_singleton()->add_singleton( Globals::Singleton("WorkerThreadPool",_worker_thread_pool ) );
 	Globals::get_singleton()->add_singleton( Globals::Singleton("TranslationServer",TranslationServer::get_singleton() ) );
 	Globals::get_singleton()->add_singleton( Globals::Singleton("TS",TranslationServer::get_singleton() ) );
 	Globals::get_singleton()->add_singleton( Globals::Singleton("Input",Input::get_singleton() ) );
@@ -189,6 +199,10 @@ void register_core_singletons() {
 void unregister_core_types() {
 
 
+	ResourceLoader::finalize();
+
+	memdelete( _worker_thread_pool );
+	memdelete( worker_thread_pool );
 
 	memdelete( _resource_loader );
 	memdelete( _resource_saver );
@@ -223,6 +237,7 @@ void unregister_core_types() {
 	ResourceCache::clear();
 	CoreStringNames::free();
 	StringName::cleanup();
+	FrameAllocator::cleanup();
 
 	if (_global_mutex) {
 		memdelete(_global_mutex);
@@ -47,6 +47,7 @@ typedef uint32_t ID;
 class RID {
 friend class RID_OwnerBase;
 	ID _id;
+	uint32_t _index;
 	RID_OwnerBase *owner;
 public:
 
@@ -79,6 +80,7 @@ public:
 
 	_FORCE_INLINE_ RID() {
 		_id = 0;
+		_index = 0;
 		owner=0;
 	}
 };
@@ -88,6 +90,8 @@ class RID_OwnerBase {
 protected:
 friend class RID;
 	void set_id(RID& p_rid, ID p_id) const { p_rid._id=p_id; }
+	void set_index(RID& p_rid, uint32_t p_index) const { p_rid._index=p_index; }
+	_FORCE_INLINE_ uint32_t get_index(const RID& p_rid) const { return p_rid._index; }
 	void set_ownage(RID& p_rid) const { p_rid.owner=const_cast<RID_OwnerBase*>(this); }
 	ID new_ID();
 public:
@@ -100,8 +104,235 @@ public:
 	virtual ~RID_OwnerBase() {}
 };
 
+/**
+ * RID owner backed by a chunked slot array. Each RID carries the index of its slot,
+ * and the slot stores the (globally unique) ID it was handed out with, so a lookup is
+ * an index plus a generation check. Stale RIDs are rejected because a reused slot
+ * always gets a new ID.
+ *
+ * Chunks are never moved once allocated. When the chunk table grows, the old table is
+ * kept alive until the owner is destroyed, so in the thread safe variant only
+ * make_rid() and free() lock; get() and owns() are lock free.
+ */
+
 template<class T,bool thread_safe=false>
 class RID_Owner : public RID_OwnerBase {
+public:
+
+	typedef void (*ReleaseNotifyFunc)(void*user,T *p_data);
+private:
+
+	enum {
+		CHUNK_BITS=8,
+		CHUNK_SIZE=1<<CHUNK_BITS,
+		CHUNK_MASK=CHUNK_SIZE-1,
+	};
+
+	struct Slot {
+
+		T *data;
+		volatile ID id; // 0 when free
+		uint32_t next_free;
+	};
+
+	struct ChunkTable {
+
+		ChunkTable *prev; // smaller table this one replaced, released on destruction
+		uint32_t size;
+		Slot *chunks[1];
+	};
+
+	Mutex *mutex;
+	ChunkTable * volatile table;
+	volatile uint32_t slot_count; // slots handed out at least once
+	uint32_t free_list; // index+1 of the first free slot, 0 if none
+	uint32_t alloc_count;
+
+	_FORCE_INLINE_ const Slot *_get_slot(const RID& p_rid) const {
+
+		uint32_t idx = get_index(p_rid);
+		if (idx >= (thread_safe ? atomic_load(&slot_count) : slot_count))
+			return NULL;
+		ChunkTable *t = thread_safe ? atomic_load(&table) : table;
+		const Slot *s = &t->chunks[idx>>CHUNK_BITS][idx&CHUNK_MASK];
+		if (s->id==0 || s->id!=p_rid.get_id())
+			return NULL;
+		return s;
+	}
+
+	uint32_t _alloc_slot() {
+
+		if (free_list) {
+			uint32_t idx = free_list-1;
+			free_list = table->chunks[idx>>CHUNK_BITS][idx&CHUNK_MASK].next_free;
+			return idx;
+		}
+
+		uint32_t idx = slot_count;
+		uint32_t chunk = idx>>CHUNK_BITS;
+
+		if ((idx&CHUNK_MASK)==0) {
+
+			if (!table || chunk==table->size) {
+
+				uint32_t new_size = table ? table->size*2 : 4;
+				ChunkTable *new_table = (ChunkTable*)memalloc(sizeof(ChunkTable)+sizeof(Slot*)*(new_size-1));
+				new_table->prev=table;
+				new_table->size=new_size;
+				for(uint32_t i=0;i<new_size;i++) {
+					new_table->chunks[i] = (table && i<table->size) ? table->chunks[i] : NULL;
+				}
+				atomic_store(&table,new_table);
+			}
+
+			Slot *slots = (Slot*)memalloc(sizeof(Slot)*CHUNK_SIZE);
+			for(int i=0;i<CHUNK_SIZE;i++) {
+				slots[i].data=NULL;
+				slots[i].id=0;
+				slots[i].next_free=0;
+			}
+			table->chunks[chunk]=slots;
+		}
+
+		atomic_store(&slot_count,idx+1);
+		return idx;
+	}
+
+public:
+
+	RID make_rid(T * p_data) {
+
+		if (thread_safe) {
+			mutex->lock();
+		}
+
+		uint32_t idx = _alloc_slot();
+		Slot &s = table->chunks[idx>>CHUNK_BITS][idx&CHUNK_MASK];
+		ID id = new_ID();
+		s.data=p_data;
+		s.next_free=0;
+		atomic_store(&s.id,id);
+		alloc_count++;
+
+		if (thread_safe) {
+			mutex->unlock();
+		}
+
+		RID rid;
+		set_id(rid,id);
+		set_index(rid,idx);
+		set_ownage(rid);
+		return rid;
+	}
+
+	_FORCE_INLINE_ T * get(const RID& p_rid) {
+
+		const Slot *s = _get_slot(p_rid);
+		ERR_FAIL_COND_V(!s,NULL);
+		return s->data;
+	}
+
+	virtual bool owns(const RID& p_rid) const {
+
+		return _get_slot(p_rid)!=NULL;
+	}
+
+	virtual void free(RID p_rid) {
+
+		if (thread_safe) {
+			mutex->lock();
+		}
+
+		// checked under the lock, so two threads can't both free the same slot
+		Slot *s = const_cast<Slot*>(_get_slot(p_rid));
+		if (!s) {
+			if (thread_safe) {
+				mutex->unlock();
+			}
+			ERR_FAIL_COND(!s);
+		}
+
+		atomic_store(&s->id,ID(0));
+		s->data=NULL;
+		s->next_free=free_list;
+		free_list=get_index(p_rid)+1;
+		alloc_count--;
+
+		if (thread_safe) {
+			mutex->unlock();
+		}
+	}
+
+	virtual void get_owned_list(List<RID> *p_owned) const {
+
+		if (thread_safe) {
+			mutex->lock();
+		}
+
+		// slots are visited in memory order
+		for(uint32_t i=0;i<slot_count;i++) {
+
+			const Slot &s = table->chunks[i>>CHUNK_BITS][i&CHUNK_MASK];
+			if (s.id==0)
+				continue;
+
+			RID rid;
+			set_id(rid,s.id);
+			set_index(rid,i);
+			set_ownage(rid);
+			p_owned->push_back(rid);
+		}
+
+		if (thread_safe) {
+			mutex->unlock();
+		}
+	}
+
+	_FORCE_INLINE_ uint32_t get_rid_count() const { return alloc_count; }
+
+	RID_Owner() {
+
+		if (thread_safe) {
+
+			mutex = Mutex::create();
+		}
+
+		table=NULL;
+		slot_count=0;
+		free_list=0;
+		alloc_count=0;
+	}
+
+
+	~RID_Owner() {
+
+		if (table) {
+			uint32_t chunks = (slot_count+CHUNK_MASK)>>CHUNK_BITS;
+			for(uint32_t i=0;i<chunks;i++) {
+				memfree(table->chunks[i]);
+			}
+		}
+
+		while(table) {
+			ChunkTable *prev=table->prev;
+			memfree(table);
+			table=prev;
+		}
+
+		if (thread_safe) {
+
+			memdelete(mutex);
+		}
+	}
+};
+
+/**
+ * Previous RID owner, resolving IDs through a HashMap.
+ * Kept around to benchmark RID_Owner against it.
+ */
+
+template<class T,bool thread_safe=false>
+class RID_HashOwner : public RID_OwnerBase {
 public:
 
 	typedef void (*ReleaseNotifyFunc)(void*user,T *p_data);
@@ -158,7 +389,7 @@ public:
 		T**elem = id_map.getptr(p_rid.get_id());
 
 		if (thread_safe) {
-			mutex->lock();
+			mutex->unlock();
 		}
 
 		return elem!=NULL;
@@ -169,8 +400,11 @@ public:
 		if (thread_safe) {
 			mutex->lock();
 		}
-		ERR_FAIL_COND(!owns(p_rid));
-		id_map.erase(p_rid.get_id());
+		bool erased = id_map.erase(p_rid.get_id());
+		if (thread_safe) {
+			mutex->unlock();
+		}
+		ERR_FAIL_COND(!erased);
 	}
 	virtual void get_owned_list(List<RID> *p_owned) const {
 
@@ -189,11 +423,11 @@ public:
 		}
 
 		if (thread_safe) {
-			mutex->lock();
+			mutex->unlock();
 		}
 
 	}
-	RID_Owner() {
+	RID_HashOwner() {
 
 		if (thread_safe) {
 
@@ -203,7 +437,7 @@ public:
 	}
 
 
-	~RID_Owner() {
+	~RID_HashOwner() {
 
 		if (thread_safe) {
 
@@ -52,4 +52,19 @@ long atomic_decrement( register long * pw ) {
 	return InterlockedDecrement( pw );
 }
 
+bool _atomic_cas_32(volatile void *p_ptr,uint32_t p_expected,uint32_t p_desired) {
+
+	return InterlockedCompareExchange((volatile LONG*)p_ptr,(LONG)p_desired,(LONG)p_expected)==(LONG)p_expected;
+}
+
+bool _atomic_cas_64(volatile void *p_ptr,uint64_t p_expected,uint64_t p_desired) {
+
+	return InterlockedCompareExchange64((volatile LONGLONG*)p_ptr,(LONGLONG)p_desired,(LONGLONG)p_expected)==(LONGLONG)p_expected;
+}
+
+void _atomic_fence() {
+
+	MemoryBarrier();
+}
+
 #endif
@@ -33,6 +33,7 @@
 /* x86/x86_64 GCC */
 
 #include "platform_config.h"
+#include "typedefs.h"
 
 
 #ifdef NO_THREADS
@@ -376,4 +377,133 @@ public:
 
 #endif // no thread safe
 
+
+/* Generic atomic helpers, used by lock-free containers (RID_Owner, queues, etc) */
+
+#ifdef NO_THREADS
+
+template<class T>
+static _ALWAYS_INLINE_ T atomic_load(const volatile T *p_ptr) {
+
+	return *p_ptr;
+}
+
+template<class T>
+static _ALWAYS_INLINE_ void atomic_store(volatile T *p_ptr,T p_value) {
+
+	*p_ptr=p_value;
+}
+
+template<class T>
+static _ALWAYS_INLINE_ bool atomic_cas(volatile T *p_ptr,T p_expected,T p_desired) {
+
+	if (*p_ptr!=p_expected)
+		return false;
+	*p_ptr=p_desired;
+	return true;
+}
+
+template<class T,class V>
+static _ALWAYS_INLINE_ T atomic_add(volatile T *p_ptr,V p_value) {
+
+	return (*p_ptr)+=p_value;
+}
+
+template<class T>
+static _ALWAYS_INLINE_ T atomic_exchange(volatile T *p_ptr,T p_value) {
+
+	T old=*p_ptr;
+	*p_ptr=p_value;
+	return old;
+}
+
+#elif defined( __GNUC__ )
+
+template<class T>
+static _ALWAYS_INLINE_ T atomic_load(const volatile T *p_ptr) {
+
+	return __atomic_load_n(p_ptr,__ATOMIC_ACQUIRE);
+}
+
+template<class T>
+static _ALWAYS_INLINE_ void atomic_store(volatile T *p_ptr,T p_value) {
+
+	__atomic_store_n(p_ptr,p_value,__ATOMIC_RELEASE);
+}
+
+template<class T>
+static _ALWAYS_INLINE_ bool atomic_cas(volatile T *p_ptr,T p_expected,T p_desired) {
+
+	return __sync_bool_compare_and_swap(p_ptr,p_expected,p_desired);
+}
+
+template<class T,class V>
+static _ALWAYS_INLINE_ T atomic_add(volatile T *p_ptr,V p_value) {
+
+	return __sync_add_and_fetch(p_ptr,p_value);
+}
+
+template<class T>
+static _ALWAYS_INLINE_ T atomic_exchange(volatile T *p_ptr,T p_value) {
+
+	return __atomic_exchange_n(p_ptr,p_value,__ATOMIC_ACQ_REL);
+}
+
+#elif defined( _MSC_VER )
+
+// implemented in safe_refcount.cpp, to avoid including windows.h here
+bool _atomic_cas_32(volatile void *p_ptr,uint32_t p_expected,uint32_t p_desired);
+bool _atomic_cas_64(volatile void *p_ptr,uint64_t p_expected,uint64_t p_desired);
+void _atomic_fence();
+
+template<class T>
+static _ALWAYS_INLINE_ T atomic_load(const volatile T *p_ptr) {
+
+	T v=*p_ptr;
+	_atomic_fence();
+	return v;
+}
+
+template<class T>
+static _ALWAYS_INLINE_ void atomic_store(volatile T *p_ptr,T p_value) {
+
+	_atomic_fence();
+	*p_ptr=p_value;
+}
+
+template<class T>
+static _ALWAYS_INLINE_ bool atomic_cas(volatile T *p_ptr,T p_expected,T p_desired) {
+
+	if (sizeof(T)==4)
+		return _atomic_cas_32(p_ptr,*(uint32_t*)&p_expected,*(uint32_t*)&p_desired);
+	else
+		return _atomic_cas_64(p_ptr,*(uint64_t*)&p_expected,*(uint64_t*)&p_desired);
+}
+
+template<class T,class V>
+static _ALWAYS_INLINE_ T atomic_add(volatile T *p_ptr,V p_value) {
+
+	while(true) {
+		T old=*p_ptr;
+		if (atomic_cas(p_ptr,old,T(old+p_value)))
+			return old+p_value;
+	}
+}
+
+template<class T>
+static _ALWAYS_INLINE_ T atomic_exchange(volatile T *p_ptr,T p_value) {
+
+	while(true) {
+		T old=*p_ptr;
+		if (atomic_cas(p_ptr,old,p_value))
+			return old;
+	}
+}
+
+#else
+
+#error This platform has no atomic operations, compile with NO_THREADS or implement them.
+
+#endif
+
 #endif
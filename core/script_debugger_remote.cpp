@@ -53,6 +53,39 @@ void ScriptDebuggerRemote::_send_video_memory() {
 
 }
 
+void ScriptDebuggerRemote::_send_memory_report() {
+
+	if (!Memory::is_tracking_enabled()) {
+		// first request starts tracking, the next ones will have something to show
+		Memory::set_tracking_enabled(true);
+	}
+
+	Memory::AllocStats categories[Memory::ALLOC_CATEGORY_MAX];
+	Memory::get_tracked_categories(categories);
+
+	enum {
+		MAX_SITES=256
+	};
+	Memory::AllocStats *sites = memnew_arr(Memory::AllocStats,MAX_SITES);
+	int site_count = Memory::get_tracked_sites(sites,MAX_SITES);
+
+	// category totals first (with an empty site), then sites sorted by live bytes
+	packet_peer_stream->put_var("message:memory_report");
+	packet_peer_stream->put_var((Memory::ALLOC_CATEGORY_MAX+site_count)*5);
+
+	for(int i=0;i<Memory::ALLOC_CATEGORY_MAX+site_count;i++) {
+
+		const Memory::AllocStats &s = i<Memory::ALLOC_CATEGORY_MAX ? categories[i] : sites[i-Memory::ALLOC_CATEGORY_MAX];
+		packet_peer_stream->put_var(i<Memory::ALLOC_CATEGORY_MAX ? String() : String(s.site?s.site:"(no description)"));
+		packet_peer_stream->put_var(Memory::get_alloc_category_name(s.category));
+		packet_peer_stream->put_var(int(s.live_bytes));
+		packet_peer_stream->put_var(int(s.live_count));
+		packet_peer_stream->put_var(int(s.frame_count));
+	}
+
+	memdelete_arr(sites);
+}
+
 Error ScriptDebuggerRemote::connect_to_host(const String& p_host,uint16_t p_port) {
 
 
@@ -288,6 +321,9 @@ void ScriptDebuggerRemote::debug(ScriptLanguage *p_script,bool p_can_continue) {
 			} else if (command=="request_video_mem") {
 
 				_send_video_memory();
+			} else if (command=="request_memory_report") {
+
+				_send_memory_report();
 			} else if (command=="inspect_object") {
 
 				ObjectID id = cmd[1];
@@ -673,6 +709,9 @@ void ScriptDebuggerRemote::_poll_events() {
 		} else if (command=="request_video_mem") {
 
 			_send_video_memory();
+		} else if (command=="request_memory_report") {
+
+			_send_memory_report();
 		} else if (command=="inspect_object") {
 
 			ObjectID id = cmd[1];
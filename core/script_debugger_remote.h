@@ -116,6 +116,7 @@ class ScriptDebuggerRemote : public ScriptDebugger {
 
 	void _send_object_id(ObjectID p_id);
 	void _send_video_memory();
+	void _send_memory_report();
 	LiveEditFuncs *live_edit_funcs;
 
 	ErrorHandlerList eh;
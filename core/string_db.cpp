@@ -29,11 +29,12 @@
 #include "string_db.h"
 #include "print_string.h"
 #include "os/os.h"
+#include <string.h>
 StaticCString StaticCString::create(const char *p_ptr) {
 	StaticCString scs; scs.ptr=p_ptr; return scs;
 }
 
-StringName::_Data *StringName::_table[STRING_TABLE_LEN];
+StringName::_Shard StringName::_shards[STRING_TABLE_SHARDS];
 
 StringName _scs_create(const char *p_chr) {
 
@@ -42,43 +43,160 @@ StringName _scs_create(const char *p_chr) {
 
 bool StringName::configured=false;
 
+static _FORCE_INLINE_ void _shard_lock(Mutex *p_mutex) {
+
+	if (p_mutex)
+		p_mutex->lock();
+}
+
+static _FORCE_INLINE_ void _shard_unlock(Mutex *p_mutex) {
+
+	if (p_mutex)
+		p_mutex->unlock();
+}
+
+/* comparisons against the stored name, without building a temporary String */
+
+static _FORCE_INLINE_ bool _name_equals(const char *p_cname,const String& p_name,const char *p_str) {
+
+	if (p_cname)
+		return strcmp(p_cname,p_str)==0;
+	return p_name==p_str;
+}
+
+static _FORCE_INLINE_ bool _name_equals(const char *p_cname,const String& p_name,const CharType *p_str) {
+
+	if (p_cname) {
+		while(*p_cname && CharType(*p_cname)==*p_str) {
+			p_cname++;
+			p_str++;
+		}
+		return CharType(*p_cname)==*p_str;
+	}
+	return p_name==p_str;
+}
+
+static _FORCE_INLINE_ bool _name_equals(const char *p_cname,const String& p_name,const String& p_str) {
+
+	if (p_cname)
+		return p_str==p_cname;
+	return p_name==p_str;
+}
+
+template<class T>
+StringName::_Data *StringName::_find(const _Shard& p_shard,uint32_t p_hash,const T& p_name) {
+
+	_Data *d=p_shard.table[p_hash&((1<<p_shard.bits)-1)];
+
+	while(d) {
+
+		// compare hash first
+		if (d->hash==p_hash && _name_equals(d->cname,d->name,p_name))
+			return d;
+		d=d->next;
+	}
+
+	return NULL;
+}
+
+void StringName::_insert(_Shard& p_shard,_Data *p_data) {
+
+	if (p_shard.count>=(1U<<p_shard.bits)) {
+
+		// grow, reusing the stored hashes
+		uint32_t new_bits=p_shard.bits+1;
+		uint32_t new_mask=(1<<new_bits)-1;
+		_Data **new_table=memnew_arr(_Data*,1<<new_bits);
+		for(uint32_t i=0;i<=new_mask;i++) {
+			new_table[i]=NULL;
+		}
+
+		for(uint32_t i=0;i<(1U<<p_shard.bits);i++) {
+
+			_Data *d=p_shard.table[i];
+			while(d) {
+				_Data *next=d->next;
+				uint32_t idx=d->hash&new_mask;
+				d->prev=NULL;
+				d->next=new_table[idx];
+				if (new_table[idx])
+					new_table[idx]->prev=d;
+				new_table[idx]=d;
+				d=next;
+			}
+		}
+
+		memdelete_arr(p_shard.table);
+		p_shard.table=new_table;
+		p_shard.bits=new_bits;
+	}
+
+	uint32_t idx=p_data->hash&((1<<p_shard.bits)-1);
+	p_data->next=p_shard.table[idx];
+	p_data->prev=NULL;
+	if (p_shard.table[idx])
+		p_shard.table[idx]->prev=p_data;
+	p_shard.table[idx]=p_data;
+	p_shard.count++;
+}
+
 void StringName::setup() {
 
 	ERR_FAIL_COND(configured);
-	for(int i=0;i<STRING_TABLE_LEN;i++) {
-
-		_table[i]=NULL;
+	for(int i=0;i<STRING_TABLE_SHARDS;i++) {
+
+		_Shard &shard=_shards[i];
+		shard.mutex=Mutex::create(false);
+		shard.bits=STRING_TABLE_MIN_BITS;
+		shard.count=0;
+		shard.table=memnew_arr(_Data*,1<<STRING_TABLE_MIN_BITS);
+		for(int j=0;j<(1<<STRING_TABLE_MIN_BITS);j++) {
+			shard.table[j]=NULL;
+		}
 	}
 	configured=true;
 }
 
 void StringName::cleanup() {
 
-	_global_lock();
 	int lost_strings=0;
-	for(int i=0;i<STRING_TABLE_LEN;i++) {
+	for(int i=0;i<STRING_TABLE_SHARDS;i++) {
+
+		_Shard &shard=_shards[i];
+		_shard_lock(shard.mutex);
+
+		for(uint32_t j=0;j<(1U<<shard.bits);j++) {
 
-		while(_table[i]) {
+			while(shard.table[j]) {
 
-			_Data*d=_table[i];
-			lost_strings++;
-			if (OS::get_singleton()->is_stdout_verbose()) {
+				_Data*d=shard.table[j];
+				lost_strings++;
+				if (OS::get_singleton()->is_stdout_verbose()) {
 
-				if (d->cname) {
-					print_line("Orphan StringName: "+String(d->cname));
-				} else {
-					print_line("Orphan StringName: "+String(d->name));
+					if (d->cname) {
+						print_line("Orphan StringName: "+String(d->cname));
+					} else {
+						print_line("Orphan StringName: "+String(d->name));
+					}
 				}
+
+				shard.table[j]=shard.table[j]->next;
+				memdelete(d);
 			}
+		}
 
-			_table[i]=_table[i]->next;
-			memdelete(d);
+		memdelete_arr(shard.table);
+		shard.table=NULL;
+		shard.count=0;
+		_shard_unlock(shard.mutex);
+		if (shard.mutex) {
+			memdelete(shard.mutex);
+			shard.mutex=NULL;
 		}
 	}
 	if (OS::get_singleton()->is_stdout_verbose() && lost_strings) {
 		print_line("StringName: "+itos(lost_strings)+" unclaimed string names at exit.");
 	}
-	_global_unlock();
 }
 
 void StringName::unref() {
@@ -87,23 +205,31 @@ void StringName::unref() {
 
 	if (_data && _data->refcount.unref()) {
 
-		_global_lock();
+		_Shard &shard=_get_shard(_data->hash);
+		if (!shard.table) {
+			// table already cleaned up at exit
+			_data=NULL;
+			return;
+		}
+		_shard_lock(shard.mutex);
 
 		if (_data->prev) {
 			_data->prev->next=_data->next;
 		} else {
-			if (_table[_data->idx]!=_data) {
+			uint32_t idx=_data->hash&((1<<shard.bits)-1);
+			if (shard.table[idx]!=_data) {
 				ERR_PRINT("BUG!");
 			}
-			_table[_data->idx]=_data->next;
+			shard.table[idx]=_data->next;
 		}
 
 		if (_data->next) {
 			_data->next->prev=_data->prev;
 
 		}
+		shard.count--;
+		_shard_unlock(shard.mutex);
 		memdelete(_data);
-		_global_unlock();
 	}
 
 	_data=NULL;
@@ -117,7 +243,7 @@ bool StringName::operator==(const String& p_name) const {
 		return (p_name.length()==0);
 	}
 
-	return (_data->get_name()==p_name);
+	return _name_equals(_data->cname,_data->name,p_name);
 }
 
 bool StringName::operator==(const char* p_name) const {
@@ -127,7 +253,7 @@ bool StringName::operator==(const char* p_name) const {
 		return (p_name[0]==0);
 	}
 
-	return (_data->get_name()==p_name);
+	return _name_equals(_data->cname,_data->name,p_name);
 }
 
 bool StringName::operator!=(const String& p_name) const {
@@ -186,47 +312,27 @@ StringName::StringName(const char *p_name) {
 	if (!p_name || p_name[0]==0)
 		return; //empty, ignore
 
-	_global_lock();
-
 	uint32_t hash = String::hash(p_name);
 
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_data=_table[idx];
-
-	while(_data) {
-
-		// compare hash first
-		if (_data->hash==hash && _data->get_name()==p_name)
-			break;
-		_data=_data->next;
-	}
-
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard.mutex);
 
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			_global_unlock();
-			return;
-		} else {
+	_data=_find(shard,hash,p_name);
 
-		}
+	if (_data && _data->refcount.ref()) {
+		// exists
+		_shard_unlock(shard.mutex);
+		return;
 	}
 
 	_data = memnew( _Data );
 	_data->name=p_name;
 	_data->refcount.init();
 	_data->hash=hash;
-	_data->idx=idx;
 	_data->cname=NULL;
-	_data->next=_table[idx];
-	_data->prev=NULL;
-	if (_table[idx])
-		_table[idx]->prev=_data;
-	_table[idx]=_data;
+	_insert(shard,_data);
 
-
-	_global_unlock();
+	_shard_unlock(shard.mutex);
 
 }
 
@@ -238,47 +344,27 @@ StringName::StringName(const StaticCString& p_static_string) {
 
 	ERR_FAIL_COND( !p_static_string.ptr || !p_static_string.ptr[0]);
 
-	_global_lock();
-
 	uint32_t hash = String::hash(p_static_string.ptr);
 
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_data=_table[idx];
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard.mutex);
 
-	while(_data) {
-
-		// compare hash first
-		if (_data->hash==hash && _data->get_name()==p_static_string.ptr)
-			break;
-		_data=_data->next;
-	}
+	_data=_find(shard,hash,p_static_string.ptr);
 
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			_global_unlock();
-			return;
-		} else {
-
-		}
+	if (_data && _data->refcount.ref()) {
+		// exists
+		_shard_unlock(shard.mutex);
+		return;
 	}
 
 	_data = memnew( _Data );
 
 	_data->refcount.init();
 	_data->hash=hash;
-	_data->idx=idx;
 	_data->cname=p_static_string.ptr;
-	_data->next=_table[idx];
-	_data->prev=NULL;
-	if (_table[idx])
-		_table[idx]->prev=_data;
-	_table[idx]=_data;
-
+	_insert(shard,_data);
 
-	_global_unlock();
+	_shard_unlock(shard.mutex);
 
 }
 
@@ -292,47 +378,27 @@ StringName::StringName(const String& p_name) {
 	if (p_name==String())
 		return;
 
-	_global_lock();
-
 	uint32_t hash = p_name.hash();
 
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_data=_table[idx];
-
-	while(_data) {
-
-		if (_data->hash==hash && _data->get_name()==p_name)
-			break;
-		_data=_data->next;
-	}
-
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard.mutex);
 
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			_global_unlock();
-			return;
-		} else {
+	_data=_find(shard,hash,p_name);
 
-
-		}
+	if (_data && _data->refcount.ref()) {
+		// exists
+		_shard_unlock(shard.mutex);
+		return;
 	}
 
-
 	_data = memnew( _Data );
 	_data->name=p_name;
 	_data->refcount.init();
 	_data->hash=hash;
-	_data->idx=idx;
 	_data->cname=NULL;
-	_data->next=_table[idx];
-	_data->prev=NULL;
-	if (_table[idx])
-		_table[idx]->prev=_data;
-	_table[idx]=_data;
+	_insert(shard,_data);
 
-	_global_unlock();
+	_shard_unlock(shard.mutex);
 
 }
 
@@ -344,29 +410,20 @@ StringName StringName::search(const char *p_name) {
 	if (!p_name[0])
 		return StringName();
 
-	_global_lock();
-
 	uint32_t hash = String::hash(p_name);
 
-	uint32_t idx=hash&STRING_TABLE_MASK;
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard.mutex);
 
-	_Data *_data=_table[idx];
-
-	while(_data) {
-
-		// compare hash first
-		if (_data->hash==hash && _data->get_name()==p_name)
-			break;
-		_data=_data->next;
-	}
+	_Data *_data=_find(shard,hash,p_name);
 
 	if (_data && _data->refcount.ref()) {
-		_global_unlock();
+		_shard_unlock(shard.mutex);
 		return StringName(_data);
 
 	}
 
-	_global_unlock();
+	_shard_unlock(shard.mutex);
 	return StringName(); //does not exist
 
 
@@ -380,29 +437,20 @@ StringName StringName::search(const CharType *p_name) {
 	if (!p_name[0])
 		return StringName();
 
-	_global_lock();
-
 	uint32_t hash = String::hash(p_name);
 
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_Data *_data=_table[idx];
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard.mutex);
 
-	while(_data) {
-
-		// compare hash first
-		if (_data->hash==hash && _data->get_name()==p_name)
-			break;
-		_data=_data->next;
-	}
+	_Data *_data=_find(shard,hash,p_name);
 
 	if (_data && _data->refcount.ref()) {
-		_global_unlock();
+		_shard_unlock(shard.mutex);
 		return StringName(_data);
 
 	}
 
-	_global_unlock();
+	_shard_unlock(shard.mutex);
 	return StringName(); //does not exist
 
 }
@@ -410,29 +458,20 @@ StringName StringName::search(const String &p_name) {
 
 	ERR_FAIL_COND_V( p_name=="", StringName() );
 
-	_global_lock();
-
 	uint32_t hash = p_name.hash();
 
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_Data *_data=_table[idx];
-
-	while(_data) {
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard.mutex);
 
-		// compare hash first
-		if (_data->hash==hash && p_name==_data->get_name())
-			break;
-		_data=_data->next;
-	}
+	_Data *_data=_find(shard,hash,p_name);
 
 	if (_data && _data->refcount.ref()) {
-		_global_unlock();
+		_shard_unlock(shard.mutex);
 		return StringName(_data);
 
 	}
 
-	_global_unlock();
+	_shard_unlock(shard.mutex);
 	return StringName(); //does not exist
 
 }
@@ -447,4 +486,3 @@ StringName::~StringName() {
 
 	unref();
 }
-
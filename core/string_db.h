@@ -50,9 +50,9 @@ class StringName {
 
 	enum {
 
-		STRING_TABLE_BITS=12,
-		STRING_TABLE_LEN=1<<STRING_TABLE_BITS,
-		STRING_TABLE_MASK=STRING_TABLE_LEN-1
+		STRING_TABLE_SHARD_BITS=6,
+		STRING_TABLE_SHARDS=1<<STRING_TABLE_SHARD_BITS,
+		STRING_TABLE_MIN_BITS=6
 	};
 
 	struct _Data {
@@ -61,15 +61,32 @@ class StringName {
 		String name;
 
 		String get_name() const {  return cname?String(cname):name; }
-		int idx;
 		uint32_t hash;
 		_Data *prev;
 		_Data *next;
 		_Data() { cname=NULL; next=prev=NULL; hash=0; }
 	};
 
+	// The intern table is split in shards, each with its own lock and bucket array,
+	// so threads creating unrelated names don't contend. Buckets grow with the shard.
+	struct _Shard {
 
-	static _Data *_table[STRING_TABLE_LEN];
+		Mutex *mutex;
+		_Data **table;
+		uint32_t bits;
+		uint32_t count;
+	};
+
+	static _Shard _shards[STRING_TABLE_SHARDS];
+
+	static _FORCE_INLINE_ _Shard& _get_shard(uint32_t p_hash) {
+		// hashes of short names only use the low bits, so scramble before picking a shard
+		return _shards[(p_hash*0x9E3779B1)>>(32-STRING_TABLE_SHARD_BITS)];
+	}
+
+	template<class T>
+	static _Data *_find(const _Shard& p_shard,uint32_t p_hash,const T& p_name);
+	static void _insert(_Shard& p_shard,_Data *p_data);
 
 	_Data *_data;
 
@@ -114,6 +131,11 @@ public:
 	}
 	bool operator!=(const StringName& p_name) const;
 
+	_FORCE_INLINE_ const void* data_unique_pointer() const {
+
+		return (void*)_data;
+	}
+
 	_FORCE_INLINE_ operator String() const {
 
 		if (_data) {
@@ -50,6 +50,166 @@
 #define snprintf _snprintf
 #endif
 
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define USTRING_SSE2
+#endif
+
+/* Fast paths for runs of plain ASCII, which is what most strings are made of.
+   They work 16 bytes at a time with SSE2, or a word at a time otherwise, and
+   always stop at the first character that needs the generic (slow) path. */
+
+static _FORCE_INLINE_ int _ascii_prefix(const uint8_t *p_src,int p_len) {
+
+	int i=0;
+#ifdef USTRING_SSE2
+	for(;i+16<=p_len;i+=16) {
+
+		if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)&p_src[i])))
+			break;
+	}
+#else
+	for(;i+8<=p_len;i+=8) {
+
+		uint64_t w;
+		memcpy(&w,&p_src[i],8);
+		if (w&0x8080808080808080ULL)
+			break;
+	}
+#endif
+	while(i<p_len && p_src[i]<0x80)
+		i++;
+	return i;
+}
+
+static _FORCE_INLINE_ void _widen_ascii(CharType *p_dst,const uint8_t *p_src,int p_len) {
+
+	int i=0;
+#ifdef USTRING_SSE2
+	const __m128i zero=_mm_setzero_si128();
+	for(;i+16<=p_len;i+=16) {
+
+		__m128i v=_mm_loadu_si128((const __m128i*)&p_src[i]);
+		__m128i lo=_mm_unpacklo_epi8(v,zero);
+		__m128i hi=_mm_unpackhi_epi8(v,zero);
+		if (sizeof(CharType)==2) {
+			_mm_storeu_si128((__m128i*)&p_dst[i],lo);
+			_mm_storeu_si128((__m128i*)&p_dst[i+8],hi);
+		} else {
+			_mm_storeu_si128((__m128i*)&p_dst[i],_mm_unpacklo_epi16(lo,zero));
+			_mm_storeu_si128((__m128i*)&p_dst[i+4],_mm_unpackhi_epi16(lo,zero));
+			_mm_storeu_si128((__m128i*)&p_dst[i+8],_mm_unpacklo_epi16(hi,zero));
+			_mm_storeu_si128((__m128i*)&p_dst[i+12],_mm_unpackhi_epi16(hi,zero));
+		}
+	}
+#endif
+	for(;i<p_len;i++)
+		p_dst[i]=p_src[i];
+}
+
+/* Returns how many leading characters are ASCII; if p_dst is given, they are also narrowed into it */
+static _FORCE_INLINE_ int _narrow_ascii(uint8_t *p_dst,const CharType *p_src,int p_len) {
+
+	int i=0;
+#ifdef USTRING_SSE2
+	if (sizeof(CharType)==4) {
+
+		const __m128i zero=_mm_setzero_si128();
+		const __m128i high=_mm_set1_epi32(~0x7F);
+		for(;i+16<=p_len;i+=16) {
+
+			__m128i a=_mm_loadu_si128((const __m128i*)&p_src[i]);
+			__m128i b=_mm_loadu_si128((const __m128i*)&p_src[i+4]);
+			__m128i c=_mm_loadu_si128((const __m128i*)&p_src[i+8]);
+			__m128i d=_mm_loadu_si128((const __m128i*)&p_src[i+12]);
+			__m128i any=_mm_or_si128(_mm_or_si128(a,b),_mm_or_si128(c,d));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(any,high),zero))!=0xFFFF)
+				break;
+			if (p_dst)
+				_mm_storeu_si128((__m128i*)&p_dst[i],_mm_packus_epi16(_mm_packs_epi32(a,b),_mm_packs_epi32(c,d)));
+		}
+	}
+#endif
+	for(;i<p_len && uint32_t(p_src[i])<0x80;i++) {
+		if (p_dst)
+			p_dst[i]=p_src[i];
+	}
+	return i;
+}
+
+/* Changes the case of a run of characters, ASCII is done inline and only the rest goes through the tables */
+static _FORCE_INLINE_ void _convert_case(CharType *p_dst,const CharType *p_src,int p_len,bool p_upper) {
+
+	const CharType from=p_upper?'a':'A';
+	const CharType to=p_upper?'z':'Z';
+	const CharType delta=p_upper?('A'-'a'):('a'-'A');
+
+	int i=0;
+#ifdef USTRING_SSE2
+	if (sizeof(CharType)==4) {
+
+		const __m128i zero=_mm_setzero_si128();
+		const __m128i high=_mm_set1_epi32(~0x7F);
+		const __m128i lower_bound=_mm_set1_epi32(from-1);
+		const __m128i upper_bound=_mm_set1_epi32(to+1);
+		const __m128i add=_mm_set1_epi32(delta);
+		for(;i+4<=p_len;i+=4) {
+
+			__m128i v=_mm_loadu_si128((const __m128i*)&p_src[i]);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v,high),zero))!=0xFFFF) {
+				// not all ASCII
+				for(int j=i;j<i+4;j++)
+					p_dst[j]=p_upper?_find_upper(p_src[j]):_find_lower(p_src[j]);
+				continue;
+			}
+			__m128i in_range=_mm_and_si128(_mm_cmpgt_epi32(v,lower_bound),_mm_cmplt_epi32(v,upper_bound));
+			_mm_storeu_si128((__m128i*)&p_dst[i],_mm_add_epi32(v,_mm_and_si128(in_range,add)));
+		}
+	}
+#endif
+	for(;i<p_len;i++) {
+
+		CharType c=p_src[i];
+		if (c>=from && c<=to)
+			p_dst[i]=c+delta;
+		else if (uint32_t(c)<0x80)
+			p_dst[i]=c;
+		else
+			p_dst[i]=p_upper?_find_upper(c):_find_lower(c);
+	}
+}
+
+static _FORCE_INLINE_ bool _is_case_changed(CharType p_char,bool p_upper) {
+
+	if (uint32_t(p_char)<0x80)
+		return p_upper ? (p_char>='a' && p_char<='z') : (p_char>='A' && p_char<='Z');
+	return (p_upper?_find_upper(p_char):_find_lower(p_char))!=p_char;
+}
+
+static _FORCE_INLINE_ int _find_chars(const CharType *p_src,int p_len,const CharType *p_key,int p_key_len,int p_from) {
+
+	if (p_from>p_len-p_key_len)
+		return -1;
+
+	const CharType first=p_key[0];
+	const CharType *from=&p_src[p_from];
+	const CharType *end=&p_src[p_len-p_key_len+1]; // past the last position a match can start at
+
+	while(from<end) {
+
+		from=wmemchr(from,first,end-from);
+		if (!from)
+			return -1;
+		if (wmemcmp(from+1,p_key+1,p_key_len-1)==0)
+			return from-p_src;
+		from++;
+	}
+
+	return -1;
+}
+
 /** STRING **/
 
 const char *CharString::get_data() const {
@@ -62,10 +222,7 @@ const char *CharString::get_data() const {
 
 void String::copy_from(const char *p_cstr) {
 
-	int len=0;
-	const char *ptr=p_cstr;
-	while (*(ptr++)!=0)
-		len++;
+	int len=strlen(p_cstr);
 
 	if (len==0) {
 
@@ -78,7 +235,10 @@ void String::copy_from(const char *p_cstr) {
 
 	CharType *dst = this->ptr();
 
-	for (int i=0;i<len+1;i++) {
+	int ascii=_ascii_prefix((const uint8_t*)p_cstr,len);
+	_widen_ascii(dst,(const uint8_t*)p_cstr,ascii);
+
+	for (int i=ascii;i<len+1;i++) {
 
 		dst[i]=p_cstr[i];
 	}
@@ -88,12 +248,13 @@ void String::copy_from(const char *p_cstr) {
 void String::copy_from(const CharType* p_cstr, int p_clip_to) {
 
 	int len=0;
-	const CharType *ptr=p_cstr;
-	while (*(ptr++)!=0)
-		len++;
-
-	if (p_clip_to>=0 && len>p_clip_to)
-		len=p_clip_to;
+	if (p_clip_to<0) {
+		len=wcslen(p_cstr);
+	} else {
+		// don't look past the clip, substr() and friends rely on this being cheap
+		while (len<p_clip_to && p_cstr[len]!=0)
+			len++;
+	}
 
 	if (len==0) {
 
@@ -102,15 +263,10 @@ void String::copy_from(const CharType* p_cstr, int p_clip_to) {
 	}
 
 	resize(len+1);
-	set(len,0);
-
-	CharType *dst = &operator[](0);
 
-
-	for (int i=0;i<len;i++) {
-
-		dst[i]=p_cstr[i];
-	}
+	CharType *dst = ptr();
+	memcpy(dst,p_cstr,len*sizeof(CharType));
+	dst[len]=0;
 }
 
 void String::copy_from(const CharType& p_char) {
@@ -128,19 +284,18 @@ bool String::operator==(const String& p_str) const {
 	if (empty())
 		return true;
 
-	int l=length();
-
 	const CharType *src = c_str();
 	const CharType *dst = p_str.c_str();
 
-	/* Compare char by char */
-	for (int i=0;i<l;i++) {
+	if (src==dst)
+		return true; // same shared data
 
-		if (src[i]!=dst[i])
-			return false;
-	}
+	uint32_t hash_a=_get_cache();
+	uint32_t hash_b=p_str._get_cache();
+	if (hash_a && hash_b && hash_a!=hash_b)
+		return false;
 
-	return true;
+	return wmemcmp(src,dst,length())==0;
 }
 
 bool String::operator!=(const String& p_str) const {
@@ -152,8 +307,18 @@ bool String::operator!=(const String& p_str) const {
 
 String String::operator+(const String& p_str)  const {
 
-	String res=*this;
-	res+=p_str;
+	if (p_str.empty())
+		return *this;
+	if (empty())
+		return p_str;
+
+	int len=length();
+
+	String res;
+	res.resize(len+p_str.size());
+	CharType *dst=res.ptr();
+	memcpy(dst,c_str(),len*sizeof(CharType));
+	memcpy(dst+len,p_str.c_str(),p_str.size()*sizeof(CharType));
 	return res;
 }
 
@@ -176,16 +341,13 @@ String& String::operator+=(const String &p_str) {
 		return *this;
 
 	int from=length();
+	int src_len=p_str.length(); // before resizing, p_str may be *this
 
-	resize( length() + p_str.size() );
-
-	const CharType *src = p_str.c_str();
-	CharType *dst = &operator[](0);
-
-	set( length(), 0 );
+	resize( from + src_len + 1 );
 
-	for (int i=0;i<p_str.length();i++)
-		dst[from+i]=src[i];
+	CharType *dst = ptr();
+	memcpy(&dst[from],p_str.c_str(),src_len*sizeof(CharType));
+	dst[from+src_len]=0;
 
 	return *this;
 
@@ -215,21 +377,19 @@ String& String::operator+=(const char * p_str) {
 	if (!p_str || p_str[0]==0)
 		return *this;
 
-	int src_len=0;
-	const char *ptr=p_str;
-	while (*(ptr++)!=0)
-		src_len++;
+	int src_len=strlen(p_str);
 
 	int from=length();
 
 	resize( from + src_len + 1 );
 
-	CharType *dst = &operator[](0);
+	CharType *dst = &ptr()[from];
 
-	set( length(), 0 );
+	int ascii=_ascii_prefix((const uint8_t*)p_str,src_len);
+	_widen_ascii(dst,(const uint8_t*)p_str,ascii);
 
-	for (int i=0;i<src_len;i++)
-		dst[from+i]=p_str[i];
+	for (int i=ascii;i<src_len+1;i++)
+		dst[i]=p_str[i];
 
 	return *this;
 
@@ -808,28 +968,36 @@ CharType String::char_lowercase(CharType p_char){
 }
 
 
-String String::to_upper() const {
+String String::_change_case(bool p_upper) const {
 
-	String upper=*this;
+	int len=length();
+	const CharType *src=c_str();
 
-	for(int i=0;i<upper.size();i++) {
+	int first=0;
+	while(first<len && !_is_case_changed(src[first],p_upper))
+		first++;
 
-		upper[i]=_find_upper(upper[i]);
-	}
+	if (first==len)
+		return *this; // nothing changes, share the data
 
-	return upper;
-}
+	String res;
+	res.resize(len+1);
+	CharType *dst=res.ptr();
+	memcpy(dst,src,first*sizeof(CharType));
+	_convert_case(&dst[first],&src[first],len-first,p_upper);
+	dst[len]=0;
 
-String String::to_lower() const {
+	return res;
+}
 
-	String upper=*this;
+String String::to_upper() const {
 
-	for(int i=0;i<upper.size();i++) {
+	return _change_case(true);
+}
 
-		upper[i]=_find_lower(upper[i]);
-	}
+String String::to_lower() const {
 
-	return upper;
+	return _change_case(false);
 }
 
 int String::length() const {
@@ -843,7 +1011,7 @@ const CharType * String::c_str() const {
 
 	static const CharType zero=0;
 
-	return size()?&operator[](0):&zero;
+	return size()?ptr():&zero;
 }
 
 String String::md5(const uint8_t *p_md5) {
@@ -1297,14 +1465,31 @@ bool String::parse_utf8(const char* p_utf8,int p_len) {
 		}
 	}
 
+	/* the data ends at p_len or at the first zero, whichever comes first */
+	if (p_len<0) {
+		p_len=strlen(p_utf8);
+	} else {
+		const char *end=(const char*)memchr(p_utf8,0,p_len);
+		if (end)
+			p_len=end-p_utf8;
+	}
+
 	{
 		const char *ptrtmp=p_utf8;
 		const char *ptrtmp_limit=&p_utf8[p_len];
 		int skip=0;
-		while (ptrtmp!=ptrtmp_limit && *ptrtmp) {
+		while (ptrtmp!=ptrtmp_limit) {
 
 			if (skip==0) {
 
+				int ascii=_ascii_prefix((const uint8_t*)ptrtmp,ptrtmp_limit-ptrtmp);
+				if (ascii) {
+					str_size+=ascii;
+					cstr_size+=ascii;
+					ptrtmp+=ascii;
+					continue;
+				}
+
 				uint8_t c = *ptrtmp;
 
 				/* Determine the number of characters in sequence */
@@ -1361,6 +1546,14 @@ bool String::parse_utf8(const char* p_utf8,int p_len) {
 
 	while (cstr_size) {
 
+		int ascii=_ascii_prefix((const uint8_t*)p_utf8,cstr_size);
+		if (ascii) {
+			_widen_ascii(dst,(const uint8_t*)p_utf8,ascii);
+			dst+=ascii;
+			cstr_size-=ascii;
+			p_utf8+=ascii;
+			continue;
+		}
 
 		int len=0;
 
@@ -1440,10 +1633,17 @@ CharString String::utf8() const {
 	if (!l)
 		return CharString();
 
-	const CharType *d=&operator[](0);
+	const CharType *d=ptr();
 	int fl=0;
 	for (int i=0;i<l;i++) {
 
+		int ascii=_narrow_ascii(NULL,&d[i],l-i);
+		if (ascii) {
+			fl+=ascii;
+			i+=ascii-1;
+			continue;
+		}
+
 		uint32_t c=d[i];
 		if (c <= 0x7f) // 7 bits.
 			fl+=1;
@@ -1474,6 +1674,13 @@ CharString String::utf8() const {
 
 	for (int i=0;i<l;i++) {
 
+		int ascii=_narrow_ascii(cdst,&d[i],l-i);
+		if (ascii) {
+			cdst+=ascii;
+			i+=ascii-1;
+			continue;
+		}
+
 		uint32_t c=d[i];
 
 		if (c <= 0x7f) // 7 bits.
@@ -2349,15 +2556,21 @@ uint32_t String::hash(const CharType* p_cstr) {
 
 uint32_t String::hash() const {
 
+	/* cached with the (shared) data, zero means not computed yet */
+	uint32_t hashv = _get_cache();
+	if (hashv)
+		return hashv;
+
 	/* simple djb2 hashing */
 
 	const CharType * chr = c_str();
-	uint32_t hashv = 5381;
 	uint32_t c;
+	hashv = 5381;
 
 	while ((c = *chr++))
 		hashv = ((hashv << 5) + hashv) + c; /* hash * 33 + c */
 
+	_set_cache(hashv);
 	return hashv;
 
 
@@ -2464,6 +2677,9 @@ String String::substr(int p_from,int p_chars) const{
 		p_chars=length()-p_from;
 	}
 
+	if (p_from==0 && p_chars==length())
+		return *this;
+
 	return String(&c_str()[p_from],p_chars);
 
 }
@@ -2494,33 +2710,7 @@ int String::find(String p_str,int p_from) const {
 		return -1; //wont find anything!
 
 
-	const CharType *src = c_str();
-
-	for (int i=p_from;i<=(len-src_len);i++) {
-
-		bool found=true;
-		for (int j=0;j<src_len;j++) {
-
-			int read_pos=i+j;
-
-			if (read_pos>=len) {
-
-				ERR_PRINT("read_pos>=len");
-				return -1;
-			};
-
-
-			if (src[read_pos]!=p_str[j]) {
-				found=false;
-				break;
-			}
-		}
-
-		if (found)
-			return i;
-	}
-
-	return -1;
+	return _find_chars(c_str(),len,p_str.c_str(),src_len,p_from);
 }
 
 int String::findmk(const Vector<String>& p_keys,int p_from,int *r_key) const {
@@ -2902,18 +3092,44 @@ bool String::matchn(const String& p_wildcard) const {
 
 String String::replace(String p_key,String p_with) const {
 
+	int len=length();
+	int key_len=p_key.length();
+	if (key_len==0 || key_len>len)
+		return *this;
+
+	const CharType *src=c_str();
+	const CharType *key=p_key.c_str();
+
+	/* count first, so the result is allocated only once */
+	int count=0;
+	for(int pos=_find_chars(src,len,key,key_len,0);pos>=0;pos=_find_chars(src,len,key,key_len,pos+key_len))
+		count++;
+
+	if (count==0)
+		return *this;
+
+	int with_len=p_with.length();
+	int new_len=len+count*(with_len-key_len);
+	if (new_len==0)
+		return String();
+
 	String new_string;
-	int search_from=0;
-	int result=0;
+	new_string.resize(new_len+1);
+	CharType *dst=new_string.ptr();
+	const CharType *with=p_with.c_str();
 
-	while( (result=find(p_key,search_from))>=0 ) {
+	int search_from=0;
+	for(int pos=_find_chars(src,len,key,key_len,0);pos>=0;pos=_find_chars(src,len,key,key_len,pos+key_len)) {
 
-		new_string+=substr(search_from,result-search_from);
-		new_string+=p_with;
-		search_from=result+p_key.length();
+		memcpy(dst,&src[search_from],(pos-search_from)*sizeof(CharType));
+		dst+=pos-search_from;
+		memcpy(dst,with,with_len*sizeof(CharType));
+		dst+=with_len;
+		search_from=pos+key_len;
 	}
 
-	new_string+=substr(search_from,length()-search_from);
+	memcpy(dst,&src[search_from],(len-search_from)*sizeof(CharType));
+	dst[len-search_from]=0;
 
 	return new_string;
 }
@@ -65,6 +65,7 @@ class String : public Vector<CharType> {
 	void copy_from(const CharType* p_cstr, int p_clip_to=-1);
 	void copy_from(const CharType& p_char);
 	bool _base_is_subsequence_of(const String& p_string, bool case_insensitive) const;
+	String _change_case(bool p_upper) const;
 
 
 public:
@@ -74,6 +75,8 @@ public:
 		npos=-1 ///<for "some" compatibility with std::string (npos is a huge value in std::string)
 	};
 
+	_FORCE_INLINE_ Error resize(int p_size) { MemoryCategoryScope scope(Memory::ALLOC_STRING); return Vector<CharType>::resize(p_size); }
+
 
 	bool operator==(const String& p_str) const;
 	bool operator!=(const String& p_str) const;
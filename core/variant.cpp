@@ -952,6 +952,8 @@ void Variant::reference(const Variant& p_variant) {
 	if (this == &p_variant)
 		return;
 
+	MemoryCategoryScope scope(Memory::ALLOC_VARIANT);
+
 	clear();
 
 	type=p_variant.type;
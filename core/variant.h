@@ -367,6 +367,12 @@ public:
 		return res;
 	}
 
+	/* fast paths for the most common operand types, they return false (leaving r_ret untouched)
+	   when the operand types or the operator are not handled, so evaluate() must be used instead */
+	static _FORCE_INLINE_ bool evaluate_int(const Operator& p_op,const Variant& p_a, const Variant& p_b,Variant &r_ret);
+	static _FORCE_INLINE_ bool evaluate_real(const Operator& p_op,const Variant& p_a, const Variant& p_b,Variant &r_ret);
+	static _FORCE_INLINE_ bool evaluate_vector2(const Operator& p_op,const Variant& p_a, const Variant& p_b,Variant &r_ret);
+
 	void zero();
 	static void blend(const Variant& a, const Variant& b, float c,Variant &r_dst);
 	static void interpolate(const Variant& a, const Variant& b, float c,Variant &r_dst);
@@ -393,6 +399,11 @@ public:
 
 	static Variant construct(const Variant::Type,const Variant** p_args,int p_argcount,CallError &r_error,bool p_strict=true);
 
+#ifdef PTRCALL_ENABLED
+	const void* get_ptrcall_arg() const; //pointer to the value as MethodBind::ptrcall expects it, NULL for objects
+	void* get_ptrcall_ret(Type p_type); //make this a default p_type and return where ptrcall must write it, NULL for objects
+#endif
+
 	void get_method_list(List<MethodInfo> *p_list) const;
 	bool has_method(const StringName& p_method) const;
 	static Vector<Variant::Type> get_method_argument_types(Variant::Type p_type,const StringName& p_method);
@@ -469,6 +480,134 @@ const Variant::ObjData& Variant::_get_obj() const {
 	return *reinterpret_cast<const ObjData*>(&_data._mem[0]);
 }
 
+// writing in place avoids a clear() when the destination already holds the type, which is the norm in loops
+#define _VARIANT_SET_FAST(m_ret,m_type,m_field,m_value)\
+	if (m_ret.type==m_type) { m_ret._data.m_field=m_value; } else { m_ret=m_value; }
+
+bool Variant::evaluate_int(const Operator& p_op,const Variant& p_a, const Variant& p_b,Variant &r_ret) {
+
+	if (p_a.type!=INT || p_b.type!=INT)
+		return false;
+
+	int a=p_a._data._int;
+	int b=p_b._data._int;
+	int res;
+
+	switch(p_op) {
+
+		case OP_ADD: res=a+b; break;
+		case OP_SUBSTRACT: res=a-b; break;
+		case OP_MULTIPLY: res=a*b; break;
+		case OP_DIVIDE: if (b==0) return false; res=a/b; break; // let evaluate() report it
+		case OP_MODULE: if (b==0) return false; res=a%b; break;
+		case OP_SHIFT_LEFT: res=a<<b; break;
+		case OP_SHIFT_RIGHT: res=a>>b; break;
+		case OP_BIT_AND: res=a&b; break;
+		case OP_BIT_OR: res=a|b; break;
+		case OP_BIT_XOR: res=a^b; break;
+		case OP_EQUAL: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a==b)); return true;
+		case OP_NOT_EQUAL: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a!=b)); return true;
+		case OP_LESS: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a<b)); return true;
+		case OP_LESS_EQUAL: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a<=b)); return true;
+		case OP_GREATER: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a>b)); return true;
+		case OP_GREATER_EQUAL: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a>=b)); return true;
+		default: return false;
+	}
+
+	_VARIANT_SET_FAST(r_ret,INT,_int,res);
+	return true;
+}
+
+bool Variant::evaluate_real(const Operator& p_op,const Variant& p_a, const Variant& p_b,Variant &r_ret) {
+
+	double a,b;
+
+	if (p_a.type==REAL) {
+		a=p_a._data._real;
+		if (p_b.type==REAL)
+			b=p_b._data._real;
+		else if (p_b.type==INT)
+			b=p_b._data._int;
+		else
+			return false;
+	} else if (p_a.type==INT && p_b.type==REAL) {
+		a=p_a._data._int;
+		b=p_b._data._real;
+	} else {
+		return false;
+	}
+
+	double res;
+
+	switch(p_op) {
+
+		case OP_ADD: res=a+b; break;
+		case OP_SUBSTRACT: res=a-b; break;
+		case OP_MULTIPLY: res=a*b; break;
+		case OP_DIVIDE: res=a/b; break;
+		case OP_EQUAL: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a==b)); return true;
+		case OP_NOT_EQUAL: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a!=b)); return true;
+		case OP_LESS: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a<b)); return true;
+		case OP_LESS_EQUAL: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a<=b)); return true;
+		case OP_GREATER: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a>b)); return true;
+		case OP_GREATER_EQUAL: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a>=b)); return true;
+		default: return false;
+	}
+
+	_VARIANT_SET_FAST(r_ret,REAL,_real,res);
+	return true;
+}
+
+bool Variant::evaluate_vector2(const Operator& p_op,const Variant& p_a, const Variant& p_b,Variant &r_ret) {
+
+	Vector2 res;
+
+	if (p_a.type==VECTOR2) {
+
+		const Vector2 &a=*reinterpret_cast<const Vector2*>(p_a._data._mem);
+
+		if (p_b.type==VECTOR2) {
+
+			const Vector2 &b=*reinterpret_cast<const Vector2*>(p_b._data._mem);
+			switch(p_op) {
+				case OP_ADD: res=a+b; break;
+				case OP_SUBSTRACT: res=a-b; break;
+				case OP_MULTIPLY: res=a*b; break;
+				case OP_DIVIDE: res=a/b; break;
+				case OP_EQUAL: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a==b)); return true;
+				case OP_NOT_EQUAL: _VARIANT_SET_FAST(r_ret,BOOL,_bool,(a!=b)); return true;
+				default: return false;
+			}
+		} else if (p_b.type==REAL || p_b.type==INT) {
+
+			real_t b = p_b.type==REAL ? real_t(p_b._data._real) : real_t(p_b._data._int);
+			switch(p_op) {
+				case OP_MULTIPLY: res=a*b; break;
+				case OP_DIVIDE: res=a/b; break;
+				default: return false;
+			}
+		} else {
+			return false;
+		}
+
+	} else if (p_b.type==VECTOR2 && p_op==OP_MULTIPLY && (p_a.type==REAL || p_a.type==INT)) {
+
+		real_t a = p_a.type==REAL ? real_t(p_a._data._real) : real_t(p_a._data._int);
+		res=a * *reinterpret_cast<const Vector2*>(p_b._data._mem);
+
+	} else {
+		return false;
+	}
+
+	if (r_ret.type==VECTOR2)
+		*reinterpret_cast<Vector2*>(r_ret._data._mem)=res;
+	else
+		r_ret=res;
+	return true;
+}
+
+#undef _VARIANT_SET_FAST
+
 
 String vformat(const String& p_text, const Variant& p1=Variant(),const Variant& p2=Variant(),const Variant& p3=Variant(),const Variant& p4=Variant(),const Variant& p5=Variant());
 #endif
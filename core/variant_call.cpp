@@ -625,7 +625,7 @@ static void _call_##m_type##_##m_method(Variant& r_ret,Variant& p_self,const Var
 	VCALL_PTR1R(Image,save_png);
 	VCALL_PTR3(Image,brush_transfer);
 	VCALL_PTR1R(Image,get_rect);
-	VCALL_PTR1R(Image,compressed);
+	VCALL_PTR2R(Image,compressed);
 	VCALL_PTR0R(Image,decompressed);
 	VCALL_PTR3R(Image, resized);
 	VCALL_PTR0R(Image, get_data);
@@ -1150,6 +1150,45 @@ Variant Variant::construct(const Variant::Type p_type, const Variant** p_args, i
 	return Variant();
 }
 
+#ifdef PTRCALL_ENABLED
+
+const void* Variant::get_ptrcall_arg() const {
+
+	switch(type) {
+
+		case NIL: return this; // taken as a Variant argument
+		case BOOL: return &_data._bool;
+		case INT: return &_data._int;
+		case REAL: return &_data._real;
+		case MATRIX32:
+		case _AABB:
+		case MATRIX3:
+		case TRANSFORM:
+		case IMAGE:
+		case INPUT_EVENT: return _data._ptr;
+		case OBJECT: return NULL; // needs a checked cast to the argument class
+		default: return _data._mem;
+	}
+}
+
+void* Variant::get_ptrcall_ret(Type p_type) {
+
+	if (p_type==OBJECT)
+		return NULL;
+	if (p_type==NIL)
+		return this; // returned as a Variant
+
+	if (type!=p_type) {
+		CallError ce;
+		*this=construct(p_type,NULL,0,ce);
+	}
+
+	return const_cast<void*>(get_ptrcall_arg());
+}
+
+#endif
+
+
 
 bool Variant::has_method(const StringName& p_method) const {
 
@@ -1534,7 +1573,7 @@ _VariantCall::addfunc(Variant::m_vtype,Variant::m_ret,_SCS(#m_method),VCALL(m_cl
 	ADDFUNC3(IMAGE, NIL, Image, brush_transfer, IMAGE, "src", IMAGE, "brush", VECTOR2, "pos", varray(0));
 	ADDFUNC0(IMAGE, RECT2, Image, get_used_rect, varray(0));
 	ADDFUNC1(IMAGE, IMAGE, Image, get_rect, RECT2, "area", varray(0));
-	ADDFUNC1(IMAGE, IMAGE, Image, compressed, INT, "format", varray(0));
+	ADDFUNC2(IMAGE, IMAGE, Image, compressed, INT, "format", INT, "quality", varray(0,Image::COMPRESS_QUALITY_FAST));
 	ADDFUNC0(IMAGE, IMAGE, Image, decompressed, varray(0));
 	ADDFUNC3(IMAGE, IMAGE, Image, resized, INT, "x", INT, "y", INT, "interpolation", varray(((int)Image::INTERPOLATE_BILINEAR)));
 	ADDFUNC0(IMAGE, RAW_ARRAY, Image, get_data, varray());
@@ -1793,6 +1832,10 @@ _VariantCall::addfunc(Variant::m_vtype,Variant::m_ret,_SCS(#m_method),VCALL(m_cl
 	_VariantCall::add_constant(Variant::IMAGE,"COMPRESS_PVRTC4",Image::COMPRESS_PVRTC4);
 	_VariantCall::add_constant(Variant::IMAGE,"COMPRESS_ETC",Image::COMPRESS_ETC);
 
+	_VariantCall::add_constant(Variant::IMAGE,"COMPRESS_QUALITY_FAST",Image::COMPRESS_QUALITY_FAST);
+	_VariantCall::add_constant(Variant::IMAGE,"COMPRESS_QUALITY_NORMAL",Image::COMPRESS_QUALITY_NORMAL);
+	_VariantCall::add_constant(Variant::IMAGE,"COMPRESS_QUALITY_HIGH",Image::COMPRESS_QUALITY_HIGH);
+
 	_VariantCall::add_constant(Variant::IMAGE,"FORMAT_GRAYSCALE",Image::FORMAT_GRAYSCALE);
 	_VariantCall::add_constant(Variant::IMAGE,"FORMAT_INTENSITY",Image::FORMAT_INTENSITY);
 	_VariantCall::add_constant(Variant::IMAGE,"FORMAT_GRAYSCALE_ALPHA",Image::FORMAT_GRAYSCALE_ALPHA);
@@ -221,6 +221,9 @@ void Variant::evaluate(const Operator& p_op, const Variant& p_a, const Variant&
 
 	r_valid=true;
 
+	if (evaluate_int(p_op,p_a,p_b,r_ret) || evaluate_real(p_op,p_a,p_b,r_ret))
+		return;
+
 	switch(p_op) {
 
 		case OP_EQUAL: {
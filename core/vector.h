@@ -44,6 +44,11 @@ class Vector {
 
 	mutable T* _ptr;
 
+	/* memory layout: refcount, cache word, (unused), size, then the elements (16 bytes aligned) */
+	enum {
+		DATA_OFFSET=16
+	};
+
  	// internal helpers
 
  	_FORCE_INLINE_ SafeRefCount* _get_refcount() const  {
@@ -51,7 +56,7 @@ class Vector {
 		if (!_ptr)
  			return NULL;
 
-		return reinterpret_cast<SafeRefCount*>((uint8_t*)_ptr-sizeof(int)-sizeof(SafeRefCount));
+		return reinterpret_cast<SafeRefCount*>((uint8_t*)_ptr-DATA_OFFSET);
  	}
 
 	_FORCE_INLINE_ int* _get_size() const  {
@@ -70,8 +75,8 @@ class Vector {
  	}
 
 	_FORCE_INLINE_ size_t _get_alloc_size(size_t p_elements) const {
-		//return nearest_power_of_2_templated(p_elements*sizeof(T)+sizeof(SafeRefCount)+sizeof(int));
-		return nearest_power_of_2(p_elements*sizeof(T)+sizeof(SafeRefCount)+sizeof(int));
+		//return nearest_power_of_2_templated(p_elements*sizeof(T)+DATA_OFFSET);
+		return nearest_power_of_2(p_elements*sizeof(T)+DATA_OFFSET);
 	}
 
 	_FORCE_INLINE_ bool _get_alloc_size_checked(size_t p_elements, size_t *out) const {
@@ -79,7 +84,7 @@ class Vector {
 		size_t o;
 		size_t p;
 		if (_mul_overflow(p_elements, sizeof(T), &o)) return false;
-		if (_add_overflow(o, sizeof(SafeRefCount)+sizeof(int), &p)) return false;
+		if (_add_overflow(o, DATA_OFFSET, &p)) return false;
 		*out = nearest_power_of_2(p);
 		return true;
 #else
@@ -90,10 +95,27 @@ class Vector {
 #endif
 	}
 
+	_FORCE_INLINE_ static T* _init_header(void *p_mem,int p_size) {
+
+		SafeRefCount *refcount=(SafeRefCount*)p_mem;
+		refcount->init();
+		*(uint32_t*)((uint8_t*)p_mem+sizeof(SafeRefCount))=0;
+		T* data=(T*)((uint8_t*)p_mem+DATA_OFFSET);
+		*((int*)data-1)=p_size;
+		return data;
+	}
+
 	void _unref(void *p_data);
 
 	void _copy_from(const Vector& p_from);
 	void _copy_on_write();
+protected:
+
+	/* A word stored with the (shared) data, for derived classes to cache something computed
+	   from it, like String does with its hash. Reset to zero whenever the data is written. */
+	_FORCE_INLINE_ uint32_t _get_cache() const { return _ptr ? *(const volatile uint32_t*)((uint8_t*)_ptr-DATA_OFFSET+sizeof(SafeRefCount)) : 0; }
+	_FORCE_INLINE_ void _set_cache(uint32_t p_value) const { if (_ptr) *(volatile uint32_t*)((uint8_t*)_ptr-DATA_OFFSET+sizeof(SafeRefCount))=p_value; }
+
 public:
 
 
@@ -190,14 +212,14 @@ void Vector<T>::_unref(void *p_data) {
 	if (!p_data)
 		return;
 
-	SafeRefCount *src = reinterpret_cast<SafeRefCount*>((uint8_t*)p_data-sizeof(int)-sizeof(SafeRefCount));
+	SafeRefCount *src = reinterpret_cast<SafeRefCount*>((uint8_t*)p_data-DATA_OFFSET);
 
 	if (!src->unref())
 		return; // still in use
 	// clean up
 
-	int *count = (int*)(src+1);
-	T *data = (T*)(count+1);
+	int *count = (int*)((uint8_t*)p_data-sizeof(int));
+	T *data = (T*)p_data;
 
 	for (int i=0;i<*count;i++) {
 		// call destructors
@@ -205,7 +227,7 @@ void Vector<T>::_unref(void *p_data) {
 	}
 
 	// free mem
-	memfree((uint8_t*)p_data-sizeof(int)-sizeof(SafeRefCount));
+	memfree((uint8_t*)p_data-DATA_OFFSET);
 
 }
 
@@ -217,22 +239,21 @@ void Vector<T>::_copy_on_write() {
 
 	if (_get_refcount()->get() > 1 ) {
 		/* in use by more than me */
-		void* mem_new = memalloc(_get_alloc_size(*_get_size()));
-		SafeRefCount *src_new=(SafeRefCount *)mem_new;
-		src_new->init();
-		int * _size = (int*)(src_new+1);
-		*_size=*_get_size();
-
-		T*_data=(T*)(_size+1);
+		int size=*_get_size();
+		void* mem_new = memalloc(_get_alloc_size(size));
+		T*_data=_init_header(mem_new,size);
 
 		// initialize new elements
-		for (int i=0;i<*_size;i++) {
+		for (int i=0;i<size;i++) {
 
 			memnew_placement(&_data[i], T( _get_data()[i] ) );
 		}
 
 		_unref(_ptr);
 		_ptr=_data;
+	} else {
+
+		_set_cache(0); // about to be written
 	}
 
 }
@@ -270,26 +291,39 @@ Error Vector<T>::resize(int p_size) {
 		return OK;
 	}
 
-	// possibly changing size, copy on write
-	_copy_on_write();
-
 	size_t alloc_size;
 	ERR_FAIL_COND_V(!_get_alloc_size_checked(p_size, &alloc_size), ERR_OUT_OF_MEMORY);
 
+	if (_ptr && _get_refcount()->get() > 1) {
+
+		// shared, copy only what is kept, straight into a buffer of the new size
+		int keep=MIN(p_size,size());
+		void* ptr=memalloc(alloc_size);
+		ERR_FAIL_COND_V( !ptr ,ERR_OUT_OF_MEMORY);
+		T* data=_init_header(ptr,keep);
+		for (int i=0;i<keep;i++) {
+
+			memnew_placement(&data[i], T( _get_data()[i] ) );
+		}
+		_unref(_ptr);
+		_ptr=data;
+	} else {
+
+		_set_cache(0);
+	}
+
 	if (p_size>size()) {
 
-		if (size()==0) {
+		if (!_ptr) {
 			// alloc from scratch
 			void* ptr=memalloc(alloc_size);
 			ERR_FAIL_COND_V( !ptr ,ERR_OUT_OF_MEMORY);
-			_ptr=(T*)((uint8_t*)ptr+sizeof(int)+sizeof(SafeRefCount));
-			_get_refcount()->init(); // init refcount
-			*_get_size()=0; // init size (currently, none)
+			_ptr=_init_header(ptr,0);
 
-		} else {
-			void *_ptrnew = (T*)memrealloc((uint8_t*)_ptr-sizeof(int)-sizeof(SafeRefCount), alloc_size);
+		} else if (_get_alloc_size(size())!=alloc_size) {
+			void *_ptrnew = (T*)memrealloc((uint8_t*)_ptr-DATA_OFFSET, alloc_size);
 			ERR_FAIL_COND_V( !_ptrnew ,ERR_OUT_OF_MEMORY);
-			_ptr=(T*)((uint8_t*)_ptrnew+sizeof(int)+sizeof(SafeRefCount));
+			_ptr=(T*)((uint8_t*)_ptrnew+DATA_OFFSET);
 		}
 
 		// construct the newly created elements
@@ -311,10 +345,12 @@ Error Vector<T>::resize(int p_size) {
 			t->~T();
 		}
 
-		void *_ptrnew = (T*)memrealloc((uint8_t*)_ptr-sizeof(int)-sizeof(SafeRefCount), alloc_size);
-		ERR_FAIL_COND_V( !_ptrnew ,ERR_OUT_OF_MEMORY);
+		if (_get_alloc_size(size())!=alloc_size) {
+			void *_ptrnew = (T*)memrealloc((uint8_t*)_ptr-DATA_OFFSET, alloc_size);
+			ERR_FAIL_COND_V( !_ptrnew ,ERR_OUT_OF_MEMORY);
 
-		_ptr=(T*)((uint8_t*)_ptrnew+sizeof(int)+sizeof(SafeRefCount));
+			_ptr=(T*)((uint8_t*)_ptrnew+DATA_OFFSET);
+		}
 
 		*_get_size()=p_size;
 
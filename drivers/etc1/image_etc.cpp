@@ -31,6 +31,7 @@
 #include "rg_etc1.h"
 #include "print_string.h"
 #include "os/copymem.h"
+#include "os/worker_thread_pool.h"
 static void _decompress_etc(Image *p_img) {
 
 	ERR_FAIL_COND(p_img->get_format()!=Image::FORMAT_ETC);
@@ -100,7 +101,71 @@ static void _decompress_etc(Image *p_img) {
 
 }
 
-static void _compress_etc(Image *p_img) {
+enum {
+	BLOCKS_PER_CHUNK=64 // blocks given to a thread at once
+};
+
+struct ETCJob {
+
+	const uint8_t *src;
+	uint8_t *dst;
+	int width,height;
+	rg_etc1::etc1_quality quality;
+};
+
+static void _compress_etc_block_rows(void *p_userdata,int p_from,int p_to) {
+
+	const ETCJob *job=(const ETCJob*)p_userdata;
+	int imgw=job->width;
+	int imgh=job->height;
+	int bw=MAX(imgw/4,1);
+
+	rg_etc1::etc1_pack_params pp; // per thread, blocks are packed independently
+	pp.m_quality=job->quality;
+
+	const uint8_t *src=job->src;
+	uint8_t *dst=&job->dst[p_from*bw*8];
+
+	for(int y=p_from;y<p_to;y++) {
+
+		for(int x=0;x<bw;x++) {
+
+			uint8_t block[4*4*4];
+			zeromem(block,4*4*4);
+			uint8_t cblock[8];
+
+			int maxy = MIN(imgh,4);
+			int maxx = MIN(imgw,4);
+
+
+			for(int yy=0;yy<maxy;yy++) {
+
+				for(int xx=0;xx<maxx;xx++) {
+
+
+					uint32_t dst_ofs = (yy*4+xx)*4;
+					uint32_t src_ofs = ((y*4+yy)*imgw+x*4+xx)*3;
+					block[dst_ofs+0]=src[src_ofs+0];
+					block[dst_ofs+1]=src[src_ofs+1];
+					block[dst_ofs+2]=src[src_ofs+2];
+					block[dst_ofs+3]=255;
+
+				}
+			}
+
+			rg_etc1::pack_etc1_block(cblock, (const unsigned int*)block, pp);
+			for(int j=0;j<8;j++) {
+
+				dst[j]=cblock[j];
+			}
+
+			dst+=8;
+		}
+
+	}
+}
+
+static void _compress_etc(Image *p_img,Image::CompressQuality p_quality) {
 
 	Image img = *p_img;
 
@@ -123,62 +188,34 @@ static void _compress_etc(Image *p_img) {
 
 	int mc=0;
 
+	WorkerThreadPool *pool=WorkerThreadPool::get_singleton();
+
+	ETCJob job;
+	switch(p_quality) {
+		case Image::COMPRESS_QUALITY_HIGH: job.quality=rg_etc1::cHighQuality; break;
+		case Image::COMPRESS_QUALITY_NORMAL: job.quality=rg_etc1::cMediumQuality; break;
+		default: job.quality=rg_etc1::cLowQuality;
+	}
 
-	rg_etc1::etc1_pack_params pp;
-	pp.m_quality=rg_etc1::cLowQuality;
 	for(int i=0;i<=mmc;i++) {
 
 
 		int bw=MAX(imgw/4,1);
 		int bh=MAX(imgh/4,1);
-		const uint8_t *src = &r[img.get_mipmap_offset(i)];
 		int mmsize = MAX(bw,1)*MAX(bh,1)*8;
 		dst_data.resize(dst_data.size()+mmsize);
 		DVector<uint8_t>::Write w=dst_data.write();
-		uint8_t *dst = &w[dst_data.size()-mmsize];
-
-
-//		print_line("bh: "+itos(bh)+" bw: "+itos(bw));
-
-		for(int y=0;y<bh;y++) {
-
-			for(int x=0;x<bw;x++) {
-
-//				print_line("x: "+itos(x)+" y: "+itos(y));
-
-				uint8_t block[4*4*4];
-				zeromem(block,4*4*4);
-				uint8_t cblock[8];
 
-				int maxy = MIN(imgh,4);
-				int maxx = MIN(imgw,4);
-
-
-				for(int yy=0;yy<maxy;yy++) {
+		job.src=&r[img.get_mipmap_offset(i)];
+		job.dst=&w[dst_data.size()-mmsize];
+		job.width=imgw;
+		job.height=imgh;
 
-					for(int xx=0;xx<maxx;xx++) {
-
-
-						uint32_t dst_ofs = (yy*4+xx)*4;
-						uint32_t src_ofs = ((y*4+yy)*imgw+x*4+xx)*3;
-						block[dst_ofs+0]=src[src_ofs+0];
-						block[dst_ofs+1]=src[src_ofs+1];
-						block[dst_ofs+2]=src[src_ofs+2];
-						block[dst_ofs+3]=255;
-
-					}
-				}
-
-				rg_etc1::pack_etc1_block(cblock, (const unsigned int*)block, pp);
-				for(int j=0;j<8;j++) {
-
-					dst[j]=cblock[j];
-				}
-
-				dst+=8;
-			}
-
-		}
+		int grain=MAX(1,BLOCKS_PER_CHUNK/bw);
+		if (pool && bh>grain)
+			pool->parallel_for(bh,_compress_etc_block_rows,&job,grain);
+		else
+			_compress_etc_block_rows(&job,0,bh);
 
 		imgw=MAX(1,imgw/2);
 		imgh=MAX(1,imgh/2);
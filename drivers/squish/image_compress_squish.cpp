@@ -29,8 +29,33 @@
 #include "image_compress_squish.h"
 #include "squish/squish.h"
 #include "print_string.h"
+#include "os/worker_thread_pool.h"
 
-void image_compress_squish(Image *p_image) {
+enum {
+	BLOCKS_PER_CHUNK=256 // blocks given to a thread at once
+};
+
+struct SquishJob {
+
+	const uint8_t *src;
+	uint8_t *dst;
+	int width,height;
+	int block_size;
+	int flags;
+};
+
+static void _compress_block_rows(void *p_userdata,int p_from,int p_to) {
+
+	// blocks don't depend on each other, so a strip of block rows compresses to exactly
+	// the same bytes it would as part of the whole image
+	const SquishJob *job=(const SquishJob*)p_userdata;
+	int blocks_w=(job->width+3)/4;
+	int rows=MIN(p_to*4,job->height)-p_from*4;
+
+	squish::CompressImage( &job->src[p_from*4*job->width*4],job->width,rows,&job->dst[p_from*blocks_w*job->block_size],job->flags);
+}
+
+void image_compress_squish(Image *p_image,Image::CompressQuality p_quality) {
 
 	int w=p_image->get_width();
 	int h=p_image->get_height();
@@ -47,7 +72,12 @@ void image_compress_squish(Image *p_image) {
 		return; //do not compress, already compressed
 
 	int shift=0;
-	int squish_comp=squish::kColourRangeFit;
+	int squish_comp;
+	switch(p_quality) {
+		case Image::COMPRESS_QUALITY_HIGH: squish_comp=squish::kColourIterativeClusterFit; break;
+		case Image::COMPRESS_QUALITY_NORMAL: squish_comp=squish::kColourClusterFit; break;
+		default: squish_comp=squish::kColourRangeFit;
+	}
 	Image::Format target_format;
 
 	if (p_image->get_format()==Image::FORMAT_GRAYSCALE_ALPHA) {
@@ -73,13 +103,30 @@ void image_compress_squish(Image *p_image) {
 
 	int dst_ofs=0;
 
+	WorkerThreadPool *pool=WorkerThreadPool::get_singleton();
+
 	for(int i=0;i<=mm_count;i++) {
 
-		int src_ofs = p_image->get_mipmap_offset(i);
-		squish::CompressImage( &rb[src_ofs],w,h,&wb[dst_ofs],squish_comp);
+		SquishJob job;
+		job.src=&rb[p_image->get_mipmap_offset(i)];
+		job.dst=&wb[dst_ofs];
+		job.width=w;
+		job.height=h;
+		job.block_size=shift?8:16;
+		job.flags=squish_comp;
+
+		int blocks_w=(w+3)/4;
+		int blocks_h=(h+3)/4;
+		int grain=MAX(1,BLOCKS_PER_CHUNK/blocks_w);
+
+		if (pool && blocks_h>grain)
+			pool->parallel_for(blocks_h,_compress_block_rows,&job,grain);
+		else
+			_compress_block_rows(&job,0,blocks_h);
+
 		dst_ofs+=(MAX(4,w)*MAX(4,h))>>shift;
-		w>>=1;
-		h>>=1;
+		w=MAX(1,w>>1);
+		h=MAX(1,h>>1);
 	}
 
 	rb = DVector<uint8_t>::Read();
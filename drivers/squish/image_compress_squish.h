@@ -33,7 +33,7 @@
 #include "image.h"
 
 
-void image_compress_squish(Image *p_image);
+void image_compress_squish(Image *p_image,Image::CompressQuality p_quality);
 
 
 #endif // IMAGE_COMPRESS_SQUISH_H
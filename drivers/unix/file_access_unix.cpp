@@ -31,14 +31,20 @@
 #if defined(UNIX_ENABLED) || defined(LIBC_FILEIO_ENABLED)
 
 #include <sys/types.h>
+#include <string.h>
 #include <sys/stat.h>
 #include "print_string.h"
+#include "io/marshalls.h"
 #include "core/os/os.h"
 
 #ifndef ANDROID_ENABLED
 #include <sys/statvfs.h>
 #endif
 
+#ifdef UNIX_ENABLED
+#include <sys/mman.h>
+#endif
+
 #ifdef MSVC
  #define S_ISREG(m) ((m)&_S_IFREG)
 #endif
@@ -57,11 +63,49 @@ void FileAccessUnix::check_errors() const {
 
 }
 
+void FileAccessUnix::_unmap() {
+
+#ifdef UNIX_ENABLED
+	if (mapped)
+		munmap(mapped,mapped_len);
+#endif
+	mapped=NULL;
+	mapped_len=0;
+	mapped_pos=0;
+}
+
+Error FileAccessUnix::map_data() {
+
+	ERR_FAIL_COND_V(!f,ERR_FILE_CANT_READ);
+	if (mapped)
+		return OK;
+	if (flags!=READ)
+		return ERR_UNAVAILABLE;
+
+#ifdef UNIX_ENABLED
+	struct stat st;
+	if (fstat(fileno(f),&st)!=0 || st.st_size<=0 || (uint64_t)st.st_size!=(uint64_t)(size_t)st.st_size)
+		return ERR_UNAVAILABLE;
+
+	void *m = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fileno(f),0);
+	if (m==MAP_FAILED)
+		return ERR_UNAVAILABLE; //out of address space, special file, etc. keep reading through stdio
+
+	mapped_pos=ftell(f);
+	mapped=(uint8_t*)m;
+	mapped_len=st.st_size;
+	return OK;
+#else
+	return ERR_UNAVAILABLE;
+#endif
+}
+
 Error FileAccessUnix::_open(const String& p_path, int p_mode_flags) {
 
 	if (f)
 		fclose(f);
 	f=NULL;
+	_unmap();
 
 	path=fix_path(p_path);
 	//printf("opening %ls, %i\n", path.c_str(), Memory::get_static_mem_usage());
@@ -106,6 +150,8 @@ Error FileAccessUnix::_open(const String& p_path, int p_mode_flags) {
 	} else {
 		last_error=OK;
 		flags=p_mode_flags;
+		if (map_reads && p_mode_flags==READ)
+			map_data();
 		return OK;
 	}
 
@@ -114,6 +160,7 @@ void FileAccessUnix::close() {
 
 	if (!f)
 		return;
+	_unmap();
 	fclose(f);
 	f = NULL;
 	if (close_notification_func) {
@@ -144,17 +191,27 @@ void FileAccessUnix::seek(size_t p_position) {
 	ERR_FAIL_COND(!f);
 
 	last_error=OK;
+	if (mapped) {
+		mapped_pos=p_position;
+		return;
+	}
 	if ( fseek(f,p_position,SEEK_SET) )
 		check_errors();
 }
 void FileAccessUnix::seek_end(int64_t p_position)  {
 
 	ERR_FAIL_COND(!f);
+	if (mapped) {
+		mapped_pos=mapped_len+p_position;
+		return;
+	}
 	if ( fseek(f,p_position,SEEK_END) )
 		check_errors();
 }
 size_t FileAccessUnix::get_pos() const{
 
+	if (mapped)
+		return mapped_pos;
 
 	size_t aux_position=0;
 	if ( !(aux_position = ftell(f)) ) {
@@ -167,6 +224,9 @@ size_t FileAccessUnix::get_len() const{
 
 	ERR_FAIL_COND_V(!f,0);
 
+	if (mapped)
+		return mapped_len;
+
 	FileAccessUnix *fau = const_cast<FileAccessUnix*>(this);
 	int pos = fau->get_pos();
 	fau->seek_end();
@@ -184,6 +244,14 @@ bool FileAccessUnix::eof_reached() const{
 uint8_t FileAccessUnix::get_8() const{
 
 	ERR_FAIL_COND_V(!f,0);
+	if (mapped) {
+		if (mapped_pos>=mapped_len) {
+			last_error=ERR_FILE_EOF;
+			return 0;
+		}
+		return mapped[mapped_pos++];
+	}
+
 	uint8_t b;
 	if (fread(&b,1,1,f) == 0) {
 		check_errors();
@@ -192,9 +260,49 @@ uint8_t FileAccessUnix::get_8() const{
 	return b;
 }
 
+uint16_t FileAccessUnix::get_16() const {
+
+	if (!mapped || mapped_pos>mapped_len || mapped_len-mapped_pos<2)
+		return FileAccess::get_16();
+
+	uint16_t res=decode_uint16(&mapped[mapped_pos]);
+	mapped_pos+=2;
+	return endian_swap?BSWAP16(res):res;
+}
+
+uint32_t FileAccessUnix::get_32() const {
+
+	if (!mapped || mapped_pos>mapped_len || mapped_len-mapped_pos<4)
+		return FileAccess::get_32();
+
+	uint32_t res=decode_uint32(&mapped[mapped_pos]);
+	mapped_pos+=4;
+	return endian_swap?BSWAP32(res):res;
+}
+
+uint64_t FileAccessUnix::get_64() const {
+
+	if (!mapped || mapped_pos>mapped_len || mapped_len-mapped_pos<8)
+		return FileAccess::get_64();
+
+	uint64_t res=decode_uint64(&mapped[mapped_pos]);
+	mapped_pos+=8;
+	return endian_swap?BSWAP64(res):res;
+}
+
 int FileAccessUnix::get_buffer(uint8_t *p_dst, int p_length) const {
 
 	ERR_FAIL_COND_V(!f,-1);
+	if (mapped) {
+		ERR_FAIL_COND_V(p_length<0,-1);
+		size_t avail = mapped_pos<mapped_len ? mapped_len-mapped_pos : 0;
+		int read = (size_t)p_length<avail ? p_length : avail;
+		memcpy(p_dst,&mapped[mapped_pos],read);
+		mapped_pos+=read;
+		if (read<p_length)
+			last_error=ERR_FILE_EOF;
+		return read;
+	}
 	int read = fread(p_dst, 1, p_length, f);
 	check_errors();
 	return read;
@@ -252,11 +360,20 @@ FileAccess * FileAccessUnix::create_libc() {
 
 CloseNotificationFunc FileAccessUnix::close_notification_func=NULL;
 
+#ifdef TOOLS_ENABLED
+bool FileAccessUnix::map_reads=false; //the editor rewrites files that may be open, and a truncated mapping faults
+#else
+bool FileAccessUnix::map_reads=true;
+#endif
+
 FileAccessUnix::FileAccessUnix() {
 
 	f=NULL;
 	flags=0;
 	last_error=OK;
+	mapped=NULL;
+	mapped_len=0;
+	mapped_pos=0;
 
 }
 FileAccessUnix::~FileAccessUnix() {
@@ -50,11 +50,19 @@ class FileAccessUnix : public FileAccess {
 	mutable Error last_error;
 	String save_path;
 	String path;
+
+	uint8_t *mapped;
+	size_t mapped_len;
+	mutable size_t mapped_pos;
+	static bool map_reads;
+	void _unmap();
 	
 	static FileAccess* create_libc();
 public:
 	
 	static CloseNotificationFunc close_notification_func;
+	static void set_map_reads(bool p_enable) { map_reads=p_enable; } ///< map every file opened for reading (default in exported builds)
+	static bool is_map_reads_enabled() { return map_reads; }
 
 	virtual Error _open(const String& p_path, int p_mode_flags); ///< open a file
 	virtual void close(); ///< close a file
@@ -68,8 +76,14 @@ public:
 	virtual bool eof_reached() const; ///< reading passed EOF 
 
 	virtual uint8_t get_8() const; ///< get a byte 
+	virtual uint16_t get_16() const;
+	virtual uint32_t get_32() const;
+	virtual uint64_t get_64() const;
 	virtual int get_buffer(uint8_t *p_dst, int p_length) const;
 
+	virtual Error map_data();
+	virtual const uint8_t *get_mapped_data() const { return mapped; }
+
 	virtual Error get_error() const; ///< get last error 
 
 	virtual void store_8(uint8_t p_dest); ///< store a byte 
@@ -36,6 +36,7 @@
 #endif
 
 #include "os/memory.h"
+#include "os/frame_allocator.h"
 
 Thread::ID ThreadPosix::get_ID() const {
 
@@ -57,6 +58,7 @@ void *ThreadPosix::thread_callback(void *userdata) {
 	t->callback(t->user);
 
 	ScriptServer::thread_exit();
+	FrameAllocator::thread_exit();
 
 	return NULL;
 }
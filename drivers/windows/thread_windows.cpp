@@ -31,6 +31,7 @@
 #if defined(WINDOWS_ENABLED) && !defined(WINRT_ENABLED)
 
 #include "os/memory.h"
+#include "os/frame_allocator.h"
 
 
 Thread::ID ThreadWindows::get_ID() const {
@@ -53,6 +54,7 @@ DWORD ThreadWindows::thread_callback( LPVOID userdata ) {
 	t->callback(t->user);
 
 	ScriptServer::thread_exit();
+	FrameAllocator::thread_exit();
 
 	return 0;
 }
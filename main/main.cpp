@@ -70,6 +70,7 @@
 
 #include "core/io/stream_peer_tcp.h"
 #include "core/os/thread.h"
+#include "core/os/frame_allocator.h"
 #include "core/io/file_access_pack.h"
 #include "core/io/file_access_zip.h"
 #include "core/io/stream_peer_ssl.h"
@@ -106,6 +107,7 @@ static int video_driver_idx=-1;
 static int audio_driver_idx=-1;
 static String locale;
 static bool use_debug_profiler=false;
+static bool track_memory=false;
 static bool force_lowdpi=false;
 static int init_screen=-1;
 static bool use_vsync=true;
@@ -178,6 +180,7 @@ void Main::print_help(const char* p_binary) {
 	OS::get_singleton()->print("\t-timescale [msec]: Simulate high CPU load (delay each frame by [msec]).\n");
 	OS::get_singleton()->print("\t-bp : breakpoint list as source::line comma separated pairs, no spaces (%%20,%%2C,etc instead).\n");
 	OS::get_singleton()->print("\t-v : Verbose stdout mode\n");
+	OS::get_singleton()->print("\t-memtrack : Track allocations by site and category, print a report at exit.\n");
 	OS::get_singleton()->print("\t-lang [locale]: Use a specific locale\n");
 	OS::get_singleton()->print("\t-rfs <host/ip>[:<port>] : Remote FileSystem.\n");
 	OS::get_singleton()->print("\t-rfs_pass <password> : Password for Remote FileSystem.\n");
@@ -367,6 +370,10 @@ Error Main::setup(const char *execpath,int argc, char *argv[],bool p_second_phas
 		} else if (I->get()=="-profile") { // video driver
 
 			use_debug_profiler=true;
+		} else if (I->get()=="-memtrack") {
+
+			track_memory=true;
+			Memory::set_tracking_enabled(true);
 		} else if (I->get()=="-vd") { // video driver
 
 			if (I->next()) {
@@ -828,6 +835,8 @@ Error Main::setup(const char *execpath,int argc, char *argv[],bool p_second_phas
 
 	OS::get_singleton()->set_frame_delay(frame_delay);
 
+	FrameAllocator::set_arena_size(size_t(int(GLOBAL_DEF("memory/frame_arena_size_kb",1024)))*1024);
+
 	message_queue = memnew( MessageQueue );
 
 	Globals::get_singleton()->register_global_defaults();
@@ -1657,6 +1666,10 @@ bool Main::iteration() {
 	//	x11_delay_usec(10000);
 	frames++;
 	OS::get_singleton()->_idle_frames++;
+	FrameAllocator::end_frame();
+	ObjectTypeDB::method_cache_end_frame();
+	if (Memory::is_tracking_enabled())
+		Memory::tracking_end_frame();
 
 	if (frame>1000000) {
 
@@ -1710,6 +1723,11 @@ void Main::cleanup() {
 
 	ERR_FAIL_COND(!_start_success);
 
+	if (track_memory) {
+		Memory::print_tracking_report();
+		Memory::set_tracking_enabled(false);
+	}
+
 	if (script_debugger) {
 		if (use_debug_profiler) {
 			script_debugger->profiling_end();
@@ -32,6 +32,7 @@
 #include "servers/physics_2d_server.h"
 #include "servers/physics_server.h"
 #include "message_queue.h"
+#include "os/frame_allocator.h"
 #include "scene/main/scene_main_loop.h"
 Performance *Performance::singleton=NULL;
 
@@ -69,6 +70,14 @@ void Performance::_bind_methods() {
 	BIND_CONSTANT( PHYSICS_3D_ACTIVE_OBJECTS );
 	BIND_CONSTANT( PHYSICS_3D_COLLISION_PAIRS );
 	BIND_CONSTANT( PHYSICS_3D_ISLAND_COUNT );
+	BIND_CONSTANT( OBJECT_METHOD_CACHE_HITS );
+	BIND_CONSTANT( OBJECT_METHOD_CACHE_MISSES );
+	BIND_CONSTANT( MEMORY_FRAME_ARENA );
+	BIND_CONSTANT( MEMORY_FRAME_ARENA_MAX );
+	BIND_CONSTANT( MEMORY_FRAME_ARENA_OVERFLOWS );
+	BIND_CONSTANT( OBJECT_NODE_PATH_CACHE_HITS );
+	BIND_CONSTANT( OBJECT_NODE_PATH_CACHE_MISSES );
+	BIND_CONSTANT( MEMORY_FRAME_ARENA_PINNED_FRAMES );
 
 	BIND_CONSTANT( MONITOR_MAX );
 
@@ -106,6 +115,14 @@ String Performance::get_monitor_name(Monitor p_monitor) const {
 		"physics_3d/active_objects",
 		"physics_3d/collision_pairs",
 		"physics_3d/islands",
+		"object/method_cache_hits",
+		"object/method_cache_misses",
+		"memory/frame_arena",
+		"memory/frame_arena_max",
+		"memory/frame_arena_overflows",
+		"object/node_path_cache_hits",
+		"object/node_path_cache_misses",
+		"memory/frame_arena_pinned_frames",
 
 	};
 
@@ -155,6 +172,24 @@ float Performance::get_monitor(Monitor p_monitor) const {
 		case PHYSICS_3D_ACTIVE_OBJECTS: return PhysicsServer::get_singleton()->get_process_info(PhysicsServer::INFO_ACTIVE_OBJECTS);
 		case PHYSICS_3D_COLLISION_PAIRS: return PhysicsServer::get_singleton()->get_process_info(PhysicsServer::INFO_COLLISION_PAIRS);
 		case PHYSICS_3D_ISLAND_COUNT: return PhysicsServer::get_singleton()->get_process_info(PhysicsServer::INFO_ISLAND_COUNT);
+		case OBJECT_METHOD_CACHE_HITS: return ObjectTypeDB::get_method_cache_frame_hits();
+		case OBJECT_METHOD_CACHE_MISSES: return ObjectTypeDB::get_method_cache_frame_misses();
+		case MEMORY_FRAME_ARENA: return FrameAllocator::get_last_frame_usage();
+		case MEMORY_FRAME_ARENA_MAX: return FrameAllocator::get_max_usage();
+		case MEMORY_FRAME_ARENA_OVERFLOWS: return FrameAllocator::get_overflow_count();
+		case MEMORY_FRAME_ARENA_PINNED_FRAMES: return FrameAllocator::get_pinned_frame_count();
+		case OBJECT_NODE_PATH_CACHE_HITS:
+		case OBJECT_NODE_PATH_CACHE_MISSES: {
+
+			MainLoop *ml = OS::get_singleton()->get_main_loop();
+			if (!ml)
+				return 0;
+			SceneTree *sml = ml->cast_to<SceneTree>();
+			if (!sml)
+				return 0;
+			return p_monitor==OBJECT_NODE_PATH_CACHE_HITS ? sml->get_node_path_cache_hits() : sml->get_node_path_cache_misses();
+
+		};
 
 		default: {}
 	}
@@ -76,6 +76,14 @@ public:
 		PHYSICS_3D_COLLISION_PAIRS,
 		PHYSICS_3D_ISLAND_COUNT,
 		//physics
+		OBJECT_METHOD_CACHE_HITS,
+		OBJECT_METHOD_CACHE_MISSES,
+		MEMORY_FRAME_ARENA,
+		MEMORY_FRAME_ARENA_MAX,
+		MEMORY_FRAME_ARENA_OVERFLOWS,
+		OBJECT_NODE_PATH_CACHE_HITS,
+		OBJECT_NODE_PATH_CACHE_MISSES,
+		MEMORY_FRAME_ARENA_PINNED_FRAMES,
 		MONITOR_MAX
 	};
 
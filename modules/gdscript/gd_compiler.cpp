@@ -69,21 +69,221 @@ bool GDCompiler::_create_binary_operator(CodeGen& codegen,const GDParser::Operat
 	int src_address_a = _parse_expression(codegen,on->arguments[0],p_stack_level,false,p_initializer);
 	if (src_address_a<0)
 		return false;
+	Variant::Type type_a = codegen.get_address_type(src_address_a);
 	if (src_address_a&GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS)
 		p_stack_level++; //uses stack for return, increase stack
 
 	int src_address_b = _parse_expression(codegen,on->arguments[1],p_stack_level,false,p_initializer);
 	if (src_address_b<0)
 		return false;
+	Variant::Type type_b = codegen.get_address_type(src_address_b);
 
 
-	codegen.opcodes.push_back(GDFunction::OPCODE_OPERATOR); // perform operator
+	codegen.opcodes.push_back(_get_operator_opcode(op,type_a,type_b)); // perform operator
 	codegen.opcodes.push_back(op); //which operator
 	codegen.opcodes.push_back(src_address_a); // argument 1
 	codegen.opcodes.push_back(src_address_b); // argument 2 (unary only takes one parameter)
+
+	codegen.typed_result_type=_get_operator_result_type(op,type_a,type_b);
+	codegen.typed_result_pos=codegen.opcodes.size()+1; //the caller appends the destination
 	return true;
 }
 
+static bool _is_fast_operand(Variant::Type p_type) {
+
+	return p_type==Variant::NIL || p_type==Variant::INT || p_type==Variant::REAL || p_type==Variant::VECTOR2;
+}
+
+GDFunction::Opcode GDCompiler::_get_operator_opcode(Variant::Operator p_op,Variant::Type p_a,Variant::Type p_b) {
+
+	//pick the specialized opcode from the operand types known at compile time (NIL means unknown,
+	//so a single literal is enough to guess). The guess is checked at run-time, a wrong one just
+	//falls back to the generic operator.
+
+	if (!_is_fast_operand(p_a) || !_is_fast_operand(p_b))
+		return GDFunction::OPCODE_OPERATOR;
+
+	switch(p_op) {
+
+		case Variant::OP_EQUAL:
+		case Variant::OP_NOT_EQUAL:
+		case Variant::OP_ADD:
+		case Variant::OP_SUBSTRACT:
+		case Variant::OP_MULTIPLY:
+		case Variant::OP_DIVIDE: {
+
+			if (p_a==Variant::VECTOR2 || p_b==Variant::VECTOR2)
+				return GDFunction::OPCODE_OPERATOR_VECTOR2;
+		} //fallthrough
+		case Variant::OP_LESS:
+		case Variant::OP_LESS_EQUAL:
+		case Variant::OP_GREATER:
+		case Variant::OP_GREATER_EQUAL: {
+
+			if (p_a==Variant::VECTOR2 || p_b==Variant::VECTOR2)
+				return GDFunction::OPCODE_OPERATOR;
+			if (p_a==Variant::REAL || p_b==Variant::REAL)
+				return GDFunction::OPCODE_OPERATOR_REAL;
+			if (p_a==Variant::INT || p_b==Variant::INT)
+				return GDFunction::OPCODE_OPERATOR_INT;
+		} break;
+		case Variant::OP_MODULE:
+		case Variant::OP_SHIFT_LEFT:
+		case Variant::OP_SHIFT_RIGHT:
+		case Variant::OP_BIT_AND:
+		case Variant::OP_BIT_OR:
+		case Variant::OP_BIT_XOR: {
+
+			if (p_a==Variant::INT || p_b==Variant::INT)
+				return GDFunction::OPCODE_OPERATOR_INT;
+		} break;
+		default: {}
+	}
+
+	return GDFunction::OPCODE_OPERATOR;
+}
+
+Variant::Type GDCompiler::_get_operator_result_type(Variant::Operator p_op,Variant::Type p_a,Variant::Type p_b) {
+
+	//only when both operand types are known, guesses are not propagated
+
+	if (p_a==Variant::NIL || p_b==Variant::NIL)
+		return Variant::NIL;
+
+	bool num_a = p_a==Variant::INT || p_a==Variant::REAL;
+	bool num_b = p_b==Variant::INT || p_b==Variant::REAL;
+
+	switch(p_op) {
+
+		case Variant::OP_EQUAL:
+		case Variant::OP_NOT_EQUAL:
+		case Variant::OP_LESS:
+		case Variant::OP_LESS_EQUAL:
+		case Variant::OP_GREATER:
+		case Variant::OP_GREATER_EQUAL: {
+
+			if (num_a && num_b)
+				return Variant::BOOL;
+		} break;
+		case Variant::OP_ADD:
+		case Variant::OP_SUBSTRACT:
+		case Variant::OP_MULTIPLY:
+		case Variant::OP_DIVIDE: {
+
+			if (num_a && num_b)
+				return (p_a==Variant::REAL || p_b==Variant::REAL) ? Variant::REAL : Variant::INT;
+			if (p_a==Variant::VECTOR2 && (p_b==Variant::VECTOR2 || num_b))
+				return Variant::VECTOR2;
+			if (num_a && p_b==Variant::VECTOR2 && p_op==Variant::OP_MULTIPLY)
+				return Variant::VECTOR2;
+		} break;
+		case Variant::OP_MODULE:
+		case Variant::OP_SHIFT_LEFT:
+		case Variant::OP_SHIFT_RIGHT:
+		case Variant::OP_BIT_AND:
+		case Variant::OP_BIT_OR:
+		case Variant::OP_BIT_XOR: {
+
+			if (p_a==Variant::INT && p_b==Variant::INT)
+				return Variant::INT;
+		} break;
+		default: {}
+	}
+
+	return Variant::NIL;
+}
+
+
+bool GDCompiler::_is_native_self_call(CodeGen& codegen,const StringName& p_method,int p_argcount) {
+
+	//a call on self that can only end up in a method of the native base class, taking exactly the given arguments
+
+	if (!codegen.script || !codegen.function_node || codegen.function_node->_static)
+		return false;
+
+	for(int i=0;i<codegen.class_node->functions.size();i++) {
+		if (codegen.class_node->functions[i]->name==p_method)
+			return false;
+	}
+	for(int i=0;i<codegen.class_node->static_functions.size();i++) {
+		if (codegen.class_node->static_functions[i]->name==p_method)
+			return false;
+	}
+
+	GDNativeClass *nc=NULL;
+	GDScript *scr=codegen.script;
+	while(scr) {
+
+		if (scr!=codegen.script && scr->member_functions.has(p_method))
+			return false;
+		if (scr->native.is_valid())
+			nc=scr->native.ptr();
+		scr=scr->_base;
+	}
+
+	if (!nc)
+		return false;
+
+	MethodBind *method = ObjectTypeDB::get_method(nc->get_name(),p_method);
+	return method && !method->is_vararg() && method->get_argument_count()==p_argcount;
+}
+
+int GDCompiler::_parse_jump_if_not(CodeGen& codegen,const GDParser::Node *p_condition,int p_stack_level) {
+
+	//emits a jump taken when the condition is false, returns the position of its (yet unknown) target.
+	//comparisons are fused into the jump, so their result never goes through the stack
+
+	if (p_condition->type==GDParser::Node::TYPE_OPERATOR) {
+
+		const GDParser::OperatorNode *on = static_cast<const GDParser::OperatorNode*>(p_condition);
+		Variant::Operator op=Variant::OP_MAX;
+
+		switch(on->op) {
+			case GDParser::OperatorNode::OP_EQUAL: op=Variant::OP_EQUAL; break;
+			case GDParser::OperatorNode::OP_NOT_EQUAL: op=Variant::OP_NOT_EQUAL; break;
+			case GDParser::OperatorNode::OP_LESS: op=Variant::OP_LESS; break;
+			case GDParser::OperatorNode::OP_LESS_EQUAL: op=Variant::OP_LESS_EQUAL; break;
+			case GDParser::OperatorNode::OP_GREATER: op=Variant::OP_GREATER; break;
+			case GDParser::OperatorNode::OP_GREATER_EQUAL: op=Variant::OP_GREATER_EQUAL; break;
+			default: {}
+		}
+
+		if (op!=Variant::OP_MAX && on->arguments.size()==2) {
+
+			int slevel=p_stack_level;
+
+			int src_address_a = _parse_expression(codegen,on->arguments[0],slevel);
+			if (src_address_a<0)
+				return -1;
+			if (src_address_a&GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS) {
+				slevel++; //uses stack for return, increase stack
+				codegen.alloc_stack(slevel);
+			}
+
+			int src_address_b = _parse_expression(codegen,on->arguments[1],slevel);
+			if (src_address_b<0)
+				return -1;
+
+			codegen.opcodes.push_back(GDFunction::OPCODE_JUMP_IF_NOT_OPERATOR);
+			codegen.opcodes.push_back(op);
+			codegen.opcodes.push_back(src_address_a);
+			codegen.opcodes.push_back(src_address_b);
+			int jump_pos=codegen.opcodes.size();
+			codegen.opcodes.push_back(0); //temporary
+			return jump_pos;
+		}
+	}
+
+	int ret = _parse_expression(codegen,p_condition,p_stack_level,false);
+	if (ret<0)
+		return -1;
+
+	codegen.opcodes.push_back(GDFunction::OPCODE_JUMP_IF_NOT);
+	codegen.opcodes.push_back(ret);
+	int jump_pos=codegen.opcodes.size();
+	codegen.opcodes.push_back(0); //temporary
+	return jump_pos;
+}
 
 /*
 int GDCompiler::_parse_subexpression(CodeGen& codegen,const GDParser::Node *p_expression) {
@@ -194,6 +394,16 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 
 					if (scr->constants.has(identifier)) {
 
+						Variant::Type ctype=scr->constants[identifier].get_type();
+						if (scr==owner && ctype!=Variant::OBJECT && ctype!=Variant::ARRAY && ctype!=Variant::DICTIONARY) {
+							//declared in this file, which is always compiled together with this function,
+							//so resolve it now instead of looking it up on every access. Objects (subclasses,
+							//preloads) are left alone, the function would keep them referenced. Arrays and
+							//dictionaries too, the constant pool merges equal values and they are mutable.
+							int idx = codegen.get_constant_pos(scr->constants[identifier]);
+							return idx|(GDFunction::ADDR_TYPE_LOCAL_CONSTANT<<GDFunction::ADDR_BITS);
+						}
+
 						//int idx=scr->constants[identifier];
 						int idx = codegen.get_name_map_pos(identifier);
 						return idx|(GDFunction::ADDR_TYPE_CLASS_CONSTANT<<GDFunction::ADDR_BITS); //argument (stack root)
@@ -210,18 +420,7 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 					bool success=false;
 					int constant = ObjectTypeDB::get_integer_constant(nc->get_name(),identifier,&success);
 					if (success) {
-						Variant key=constant;
-						int idx;
-
-						if (!codegen.constant_map.has(key)) {
-
-							idx=codegen.constant_map.size();
-							codegen.constant_map[key]=idx;
-
-						} else {
-							idx=codegen.constant_map[key];
-						}
-
+						int idx = codegen.get_constant_pos(constant);
 						return idx|(GDFunction::ADDR_TYPE_LOCAL_CONSTANT<<GDFunction::ADDR_BITS); //make it a local constant (faster access)
 					}
 
@@ -258,17 +457,7 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 			const GDParser::ConstantNode *cn = static_cast<const GDParser::ConstantNode*>(p_expression);
 
 
-			int idx;
-
-			if (!codegen.constant_map.has(cn->value)) {
-
-				idx=codegen.constant_map.size();
-				codegen.constant_map[cn->value]=idx;
-
-			} else {
-				idx=codegen.constant_map[cn->value];
-			}
-
+			int idx = codegen.get_constant_pos(cn->value);
 
 			return idx|(GDFunction::ADDR_TYPE_LOCAL_CONSTANT<<GDFunction::ADDR_BITS); //argument (stack root)
 
@@ -460,10 +649,14 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 
 						const GDParser::Node *instance = on->arguments[0];
 
-						if (instance->type==GDParser::Node::TYPE_SELF) {
-							//room for optimization
+						int call_opcode = p_root?GDFunction::OPCODE_CALL:GDFunction::OPCODE_CALL_RETURN;
+#ifdef PTRCALL_ENABLED
+						if (instance->type==GDParser::Node::TYPE_SELF && on->arguments[1]->type==GDParser::Node::TYPE_IDENTIFIER) {
 
+							if (_is_native_self_call(codegen,static_cast<const GDParser::IdentifierNode*>(on->arguments[1])->name,on->arguments.size()-2))
+								call_opcode=GDFunction::OPCODE_CALL_PTRCALL;
 						}
+#endif
 
 
 						Vector<int> arguments;
@@ -499,7 +692,7 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 
 						}
 
-						codegen.opcodes.push_back(p_root?GDFunction::OPCODE_CALL:GDFunction::OPCODE_CALL_RETURN); // perform operator
+						codegen.opcodes.push_back(call_opcode); // perform operator
 						codegen.opcodes.push_back(on->arguments.size()-2);
 						codegen.alloc_call(on->arguments.size()-2);
 						for(int i=0;i<arguments.size();i++)
@@ -1027,15 +1220,10 @@ Error GDCompiler::_parse_block(CodeGen& codegen,const GDParser::BlockNode *p_blo
 						codegen.opcodes.push_back(cf->line);
 						codegen.current_line=cf->line;
 #endif
-						int ret = _parse_expression(codegen,cf->arguments[0],p_stack_level,false);
-						if (ret<0)
+						int else_addr = _parse_jump_if_not(codegen,cf->arguments[0],p_stack_level);
+						if (else_addr<0)
 							return ERR_PARSE_ERROR;
 
-						codegen.opcodes.push_back(GDFunction::OPCODE_JUMP_IF_NOT);
-						codegen.opcodes.push_back(ret);
-						int else_addr=codegen.opcodes.size();
-						codegen.opcodes.push_back(0); //temporary
-
 						Error err = _parse_block(codegen,cf->body,p_stack_level,p_break_addr,p_continue_addr);
 						if (err)
 							return err;
@@ -1061,7 +1249,82 @@ Error GDCompiler::_parse_block(CodeGen& codegen,const GDParser::BlockNode *p_blo
 					} break;
 					case GDParser::ControlFlowNode::CF_FOR: {
 
+						const GDParser::OperatorNode *range_call=NULL;
+						if (cf->arguments[1]->type==GDParser::Node::TYPE_OPERATOR) {
 
+							const GDParser::OperatorNode *on = static_cast<const GDParser::OperatorNode*>(cf->arguments[1]);
+							if (on->op==GDParser::OperatorNode::OP_CALL && on->arguments.size()>=2 && on->arguments.size()<=4 && on->arguments[0]->type==GDParser::Node::TYPE_BUILT_IN_FUNCTION && static_cast<const GDParser::BuiltInFunctionNode*>(on->arguments[0])->function==GDFunctions::GEN_RANGE) {
+								range_call=on;
+							}
+						}
+
+						if (range_call) {
+							//for over range(): keep counter, end and step on the stack and count, no array is created
+
+							int slevel=p_stack_level;
+							int iter_stack_pos=slevel;
+							int iterator_pos = (slevel++)|(GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS);
+							int counter_pos = (slevel++)|(GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS);
+							int to_pos = (slevel++)|(GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS);
+							int step_pos = (slevel++)|(GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS);
+							codegen.alloc_stack(slevel);
+
+							codegen.push_stack_identifiers();
+							codegen.add_stack_identifier(static_cast<const GDParser::IdentifierNode*>(cf->arguments[0])->name,iter_stack_pos);
+
+							int range_args[3];
+							int range_argc=range_call->arguments.size()-1;
+							range_args[0]=codegen.get_constant_pos(0)|(GDFunction::ADDR_TYPE_LOCAL_CONSTANT<<GDFunction::ADDR_BITS);
+							range_args[2]=codegen.get_constant_pos(1)|(GDFunction::ADDR_TYPE_LOCAL_CONSTANT<<GDFunction::ADDR_BITS);
+
+							for(int i=0;i<range_argc;i++) {
+
+								int ret = _parse_expression(codegen,range_call->arguments[i+1],slevel);
+								if (ret<0)
+									return ERR_COMPILATION_FAILED;
+								if (ret&GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS) {
+									slevel++;
+									codegen.alloc_stack(slevel);
+								}
+								range_args[range_argc==1?1:i]=ret;
+							}
+
+							//begin loop
+							codegen.opcodes.push_back(GDFunction::OPCODE_ITERATE_RANGE_BEGIN);
+							codegen.opcodes.push_back(counter_pos);
+							codegen.opcodes.push_back(to_pos);
+							codegen.opcodes.push_back(step_pos);
+							codegen.opcodes.push_back(range_args[0]);
+							codegen.opcodes.push_back(range_args[1]);
+							codegen.opcodes.push_back(range_args[2]);
+							codegen.opcodes.push_back(codegen.opcodes.size()+4);
+							codegen.opcodes.push_back(iterator_pos);
+							codegen.opcodes.push_back(GDFunction::OPCODE_JUMP); //skip code for next
+							codegen.opcodes.push_back(codegen.opcodes.size()+9);
+							//break loop
+							int break_pos=codegen.opcodes.size();
+							codegen.opcodes.push_back(GDFunction::OPCODE_JUMP); //skip code for next
+							codegen.opcodes.push_back(0); //skip code for next
+							//next loop
+							int continue_pos=codegen.opcodes.size();
+							codegen.opcodes.push_back(GDFunction::OPCODE_ITERATE_RANGE);
+							codegen.opcodes.push_back(counter_pos);
+							codegen.opcodes.push_back(to_pos);
+							codegen.opcodes.push_back(step_pos);
+							codegen.opcodes.push_back(break_pos);
+							codegen.opcodes.push_back(iterator_pos);
+
+							Error err = _parse_block(codegen,cf->body,slevel,break_pos,continue_pos);
+							if (err)
+								return err;
+
+							codegen.opcodes.push_back(GDFunction::OPCODE_JUMP);
+							codegen.opcodes.push_back(continue_pos);
+							codegen.opcodes[break_pos+1]=codegen.opcodes.size();
+
+							codegen.pop_stack_identifiers();
+							break;
+						}
 
 						int slevel=p_stack_level;
 						int iter_stack_pos=slevel;
@@ -1125,12 +1388,10 @@ Error GDCompiler::_parse_block(CodeGen& codegen,const GDParser::BlockNode *p_blo
 						codegen.opcodes.push_back(0);
 						int continue_addr=codegen.opcodes.size();
 
-						int ret = _parse_expression(codegen,cf->arguments[0],p_stack_level,false);
-						if (ret<0)
+						int jump_pos = _parse_jump_if_not(codegen,cf->arguments[0],p_stack_level);
+						if (jump_pos<0)
 							return ERR_PARSE_ERROR;
-						codegen.opcodes.push_back(GDFunction::OPCODE_JUMP_IF_NOT);
-						codegen.opcodes.push_back(ret);
-						codegen.opcodes.push_back(break_addr);
+						codegen.opcodes[jump_pos]=break_addr;
 						Error err = _parse_block(codegen,cf->body,p_stack_level,break_addr,continue_addr);
 						if (err)
 							return err;
@@ -1240,6 +1501,8 @@ Error GDCompiler::_parse_function(GDScript *p_script,const GDParser::ClassNode *
 	codegen.stack_max=0;
 	codegen.current_line=0;
 	codegen.call_max=0;
+	codegen.typed_result_type=Variant::NIL;
+	codegen.typed_result_pos=-1;
 	codegen.debug_stack=ScriptDebugger::get_singleton()!=NULL;
 	Vector<StringName> argnames;
 
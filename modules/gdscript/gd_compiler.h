@@ -111,9 +111,34 @@ class GDCompiler {
 				return constant_map[p_constant];
 			int pos = constant_map.size();
 			constant_map[p_constant]=pos;
+			constant_types.push_back(p_constant.get_type());
 			return pos;
 		}
 
+		Vector<Variant::Type> constant_types;
+
+		//type of the last operator result, only known while its destination is the last emitted word
+		Variant::Type typed_result_type;
+		int typed_result_pos;
+
+		Variant::Type get_address_type(int p_address) const {
+
+			int address = p_address&GDFunction::ADDR_MASK;
+			switch((p_address&GDFunction::ADDR_TYPE_MASK)>>GDFunction::ADDR_BITS) {
+
+				case GDFunction::ADDR_TYPE_LOCAL_CONSTANT: {
+					if (address<constant_types.size())
+						return constant_types[address];
+				} break;
+				case GDFunction::ADDR_TYPE_STACK: {
+					if (typed_result_pos==opcodes.size() && opcodes[typed_result_pos-1]==p_address)
+						return typed_result_type;
+				} break;
+			}
+
+			return Variant::NIL; //unknown
+		}
+
 		Vector<int> opcodes;
 		void alloc_stack(int p_level) { if (p_level >= stack_max) stack_max=p_level+1; }
 		void alloc_call(int p_params) { if (p_params >= call_max) call_max=p_params; }
@@ -138,6 +163,10 @@ class GDCompiler {
 
 	bool _create_unary_operator(CodeGen& codegen,const GDParser::OperatorNode *on,Variant::Operator op, int p_stack_level);
 	bool _create_binary_operator(CodeGen& codegen,const GDParser::OperatorNode *on,Variant::Operator op, int p_stack_level,bool p_initializer=false);
+	static GDFunction::Opcode _get_operator_opcode(Variant::Operator p_op,Variant::Type p_a,Variant::Type p_b);
+	static Variant::Type _get_operator_result_type(Variant::Operator p_op,Variant::Type p_a,Variant::Type p_b);
+	bool _is_native_self_call(CodeGen& codegen,const StringName& p_method,int p_argcount);
+	int _parse_jump_if_not(CodeGen& codegen,const GDParser::Node *p_condition,int p_stack_level);
 
 	//int _parse_subexpression(CodeGen& codegen,const GDParser::BlockNode *p_block,const GDParser::Node *p_expression);
 	int _parse_assign_right_expression(CodeGen& codegen,const GDParser::OperatorNode *p_expression, int p_stack_level);
@@ -3,6 +3,53 @@
 #include "os/os.h"
 #include "gd_functions.h"
 
+//threaded dispatch through a table of label addresses where the compiler supports it,
+//a regular switch elsewhere. Opcode bodies end with DISPATCH_OPCODE to run the next one
+//and leave the loop (on error or exit) with OPCODE_BREAK.
+
+#if defined(__GNUC__) || defined(__clang__)
+#define GDSCRIPT_COMPUTED_GOTO
+#endif
+
+#ifdef GDSCRIPT_COMPUTED_GOTO
+
+#define OPCODE(m_op) m_op:
+#define OPCODE_SWITCH(m_test) DISPATCH_OPCODE;
+#define OPCODES_END OPSEXIT:
+#define OPCODE_BREAK goto OPSEXIT
+
+#ifdef DEBUG_ENABLED
+#define DISPATCH_OPCODE {\
+	last_opcode=_code_ptr[ip];\
+	if (last_opcode<0 || last_opcode>OPCODE_END) {\
+		err_text="Illegal opcode "+itos(last_opcode)+" at address "+itos(ip);\
+		OPCODE_BREAK;\
+	}\
+	goto *switch_table_ops[last_opcode];\
+}
+#else
+#define DISPATCH_OPCODE {\
+	last_opcode=_code_ptr[ip];\
+	goto *switch_table_ops[last_opcode];\
+}
+#endif
+
+#else
+
+#define OPCODE(m_op) case m_op:
+#define OPCODE_SWITCH(m_test) switch(last_opcode=(m_test))
+#define OPCODES_END
+#define OPCODE_BREAK break
+#define DISPATCH_OPCODE continue
+
+#endif
+
+#define GD_ERR_BREAK(m_cond) \
+	{ if ( m_cond ) {	\
+		_err_print_error(FUNCTION_STR,__FILE__,__LINE__,"Condition ' " _STR(m_cond)" ' is true. Breaking..:");	\
+		OPCODE_BREAK;\
+	} else _err_error_exists=false;}
+
 Variant *GDFunction::_get_variant(int p_address,GDInstance *p_instance,GDScript *p_script,Variant &self, Variant *p_stack,String& r_error) const{
 
 	int address = p_address&ADDR_MASK;
@@ -147,6 +194,8 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 		return Variant();
 	}
 
+	MemoryCategoryScope mem_scope(Memory::ALLOC_SCRIPT);
+
 	r_err.error=Variant::CallError::CALL_OK;
 
 	Variant self;
@@ -255,13 +304,13 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 		GDScriptLanguage::get_singleton()->enter_function(p_instance,this,stack,&ip,&line);
 
 #define CHECK_SPACE(m_space)\
-	ERR_BREAK((ip+m_space)>_code_size)
+	GD_ERR_BREAK((ip+m_space)>_code_size)
 
 #define GET_VARIANT_PTR(m_v,m_code_ofs) \
 	Variant *m_v; \
 	m_v = _get_variant(_code_ptr[ip+m_code_ofs],p_instance,_class,self,stack,err_text);\
 	if (!m_v)\
-	break;
+	OPCODE_BREAK;
 
 
 #else
@@ -286,20 +335,104 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 	}
 #endif
 	bool exit_ok=false;
+	int last_opcode=-1;
+
+#ifdef GDSCRIPT_COMPUTED_GOTO
+	static const void* switch_table_ops[]={
+		&&OPCODE_OPERATOR,
+		&&OPCODE_OPERATOR_INT,
+		&&OPCODE_OPERATOR_REAL,
+		&&OPCODE_OPERATOR_VECTOR2,
+		&&OPCODE_EXTENDS_TEST,
+		&&OPCODE_SET,
+		&&OPCODE_GET,
+		&&OPCODE_SET_NAMED,
+		&&OPCODE_GET_NAMED,
+		&&OPCODE_ASSIGN,
+		&&OPCODE_ASSIGN_TRUE,
+		&&OPCODE_ASSIGN_FALSE,
+		&&OPCODE_CONSTRUCT,
+		&&OPCODE_CONSTRUCT_ARRAY,
+		&&OPCODE_CONSTRUCT_DICTIONARY,
+		&&OPCODE_CALL,
+		&&OPCODE_CALL_RETURN,
+		&&OPCODE_CALL_PTRCALL,
+		&&OPCODE_CALL_BUILT_IN,
+		&&OPCODE_CALL_SELF,
+		&&OPCODE_CALL_SELF_BASE,
+		&&OPCODE_YIELD,
+		&&OPCODE_YIELD_SIGNAL,
+		&&OPCODE_YIELD_RESUME,
+		&&OPCODE_JUMP,
+		&&OPCODE_JUMP_IF,
+		&&OPCODE_JUMP_IF_NOT,
+		&&OPCODE_JUMP_IF_NOT_OPERATOR,
+		&&OPCODE_JUMP_TO_DEF_ARGUMENT,
+		&&OPCODE_RETURN,
+		&&OPCODE_ITERATE_BEGIN,
+		&&OPCODE_ITERATE,
+		&&OPCODE_ITERATE_RANGE_BEGIN,
+		&&OPCODE_ITERATE_RANGE,
+		&&OPCODE_ASSERT,
+		&&OPCODE_BREAKPOINT,
+		&&OPCODE_LINE,
+		&&OPCODE_END
+	};
+	//fails to compile if an opcode is added to the enum but not to the table
+	typedef char _switch_table_ops_check[(sizeof(switch_table_ops)/sizeof(void*))==OPCODE_END+1?1:-1];
+#endif
 
 	while(ip<_code_size) {
 
+		OPCODE_SWITCH(_code_ptr[ip]) {
+
+			OPCODE(OPCODE_OPERATOR_INT) {
+
+				CHECK_SPACE(5);
+
+				GET_VARIANT_PTR(a,2);
+				GET_VARIANT_PTR(b,3);
+				GET_VARIANT_PTR(dst,4);
+
+				if (Variant::evaluate_int((Variant::Operator)_code_ptr[ip+1],*a,*b,*dst)) {
+					ip+=5;
+					DISPATCH_OPCODE;
+				}
+				//the compiler guessed wrong, try the next ones (same layout)
+			}
+			OPCODE(OPCODE_OPERATOR_REAL) {
 
-		int last_opcode=_code_ptr[ip];
-		switch(_code_ptr[ip]) {
+				CHECK_SPACE(5);
 
-			case OPCODE_OPERATOR: {
+				GET_VARIANT_PTR(a,2);
+				GET_VARIANT_PTR(b,3);
+				GET_VARIANT_PTR(dst,4);
+
+				if (Variant::evaluate_real((Variant::Operator)_code_ptr[ip+1],*a,*b,*dst)) {
+					ip+=5;
+					DISPATCH_OPCODE;
+				}
+			}
+			OPCODE(OPCODE_OPERATOR_VECTOR2) {
+
+				CHECK_SPACE(5);
+
+				GET_VARIANT_PTR(a,2);
+				GET_VARIANT_PTR(b,3);
+				GET_VARIANT_PTR(dst,4);
+
+				if (Variant::evaluate_vector2((Variant::Operator)_code_ptr[ip+1],*a,*b,*dst)) {
+					ip+=5;
+					DISPATCH_OPCODE;
+				}
+			}
+			OPCODE(OPCODE_OPERATOR) {
 
 				CHECK_SPACE(5);
 
 				bool valid;
 				Variant::Operator op = (Variant::Operator)_code_ptr[ip+1];
-				ERR_BREAK(op>=Variant::OP_MAX);
+				GD_ERR_BREAK(op>=Variant::OP_MAX);
 
 				GET_VARIANT_PTR(a,2);
 				GET_VARIANT_PTR(b,3);
@@ -323,7 +456,7 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 						err_text="Invalid operands '"+Variant::get_type_name(a->get_type())+"' and '"+Variant::get_type_name(b->get_type())+"' in operator '"+Variant::get_operator_name(op)+"'.";
 					}
 #endif
-					break;
+					OPCODE_BREAK;
 
 				}
 #ifdef DEBUG_ENABLED
@@ -332,8 +465,8 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 				ip+=5;
 
-			} continue;
-			case OPCODE_EXTENDS_TEST: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_EXTENDS_TEST) {
 
 				CHECK_SPACE(4);
 
@@ -346,13 +479,13 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (a->get_type()!=Variant::OBJECT || a->operator Object*()==NULL) {
 
 					err_text="Left operand of 'extends' is not an instance of anything.";
-					break;
+					OPCODE_BREAK;
 
 				}
 				if (b->get_type()!=Variant::OBJECT || b->operator Object*()==NULL) {
 
 					err_text="Right operand of 'extends' is not a class.";
-					break;
+					OPCODE_BREAK;
 
 				}
 #endif
@@ -396,7 +529,7 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 					if (!nc) {
 
 						err_text="Right operand of 'extends' is not a class (type: '"+obj_B->get_type()+"').";
-						break;
+						OPCODE_BREAK;
 					}
 
 					extends_ok=ObjectTypeDB::is_type(obj_A->get_type_name(),nc->get_name());
@@ -405,8 +538,8 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				*dst=extends_ok;
 				ip+=4;
 
-			} continue;
-			case OPCODE_SET: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_SET) {
 
 				CHECK_SPACE(3);
 
@@ -425,12 +558,12 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 						v="of type '"+_get_var_type(index)+"'";
 					}
 					err_text="Invalid set index "+v+" (on base: '"+_get_var_type(dst)+"').";
-					break;
+					OPCODE_BREAK;
 				}
 
 				ip+=4;
-			} continue;
-			case OPCODE_GET: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_GET) {
 
 				CHECK_SPACE(3);
 
@@ -454,14 +587,14 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 						v="of type '"+_get_var_type(index)+"'";
 					}
 					err_text="Invalid get index "+v+" (on base: '"+_get_var_type(src)+"').";
-					break;
+					OPCODE_BREAK;
 				}
 #ifdef DEBUG_ENABLED
 				*dst=ret;
 #endif
 				ip+=4;
-			} continue;
-			case OPCODE_SET_NAMED: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_SET_NAMED) {
 
 				CHECK_SPACE(3);
 
@@ -470,7 +603,7 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 				int indexname = _code_ptr[ip+2];
 
-				ERR_BREAK(indexname<0 || indexname>=_global_names_count);
+				GD_ERR_BREAK(indexname<0 || indexname>=_global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
 				bool valid;
@@ -479,12 +612,12 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (!valid) {
 					String err_type;
 					err_text="Invalid set index '"+String(*index)+"' (on base: '"+_get_var_type(dst)+"').";
-					break;
+					OPCODE_BREAK;
 				}
 
 				ip+=4;
-			} continue;
-			case OPCODE_GET_NAMED: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_GET_NAMED) {
 
 
 				CHECK_SPACE(3);
@@ -494,7 +627,7 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 				int indexname = _code_ptr[ip+2];
 
-				ERR_BREAK(indexname<0 || indexname>=_global_names_count);
+				GD_ERR_BREAK(indexname<0 || indexname>=_global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
 				bool valid;
@@ -512,14 +645,14 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 					} else {
 						err_text="Invalid get index '"+index->operator String()+"' (on base: '"+_get_var_type(src)+"').";
 					}
-					break;
+					OPCODE_BREAK;
 				}
 #ifdef DEBUG_ENABLED
 				*dst=ret;
 #endif
 				ip+=4;
-			} continue;
-			case OPCODE_ASSIGN: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ASSIGN) {
 
 				CHECK_SPACE(3);
 				GET_VARIANT_PTR(dst,1);
@@ -529,8 +662,8 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 				ip+=3;
 
-			} continue;
-			case OPCODE_ASSIGN_TRUE: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ASSIGN_TRUE) {
 
 				CHECK_SPACE(2);
 				GET_VARIANT_PTR(dst,1);
@@ -538,8 +671,8 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				*dst = true;
 
 				ip+=2;
-			} continue;
-			case OPCODE_ASSIGN_FALSE: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ASSIGN_FALSE) {
 
 				CHECK_SPACE(2);
 				GET_VARIANT_PTR(dst,1);
@@ -547,8 +680,8 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				*dst = false;
 
 				ip+=2;
-			} continue;
-			case OPCODE_CONSTRUCT: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_CONSTRUCT) {
 
 				CHECK_SPACE(2);
 				Variant::Type t=Variant::Type(_code_ptr[ip+1]);
@@ -567,13 +700,13 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (err.error!=Variant::CallError::CALL_OK) {
 
 					err_text=_get_call_error(err,"'"+Variant::get_type_name(t)+"' constructor",(const Variant**)argptrs);
-					break;
+					OPCODE_BREAK;
 				}
 
 				ip+=4+argc;
 				//construct a basic type
-			} continue;
-			case OPCODE_CONSTRUCT_ARRAY: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_CONSTRUCT_ARRAY) {
 
 				CHECK_SPACE(1);
 				int argc=_code_ptr[ip+1];
@@ -593,8 +726,8 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 				ip+=3+argc;
 
-			} continue;
-			case OPCODE_CONSTRUCT_DICTIONARY: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_CONSTRUCT_DICTIONARY) {
 
 				CHECK_SPACE(1);
 				int argc=_code_ptr[ip+1];
@@ -616,22 +749,92 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 				ip+=3+argc*2;
 
-			} continue;
-			case OPCODE_CALL_RETURN:
-			case OPCODE_CALL: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_CALL_PTRCALL) {
+#ifdef PTRCALL_ENABLED
+
+				CHECK_SPACE(4);
+
+				int argc=_code_ptr[ip+1];
+				int nameg=_code_ptr[ip+3];
+
+				GD_ERR_BREAK(nameg<0 || nameg>=_global_names_count);
+				GD_ERR_BREAK(argc<0);
+				CHECK_SPACE(argc+5);
+
+				//the compiler made sure no script function of this class can take the call,
+				//so it goes straight to the native method unless a derived script is in the way
+				MethodBind *method=NULL;
+				if (p_instance && p_instance->script.ptr()==_script) {
+					method=ObjectTypeDB::get_method(p_instance->owner->get_type_name(),_global_names_ptr[nameg]);
+				}
+
+				if (method && !method->is_vararg() && method->get_argument_count()==argc) {
+
+					const void **ptrargs = (const void**)call_args;
+					int argi=0;
+
+					for(;argi<argc;argi++) {
+
+						GET_VARIANT_PTR(v,4+argi);
+						Variant::Type argtype = method->get_argument_type(argi);
+						if (argtype==Variant::NIL) {
+							ptrargs[argi]=v;
+						} else if (argtype==v->get_type() && argtype!=Variant::OBJECT) {
+							ptrargs[argi]=v->get_ptrcall_arg();
+						} else {
+							break; //needs conversion, let the regular call handle it
+						}
+					}
+
+					void *ptrret=NULL;
+					Variant *ret=NULL;
+					Variant retval; //the return slot may hold an argument, so it's only written after the call
+
+					if (argi==argc) {
+
+						ret=_get_variant(_code_ptr[ip+4+argc],p_instance,_class,self,stack,err_text);
+						if (ret && method->has_return())
+							ptrret=retval.get_ptrcall_ret(method->get_argument_type(-1));
+					}
+
+					if (ret && (ptrret || !method->has_return())) {
+
+#ifdef DEBUG_ENABLED
+						uint64_t call_time;
+
+						if (GDScriptLanguage::get_singleton()->profiling) {
+							call_time=OS::get_singleton()->get_ticks_usec();
+						}
+#endif
+						method->ptrcall(p_instance->owner,ptrargs,ptrret);
+						*ret=retval;
+#ifdef DEBUG_ENABLED
+						if (GDScriptLanguage::get_singleton()->profiling) {
+							function_call_time+=OS::get_singleton()->get_ticks_usec() - call_time;
+						}
+#endif
+						ip+=argc+5;
+						DISPATCH_OPCODE;
+					}
+				}
+#endif
+			} //fallthrough to the regular call
+			OPCODE(OPCODE_CALL_RETURN)
+			OPCODE(OPCODE_CALL) {
 
 
 				CHECK_SPACE(4);
-				bool call_ret = _code_ptr[ip]==OPCODE_CALL_RETURN;
+				bool call_ret = _code_ptr[ip]!=OPCODE_CALL;
 
 				int argc=_code_ptr[ip+1];
 				GET_VARIANT_PTR(base,2);
 				int nameg=_code_ptr[ip+3];
 
-				ERR_BREAK(nameg<0 || nameg>=_global_names_count);
+				GD_ERR_BREAK(nameg<0 || nameg>=_global_names_count);
 				const StringName *methodname = &_global_names_ptr[nameg];
 
-				ERR_BREAK(argc<0);
+				GD_ERR_BREAK(argc<0);
 				ip+=4;
 				CHECK_SPACE(argc+1);
 				Variant **argptrs = call_args;
@@ -683,29 +886,29 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 							if (base->is_ref()) {
 								err_text="Attempted to free a reference.";
-								break;
+								OPCODE_BREAK;
 							} else if (base->get_type()==Variant::OBJECT) {
 
 								err_text="Attempted to free a locked object (calling or emitting).";
-								break;
+								OPCODE_BREAK;
 							}
 						}
 					}
 					err_text=_get_call_error(err,"function '"+methodstr+"' in base '"+basestr+"'",(const Variant**)argptrs);
-					break;
+					OPCODE_BREAK;
 				}
 
 				//_call_func(NULL,base,*methodname,ip,argc,p_instance,stack);
 				ip+=argc+1;
 
-			} continue;
-			case OPCODE_CALL_BUILT_IN: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_CALL_BUILT_IN) {
 
 				CHECK_SPACE(4);
 
 				GDFunctions::Function func = GDFunctions::Function(_code_ptr[ip+1]);
 				int argc=_code_ptr[ip+2];
-				ERR_BREAK(argc<0);
+				GD_ERR_BREAK(argc<0);
 
 				ip+=3;
 				CHECK_SPACE(argc+1);
@@ -732,16 +935,16 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 					} else {
 						err_text=_get_call_error(err,"built-in function '"+methodstr+"'",(const Variant**)argptrs);
 					}
-					break;
+					OPCODE_BREAK;
 				}
 				ip+=argc+1;
 
-			} continue;
-			case OPCODE_CALL_SELF: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_CALL_SELF) {
 
 
-			} break;
-			case OPCODE_CALL_SELF_BASE: {
+			} OPCODE_BREAK;
+			OPCODE(OPCODE_CALL_SELF_BASE) {
 
 				CHECK_SPACE(2);
 				int self_fun = _code_ptr[ip+1];
@@ -750,7 +953,7 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (self_fun<0 || self_fun>=_global_names_count) {
 
 					err_text="compiler bug, function name not found";
-					break;
+					OPCODE_BREAK;
 				}
 #endif
 				const StringName *methodname = &_global_names_ptr[self_fun];
@@ -813,14 +1016,14 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 					String methodstr = *methodname;
 					err_text=_get_call_error(err,"function '"+methodstr+"'",(const Variant**)argptrs);
 
-					break;
+					OPCODE_BREAK;
 				}
 
 				ip+=4+argc;
 
-			} continue;
-			case OPCODE_YIELD:
-			case OPCODE_YIELD_SIGNAL: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_YIELD)
+			OPCODE(OPCODE_YIELD_SIGNAL) {
 
 				int ipofs=1;
 				if (_code_ptr[ip]==OPCODE_YIELD_SIGNAL) {
@@ -861,11 +1064,11 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 					if (argobj->get_type()!=Variant::OBJECT) {
 						err_text="First argument of yield() not of type object.";
-						break;
+						OPCODE_BREAK;
 					}
 					if (argname->get_type()!=Variant::STRING) {
 						err_text="Second argument of yield() not a string (for signal name).";
-						break;
+						OPCODE_BREAK;
 					}
 					Object *obj=argobj->operator Object *();
 					String signal = argname->operator String();
@@ -873,25 +1076,25 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 					if (!obj) {
 						err_text="First argument of yield() is null.";
-						break;
+						OPCODE_BREAK;
 					}
 					if (ScriptDebugger::get_singleton()) {
 						if (!ObjectDB::instance_validate(obj)) {
 							err_text="First argument of yield() is a previously freed instance.";
-							break;
+							OPCODE_BREAK;
 						}
 					}
 					if (signal.length()==0) {
 
 						err_text="Second argument of yield() is an empty string (for signal name).";
-						break;
+						OPCODE_BREAK;
 					}
 
 #endif
 					Error err = obj->connect(signal,gdfs.ptr(),"_signal_callback",varray(gdfs),Object::CONNECT_ONESHOT);
 					if (err!=OK) {
 						err_text="Error connecting to signal: "+signal+" during yield().";
-						break;
+						OPCODE_BREAK;
 					}
 
 
@@ -899,29 +1102,29 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 				exit_ok=true;
 
-			} break;
-			case OPCODE_YIELD_RESUME: {
+			} OPCODE_BREAK;
+			OPCODE(OPCODE_YIELD_RESUME) {
 
 				CHECK_SPACE(2);
 				if (!p_state) {
 					err_text=("Invalid Resume (bug?)");
-					break;
+					OPCODE_BREAK;
 				}
 				GET_VARIANT_PTR(result,1);
 				*result=p_state->result;
 				ip+=2;
 
-			} continue;
-			case OPCODE_JUMP: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_JUMP) {
 
 				CHECK_SPACE(2);
 				int to = _code_ptr[ip+1];
 
-				ERR_BREAK(to<0 || to>_code_size);
+				GD_ERR_BREAK(to<0 || to>_code_size);
 				ip=to;
 
-			} continue;
-			case OPCODE_JUMP_IF: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_JUMP_IF) {
 
 				CHECK_SPACE(3);
 
@@ -933,18 +1136,18 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (!valid) {
 
 					err_text="cannot evaluate conditional expression of type: "+Variant::get_type_name(test->get_type());
-					break;
+					OPCODE_BREAK;
 				}
 #endif
 				if (result) {
 					int to = _code_ptr[ip+2];
-					ERR_BREAK(to<0 || to>_code_size);
+					GD_ERR_BREAK(to<0 || to>_code_size);
 					ip=to;
-					continue;
+					DISPATCH_OPCODE;
 				}
 				ip+=3;
-			} continue;
-			case OPCODE_JUMP_IF_NOT: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_JUMP_IF_NOT) {
 
 				CHECK_SPACE(3);
 
@@ -956,32 +1159,68 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (!valid) {
 
 					err_text="cannot evaluate conditional expression of type: "+Variant::get_type_name(test->get_type());
-					break;
+					OPCODE_BREAK;
 				}
 #endif
 				if (!result) {
 					int to = _code_ptr[ip+2];
-					ERR_BREAK(to<0 || to>_code_size);
+					GD_ERR_BREAK(to<0 || to>_code_size);
 					ip=to;
-					continue;
+					DISPATCH_OPCODE;
 				}
 				ip+=3;
-			} continue;
-			case OPCODE_JUMP_TO_DEF_ARGUMENT: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_JUMP_IF_NOT_OPERATOR) {
+
+				CHECK_SPACE(5);
+
+				bool valid;
+				Variant::Operator op = (Variant::Operator)_code_ptr[ip+1];
+				GD_ERR_BREAK(op>=Variant::OP_MAX);
+
+				GET_VARIANT_PTR(a,2);
+				GET_VARIANT_PTR(b,3);
+
+				Variant ret;
+				Variant::evaluate(op,*a,*b,ret,valid);
+
+				if (!valid) {
+#ifdef DEBUG_ENABLED
+
+					if (ret.get_type()==Variant::STRING) {
+						//return a string when invalid with the error
+						err_text=ret;
+						err_text += " in operator '"+Variant::get_operator_name(op)+"'.";
+					} else {
+						err_text="Invalid operands '"+Variant::get_type_name(a->get_type())+"' and '"+Variant::get_type_name(b->get_type())+"' in operator '"+Variant::get_operator_name(op)+"'.";
+					}
+#endif
+					OPCODE_BREAK;
+				}
+
+				if (!ret.booleanize(valid)) {
+					int to = _code_ptr[ip+4];
+					GD_ERR_BREAK(to<0 || to>_code_size);
+					ip=to;
+					DISPATCH_OPCODE;
+				}
+				ip+=5;
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_JUMP_TO_DEF_ARGUMENT) {
 
 				CHECK_SPACE(2);
 				ip=_default_arg_ptr[defarg];
 
-			} continue;
-			case OPCODE_RETURN: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_RETURN) {
 
 				CHECK_SPACE(2);
 				GET_VARIANT_PTR(r,1);
 				retvalue=*r;
 				exit_ok=true;
 
-			} break;
-			case OPCODE_ITERATE_BEGIN: {
+			} OPCODE_BREAK;
+			OPCODE(OPCODE_ITERATE_BEGIN) {
 
 				CHECK_SPACE(8); //space for this an regular iterate
 
@@ -992,12 +1231,12 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (!container->iter_init(*counter,valid)) {
 					if (!valid) {
 						err_text="Unable to iterate on object of type  "+Variant::get_type_name(container->get_type())+"'.";
-						break;
+						OPCODE_BREAK;
 					}
 					int jumpto=_code_ptr[ip+3];
-					ERR_BREAK(jumpto<0 || jumpto>_code_size);
+					GD_ERR_BREAK(jumpto<0 || jumpto>_code_size);
 					ip=jumpto;
-					continue;
+					DISPATCH_OPCODE;
 				}
 				GET_VARIANT_PTR(iterator,4);
 
@@ -1005,14 +1244,14 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				*iterator=container->iter_get(*counter,valid);
 				if (!valid) {
 					err_text="Unable to obtain iterator object of type  "+Variant::get_type_name(container->get_type())+"'.";
-					break;
+					OPCODE_BREAK;
 				}
 
 
 				ip+=5; //skip regular iterate which is always next
 
-			} continue;
-			case OPCODE_ITERATE: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ITERATE) {
 
 				CHECK_SPACE(4);
 
@@ -1023,24 +1262,98 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (!container->iter_next(*counter,valid)) {
 					if (!valid) {
 						err_text="Unable to iterate on object of type  "+Variant::get_type_name(container->get_type())+"' (type changed since first iteration?).";
-						break;
+						OPCODE_BREAK;
 					}
 					int jumpto=_code_ptr[ip+3];
-					ERR_BREAK(jumpto<0 || jumpto>_code_size);
+					GD_ERR_BREAK(jumpto<0 || jumpto>_code_size);
 					ip=jumpto;
-					continue;
+					DISPATCH_OPCODE;
 				}
 				GET_VARIANT_PTR(iterator,4);
 
 				*iterator=container->iter_get(*counter,valid);
 				if (!valid) {
 					err_text="Unable to obtain iterator object of type  "+Variant::get_type_name(container->get_type())+"' (but was obtained on first iteration?).";
-					break;
+					OPCODE_BREAK;
 				}
 
 				ip+=5; //loop again
-			} continue;
-			case OPCODE_ASSERT: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ITERATE_RANGE_BEGIN) {
+
+				CHECK_SPACE(9);
+
+				GET_VARIANT_PTR(counter,1);
+				GET_VARIANT_PTR(to,2);
+				GET_VARIANT_PTR(step,3);
+				GET_VARIANT_PTR(from_arg,4);
+				GET_VARIANT_PTR(to_arg,5);
+				GET_VARIANT_PTR(step_arg,6);
+
+				const Variant *range_args[3]={from_arg,to_arg,step_arg};
+				bool valid=true;
+				for(int i=0;i<3;i++) {
+					if (range_args[i]->get_type()!=Variant::INT && range_args[i]->get_type()!=Variant::REAL) {
+						err_text="Invalid type in built-in function 'range'. Cannot convert "+Variant::get_type_name(range_args[i]->get_type())+" to a number.";
+						valid=false;
+						break;
+					}
+				}
+				if (!valid)
+					OPCODE_BREAK;
+
+				int from_i=*from_arg;
+				int to_i=*to_arg;
+				int step_i=*step_arg;
+
+				if (step_i==0) {
+					err_text="Error calling built-in function 'range': step argument is zero!";
+					OPCODE_BREAK;
+				}
+
+				if (step_i>0 ? from_i>=to_i : from_i<=to_i) {
+					int jumpto=_code_ptr[ip+7];
+					GD_ERR_BREAK(jumpto<0 || jumpto>_code_size);
+					ip=jumpto;
+					DISPATCH_OPCODE;
+				}
+
+				GET_VARIANT_PTR(iterator,8);
+
+				*counter=from_i;
+				*to=to_i;
+				*step=step_i;
+				*iterator=from_i;
+
+				ip+=9; //skip regular iterate which is always next
+
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ITERATE_RANGE) {
+
+				CHECK_SPACE(6);
+
+				GET_VARIANT_PTR(counter,1);
+				GET_VARIANT_PTR(to,2);
+				GET_VARIANT_PTR(step,3);
+
+				int step_i=*step;
+				int next=int(*counter)+step_i;
+
+				if (step_i>0 ? next>=int(*to) : next<=int(*to)) {
+					int jumpto=_code_ptr[ip+4];
+					GD_ERR_BREAK(jumpto<0 || jumpto>_code_size);
+					ip=jumpto;
+					DISPATCH_OPCODE;
+				}
+
+				GET_VARIANT_PTR(iterator,5);
+
+				*counter=next;
+				*iterator=next;
+
+				ip+=6; //loop again
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ASSERT) {
 				CHECK_SPACE(2);
 				GET_VARIANT_PTR(test,1);
 
@@ -1052,29 +1365,29 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (!valid) {
 
 					err_text="cannot evaluate conditional expression of type: "+Variant::get_type_name(test->get_type());
-					break;
+					OPCODE_BREAK;
 				}
 
 
 				if (!result) {
 
 					err_text="Assertion failed.";
-					break;
+					OPCODE_BREAK;
 				}
 
 #endif
 
 				ip+=2;
-			} continue;
-			case OPCODE_BREAKPOINT: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_BREAKPOINT) {
 #ifdef DEBUG_ENABLED
 				if (ScriptDebugger::get_singleton()) {
 					GDScriptLanguage::get_singleton()->debug_break("Breakpoint Statement",true);
 				}
 #endif
 				ip+=1;
-			} continue;
-			case OPCODE_LINE: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_LINE) {
 				CHECK_SPACE(2);
 
 				line=_code_ptr[ip+1];
@@ -1102,20 +1415,23 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 					ScriptDebugger::get_singleton()->line_poll();
 
 				}
-			} continue;
-			case OPCODE_END: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_END) {
 
 				exit_ok=true;
-				break;
 
-			} break;
+			} OPCODE_BREAK;
+#ifndef GDSCRIPT_COMPUTED_GOTO
 			default: {
 
 				err_text="Illegal opcode "+itos(_code_ptr[ip])+" at address "+itos(ip);
-			} break;
+			} OPCODE_BREAK;
+#endif
 
 		}
 
+		OPCODES_END
+
 		if (exit_ok)
 			break;
 		//error
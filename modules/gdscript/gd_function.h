@@ -18,6 +18,9 @@ public:
 
 	enum Opcode {
 		OPCODE_OPERATOR,
+		OPCODE_OPERATOR_INT,
+		OPCODE_OPERATOR_REAL,
+		OPCODE_OPERATOR_VECTOR2,
 		OPCODE_EXTENDS_TEST,
 		OPCODE_SET,
 		OPCODE_GET,
@@ -31,6 +34,7 @@ public:
 		OPCODE_CONSTRUCT_DICTIONARY,
 		OPCODE_CALL,
 		OPCODE_CALL_RETURN,
+		OPCODE_CALL_PTRCALL,
 		OPCODE_CALL_BUILT_IN,
 		OPCODE_CALL_SELF,
 		OPCODE_CALL_SELF_BASE,
@@ -40,10 +44,13 @@ public:
 		OPCODE_JUMP,
 		OPCODE_JUMP_IF,
 		OPCODE_JUMP_IF_NOT,
+		OPCODE_JUMP_IF_NOT_OPERATOR, //comparison fused with the conditional jump
 		OPCODE_JUMP_TO_DEF_ARGUMENT,
 		OPCODE_RETURN,
 		OPCODE_ITERATE_BEGIN,
 		OPCODE_ITERATE,
+		OPCODE_ITERATE_RANGE_BEGIN, //for over range(), counting without building the array
+		OPCODE_ITERATE_RANGE,
 		OPCODE_ASSERT,
 		OPCODE_BREAKPOINT,
 		OPCODE_LINE,
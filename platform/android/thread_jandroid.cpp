@@ -29,6 +29,7 @@
 #include "thread_jandroid.h"
 
 #include "os/memory.h"
+#include "os/frame_allocator.h"
 #include "script_language.h"
 
 Thread::ID ThreadAndroid::get_ID() const {
@@ -49,6 +50,7 @@ void *ThreadAndroid::thread_callback(void *userdata) {
 	t->id=(ID)pthread_self();
 	t->callback(t->user);
 	ScriptServer::thread_exit();
+	FrameAllocator::thread_exit();
 	return NULL;
 }
 
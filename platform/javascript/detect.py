@@ -37,6 +37,7 @@ def get_flags():
 		('speex', 'no'),
 		('old_scenes', 'no'),
 		('etc1', 'no'),
+		('ptrcall', 'no'),
 #		('default_gui_theme', 'no'),
 
 		#('builtin_zlib', 'no'),
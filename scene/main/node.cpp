@@ -34,8 +34,30 @@
 #include "io/resource_loader.h"
 #include "viewport.h"
 #include "instance_placeholder.h"
+#include "oa_hash_map.h"
 
 VARIANT_ENUM_CAST(Node::PauseMode);
+
+// past this amount of children, names are looked up in a hash index instead of scanning them
+#define CHILD_INDEX_THRESHOLD 32
+
+struct Node::ChildNameIndex {
+
+	OAHashMap<StringName,Node*,StringNameHasher> names;
+	OAHashMap<String,int> legible_suffix; // last suffix handed out per basename, for human readable names
+	bool duplicates; // _add_child_nocheck() trusts its caller, so two children may share a name
+
+	ChildNameIndex() { duplicates=false; }
+};
+
+// a node resolving more distinct paths than this starts over, instead of growing without limit
+#define GET_NODE_CACHE_MAX 256
+
+struct Node::GetNodeCache {
+
+	uint64_t tree_version;
+	OAHashMap<NodePath,Node*,NodePathHasher> nodes;
+};
 VARIANT_ENUM_CAST(Node::NetworkMode);
 VARIANT_ENUM_CAST(Node::RPCMode);
 
@@ -154,7 +176,7 @@ void Node::_notification(int p_notification) {
 			// kill children as cleanly as possible
 			while( data.children.size() ) {
 
-				Node *child = data.children[0];
+				Node *child = data.children[data.children.size()-1]; // from the end, nothing to shift
 				remove_child(child);
 				memdelete( child );
 			}
@@ -288,6 +310,7 @@ void Node::_propagate_exit_tree() {
 
 
 	data.viewport = NULL;
+	_clear_get_node_cache();
 
 	if (data.tree)
 		data.tree->tree_changed();
@@ -305,6 +328,10 @@ void Node::_propagate_exit_tree() {
 void Node::move_child(Node *p_child,int p_pos) {
 
 	ERR_FAIL_NULL(p_child);
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"move_child",p_child,p_pos);
+		return;
+	}
 	ERR_EXPLAIN("Invalid new child position: "+itos(p_pos));
 	ERR_FAIL_INDEX( p_pos, data.children.size()+1 );
 	ERR_EXPLAIN("child is not a child of this node.");
@@ -380,6 +407,11 @@ void Node::move_child_notify(Node *p_child) {
 
 void Node::set_fixed_process(bool p_process) {
 
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"set_fixed_process",p_process);
+		return;
+	}
+
 	if (data.fixed_process==p_process)
 		return;
 
@@ -396,30 +428,38 @@ void Node::set_fixed_process(bool p_process) {
 
 void Node::set_pause_mode(PauseMode p_mode) {
 
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"set_pause_mode",int(p_mode));
+		return;
+	}
+
 	if (data.pause_mode==p_mode)
 		return;
 
 	bool prev_inherits=data.pause_mode==PAUSE_MODE_INHERIT;
+	bool prev_can_process=is_inside_tree() && can_process();
 	data.pause_mode=p_mode;
 	if (!is_inside_tree())
 		return; //pointless
-	if ((data.pause_mode==PAUSE_MODE_INHERIT) == prev_inherits)
-		return; ///nothing changed
 
-	Node *owner=NULL;
+	if ((data.pause_mode==PAUSE_MODE_INHERIT) != prev_inherits) {
 
-	if (data.pause_mode==PAUSE_MODE_INHERIT) {
+		Node *owner=NULL;
 
-		if (data.parent)
-			owner=data.parent->data.pause_owner;
-	} else {
-		owner=this;
-	}
-
-	_propagate_pause_owner(owner);
+		if (data.pause_mode==PAUSE_MODE_INHERIT) {
 
+			if (data.parent)
+				owner=data.parent->data.pause_owner;
+		} else {
+			owner=this;
+		}
 
+		_propagate_pause_owner(owner);
+	}
 
+	// while paused, this and the nodes inheriting from it may stop or start processing
+	if (can_process()!=prev_can_process)
+		_propagate_pause_notification(prev_can_process ? NOTIFICATION_PAUSED : NOTIFICATION_UNPAUSED);
 }
 
 Node::PauseMode Node::get_pause_mode() const {
@@ -429,7 +469,7 @@ Node::PauseMode Node::get_pause_mode() const {
 
 void Node::_propagate_pause_owner(Node*p_owner) {
 
-	if (data.pause_mode!=PAUSE_MODE_INHERIT)
+	if (this!=p_owner && data.pause_mode!=PAUSE_MODE_INHERIT)
 		return;
 	data.pause_owner=p_owner;
 	for(int i=0;i<data.children.size();i++) {
@@ -438,6 +478,16 @@ void Node::_propagate_pause_owner(Node*p_owner) {
 	}
 }
 
+void Node::_propagate_pause_notification(int p_notification) {
+
+	notification(p_notification);
+	for(int i=0;i<data.children.size();i++) {
+
+		if (data.children[i]->data.pause_mode==PAUSE_MODE_INHERIT)
+			data.children[i]->_propagate_pause_notification(p_notification);
+	}
+}
+
 void Node::set_network_mode(NetworkMode p_mode) {
 
 	if (data.network_mode==p_mode)
@@ -1110,6 +1160,11 @@ float Node::get_fixed_process_delta_time() const {
 
 void Node::set_process(bool p_idle_process) {
 
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"set_process",p_idle_process);
+		return;
+	}
+
 	if (data.idle_process==p_idle_process)
 		return;
 
@@ -1142,6 +1197,16 @@ bool Node::is_processing() const {
 	return data.idle_process;
 }
 
+void Node::set_process_threaded(bool p_enable) {
+
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"set_process_threaded",p_enable);
+		return;
+	}
+
+	data.threaded_process=p_enable;
+}
+
 
 void Node::set_process_input(bool p_enable) {
 
@@ -1211,20 +1276,40 @@ StringName Node::get_name() const {
 
 void Node::_set_name_nocheck(const StringName& p_name) {
 
+	ERR_FAIL_COND(_must_defer_tree_change()); // the parent's child index is being read
+	StringName old_name=data.name;
 	data.name=p_name;
 
+	if (data.parent && data.parent->data.child_index) {
+		data.parent->_child_index_remove(this,old_name);
+		data.parent->_child_index_add(this);
+	}
+
+	if (data.inside_tree)
+		data.tree->tree_version++; // get_node() caches may have resolved the old name
 }
 
 void Node::set_name(const String& p_name) {
 
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"set_name",p_name);
+		return;
+	}
+
 	String name=p_name.replace(":","").replace("/","").replace("@","");
 
 	ERR_FAIL_COND(name=="");
+	StringName old_name=data.name;
 	data.name=name;
 
 	if (data.parent) {
 
 		data.parent->_validate_child_name(this);
+
+		if (data.parent->data.child_index) {
+			data.parent->_child_index_remove(this,old_name);
+			data.parent->_child_index_add(this);
+		}
 	}
 
 	propagate_notification(NOTIFICATION_PATH_CHANGED);
@@ -1313,24 +1398,19 @@ void Node::_validate_child_name(Node *p_child, bool p_force_human_readable) {
 
 		int val=1;
 
-		for(;;) {
+		if (data.child_index) {
 
-			String attempted = val > 1 ? (basename + " " +itos(val) ) : basename;
-
-			bool found=false;
-
-			for (int i=0;i<data.children.size();i++) {
+			//with many siblings sharing a basename, start past the suffixes already handed out
+			const int *last=data.child_index->legible_suffix.getptr(basename);
+			if (last && !_is_child_name_free(p_child,basename))
+				val=*last+1;
+		}
 
-				if (data.children[i]==p_child)
-					continue;
-				if (data.children[i]->get_name() == attempted) {
-					found=true;
-					break;
-				}
+		for(;;) {
 
-			}
+			String attempted = val > 1 ? (basename + " " +itos(val) ) : basename;
 
-			if (found) {
+			if (!_is_child_name_free(p_child,attempted)) {
 
 				val++;
 				continue;
@@ -1339,6 +1419,9 @@ void Node::_validate_child_name(Node *p_child, bool p_force_human_readable) {
 			p_child->data.name=attempted;
 			break;
 		}
+
+		if (data.child_index && val>1)
+			data.child_index->legible_suffix.set(basename,val);
 	} else {
 
 		//this approach to autoset node names is fast but not as readable
@@ -1351,17 +1434,7 @@ void Node::_validate_child_name(Node *p_child, bool p_force_human_readable) {
 			unique=false;
 		} else {
 			//check if exists
-			Node **childs=data.children.ptr();
-			int cc = data.children.size();
-
-			for(int i=0;i<cc;i++) {
-				if (childs[i]==p_child)
-					continue;
-				if (childs[i]->data.name==p_child->data.name) {
-					unique=false;
-					break;
-				}
-			}
+			unique=_is_child_name_free(p_child,p_child->data.name);
 		}
 
 		if (!unique) {
@@ -1379,6 +1452,11 @@ void Node::_add_child_nocheck(Node* p_child,const StringName& p_name) {
 	p_child->data.name=p_name;
 	p_child->data.pos=data.children.size();
 	data.children.push_back( p_child );
+
+	if (data.child_index)
+		_child_index_add(p_child);
+	else if (data.children.size()>CHILD_INDEX_THRESHOLD)
+		_child_index_build();
 	p_child->data.parent=this;
 	p_child->notification(NOTIFICATION_PARENTED);
 
@@ -1398,6 +1476,11 @@ void Node::_add_child_nocheck(Node* p_child,const StringName& p_name) {
 void Node::add_child(Node *p_child, bool p_legible_unique_name) {
 
 	ERR_FAIL_NULL(p_child);
+	if (_must_defer_tree_change()) {
+		// called from a threaded process callback, the tree only changes once they are all done
+		MessageQueue::get_singleton()->push_call(this,"add_child",p_child,p_legible_unique_name);
+		return;
+	}
 	/* Fail if node has a parent */
 	if (p_child==this) {
 		ERR_EXPLAIN("Can't add child "+p_child->get_name()+" to itself.")
@@ -1472,22 +1555,18 @@ void Node::_propagate_validate_owner() {
 void Node::remove_child(Node *p_child) {
 
 	ERR_FAIL_NULL(p_child);
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"remove_child",p_child);
+		return;
+	}
 	if (data.blocked>0) {
 		ERR_EXPLAIN("Parent node is busy setting up children, remove_node() failed. Consider using call_deferred(\"remove_child\",child) instead.");
 		ERR_FAIL_COND(data.blocked>0);
 	}
 
-	int idx=-1;
-	for (int i=0;i<data.children.size();i++) {
-
-		if (data.children[i]==p_child) {
-
-			idx=i;
-			break;
-		}
-	}
+	int idx=p_child->data.pos;
 
-	ERR_FAIL_COND( idx==-1 );
+	ERR_FAIL_COND( idx<0 || idx>=data.children.size() || data.children[idx]!=p_child );
 	//ERR_FAIL_COND( p_child->data.blocked > 0 );
 
 
@@ -1501,6 +1580,14 @@ void Node::remove_child(Node *p_child) {
 
 	data.children.remove(idx);
 
+	if (data.child_index) {
+
+		if (data.children.size()<CHILD_INDEX_THRESHOLD/2)
+			_child_index_free();
+		else
+			_child_index_remove(p_child,p_child->data.name);
+	}
+
 	for (int i=idx;i<data.children.size();i++) {
 
 		data.children[i]->data.pos=i;
@@ -1516,6 +1603,86 @@ void Node::remove_child(Node *p_child) {
 
 }
 
+bool Node::_recycle() {
+
+	if (data.recycle_state.is_null())
+		return false;
+
+	Ref<SceneState> state=data.recycle_state;
+	data.recycle_state.unref(); // the pool doesn't keep its scene alive
+	return state->recycle_instance(this);
+}
+
+bool Node::_is_child_name_free(Node *p_child,const StringName& p_name) const {
+
+	if (data.child_index) {
+
+		Node * const *child=data.child_index->names.getptr(p_name);
+		return !child || *child==p_child;
+	}
+
+	Node * const *childs=data.children.ptr();
+	int cc=data.children.size();
+
+	for(int i=0;i<cc;i++) {
+		if (childs[i]!=p_child && childs[i]->data.name==p_name)
+			return false;
+	}
+
+	return true;
+}
+
+void Node::_child_index_build() {
+
+	data.child_index=memnew(ChildNameIndex);
+
+	for(int i=0;i<data.children.size();i++) {
+		_child_index_add(data.children[i]);
+	}
+}
+
+void Node::_child_index_free() {
+
+	if (data.child_index) {
+		memdelete(data.child_index);
+		data.child_index=NULL;
+	}
+}
+
+void Node::_child_index_add(Node *p_child) {
+
+	Node **existing=data.child_index->names.getptr(p_child->data.name);
+	if (existing) {
+		if (*existing!=p_child)
+			data.child_index->duplicates=true;
+		return;
+	}
+
+	data.child_index->names.set(p_child->data.name,p_child);
+}
+
+void Node::_child_index_remove(Node *p_child,const StringName& p_name) {
+
+	Node **existing=data.child_index->names.getptr(p_name);
+	if (!existing || *existing!=p_child)
+		return;
+
+	data.child_index->names.erase(p_name);
+
+	if (!data.child_index->duplicates)
+		return;
+
+	//another child may still use this name, keep it reachable
+	for(int i=0;i<data.children.size();i++) {
+
+		Node *c=data.children[i];
+		if (c!=p_child && c->data.name==p_name) {
+			data.child_index->names.set(p_name,c);
+			break;
+		}
+	}
+}
+
 int Node::get_child_count() const {
 
 	return data.children.size();
@@ -1530,6 +1697,12 @@ Node *Node::get_child(int p_index) const {
 
 Node *Node::_get_child_by_name(const StringName& p_name) const {
 
+	if (data.child_index) {
+
+		Node * const *child=data.child_index->names.getptr(p_name);
+		return child ? *child : NULL;
+	}
+
 	int cc=data.children.size();
 	Node* const* cd=data.children.ptr();
 
@@ -1541,8 +1714,63 @@ Node *Node::_get_child_by_name(const StringName& p_name) const {
 	return NULL;
 }
 
+void Node::_clear_get_node_cache() const {
+
+	if (data.get_node_cache) {
+		memdelete(data.get_node_cache);
+		data.get_node_cache=NULL;
+	}
+}
+
 Node *Node::_get_node(const NodePath& p_path) const {
 
+	if (!data.inside_tree)
+		return _get_node_uncached(p_path);
+
+	/* Results are valid until something leaves the tree or gets renamed, which bumps the tree version.
+	   Adding nodes can't change what an existing path resolves to, and failed lookups are not kept. */
+
+	SceneTree *tree=data.tree;
+	GetNodeCache *cache=data.get_node_cache;
+	// threaded process callbacks may be resolving paths at the same time, only read then
+	bool threaded=tree->is_threaded_process_running();
+
+	if (cache && cache->tree_version==tree->tree_version) {
+
+		Node * const *node=cache->nodes.getptr(p_path);
+		if (node) {
+			if (!threaded)
+				tree->node_path_cache_hits++;
+			return *node;
+		}
+	}
+
+	Node *node=_get_node_uncached(p_path);
+
+	if (threaded)
+		return node;
+
+	tree->node_path_cache_misses++;
+
+	if (!node || !node->data.inside_tree) // also while being removed, the version was bumped already
+		return node;
+
+	if (!cache) {
+		cache=memnew(GetNodeCache);
+		cache->tree_version=tree->tree_version;
+		data.get_node_cache=cache;
+	} else if (cache->tree_version!=tree->tree_version || cache->nodes.size()>=GET_NODE_CACHE_MAX) {
+		cache->nodes.clear();
+		cache->tree_version=tree->tree_version;
+	}
+
+	cache->nodes.set(p_path,node);
+
+	return node;
+}
+
+Node *Node::_get_node_uncached(const NodePath& p_path) const {
+
 	if (!data.inside_tree && p_path.is_absolute()) {
 		ERR_EXPLAIN("Can't use get_node() with absolute paths from outside the active scene tree.");
 		ERR_FAIL_V(NULL);
@@ -1584,18 +1812,8 @@ Node *Node::_get_node(const NodePath& p_path) const {
 
 		} else {
 
-			next=NULL;
-
-			for(int j=0;j<current->data.children.size();j++) {
+			next=current->_get_child_by_name(name);
 
-				Node *child = current->data.children[j];
-
-				if ( child->data.name == name ) {
-
-					next = child;
-					break;
-				}
-			}
 			if (next == NULL) {
 				return NULL;
 			};
@@ -1749,6 +1967,11 @@ void Node::_set_owner_nocheck(Node* p_owner) {
 
 void Node::set_owner(Node *p_owner) {
 
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"set_owner",p_owner);
+		return;
+	}
+
 	if (data.owner) {
 
 		data.owner->data.owned.erase( data.OW );
@@ -1900,6 +2123,10 @@ bool Node::is_in_group(const StringName& p_identifier) const {
 void Node::add_to_group(const StringName& p_identifier,bool p_persistent) {
 
 	ERR_FAIL_COND(!p_identifier.operator String().length());
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"add_to_group",p_identifier,p_persistent);
+		return;
+	}
 
 	if (data.grouped.has(p_identifier))
 		return;
@@ -1920,6 +2147,10 @@ void Node::add_to_group(const StringName& p_identifier,bool p_persistent) {
 
 void Node::remove_from_group(const StringName& p_identifier) {
 
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"remove_from_group",p_identifier);
+		return;
+	}
 
 	ERR_FAIL_COND(!data.grouped.has(p_identifier) );
 
@@ -2475,6 +2706,10 @@ struct _NodeReplaceByPair {
 void Node::replace_by(Node* p_node,bool p_keep_data) {
 
 	ERR_FAIL_NULL(p_node);
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"replace_by",p_node,p_keep_data);
+		return;
+	}
 	ERR_FAIL_COND(p_node->data.parent);
 
 	List<Node*> owned = data.owned;
@@ -2720,6 +2955,10 @@ void Node::print_stray_nodes() {
 void Node::queue_delete() {
 
 	ERR_FAIL_COND( !is_inside_tree() );
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"queue_free");
+		return;
+	}
 	get_tree()->queue_delete(this);
 }
 
@@ -2853,6 +3092,8 @@ void Node::_bind_methods() {
 	ObjectTypeDB::bind_method(_MD("set_process","enable"),&Node::set_process);
 	ObjectTypeDB::bind_method(_MD("get_process_delta_time"),&Node::get_process_delta_time);
 	ObjectTypeDB::bind_method(_MD("is_processing"),&Node::is_processing);
+	ObjectTypeDB::bind_method(_MD("set_process_threaded","enable"),&Node::set_process_threaded);
+	ObjectTypeDB::bind_method(_MD("is_processing_threaded"),&Node::is_processing_threaded);
 	ObjectTypeDB::bind_method(_MD("set_process_input","enable"),&Node::set_process_input);
 	ObjectTypeDB::bind_method(_MD("is_processing_input"),&Node::is_processing_input);
 	ObjectTypeDB::bind_method(_MD("set_process_unhandled_input","enable"),&Node::set_process_unhandled_input);
@@ -2988,6 +3229,7 @@ Node::Node() {
 	data.tree=NULL;
 	data.fixed_process=false;
 	data.idle_process=false;
+	data.threaded_process=false;
 	data.inside_tree=false;
 
 	data.owner=NULL;
@@ -3000,6 +3242,8 @@ Node::Node() {
 	data.network_mode=NETWORK_MODE_INHERIT;
 	data.network_owner=NULL;
 	data.path_cache=NULL;
+	data.child_index=NULL;
+	data.get_node_cache=NULL;
 	data.parent_owned=false;
 	data.in_constructor=true;
 	data.viewport=NULL;
@@ -3014,6 +3258,8 @@ Node::~Node() {
 	data.grouped.clear();
 	data.owned.clear();
 	data.children.clear();
+	_child_index_free();
+	_clear_get_node_cache();
 
 
 	ERR_FAIL_COND(data.parent);
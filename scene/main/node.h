@@ -85,17 +85,22 @@ private:
 
 
 
+	struct ChildNameIndex;
+	struct GetNodeCache;
+
 	struct Data {
 
 		String filename;
 		Ref<SceneState> instance_state;
 		Ref<SceneState> inherited_state;
+		Ref<SceneState> recycle_state; // instanced from a pooled scene, goes back to it instead of being deleted
 
 		HashMap<NodePath,int> editable_instances;
 
 		Node *parent;
 		Node *owner;
 		Vector<Node*> children;	// list of children
+		ChildNameIndex *child_index; // name -> child, only built for nodes with many children
 		int pos;
 		int depth;
 		int blocked; // safeguard that throws an error when attempting to modify the tree in a harmful way while being traversed.
@@ -126,6 +131,7 @@ private:
 		//should move all the stuff below to bits
 		bool fixed_process;
 		bool idle_process;
+		bool threaded_process;
 
 		bool input;
 		bool unhandled_input;
@@ -138,6 +144,7 @@ private:
 		bool display_folded;
 
 		mutable NodePath *path_cache;
+		mutable GetNodeCache *get_node_cache; // paths resolved from this node, valid while the tree version does not change
 
 	} data;
 
@@ -145,8 +152,18 @@ private:
 	void _print_tree(const Node *p_node);
 
 	virtual bool _use_builtin_script() const { return true; }
+	virtual bool _must_defer_free() const { return _must_defer_tree_change(); }
 	Node *_get_node(const NodePath& p_path) const;
+	Node *_get_node_uncached(const NodePath& p_path) const;
+	void _clear_get_node_cache() const;
 	Node *_get_child_by_name(const StringName& p_name) const;
+	bool _recycle();
+
+	void _child_index_build();
+	void _child_index_free();
+	void _child_index_add(Node *p_child);
+	void _child_index_remove(Node *p_child,const StringName& p_name);
+	bool _is_child_name_free(Node *p_child,const StringName& p_name) const;
 
 	void _replace_connections_target(Node* p_new_target);
 
@@ -160,6 +177,7 @@ private:
 	void _propagate_validate_owner();
 	void _print_stray_nodes();
 	void _propagate_pause_owner(Node*p_owner);
+	void _propagate_pause_notification(int p_notification);
 	void _propagate_network_owner(Node*p_owner);
 	Array _get_node_and_resource(const NodePath& p_path);
 
@@ -183,6 +201,8 @@ protected:
 	void _block() { data.blocked++; }
 	void _unblock()  { data.blocked--; }
 
+	_FORCE_INLINE_ bool _must_defer_tree_change() const { return data.tree && data.tree->is_threaded_process_running(); }
+
 	void _notification(int p_notification);
 
 	virtual void add_child_notify(Node *p_child);
@@ -298,6 +318,9 @@ public:
 	float get_process_delta_time() const;
 	bool is_processing() const;
 
+	void set_process_threaded(bool p_enable);
+	_FORCE_INLINE_ bool is_processing_threaded() const { return data.threaded_process; }
+
 
 	void set_process_input(bool p_enable);
 	bool is_processing_input() const;
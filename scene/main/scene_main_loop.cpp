@@ -41,10 +41,131 @@
 #include "scene/scene_string_names.h"
 #include "io/resource_loader.h"
 #include "viewport.h"
+#include "timer.h"
 #include "scene/resources/packed_scene.h"
 #include "scene/resources/material.h"
 #include "scene/resources/mesh.h"
 #include "io/marshalls.h"
+#include "os/worker_thread_pool.h"
+
+void SceneTreeTimerQueue::_sift_up(Entry *p_heap,int p_pos,const Entry& p_entry) {
+
+	while(p_pos>0) {
+
+		int parent=(p_pos-1)/2;
+		if (!_before(p_entry,p_heap[parent]))
+			break;
+		p_heap[p_pos]=p_heap[parent];
+		*p_heap[p_pos].index=p_pos;
+		p_pos=parent;
+	}
+
+	p_heap[p_pos]=p_entry;
+	*p_entry.index=p_pos;
+}
+
+void SceneTreeTimerQueue::_sift_down(Entry *p_heap,int p_pos,const Entry& p_entry) {
+
+	int count=heap.size();
+
+	while(true) {
+
+		int child=p_pos*2+1;
+		if (child>=count)
+			break;
+		if (child+1<count && _before(p_heap[child+1],p_heap[child]))
+			child++;
+		if (!_before(p_heap[child],p_entry))
+			break;
+		p_heap[p_pos]=p_heap[child];
+		*p_heap[p_pos].index=p_pos;
+		p_pos=child;
+	}
+
+	p_heap[p_pos]=p_entry;
+	*p_entry.index=p_pos;
+}
+
+void SceneTreeTimerQueue::queue(Object *p_timer,int *p_index,double p_time_left) {
+
+	ERR_FAIL_NULL(p_timer);
+
+	Entry e;
+	e.deadline=time+p_time_left;
+	e.order=++last_order;
+	e.timer=p_timer;
+	e.index=p_index;
+
+	if (*p_index<0) {
+
+		heap.resize(heap.size()+1);
+		_sift_up(heap.ptr(),heap.size()-1,e);
+
+	} else {
+
+		ERR_FAIL_INDEX(*p_index,heap.size());
+		Entry *h=heap.ptr();
+		ERR_FAIL_COND(h[*p_index].timer!=p_timer);
+		if (_before(e,h[*p_index]))
+			_sift_up(h,*p_index,e);
+		else
+			_sift_down(h,*p_index,e);
+	}
+}
+
+void SceneTreeTimerQueue::unqueue(int *p_index) {
+
+	ERR_FAIL_INDEX(*p_index,heap.size());
+
+	int pos=*p_index;
+	*p_index=-1;
+
+	int last=heap.size()-1;
+	if (pos!=last) {
+
+		Entry *h=heap.ptr();
+		Entry e=h[last];
+		if (_before(e,h[pos]))
+			_sift_up(h,pos,e);
+		else
+			_sift_down(h,pos,e);
+	}
+	heap.resize(last);
+}
+
+double SceneTreeTimerQueue::get_time_left(int p_index) const {
+
+	ERR_FAIL_INDEX_V(p_index,heap.size(),0);
+	return heap[p_index].deadline-time;
+}
+
+Object *SceneTreeTimerQueue::pop_expired(double *r_time_left) {
+
+	if (heap.size()==0 || !(heap[0].deadline<time))
+		return NULL;
+
+	return pop(r_time_left);
+}
+
+Object *SceneTreeTimerQueue::pop(double *r_time_left) {
+
+	if (heap.size()==0)
+		return NULL;
+
+	const Entry &e=heap[0];
+	Object *timer=e.timer;
+	if (r_time_left)
+		*r_time_left=e.deadline-time;
+	unqueue(e.index);
+	return timer;
+}
+
+SceneTreeTimerQueue::SceneTreeTimerQueue() {
+
+	time=0;
+	last_order=0;
+}
+
 
 void SceneTreeTimer::_bind_methods() {
 
@@ -56,16 +177,25 @@ void SceneTreeTimer::_bind_methods() {
 
 
 void SceneTreeTimer::set_time_left(float p_time) {
-	time_left=p_time;
+
+	if (queue_index>=0)
+		tree->timers.queue(this,&queue_index,p_time);
+	else
+		time_left=p_time;
 }
 
 float SceneTreeTimer::get_time_left() const {
+
+	if (queue_index>=0)
+		return tree->timers.get_time_left(queue_index);
 	return time_left;
 }
 
 
 SceneTreeTimer::SceneTreeTimer() {
 	time_left=0;
+	tree=NULL;
+	queue_index=-1;
 }
 
 
@@ -509,6 +639,7 @@ void SceneTree::init() {
 
 bool SceneTree::iteration(float p_time) {
 
+	MemoryCategoryScope mem_scope(Memory::ALLOC_NODE);
 
 	root_lock++;
 
@@ -522,6 +653,7 @@ bool SceneTree::iteration(float p_time) {
 	emit_signal("fixed_frame");
 
 	_notify_group_pause("fixed_process",Node::NOTIFICATION_FIXED_PROCESS);
+	_process_node_timers(fixed_node_timers,p_time);
 	_flush_ugc();
 	_flush_transform_notifications();
 	call_group(GROUP_CALL_REALTIME,"_viewports","update_worlds");
@@ -534,6 +666,7 @@ bool SceneTree::iteration(float p_time) {
 
 bool SceneTree::idle(float p_time){
 
+	MemoryCategoryScope mem_scope(Memory::ALLOC_NODE);
 
 //	print_line("ram: "+itos(OS::get_singleton()->get_static_memory_usage())+" sram: "+itos(OS::get_singleton()->get_dynamic_memory_usage()));
 //	print_line("node count: "+itos(get_node_count()));
@@ -547,11 +680,14 @@ bool SceneTree::idle(float p_time){
 
 	_network_poll();
 
+	_poll_pending_scene();
+
 	emit_signal("idle_frame");
 
 	_flush_transform_notifications();
 
 	_notify_group_pause("idle_process",Node::NOTIFICATION_PROCESS);
+	_process_node_timers(idle_node_timers,p_time);
 
 	Size2 win_size=Size2( OS::get_singleton()->get_video_mode().width, OS::get_singleton()->get_video_mode().height );
 	if(win_size!=last_screen_size) {
@@ -573,26 +709,31 @@ bool SceneTree::idle(float p_time){
 
 	_flush_delete_queue();
 
-	//go through timers
-
-	for (List<Ref<SceneTreeTimer> >::Element *E=timers.front();E;) {
+	//go through the timers that are due
 
-		List<Ref<SceneTreeTimer> >::Element *N = E->next();
+	timers.advance(p_time);
 
-		float time_left = E->get()->get_time_left();
-		time_left-=p_time;
-		E->get()->set_time_left(time_left);
+	double time_left;
+	while(SceneTreeTimer *timer=static_cast<SceneTreeTimer*>(timers.pop_expired(&time_left))) {
 
-		if (time_left<0) {
-			E->get()->emit_signal("timeout");
-			timers.erase(E);
-		}
-		E=N;
+		timer->time_left=time_left;
+		timer->emit_signal("timeout");
+		if (timer->unreference())
+			memdelete(timer);
 	}
 
 	return _quit;
 }
 
+void SceneTree::_process_node_timers(SceneTreeTimerQueue& p_queue,float p_time) {
+
+	p_queue.advance(p_time);
+
+	while(Timer *timer=static_cast<Timer*>(p_queue.pop_expired())) {
+		timer->_timeout();
+	}
+}
+
 void SceneTree::finish() {
 
 	_flush_delete_queue();
@@ -931,9 +1072,44 @@ void SceneTree::_notify_group_pause(const StringName& p_group,int p_notification
 
 	call_lock++;
 
+	WorkerThreadPool *pool=WorkerThreadPool::get_singleton();
+	bool use_threads = pool && !threaded_process_running && (p_notification==Node::NOTIFICATION_PROCESS || p_notification==Node::NOTIFICATION_FIXED_PROCESS);
+
+	if (use_threads) {
+
+		// threaded nodes run first, all together. Whatever they do to the tree is
+		// deferred through the MessageQueue, so they only ever see it unchanged.
+		threaded_process_nodes.clear();
+		for(int i=0;i<node_count;i++) {
+
+			Node *n = nodes[i];
+			if (!n->is_processing_threaded())
+				continue;
+			if (call_lock && call_skip.has(n))
+				continue;
+			if (!n->can_process())
+				continue;
+			threaded_process_nodes.push_back(n);
+		}
+
+		int threaded_count=threaded_process_nodes.size();
+		if (threaded_count) {
+
+			threaded_process_notification=p_notification;
+			threaded_process_running=true;
+			int grain=MAX(1,threaded_count/(pool->get_thread_count()*4));
+			pool->parallel_for(threaded_count,_threaded_process_nodes,this,grain);
+			threaded_process_running=false;
+		}
+	}
+
+	// serial nodes only start once every threaded one is done
 	for(int i=0;i<node_count;i++) {
 
 		Node *n = nodes[i];
+		if (use_threads && n->is_processing_threaded())
+			continue;
+
 		if (call_lock && call_skip.has(n))
 			continue;
 
@@ -949,6 +1125,14 @@ void SceneTree::_notify_group_pause(const StringName& p_group,int p_notification
 		call_skip.clear();
 }
 
+void SceneTree::_threaded_process_nodes(void *p_userdata,int p_from,int p_to) {
+
+	SceneTree *self=(SceneTree*)p_userdata;
+	const Vector<Node*> &nodes=self->threaded_process_nodes;
+	for(int i=p_from;i<p_to;i++)
+		nodes.get(i)->notification(self->threaded_process_notification);
+}
+
 /*
 void SceneMainLoop::_update_listener_2d() {
 
@@ -1073,7 +1257,9 @@ void SceneTree::_flush_delete_queue() {
 
 		Object *obj = ObjectDB::get_instance( delete_queue.front()->get() );
 		if (obj) {
-			memdelete( obj );
+			Node *node = obj->cast_to<Node>();
+			if (!node || !node->_recycle()) // instances of pooled scenes are kept for reuse
+				memdelete( obj );
 		}
 		delete_queue.pop_front();
 	}
@@ -1262,6 +1448,49 @@ Error SceneTree::change_scene_to(const Ref<PackedScene>& p_scene){
 	return OK;
 
 }
+Error SceneTree::change_scene_threaded(const String& p_path){
+
+	ERR_FAIL_COND_V(pending_scene_path!="",ERR_BUSY);
+
+	Error err = ResourceLoader::load_threaded_request(p_path,"PackedScene");
+	if (err!=OK)
+		return err;
+
+	pending_scene_path=p_path;
+	return OK;
+}
+
+float SceneTree::get_change_scene_progress() const {
+
+	if (pending_scene_path=="")
+		return 1.0;
+
+	float progress=0;
+	ResourceLoader::load_threaded_poll(pending_scene_path,&progress);
+	return progress;
+}
+
+void SceneTree::_poll_pending_scene() {
+
+	if (pending_scene_path=="")
+		return;
+
+	if (ResourceLoader::load_threaded_poll(pending_scene_path)==ResourceLoader::THREAD_LOAD_IN_PROGRESS)
+		return;
+
+	Error err;
+	Ref<PackedScene> new_scene = ResourceLoader::load_threaded_get(pending_scene_path,&err);
+	String path=pending_scene_path;
+	pending_scene_path="";
+
+	if (new_scene.is_null()) {
+		ERR_EXPLAIN("Failed loading scene: "+path);
+		ERR_FAIL();
+	}
+
+	change_scene_to(new_scene);
+}
+
 Error SceneTree::reload_current_scene() {
 
 	ERR_FAIL_COND_V(!current_scene,ERR_UNCONFIGURED);
@@ -1652,8 +1881,9 @@ Ref<SceneTreeTimer> SceneTree::create_timer(float p_delay_sec) {
 
 	Ref<SceneTreeTimer> stt;
 	stt.instance();
-	stt->set_time_left(p_delay_sec);
-	timers.push_back(stt);
+	stt->tree=this;
+	stt->reference(); // released when it times out
+	timers.queue(stt.ptr(),&stt->queue_index,p_delay_sec);
 	return stt;
 }
 
@@ -1975,9 +2205,8 @@ void SceneTree::_network_process_packet(int p_from, const uint8_t* p_packet, int
 				ERR_FAIL_COND(!F);
 
 				PathGetCache::NodeInfo *ni = &F->get();
-				//do proper caching later
 
-				node = get_root()->get_node(ni->path);
+				node = get_root()->get_node(ni->path); // same path every time, answered by the root's node path cache
 				if (node==NULL) {
 					ERR_EXPLAIN("Failed to get cached path from RPC: "+String(ni->path));
 					ERR_FAIL_COND(node==NULL);
@@ -2209,6 +2438,8 @@ void SceneTree::_bind_methods() {
 
 	ObjectTypeDB::bind_method(_MD("change_scene","path"),&SceneTree::change_scene);
 	ObjectTypeDB::bind_method(_MD("change_scene_to","packed_scene:PackedScene"),&SceneTree::change_scene_to);
+	ObjectTypeDB::bind_method(_MD("change_scene_threaded","path"),&SceneTree::change_scene_threaded);
+	ObjectTypeDB::bind_method(_MD("get_change_scene_progress"),&SceneTree::get_change_scene_progress);
 
 	ObjectTypeDB::bind_method(_MD("reload_current_scene"),&SceneTree::reload_current_scene);
 
@@ -2274,6 +2505,8 @@ SceneTree::SceneTree() {
 
 
 	tree_version=1;
+	node_path_cache_hits=0;
+	node_path_cache_misses=0;
 	fixed_process_time=1;
 	idle_process_time=1;
 	last_id=1;
@@ -2283,6 +2516,8 @@ SceneTree::SceneTree() {
 	node_removed_name="node_removed";
 	ugc_locked=false;
 	call_lock=0;
+	threaded_process_running=false;
+	threaded_process_notification=0;
 	root_lock=0;
 	node_count=0;
 
@@ -2350,5 +2585,12 @@ SceneTree::SceneTree() {
 
 SceneTree::~SceneTree() {
 
+	double time_left;
+	while(SceneTreeTimer *timer=static_cast<SceneTreeTimer*>(timers.pop(&time_left))) {
+
+		timer->time_left=time_left;
+		if (timer->unreference())
+			memdelete(timer);
+	}
 
 }
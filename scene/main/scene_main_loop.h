@@ -52,10 +52,54 @@ class Mesh;
 
 
 
+// Timers waiting on a clock, kept as a binary min-heap on their deadlines.
+// Finding out nothing expired is O(1) and queueing, moving or removing a
+// timer is O(log n), so a frame costs the same however many are pending.
+// Each queued timer owns an int the queue keeps at its heap position, -1
+// while it is not queued.
+
+class SceneTreeTimerQueue {
+
+	struct Entry {
+
+		double deadline;
+		uint64_t order; // same deadline, same order they were queued in
+		Object *timer;
+		int *index;
+	};
+
+	double time;
+	uint64_t last_order;
+	Vector<Entry> heap;
+
+	_FORCE_INLINE_ static bool _before(const Entry& p_a,const Entry& p_b) { return p_a.deadline<p_b.deadline || (p_a.deadline==p_b.deadline && p_a.order<p_b.order); }
+	void _sift_up(Entry *p_heap,int p_pos,const Entry& p_entry);
+	void _sift_down(Entry *p_heap,int p_pos,const Entry& p_entry);
+
+public:
+
+	void advance(double p_time) { time+=p_time; }
+	double get_time() const { return time; }
+
+	void queue(Object *p_timer,int *p_index,double p_time_left); // moves it when already queued
+	void unqueue(int *p_index);
+	double get_time_left(int p_index) const;
+
+	Object *pop_expired(double *r_time_left=NULL); // NULL when nothing is due
+	Object *pop(double *r_time_left=NULL);
+	int size() const { return heap.size(); }
+
+	SceneTreeTimerQueue();
+};
+
 class SceneTreeTimer : public Reference {
 	OBJ_TYPE(SceneTreeTimer,Reference);
 
-	float time_left;
+	float time_left; // while not queued
+	SceneTree *tree;
+	int queue_index;
+
+friend class SceneTree;
 protected:
 	static void _bind_methods();
 public:
@@ -102,6 +146,8 @@ private:
 	Viewport *root;
 
 	uint64_t tree_version;
+	uint64_t node_path_cache_hits;
+	uint64_t node_path_cache_misses;
 	float fixed_process_time;
 	float idle_process_time;
 	bool accept_quit;
@@ -140,6 +186,13 @@ private:
 	int call_lock;
 	Set<Node*> call_skip; //skip erased nodes
 
+	//nodes with threaded process enabled, notified in parallel before the rest
+	bool threaded_process_running;
+	Vector<Node*> threaded_process_nodes;
+	int threaded_process_notification;
+
+	static void _threaded_process_nodes(void *p_userdata,int p_from,int p_to);
+
 
 	StretchMode stretch_mode;
 	StretchAspect stretch_aspect;
@@ -172,9 +225,14 @@ private:
 	int collision_debug_contacts;
 
 	void _change_scene(Node* p_to);
+	String pending_scene_path; // being loaded by change_scene_threaded()
+	void _poll_pending_scene();
 	//void _call_group(uint32_t p_call_flags,const StringName& p_group,const StringName& p_function,const Variant& p_arg1,const Variant& p_arg2);
 
-	List<Ref<SceneTreeTimer> > timers;
+	SceneTreeTimerQueue timers; // holds a reference to each SceneTreeTimer in it
+	SceneTreeTimerQueue idle_node_timers;
+	SceneTreeTimerQueue fixed_node_timers;
+	void _process_node_timers(SceneTreeTimerQueue& p_queue,float p_time);
 
 
 	///network///
@@ -248,6 +306,8 @@ friend class Node;
 friend class CanvasItem;
 friend class Spatial;
 friend class Viewport;
+friend class SceneTreeTimer;
+friend class Timer;
 
 	SelfList<Node>::List xform_change_list;
 
@@ -357,6 +417,8 @@ public:
 	void set_pause(bool p_enabled);
 	bool is_paused() const;
 
+	_FORCE_INLINE_ bool is_threaded_process_running() const { return threaded_process_running; } ///< tree changes must be deferred while true
+
 	void set_camera(const RID& p_camera);
 	RID get_camera() const;
 
@@ -390,6 +452,9 @@ public:
 
 	int get_node_count() const;
 
+	_FORCE_INLINE_ uint64_t get_node_path_cache_hits() const { return node_path_cache_hits; }
+	_FORCE_INLINE_ uint64_t get_node_path_cache_misses() const { return node_path_cache_misses; }
+
 	void queue_delete(Object *p_object);
 
 	void get_nodes_in_group(const StringName& p_group,List<Node*> *p_list);
@@ -410,6 +475,8 @@ public:
 	Node* get_current_scene() const;
 	Error change_scene(const String& p_path);
 	Error change_scene_to(const Ref<PackedScene>& p_scene);
+	Error change_scene_threaded(const String& p_path);
+	float get_change_scene_progress() const;
 	Error reload_current_scene();
 
 	Ref<SceneTreeTimer> create_timer(float p_delay_sec);
@@ -27,13 +27,18 @@
 /* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
 /*************************************************************************/
 #include "timer.h"
+#include "scene/main/scene_main_loop.h"
+#include "message_queue.h"
 
 
 void Timer::_notification(int p_what) {
 
 	switch(p_what) {
 
+		case NOTIFICATION_ENTER_TREE: {
 
+			_update_queue();
+		} break;
 		case NOTIFICATION_READY: {
 
 			if (autostart) {
@@ -45,43 +50,80 @@ void Timer::_notification(int p_what) {
 				autostart=false;
 			}
 		} break;
-		case NOTIFICATION_PROCESS: {
-			if (timer_process_mode == TIMER_PROCESS_FIXED || !is_processing())
-				return;
-			time_left -= get_process_delta_time();
-
-			if (time_left<0) {
-				if (!one_shot)
-					//time_left=wait_time+time_left;
-					time_left = wait_time;
-				else
-					stop();
-
-				emit_signal("timeout");
-			}
+		case NOTIFICATION_EXIT_TREE: {
 
+			_set_queue(NULL);
 		} break;
-		case NOTIFICATION_FIXED_PROCESS: {
-			if (timer_process_mode == TIMER_PROCESS_IDLE || !is_fixed_processing())
-				return;
-			time_left -= get_fixed_process_delta_time();
-
-			if (time_left<0) {
-				if (!one_shot)
-					//time_left = wait_time + time_left;
-					time_left = wait_time;
-				else
-					stop();
-				emit_signal("timeout");
-			}
+		case NOTIFICATION_PAUSED:
+		case NOTIFICATION_UNPAUSED: {
 
+			_update_queue();
 		} break;
 	}
 }
 
+void Timer::_timeout() {
+
+	// expired in the tree's queue, which already took it out
+	queue=NULL;
+	time_left=0;
+
+	if (!can_process()) {
+		// stopped processing without a notification; times out once it processes again
+		return;
+	}
+
+	if (!one_shot) {
+		time_left=wait_time;
+		_update_queue();
+	} else {
+		stop();
+	}
+
+	emit_signal("timeout");
+}
+
+void Timer::_set_queue(SceneTreeTimerQueue *p_queue) {
+
+	if (queue==p_queue)
+		return;
+
+	if (queue) {
+		time_left=queue->get_time_left(queue_index);
+		queue->unqueue(&queue_index);
+	}
+
+	queue=p_queue;
+
+	if (queue)
+		queue->queue(this,&queue_index,time_left);
+}
+
+void Timer::_update_queue() {
+
+	if (_must_defer_tree_change()) {
+		// the queues are the tree's, only changed from the main thread
+		MessageQueue::get_singleton()->push_call(this,"_update_queue");
+		return;
+	}
+
+	if (!processing || !active || !is_inside_tree() || !can_process()) {
+		_set_queue(NULL);
+		return;
+	}
+
+	switch (timer_process_mode) {
+		case TIMER_PROCESS_FIXED: _set_queue(&get_tree()->fixed_node_timers); break;
+		case TIMER_PROCESS_IDLE: _set_queue(&get_tree()->idle_node_timers); break;
+	}
+}
 
 
 void Timer::set_wait_time(float p_time) {
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"set_wait_time",p_time);
+		return;
+	}
 	ERR_EXPLAIN("time should be greater than zero.");
 	ERR_FAIL_COND(p_time<=0);
 	wait_time=p_time;
@@ -111,23 +153,40 @@ bool Timer::has_autostart() const {
 }
 
 void Timer::start() {
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"start");
+		return;
+	}
 	time_left=wait_time;
-	_set_process(true);
+	processing=true;
+	if (queue)
+		queue->queue(this,&queue_index,time_left); // restarted
+	else
+		_update_queue();
 }
 
 void Timer::stop() {
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"stop");
+		return;
+	}
+	processing=false;
+	_update_queue();
 	time_left=-1;
-	_set_process(false);
 	autostart=false;
 }
 
 
 void Timer::set_active(bool p_active) {
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"set_active",p_active);
+		return;
+	}
 	if (active == p_active)
 		return;
 
 	active = p_active;
-	_set_process(processing);
+	_update_queue();
 
 }
 
@@ -137,29 +196,22 @@ bool Timer::is_active() const {
 
 float Timer::get_time_left() const {
 
-	return time_left >0 ? time_left : 0;
+	double left = queue ? queue->get_time_left(queue_index) : time_left;
+	return left >0 ? left : 0;
 }
 
 void Timer::set_timer_process_mode(TimerProcessMode p_mode) {
 
+	if (_must_defer_tree_change()) {
+		MessageQueue::get_singleton()->push_call(this,"set_timer_process_mode",int(p_mode));
+		return;
+	}
+
 	if (timer_process_mode == p_mode)
 		return;
 
-	switch (timer_process_mode) {
-		case TIMER_PROCESS_FIXED:
-			if (is_fixed_processing()) {
-				set_fixed_process(false);
-				set_process(true);
-			}
-		break;
-		case TIMER_PROCESS_IDLE:
-			if (is_processing()) {
-				set_process(false);
-				set_fixed_process(true);
-			}
-		break;
-	}
 	timer_process_mode = p_mode;
+	_update_queue();
 }
 
 Timer::TimerProcessMode Timer::get_timer_process_mode() const{
@@ -168,15 +220,6 @@ Timer::TimerProcessMode Timer::get_timer_process_mode() const{
 }
 
 
-void Timer::_set_process(bool p_process, bool p_force)
-{
-	switch (timer_process_mode) {
-		case TIMER_PROCESS_FIXED: set_fixed_process(p_process && active); break;
-		case TIMER_PROCESS_IDLE: set_process(p_process && active); break;
-	}
-	processing = p_process;
-}
-
 void Timer::_bind_methods() {
 
 	ObjectTypeDB::bind_method(_MD("set_wait_time","time_sec"),&Timer::set_wait_time);
@@ -199,6 +242,8 @@ void Timer::_bind_methods() {
 	ObjectTypeDB::bind_method(_MD("set_timer_process_mode", "mode"), &Timer::set_timer_process_mode);
 	ObjectTypeDB::bind_method(_MD("get_timer_process_mode"), &Timer::get_timer_process_mode);
 
+	ObjectTypeDB::bind_method(_MD("_update_queue"),&Timer::_update_queue);
+
 	ADD_SIGNAL( MethodInfo("timeout") );
 
 	ADD_PROPERTY( PropertyInfo(Variant::INT, "process_mode", PROPERTY_HINT_ENUM, "Fixed,Idle"), _SCS("set_timer_process_mode"), _SCS("get_timer_process_mode") );
@@ -219,4 +264,6 @@ Timer::Timer() {
 	time_left = -1;
 	processing = false;
 	active = true;
+	queue = NULL;
+	queue_index = -1;
 }
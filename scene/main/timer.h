@@ -31,6 +31,8 @@
 
 #include "scene/main/node.h"
 
+class SceneTreeTimerQueue;
+
 class Timer : public Node {
 
 	OBJ_TYPE( Timer, Node );
@@ -41,7 +43,14 @@ class Timer : public Node {
 	bool processing;
 	bool active;
 
-	double time_left;
+	double time_left; // while not queued
+	SceneTreeTimerQueue *queue; // the tree's, while running inside it
+	int queue_index;
+
+friend class SceneTree;
+	void _timeout();
+	void _update_queue();
+	void _set_queue(SceneTreeTimerQueue *p_queue);
 protected:
 
 	void _notification(int p_what);
@@ -75,7 +84,6 @@ public:
 
 private:
 	TimerProcessMode timer_process_mode;
-	void _set_process(bool p_process, bool p_force = false);
 
 };
 
@@ -34,13 +34,271 @@
 #include "scene/2d/node_2d.h"
 #include "scene/main/instance_placeholder.h"
 #include "core/core_string_names.h"
+#include "os/thread.h"
+#include "safe_refcount.h"
 #define PACK_VERSION 2
 
+enum {
+	PROCESS_FLAG_IDLE=1,
+	PROCESS_FLAG_FIXED=2,
+	PROCESS_FLAG_INPUT=4,
+	PROCESS_FLAG_UNHANDLED_INPUT=8,
+	PROCESS_FLAG_UNHANDLED_KEY_INPUT=16,
+};
+
+static int _get_process_flags(Node *p_node) {
+
+	return (p_node->is_processing()?PROCESS_FLAG_IDLE:0)|
+		(p_node->is_fixed_processing()?PROCESS_FLAG_FIXED:0)|
+		(p_node->is_processing_input()?PROCESS_FLAG_INPUT:0)|
+		(p_node->is_processing_unhandled_input()?PROCESS_FLAG_UNHANDLED_INPUT:0)|
+		(p_node->is_processing_unhandled_key_input()?PROCESS_FLAG_UNHANDLED_KEY_INPUT:0);
+}
+
+static void _set_process_flags(Node *p_node,int p_flags) {
+
+	p_node->set_process(p_flags&PROCESS_FLAG_IDLE);
+	p_node->set_fixed_process(p_flags&PROCESS_FLAG_FIXED);
+	p_node->set_process_input(p_flags&PROCESS_FLAG_INPUT);
+	p_node->set_process_unhandled_input(p_flags&PROCESS_FLAG_UNHANDLED_INPUT);
+	p_node->set_process_unhandled_key_input(p_flags&PROCESS_FLAG_UNHANDLED_KEY_INPUT);
+}
+
 bool SceneState::can_instance() const {
 
 	return nodes.size()>0;
 }
 
+void SceneState::_apply_set(Node *p_node,const CompiledSet& p_set) {
+
+	if (!p_set.setter || p_node->get_script_instance()) {
+		// scripts may override any property
+		p_node->set(p_set.name,p_set.value);
+		return;
+	}
+
+	Variant::CallError ce;
+	if (p_set.index>=0) {
+		Variant index=p_set.index;
+		const Variant* arg[2]={&index,&p_set.value};
+		p_set.setter->call(p_node,arg,2,ce);
+	} else {
+		const Variant* arg[1]={&p_set.value};
+		p_set.setter->call(p_node,arg,1,ce);
+	}
+}
+
+void SceneState::_set_script_keeping_state(Node *p_node,const Variant& p_script) {
+
+	//work around to avoid old script variables from disappearing, should be the proper fix to:
+	//https://github.com/godotengine/godot/issues/2958
+
+	//store old state
+	List<Pair<StringName,Variant> > old_state;
+	if (p_node->get_script_instance()) {
+		p_node->get_script_instance()->get_property_state(old_state);
+	}
+
+	p_node->set(CoreStringNames::get_singleton()->_script,p_script);
+
+	//restore old state for new script, if exists
+	for (List<Pair<StringName,Variant> >::Element *E=old_state.front();E;E=E->next()) {
+		p_node->set(E->get().first,E->get().second);
+	}
+}
+
+SceneState::Compiled *SceneState::_compile() const {
+
+	int nc=nodes.size();
+	const NodeData *nd=nodes.ptr();
+	const StringName &script_name=CoreStringNames::get_singleton()->_script;
+
+	Compiled *c = memnew( Compiled );
+	c->poolable=base_scene_idx<0;
+	c->next_retired=NULL;
+	c->nodes.resize(nc);
+	CompiledNode *cnodes=c->nodes.ptr();
+
+	for(int i=0;i<nc;i++) {
+
+		const NodeData &n=nd[i];
+		CompiledNode &cn=cnodes[i];
+		cn.create=NULL;
+		cn.script_set=-1;
+		cn.process_flags=0;
+		cn.child_count=0;
+		cn.child_pos=-1;
+
+		if (n.type!=TYPE_INSTANCED && (n.type<0 || n.type>=names.size())) {
+			memdelete(c);
+			return NULL;
+		}
+
+		if (i>0) {
+			if (n.parent<0 || n.parent>=i) {
+				c->poolable=false; // parented by path, part of another scene
+			} else {
+				cn.child_pos=cnodes[n.parent].child_count++;
+			}
+		}
+
+		Node *temp=NULL;
+
+		if (!(i==0 && base_scene_idx>=0) && n.instance<0 && n.type!=TYPE_INSTANCED && ObjectTypeDB::is_type_enabled(names[n.type])) {
+
+			cn.create=ObjectTypeDB::get_creation_func(names[n.type]);
+			Object *obj = cn.create ? cn.create() : NULL;
+			temp = obj ? obj->cast_to<Node>() : NULL;
+			if (!temp) {
+				if (obj)
+					memdelete(obj);
+				cn.create=NULL; // instance() warns and makes up a node
+			}
+		}
+
+		if (temp) {
+			cn.child_count=temp->get_child_count(); // created by the constructor
+			cn.process_flags=_get_process_flags(temp);
+		} else {
+			c->poolable=false;
+		}
+
+		for(int j=0;j<n.properties.size();j++) {
+
+			if (n.properties[j].name<0 || n.properties[j].name>=names.size() || n.properties[j].value<0 || n.properties[j].value>=variants.size()) {
+				if (temp)
+					memdelete(temp);
+				memdelete(c);
+				return NULL;
+			}
+
+			CompiledSet set;
+			set.name=names[n.properties[j].name];
+			set.value=variants[n.properties[j].value];
+			set.setter=NULL;
+			set.index=-1;
+
+			if (set.name==script_name) {
+
+				cn.script_set=cn.sets.size();
+
+			} else if (temp && cn.script_set<0) {
+
+				// a new node, with the properties before this one set, may have it already
+				Variant current=temp->get(set.name);
+				if (current.get_type()==set.value.get_type() && current==set.value)
+					continue;
+
+				ObjectTypeDB::get_property_setter(names[n.type],set.name,&set.setter,&set.index);
+				temp->set(set.name,set.value);
+			}
+
+			cn.sets.push_back(set);
+		}
+
+		if (temp && c->poolable && instance_pool_size>0) {
+
+			List<PropertyInfo> plist;
+			temp->get_property_list(&plist);
+
+			for(List<PropertyInfo>::Element *E=plist.front();E;E=E->next()) {
+
+				if (!(E->get().usage&PROPERTY_USAGE_STORAGE) || E->get().name==script_name || E->get().name==CoreStringNames::get_singleton()->_meta)
+					continue; // metadata is reset apart, it's only listed while there is some
+
+				CompiledSet set;
+				set.name=E->get().name;
+				set.value=temp->get(set.name);
+				set.setter=NULL;
+				set.index=-1;
+
+				if (set.value.get_type()==Variant::OBJECT && !set.value.is_zero()) {
+					// objects the constructor made must not end up shared by the recycled instances
+					bool in_scene=false;
+					for(int j=0;j<cn.sets.size() && !in_scene;j++)
+						in_scene=cn.sets[j].name==set.name;
+					if (!in_scene)
+						continue;
+				}
+
+				ObjectTypeDB::get_property_setter(names[n.type],set.name,&set.setter,&set.index);
+				cn.reset.push_back(set);
+			}
+
+			// what the constructor and setters connected (resources telling the node they
+			// changed, internal children), resetting the properties doesn't remake it
+			List<Connection> conns;
+			temp->get_all_signal_connections(&conns);
+			for(List<Connection>::Element *E=conns.front();E;E=E->next())
+				_add_owned_connection(cn,temp,plist,E->get().target,E->get().signal,E->get().method,false);
+			conns.clear();
+			temp->get_signals_connected_to_this(&conns);
+			for(List<Connection>::Element *E=conns.front();E;E=E->next())
+				_add_owned_connection(cn,temp,plist,E->get().source,E->get().signal,E->get().method,true);
+		}
+
+		if (temp)
+			memdelete(temp);
+	}
+
+	for(int i=0;i<connections.size();i++) {
+
+		const ConnectionData &cd=connections[i];
+		Vector<Variant> binds;
+		for(int j=0;j<cd.binds.size();j++) {
+			if (cd.binds[j]<0 || cd.binds[j]>=variants.size()) {
+				memdelete(c);
+				return NULL;
+			}
+			binds.push_back(variants[cd.binds[j]]);
+		}
+		c->connection_binds.push_back(binds);
+	}
+
+	return c;
+}
+
+SceneState::InstancingGuard::InstancingGuard(const SceneState *p_state) {
+
+	state=p_state;
+	atomic_add(&state->instancing,1);
+}
+
+SceneState::InstancingGuard::~InstancingGuard() {
+
+	atomic_add(&state->instancing,-1);
+}
+
+void SceneState::_delete_retired() {
+
+	Compiled *c=retired;
+	retired=NULL;
+	while(c) {
+		Compiled *next=c->next_retired;
+		memdelete(c);
+		c=next;
+	}
+}
+
+void SceneState::_clear_compiled() {
+
+	// other threads may still be instancing with the old program, so it is
+	// only deleted here (or on a later call) once none is. Retiring and
+	// deleting both happen here, so a thread that starts instancing after
+	// the check can only pick up the new program.
+	Compiled *c=atomic_exchange(&compiled,(Compiled*)NULL);
+	if (c) {
+		c->next_retired=retired;
+		retired=c;
+	}
+	if (atomic_add(&instancing,0)==0)
+		_delete_retired();
+
+	for(int i=0;i<instance_pool.size();i++)
+		memdelete(instance_pool[i]);
+	instance_pool.clear();
+}
+
 
 Node *SceneState::instance(bool p_gen_edit_state) const {
 
@@ -60,6 +318,33 @@ Node *SceneState::instance(bool p_gen_edit_state) const {
 	int nc = nodes.size();
 	ERR_FAIL_COND_V(nc==0,NULL);
 
+	const Compiled *program=NULL;
+	// keeps the program alive while this runs, even if it is replaced meanwhile
+	InstancingGuard guard(this);
+
+	if (!p_gen_edit_state) {
+
+		if (Thread::get_caller_ID()==Thread::get_main_ID() && instance_pool.size()) {
+			// the pool is only touched from the main thread
+			// reset already when it was freed
+			Node *node=instance_pool[instance_pool.size()-1];
+			instance_pool.resize(instance_pool.size()-1);
+			node->data.recycle_state=Ref<SceneState>(const_cast<SceneState*>(this));
+			return node;
+		}
+
+		Compiled *c=atomic_load(&compiled);
+		if (!c) {
+			c=_compile();
+			if (c && !atomic_cas(&compiled,(Compiled*)NULL,c)) {
+				// another thread compiled it meanwhile
+				memdelete(c);
+				c=atomic_load(&compiled);
+			}
+		}
+		program=c;
+	}
+
 	const StringName*snames=NULL;
 	int sname_count=names.size();
 	if (sname_count)
@@ -81,6 +366,7 @@ Node *SceneState::instance(bool p_gen_edit_state) const {
 	for(int i=0;i<nc;i++) {
 
 		const NodeData &n=nd[i];
+		const CompiledNode *cn = program ? &program->nodes[i] : NULL;
 
 		Node *parent=NULL;
 
@@ -148,6 +434,10 @@ Node *SceneState::instance(bool p_gen_edit_state) const {
 				}
 #endif
 			}
+		} else if (cn && cn->create) {
+			//type, setters and defaults were resolved when compiling
+			node=cn->create()->cast_to<Node>();
+
 		} else if (ObjectTypeDB::is_type_enabled(snames[n.type])) {
             //print_line("created");
 			//node belongs to this scene and must be created
@@ -183,8 +473,22 @@ Node *SceneState::instance(bool p_gen_edit_state) const {
 			// if found all is good, otherwise ignore
 
 			//properties
-			int nprop_count=n.properties.size();
-			if (nprop_count) {
+			int nprop_count=cn ? 0 : n.properties.size();
+
+			if (cn) {
+
+				const CompiledSet *sets=cn->sets.ptr();
+				int set_count=cn->sets.size();
+
+				for(int j=0;j<set_count;j++) {
+
+					if (j==cn->script_set)
+						_set_script_keeping_state(node,sets[j].value);
+					else
+						_apply_set(node,sets[j]);
+				}
+
+			} else if (nprop_count) {
 
 				const NodeData::Property* nprops=&n.properties[0];
 
@@ -195,21 +499,7 @@ Node *SceneState::instance(bool p_gen_edit_state) const {
 					ERR_FAIL_INDEX_V( nprops[j].value, prop_count, NULL );
 
 					if (snames[ nprops[j].name ]==CoreStringNames::get_singleton()->_script) {
-						//work around to avoid old script variables from disappearing, should be the proper fix to:
-						//https://github.com/godotengine/godot/issues/2958
-
-						//store old state
-						List<Pair<StringName,Variant> > old_state;
-						if (node->get_script_instance()) {
-							node->get_script_instance()->get_property_state(old_state);
-						}
-
-						node->set(snames[ nprops[j].name ],props[ nprops[j].value ],&valid);
-
-						//restore old state for new script, if exists
-						for (List<Pair<StringName,Variant> >::Element *E=old_state.front();E;E=E->next()) {
-							node->set(E->get().first,E->get().second);
-						}
+						_set_script_keeping_state(node,props[ nprops[j].value ]);
 					} else {
 
 						node->set(snames[ nprops[j].name ],props[ nprops[j].value ],&valid);
@@ -279,7 +569,9 @@ Node *SceneState::instance(bool p_gen_edit_state) const {
 			continue;
 
 		Vector<Variant> binds;
-		if (c.binds.size()) {
+		if (program) {
+			binds=program->connection_binds[i];
+		} else if (c.binds.size()) {
 			binds.resize(c.binds.size());
 			for(int j=0;j<c.binds.size();j++)
 				binds[j]=props[ c.binds[j] ];
@@ -304,11 +596,220 @@ Node *SceneState::instance(bool p_gen_edit_state) const {
 		}
 	}
 
+	if (program && program->poolable && instance_pool_size>0) {
+		// goes back to the pool instead of being deleted, see recycle_instance()
+		ret_nodes[0]->data.recycle_state=Ref<SceneState>(const_cast<SceneState*>(this));
+	}
+
 	return ret_nodes[0];
 
 }
 
 
+static bool _is_in_instance(Node *p_root,Object *p_object) {
+
+	Node *node = p_object ? p_object->cast_to<Node>() : NULL;
+	return node && (node==p_root || p_root->is_a_parent_of(node));
+}
+
+void SceneState::_add_owned_connection(CompiledNode& p_node,Node *p_temp,const List<PropertyInfo>& p_plist,Object *p_other,const StringName& p_signal,const StringName& p_method,bool p_incoming) {
+
+	CompiledConnection cc;
+	cc.other=0;
+	cc.signal=p_signal;
+	cc.method=p_method;
+	cc.incoming=p_incoming;
+
+	if (_is_in_instance(p_temp,p_other)) {
+
+		for(Node *n=p_other->cast_to<Node>();n!=p_temp;n=n->get_parent())
+			cc.path.insert(0,n->get_position_in_parent());
+	} else {
+
+		for(const List<PropertyInfo>::Element *E=p_plist.front();E;E=E->next()) {
+			if (E->get().type==Variant::OBJECT && p_temp->get(E->get().name).operator Object*()==p_other) {
+				cc.property=E->get().name;
+				break;
+			}
+		}
+		if (cc.property==StringName())
+			cc.other=p_other->get_instance_ID();
+	}
+
+	p_node.owned.push_back(cc);
+}
+
+bool SceneState::_is_owned_connection(const CompiledNode& p_node,Node *p_instance,Object *p_other,const StringName& p_signal,const StringName& p_method,bool p_incoming) {
+
+	for(int i=0;i<p_node.owned.size();i++) {
+
+		const CompiledConnection &cc=p_node.owned[i];
+		if (cc.incoming!=p_incoming || cc.signal!=p_signal || cc.method!=p_method)
+			continue;
+
+		if (cc.property!=StringName()) {
+			if (p_instance->get(cc.property).operator Object*()==p_other)
+				return true;
+			continue;
+		}
+		if (cc.other) {
+			if (cc.other==p_other->get_instance_ID())
+				return true;
+			continue;
+		}
+
+		Node *n=p_instance;
+		for(int j=0;j<cc.path.size() && n;j++)
+			n = cc.path[j]<n->get_child_count() ? n->get_child(cc.path[j]) : NULL;
+		if (n==p_other)
+			return true;
+	}
+
+	return false;
+}
+
+bool SceneState::recycle_instance(Node *p_node) {
+
+	ERR_FAIL_NULL_V(p_node,false);
+
+	const Compiled *c=atomic_load(&compiled);
+	if (!c || !c->poolable || instance_pool.size()>=instance_pool_size || Thread::get_caller_ID()!=Thread::get_main_ID())
+		return false;
+
+	int nc=c->nodes.size();
+	const NodeData *nd=nodes.ptr();
+	const CompiledNode *cnodes=c->nodes.ptr();
+	Node **ret_nodes=(Node**)alloca( sizeof(Node*)*nc );
+
+	// only an instance that still has the nodes it was created with can be handed out again
+	for(int i=0;i<nc;i++) {
+
+		Node *node=p_node;
+
+		if (i>0) {
+			Node *parent=ret_nodes[nd[i].parent];
+			if (cnodes[i].child_pos>=parent->get_child_count())
+				return false;
+			node=parent->get_child(cnodes[i].child_pos);
+			if (node->get_name()!=names[nd[i].name])
+				return false;
+		}
+
+		if (node->get_child_count()!=cnodes[i].child_count || node->get_type_name()!=names[nd[i].type])
+			return false;
+
+		ret_nodes[i]=node;
+	}
+
+	if (p_node->get_parent())
+		p_node->get_parent()->remove_child(p_node);
+
+	for(int i=0;i<nc;i++) {
+
+		Node *node=ret_nodes[i];
+		const CompiledNode &cn=cnodes[i];
+
+		List<Node::GroupInfo> groups;
+		node->get_groups(&groups);
+		for(List<Node::GroupInfo>::Element *E=groups.front();E;E=E->next())
+			node->remove_from_group(E->get().name);
+		for(int j=0;j<nd[i].groups.size();j++)
+			node->add_to_group(names[nd[i].groups[j]],true);
+
+		// properties go back to how a new instance has them, scripts start over
+		if (!node->get_script().is_null())
+			node->set_script(RefPtr());
+
+		for(int j=0;j<cn.reset.size();j++)
+			_apply_set(node,cn.reset[j]);
+
+		List<String> meta;
+		node->get_meta_list(&meta);
+		for(List<String>::Element *E=meta.front();E;E=E->next())
+			node->set_meta(E->get(),Variant());
+
+		for(int j=0;j<cn.sets.size();j++) {
+
+			if (cn.sets[j].name!=CoreStringNames::get_singleton()->_meta)
+				continue;
+
+			// entry by entry, the scene's dictionary must not be shared with the instance
+			Dictionary d=cn.sets[j].value;
+			List<Variant> keys;
+			d.get_key_list(&keys);
+			for(List<Variant>::Element *E=keys.front();E;E=E->next())
+				node->set_meta(E->get(),d[E->get()]);
+		}
+
+		if (cn.script_set>=0) {
+			for(int j=cn.script_set;j<cn.sets.size();j++)
+				_apply_set(node,cn.sets[j]);
+		}
+
+		_set_process_flags(node,cn.process_flags);
+
+		// every connection made after instancing goes away, as it would with the instance, whatever
+		// the other end is. the setters undid theirs for values that changed when the properties
+		// were reset, and those of a new instance stay
+		List<Connection> conns;
+		node->get_all_signal_connections(&conns);
+		for(List<Connection>::Element *E=conns.front();E;E=E->next()) {
+			const Connection &conn=E->get();
+			if (conn.flags&CONNECT_PERSIST && _is_in_instance(p_node,conn.target))
+				continue;
+			if (!_is_owned_connection(cn,node,conn.target,conn.signal,conn.method,false))
+				node->disconnect(conn.signal,conn.target,conn.method);
+		}
+		conns.clear();
+		node->get_signals_connected_to_this(&conns);
+		for(List<Connection>::Element *E=conns.front();E;E=E->next()) {
+			const Connection &conn=E->get();
+			if (conn.flags&CONNECT_PERSIST && _is_in_instance(p_node,conn.source))
+				continue;
+			if (!_is_owned_connection(cn,node,conn.source,conn.signal,conn.method,true))
+				conn.source->disconnect(conn.signal,node,conn.method);
+		}
+	}
+
+	for(int i=0;i<connections.size();i++) {
+
+		const ConnectionData &cd=connections[i];
+		if (cd.from&FLAG_ID_IS_PATH || cd.to&FLAG_ID_IS_PATH || cd.from>=nc || cd.to>=nc)
+			continue;
+
+		Node *from=ret_nodes[cd.from];
+		Node *to=ret_nodes[cd.to];
+		if (!from->is_connected(names[cd.signal],to,names[cd.method]))
+			from->connect(names[cd.signal],to,names[cd.method],c->connection_binds[i],CONNECT_PERSIST|cd.flags);
+	}
+
+	p_node->_set_name_nocheck(names[nd[0].name]);
+	p_node->_is_queued_for_deletion=false;
+
+	instance_pool.push_back(p_node);
+	return true;
+}
+
+void SceneState::set_instance_pool_size(int p_size) {
+
+	ERR_FAIL_COND(p_size<0);
+
+	if (p_size>0 && instance_pool_size==0)
+		_clear_compiled(); // compiled again with what recycling needs
+
+	instance_pool_size=p_size;
+
+	while(instance_pool.size()>p_size) {
+		memdelete(instance_pool[instance_pool.size()-1]);
+		instance_pool.resize(instance_pool.size()-1);
+	}
+}
+
+int SceneState::get_instance_pool_size() const {
+
+	return instance_pool_size;
+}
+
 static int _nm_get_string(const String& p_string, Map<StringName,int> &name_map) {
 
 	if (name_map.has(p_string))
@@ -979,6 +1480,7 @@ void SceneState::clear() {
 	node_paths.clear();
 	editable_instances.clear();
 	base_scene_idx=-1;
+	_clear_compiled();
 
 }
 
@@ -1130,6 +1632,8 @@ void SceneState::set_bundled_scene(const Dictionary& d) {
 	ERR_FAIL_COND( !d.has("conns"));
 //	ERR_FAIL_COND( !d.has("path"));
 
+	_clear_compiled();
+
 	int version=1;
 	if (d.has("version"))
 		version=d["version"];
@@ -1610,6 +2114,7 @@ int SceneState::add_node(int p_parent,int p_owner,int p_type,int p_name, int p_i
 	nd.instance=p_instance;
 
 	nodes.push_back(nd);
+	_clear_compiled();
 
 	return nodes.size()-1;
 }
@@ -1623,18 +2128,21 @@ void SceneState::add_node_property(int p_node,int p_name,int p_value){
 	prop.name=p_name;
 	prop.value=p_value;
 	nodes[p_node].properties.push_back(prop);
+	_clear_compiled();
 }
 void SceneState::add_node_group(int p_node,int p_group){
 
 	ERR_FAIL_INDEX(p_node,nodes.size());
 	ERR_FAIL_INDEX(p_group,names.size());
 	nodes[p_node].groups.push_back(p_group);
+	_clear_compiled();
 
 }
 void SceneState::set_base_scene(int p_idx){
 
 	ERR_FAIL_INDEX(p_idx,variants.size());
 	base_scene_idx=p_idx;
+	_clear_compiled();
 }
 void SceneState::add_connection(int p_from,int p_to, int p_signal, int p_method, int p_flags,const Vector<int>& p_binds){
 
@@ -1652,6 +2160,7 @@ void SceneState::add_connection(int p_from,int p_to, int p_signal, int p_method,
 	c.flags=p_flags;
 	c.binds=p_binds;
 	connections.push_back(c);
+	_clear_compiled();
 
 }
 void SceneState::add_editable_instance(const NodePath& p_path){
@@ -1699,6 +2208,16 @@ SceneState::SceneState() {
 
 	base_scene_idx=-1;
 	last_modified_time=0;
+	compiled=NULL;
+	instancing=0;
+	retired=NULL;
+	instance_pool_size=0;
+}
+
+SceneState::~SceneState() {
+
+	_clear_compiled();
+	_delete_retired();
 }
 
 
@@ -1732,6 +2251,16 @@ bool PackedScene::can_instance() const {
 	return state->can_instance();
 }
 
+void PackedScene::set_instance_pool_size(int p_size) {
+
+	state->set_instance_pool_size(p_size);
+}
+
+int PackedScene::get_instance_pool_size() const {
+
+	return state->get_instance_pool_size();
+}
+
 Node *PackedScene::instance(bool p_gen_edit_state) const {
 
 #ifndef TOOLS_ENABLED
@@ -1760,6 +2289,7 @@ Node *PackedScene::instance(bool p_gen_edit_state) const {
 
 void PackedScene::replace_state(Ref<SceneState> p_by) {
 
+	p_by->set_instance_pool_size(state->get_instance_pool_size());
 	state=p_by;
 	state->set_path(get_path());
 #ifdef TOOLS_ENABLED
@@ -1770,7 +2300,9 @@ void PackedScene::replace_state(Ref<SceneState> p_by) {
 
 void PackedScene::recreate_state() {
 
+	int pool_size=state.is_valid() ? state->get_instance_pool_size() : 0;
 	state = Ref<SceneState>( memnew( SceneState ));
+	state->set_instance_pool_size(pool_size);
 	state->set_path(get_path());
 #ifdef TOOLS_ENABLED
 	state->set_last_modified_time(get_last_modified_time());
@@ -1794,6 +2326,8 @@ void PackedScene::_bind_methods() {
 	ObjectTypeDB::bind_method(_MD("pack","path:Node"),&PackedScene::pack);
 	ObjectTypeDB::bind_method(_MD("instance:Node","gen_edit_state"),&PackedScene::instance,DEFVAL(false));
 	ObjectTypeDB::bind_method(_MD("can_instance"),&PackedScene::can_instance);
+	ObjectTypeDB::bind_method(_MD("set_instance_pool_size","size"),&PackedScene::set_instance_pool_size);
+	ObjectTypeDB::bind_method(_MD("get_instance_pool_size"),&PackedScene::get_instance_pool_size);
 	ObjectTypeDB::bind_method(_MD("_set_bundled_scene"),&PackedScene::_set_bundled_scene);
 	ObjectTypeDB::bind_method(_MD("_get_bundled_scene"),&PackedScene::_get_bundled_scene);
 	ObjectTypeDB::bind_method(_MD("get_state:SceneState"),&PackedScene::get_state);
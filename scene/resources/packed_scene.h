@@ -90,6 +90,67 @@ class SceneState : public Reference {
 
 	Vector<ConnectionData> connections;
 
+	// instance() without edit state runs from a program compiled out of the data above on first use
+
+	struct CompiledSet {
+
+		StringName name;
+		Variant value;
+		MethodBind *setter; // NULL to go through Object::set()
+		int index; // for indexed setters, -1 otherwise
+	};
+
+	struct CompiledConnection {
+
+		StringName property; // the other object is the value of this property,
+		Vector<int> path; // or the node itself or a child it made, by child positions,
+		ObjectID other; // or else always the same object
+		StringName signal;
+		StringName method;
+		bool incoming; // the other object emits the signal
+	};
+
+	struct CompiledNode {
+
+		Object* (*create)(); // NULL unless the node is created from its type
+		Vector<CompiledSet> sets; // properties that differ from what a new node of the type has
+		int script_set; // index of the script in sets, -1 if none
+		Vector<CompiledSet> reset; // every stored property as a new instance has it, for recycling
+		Vector<CompiledConnection> owned; // a new instance has them, recycling keeps them
+		int process_flags; // as a new node has them, for recycling
+		int child_count;
+		int child_pos;
+	};
+
+	struct Compiled {
+
+		Vector<CompiledNode> nodes;
+		Vector< Vector<Variant> > connection_binds;
+		bool poolable; // every node is created from its type and parented by index
+		Compiled *next_retired;
+	};
+
+	struct InstancingGuard {
+
+		const SceneState *state;
+		InstancingGuard(const SceneState *p_state);
+		~InstancingGuard();
+	};
+
+	mutable Compiled *compiled;
+	mutable volatile uint32_t instancing; // instance() calls running a program, from any thread
+	Compiled *retired; // replaced while some were, deleted once none are
+	int instance_pool_size;
+	mutable Vector<Node*> instance_pool;
+
+	Compiled *_compile() const;
+	void _clear_compiled();
+	void _delete_retired();
+	static void _apply_set(Node *p_node,const CompiledSet& p_set);
+	static void _add_owned_connection(CompiledNode& p_node,Node *p_temp,const List<PropertyInfo>& p_plist,Object *p_other,const StringName& p_signal,const StringName& p_method,bool p_incoming);
+	static bool _is_owned_connection(const CompiledNode& p_node,Node *p_instance,Object *p_other,const StringName& p_signal,const StringName& p_method,bool p_incoming);
+	static void _set_script_keeping_state(Node *p_node,const Variant& p_script);
+
 
 	Error _parse_node(Node *p_owner,Node *p_node,int p_parent_idx, Map<StringName,int> &name_map,HashMap<Variant,int,VariantHasher> &variant_map,Map<Node*,int> &node_map,Map<Node*,int> &nodepath_map);
 	Error _parse_connections(Node *p_owner,Node *p_node, Map<StringName,int> &name_map,HashMap<Variant,int,VariantHasher> &variant_map,Map<Node*,int> &node_map,Map<Node*,int> &nodepath_map);
@@ -138,6 +199,10 @@ public:
 	bool can_instance() const;
 	Node *instance(bool p_gen_edit_state=false) const;
 
+	void set_instance_pool_size(int p_size);
+	int get_instance_pool_size() const;
+	bool recycle_instance(Node *p_node);
+
 
 	//unbuild API
 
@@ -185,6 +250,7 @@ public:
 
 
 	SceneState();
+	~SceneState();
 };
 
 class PackedScene : public Resource {
@@ -211,6 +277,9 @@ public:
 	bool can_instance() const;
 	Node *instance(bool p_gen_edit_state=false) const;
 
+	void set_instance_pool_size(int p_size);
+	int get_instance_pool_size() const;
+
 	void recreate_state();
 	void replace_state(Ref<SceneState> p_by);
 
@@ -1481,6 +1481,8 @@ void PhysicsServerSW::step(float p_step) {
 	if (!active)
 		return;
 
+	MemoryCategoryScope mem_scope(Memory::ALLOC_SERVER);
+
 
 	doing_sync=false;
 
@@ -1265,6 +1265,8 @@ void Physics2DServerSW::step(float p_step) {
 	if (!active)
 		return;
 
+	MemoryCategoryScope mem_scope(Memory::ALLOC_SERVER);
+
 	doing_sync=false;
 
 	last_step=p_step;
@@ -61,8 +61,8 @@ void Physics2DServerWrapMT::thread_loop() {
 	exit=false;
 	step_thread_up=true;
 	while(!exit) {
-		// flush commands one by one, until exit is requested
-		command_queue.wait_and_flush_one();
+		// flush commands in batches, until exit is requested
+		command_queue.wait_and_flush();
 	}
 
 	command_queue.flush_all(); // flush all
@@ -77,6 +77,8 @@ void Physics2DServerWrapMT::thread_loop() {
 
 void Physics2DServerWrapMT::step(float p_step) {
 
+	command_queue.mark_frame();
+
 	if (create_thread) {
 
 		command_queue.push( this, &Physics2DServerWrapMT::thread_step,p_step);
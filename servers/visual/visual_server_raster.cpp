@@ -32,6 +32,7 @@
 #include "default_mouse_cursor.xpm"
 #include "sort.h"
 #include "io/marshalls.h"
+#include "os/frame_allocator.h"
 // careful, these may run in different threads than the visual server
 
 BalloonAllocator<> *VisualServerRaster::OctreeAllocator::allocator=NULL;
@@ -6547,8 +6548,9 @@ void VisualServerRaster::_render_camera(Viewport *p_viewport,Camera *p_camera, S
 		room_cull_count = p_scenario->octree.cull_point(p_camera->transform.origin,room_cull_result,MAX_ROOM_CULL,NULL,(1<<INSTANCE_ROOM)|(1<<INSTANCE_PORTAL));
 
 
-		Set<Instance*> current_rooms;
-		Set<Instance*> portal_rooms;
+		// rebuilt for every camera, every frame
+		Set<Instance*,Comparator<Instance*>,FrameAllocator> current_rooms;
+		Set<Instance*,Comparator<Instance*>,FrameAllocator> portal_rooms;
 		//add to set
 		for(int i=0;i<room_cull_count;i++) {
 
@@ -6592,7 +6594,7 @@ void VisualServerRaster::_render_camera(Viewport *p_viewport,Camera *p_camera, S
 		if (current_rooms.size()) {
 			//camera is inside a room
 			// go through rooms
-			for(Set<Instance*>::Element *E=current_rooms.front();E;E=E->next()) {
+			for(Set<Instance*,Comparator<Instance*>,FrameAllocator>::Element *E=current_rooms.front();E;E=E->next()) {
 				_cull_room(p_camera,E->get());
 			}
 
@@ -7218,7 +7220,7 @@ void VisualServerRaster::_draw_viewport(Viewport *p_viewport,int p_ofs_x, int p_
 	if (!p_viewport->hide_canvas) {
 		int i=0;
 
-		Map<Viewport::CanvasKey,Viewport::CanvasData*> canvas_map;
+		Map<Viewport::CanvasKey,Viewport::CanvasData*,Comparator<Viewport::CanvasKey>,FrameAllocator> canvas_map;
 
 		Rect2 clip_rect(0,0,viewport_rect.width,viewport_rect.height);
 		Rasterizer::CanvasLight *lights=NULL;
@@ -7331,7 +7333,7 @@ void VisualServerRaster::_draw_viewport(Viewport *p_viewport,int p_ofs_x, int p_
 
 		}
 
-		for (Map<Viewport::CanvasKey,Viewport::CanvasData*>::Element *E=canvas_map.front();E;E=E->next()) {
+		for (Map<Viewport::CanvasKey,Viewport::CanvasData*,Comparator<Viewport::CanvasKey>,FrameAllocator>::Element *E=canvas_map.front();E;E=E->next()) {
 
 
 	//		print_line("canvas "+itos(i)+" size: "+itos(I->get()->canvas->child_items.size()));
@@ -7395,8 +7397,8 @@ void VisualServerRaster::_draw_viewports() {
 
 	//draw viewports for render targets
 
-	List<Viewport*> to_blit;
-	List<Viewport*> to_disable;
+	List<Viewport*,FrameAllocator> to_blit;
+	List<Viewport*,FrameAllocator> to_disable;
 	for(SelfList<Viewport> *E=viewport_update_list.first();E;E=E->next()) {
 
 		Viewport *vp = E->self();
@@ -7435,7 +7437,7 @@ void VisualServerRaster::_draw_viewports() {
 
 	//draw RTs directly to screen when requested
 
-	for (List<Viewport*>::Element *E=to_blit.front();E;E=E->next()) {
+	for (List<Viewport*,FrameAllocator>::Element *E=to_blit.front();E;E=E->next()) {
 
 		int window_w = OS::get_singleton()->get_video_mode().width;
 		int window_h = OS::get_singleton()->get_video_mode().height;
@@ -7581,6 +7583,7 @@ void VisualServerRaster::sync() {
 void VisualServerRaster::draw() {
 	//if (changes)
 	//	print_line("changes: "+itos(changes));
+	MemoryCategoryScope mem_scope(Memory::ALLOC_SERVER);
 	changes=0;
 	shadows_enabled=GLOBAL_DEF("render/shadows_enabled",true);
 	room_cull_enabled = GLOBAL_DEF("render/room_cull_enabled",true);
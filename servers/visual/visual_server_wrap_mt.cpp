@@ -83,8 +83,8 @@ void VisualServerWrapMT::thread_loop() {
 	exit=false;
 	draw_thread_up=true;
 	while(!exit) {
-		// flush commands one by one, until exit is requested
-		command_queue.wait_and_flush_one();
+		// flush commands in batches, until exit is requested
+		command_queue.wait_and_flush();
 	}
 
 	command_queue.flush_all(); // flush all
@@ -118,6 +118,7 @@ void VisualServerWrapMT::sync() {
 
 void VisualServerWrapMT::draw() {
 
+	command_queue.mark_frame();
 
 	if (create_thread) {
 
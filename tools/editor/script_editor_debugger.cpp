@@ -313,6 +313,17 @@ void ScriptEditorDebugger::_video_mem_request() {
 
 }
 
+void ScriptEditorDebugger::_memory_report_request() {
+
+	ERR_FAIL_COND(connection.is_null());
+	ERR_FAIL_COND(!connection->is_connected());
+
+	Array msg;
+	msg.push_back("request_memory_report");
+	ppeer->put_var(msg);
+
+}
+
 Size2 ScriptEditorDebugger::get_minimum_size() const {
 
 	Size2 ms = Control::get_minimum_size();
@@ -504,6 +515,41 @@ void ScriptEditorDebugger::_parse_message(const String& p_msg,const Array& p_dat
 		vmem_total->set_tooltip(TTR("Bytes:")+" "+itos(total));
 		vmem_total->set_text(String::humanize_size(total));
 
+	} else if (p_msg=="message:memory_report") {
+
+		heap_tree->clear();
+		TreeItem* root=heap_tree->create_item();
+		Map<String,TreeItem*> categories;
+
+		int total=0;
+
+		for(int i=0;i<p_data.size();i+=5) {
+
+			String site=p_data[i+0];
+			String category=p_data[i+1];
+			int bytes=p_data[i+2].operator int();
+
+			TreeItem *it;
+			if (site==String()) {
+				// category totals come first
+				it = heap_tree->create_item(root);
+				it->set_text(0,category);
+				it->set_collapsed(true);
+				categories[category]=it;
+				total+=bytes;
+			} else {
+				ERR_CONTINUE(!categories.has(category));
+				it = heap_tree->create_item(categories[category]);
+				it->set_text(0,site);
+			}
+			it->set_text(1,String::humanize_size(bytes));
+			it->set_text(2,itos(p_data[i+3]));
+			it->set_text(3,itos(p_data[i+4]));
+		}
+
+		heap_total->set_tooltip(TTR("Bytes:")+" "+itos(total));
+		heap_total->set_text(String::humanize_size(total));
+
 	} else if (p_msg=="stack_dump") {
 
 		stack_dump->clear();
@@ -898,6 +944,7 @@ void ScriptEditorDebugger::_notification(int p_what) {
 			error_list->connect("item_selected",this,"_error_selected");
 			error_stack->connect("item_selected",this,"_error_stack_selected");
 			vmem_refresh->set_icon( get_icon("Reload","EditorIcons"));
+			heap_refresh->set_icon( get_icon("Reload","EditorIcons"));
 
 		} break;
 		case NOTIFICATION_PROCESS: {
@@ -1653,6 +1700,7 @@ void ScriptEditorDebugger::_bind_methods() {
 	ObjectTypeDB::bind_method(_MD("_performance_select"),&ScriptEditorDebugger::_performance_select);
 	ObjectTypeDB::bind_method(_MD("_scene_tree_request"),&ScriptEditorDebugger::_scene_tree_request);
 	ObjectTypeDB::bind_method(_MD("_video_mem_request"),&ScriptEditorDebugger::_video_mem_request);
+	ObjectTypeDB::bind_method(_MD("_memory_report_request"),&ScriptEditorDebugger::_memory_report_request);
 	ObjectTypeDB::bind_method(_MD("_live_edit_set"),&ScriptEditorDebugger::_live_edit_set);
 	ObjectTypeDB::bind_method(_MD("_live_edit_clear"),&ScriptEditorDebugger::_live_edit_clear);
 
@@ -1944,6 +1992,49 @@ ScriptEditorDebugger::ScriptEditorDebugger(EditorNode *p_editor){
 		tabs->add_child(vmem_vb);
 	}
 
+	{ //heap inspect
+		VBoxContainer *heap_vb = memnew( VBoxContainer );
+		HBoxContainer *heap_hb = memnew( HBoxContainer );
+		Label *hlb = memnew(Label(TTR("Tracked Allocations by Category and Site (first refresh starts tracking):")+" ") );
+		hlb->set_h_size_flags(SIZE_EXPAND_FILL);
+		heap_hb->add_child( hlb );
+		heap_hb->add_child( memnew(Label(TTR("Live:")+" ")) );
+		heap_total = memnew( LineEdit );
+		heap_total->set_editable(false);
+		heap_total->set_custom_minimum_size(Size2(100,1)*EDSCALE);
+		heap_hb->add_child(heap_total);
+		heap_refresh = memnew( Button );
+		heap_hb->add_child(heap_refresh);
+		heap_vb->add_child(heap_hb);
+		heap_refresh->connect("pressed",this,"_memory_report_request");
+
+		MarginContainer *hmc = memnew( MarginContainer );
+		heap_tree = memnew( Tree );
+		heap_tree->set_v_size_flags(SIZE_EXPAND_FILL);
+		heap_tree->set_h_size_flags(SIZE_EXPAND_FILL);
+		hmc->add_child(heap_tree);
+		hmc->set_v_size_flags(SIZE_EXPAND_FILL);
+		heap_vb->add_child(hmc);
+
+		heap_vb->set_name(TTR("Heap"));
+		heap_tree->set_columns(4);
+		heap_tree->set_column_titles_visible(true);
+		heap_tree->set_column_title(0,TTR("Category / Site"));
+		heap_tree->set_column_expand(0,true);
+		heap_tree->set_column_expand(1,false);
+		heap_tree->set_column_title(1,TTR("Live"));
+		heap_tree->set_column_min_width(1,80);
+		heap_tree->set_column_expand(2,false);
+		heap_tree->set_column_title(2,TTR("Count"));
+		heap_tree->set_column_min_width(2,80);
+		heap_tree->set_column_expand(3,false);
+		heap_tree->set_column_title(3,TTR("Allocs/Frame"));
+		heap_tree->set_column_min_width(3,100);
+		heap_tree->set_hide_root(true);
+
+		tabs->add_child(heap_vb);
+	}
+
 	{ // misc
 		VBoxContainer *info_left = memnew( VBoxContainer );
 		info_left->set_h_size_flags(SIZE_EXPAND_FILL);
@@ -119,6 +119,10 @@ class ScriptEditorDebugger : public Control {
 	Button *vmem_refresh;
 	LineEdit *vmem_total;
 
+	Tree *heap_tree;
+	Button *heap_refresh;
+	LineEdit *heap_total;
+
 	Tree *stack_dump;
 	PropertyEditor *inspector;
 
@@ -156,6 +160,7 @@ class ScriptEditorDebugger : public Control {
 	void _scene_tree_property_value_edited(const String& p_prop,const Variant& p_value);
 
 	void _video_mem_request();
+	void _memory_report_request();
 
 	int _get_node_path_cache(const NodePath& p_path);
 